@@ -264,22 +264,6 @@ StaticVector<float>* DepthSimMap::getSimMapStep1XPart(int xFrom, int partW)
     return simMap;
 }
 
-void DepthSimMap::initJustFromDepthMapT(StaticVector<float>* depthMapT, float defaultSim)
-{
-    int hdm = mp->getHeight(rc) / scale;
-
-    for(int i = 0; i < dsm->size(); i++)
-    {
-        int x = (i % w) * step;
-        int y = (i / w) * step;
-        if((x < w) && (y < h))
-        {
-            (*dsm)[i].depth = (*depthMapT)[x * hdm + y];
-            (*dsm)[i].sim = defaultSim;
-        }
-    }
-}
-
 void DepthSimMap::initJustFromDepthMap(StaticVector<float>* depthMap, float defaultSim)
 {
     int wdm = mp->getWidth(rc) / scale;
@@ -296,8 +280,8 @@ void DepthSimMap::initJustFromDepthMap(StaticVector<float>* depthMap, float defa
     }
 }
 
-void DepthSimMap::initFromDepthMapTAndSimMapT(StaticVector<float>* depthMapT, StaticVector<float>* simMapT,
-                                                 int depthSimMapsScale)
+void DepthSimMap::initFromDepthMapAndSimMap(StaticVector<float>* depthMap, StaticVector<float>* simMap,
+                                            int depthSimMapsScale)
 {
     int wdm = mp->getWidth(rc) / depthSimMapsScale;
     int hdm = mp->getHeight(rc) / depthSimMapsScale;
@@ -308,32 +292,10 @@ void DepthSimMap::initFromDepthMapTAndSimMapT(StaticVector<float>* depthMapT, St
         int y = (((i / w) * step) * scale) / depthSimMapsScale;
         if((x < wdm) && (y < hdm))
         {
-            (*dsm)[i].depth = (*depthMapT)[x * hdm + y];
-            (*dsm)[i].sim = (*simMapT)[x * hdm + y];
-        }
-    }
-}
-
-StaticVector<float>* DepthSimMap::getDepthMapTStep1()
-{
-    int wdm = mp->getWidth(rc) / scale;
-    int hdm = mp->getHeight(rc) / scale;
-
-    StaticVector<float>* depthMap = new StaticVector<float>();
-    depthMap->reserve(wdm * hdm);
-    depthMap->resize_with(wdm * hdm, -1.0f);
-    for(int i = 0; i < wdm * hdm; i++)
-    {
-        int x = (i / hdm) / step;
-        int y = (i % hdm) / step;
-        if((x < w) && (y < h))
-        {
-            float depth = (*dsm)[y * w + x].depth;
-            (*depthMap)[i] = depth;
+            (*dsm)[i].depth = (*depthMap)[y * wdm + x];
+            (*dsm)[i].sim = (*simMap)[y * wdm + x];
         }
     }
-
-    return depthMap;
 }
 
 StaticVector<float>* DepthSimMap::getDepthMap()
@@ -436,10 +398,7 @@ void DepthSimMap::load(int rc, int fromScale)
     imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::depthMap, fromScale), width, height, depthMap.getDataWritable());
     imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::simMap, fromScale), width, height, simMap.getDataWritable());
 
-    imageIO::transposeImage(width, height, depthMap.getDataWritable());
-    imageIO::transposeImage(width, height, simMap.getDataWritable());
-
-    initFromDepthMapTAndSimMapT(&depthMap, &simMap, fromScale);
+    initFromDepthMapAndSimMap(&depthMap, &simMap, fromScale);
 }
 
 void DepthSimMap::saveRefine(int rc, std::string depthMapFileName, std::string simMapFileName)
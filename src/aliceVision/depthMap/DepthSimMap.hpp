@@ -58,10 +58,9 @@ public:
     DepthSimMap(int rc, mvsUtils::MultiViewParams* _mp, int _scale, int _step);
     ~DepthSimMap(void);
 
-    void initJustFromDepthMapT(StaticVector<float>* depthMapT, float defaultSim);
     void initJustFromDepthMap(StaticVector<float>* depthMap, float defaultSim);
-    void initFromDepthMapTAndSimMapT(StaticVector<float>* depthMapT, StaticVector<float>* simMapT,
-                                     int depthSimMapsScale);
+    void initFromDepthMapAndSimMap(StaticVector<float>* depthMap, StaticVector<float>* simMap,
+                                   int depthSimMapsScale);
 
     void add11(DepthSimMap* depthSimMap);
     void add(DepthSimMap* depthSimMap);
@@ -71,7 +70,6 @@ public:
 
     float getPercentileDepth(float perc);
     StaticVector<float>* getDepthMapStep1();
-    StaticVector<float>* getDepthMapTStep1();
     StaticVector<float>* getSimMapStep1();
     StaticVector<float>* getDepthMap();
 
@@ -0,0 +1,28 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/config.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include <aliceVision/depthMap/cuda/PlaneSweepingCuda.hpp>
+#else
+#include <aliceVision/depthMap/cpu/PlaneSweepingCpu.hpp>
+#endif
+
+namespace aliceVision {
+namespace depthMap {
+
+// plane sweeping engine used by the depth map estimation, selected at build time
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+typedef PlaneSweepingCuda PlaneSweeping;
+#else
+typedef PlaneSweepingCpu PlaneSweeping;
+#endif
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -5,6 +5,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "RefineRc.hpp"
+#include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
@@ -322,16 +323,26 @@ void refineDepthMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::
     }
 
     int bandType = 0;
-    mvsUtils::ImagesCache* ic = new mvsUtils::ImagesCache(mp, bandType, true);
-    PlaneSweepingCuda* cps = new PlaneSweepingCuda(CUDADeviceNo, ic, mp, pc, sgmScale);
+    mvsUtils::ImagesCache* ic = new mvsUtils::ImagesCache(mp, bandType);
+    PlaneSweeping* cps = new PlaneSweeping(CUDADeviceNo, ic, mp, pc, sgmScale);
     SemiGlobalMatchingParams* sp = new SemiGlobalMatchingParams(mp, pc, cps);
 
     //////////////////////////////////////////////////////////////////////////////////////////
 
-    for(const int rc : cams)
+    const int maxTCams = mp->_ini.get<int>("refineRc.maxTCams", 6);
+
+    for(int i = 0; i < cams.size(); ++i)
     {
+        const int rc = cams[i];
         if(!mvsUtils::FileExists(sp->getREFINE_opt_simMapFileName(mp->getViewId(rc), 1, 1)))
         {
+            // load the images of the next camera and of its target cameras in the background
+            if(i + 1 < cams.size() && !mvsUtils::FileExists(sp->getREFINE_opt_simMapFileName(mp->getViewId(cams[i + 1]), 1, 1)))
+            {
+                ic->refreshImage_async(cams[i + 1]);
+                ic->refreshImages_async(pc->findNearestCamsFromSeeds(cams[i + 1], maxTCams).getData());
+            }
+
             RefineRc* rrc = new RefineRc(rc, sgmScale, sgmStep, sp);
             rrc->refinercCUDA();
             delete rrc;
@@ -345,6 +356,7 @@ void refineDepthMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsUtils::
 
 void refineDepthMaps(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
 {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     int num_gpus = listCUDADevices(true);
     int num_cpu_threads = omp_get_num_procs();
     ALICEVISION_LOG_INFO("Number of GPU devices: " << num_gpus << ", number of CPU threads: " << num_cpu_threads);
@@ -384,6 +396,10 @@ void refineDepthMaps(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc,
             refineDepthMaps(cpu_thread_id, mp, pc, subcams);
         }
     }
+#else
+    // the CPU engine is already parallelized internally
+    refineDepthMaps(mp->CUDADeviceNo, mp, pc, cams);
+#endif
 }
 
 } // namespace depthMap
@@ -5,9 +5,11 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "SemiGlobalMatchingRc.hpp"
+#include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/depthMap/SemiGlobalMatchingRcTc.hpp>
 #include <aliceVision/depthMap/SemiGlobalMatchingVolume.hpp>
+#include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/OrientedPoint.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/SeedPoint.hpp>
@@ -710,19 +712,29 @@ void computeDepthMapsPSSGM(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsU
     const int bandType = 0;
     
     // load images from files into RAM 
-    mvsUtils::ImagesCache ic(mp, bandType, true);
-    // load stuff on GPU memory and creates multi-level images and computes gradients
-    PlaneSweepingCuda cps(CUDADeviceNo, &ic, mp, pc, sgmScale);
+    mvsUtils::ImagesCache ic(mp, bandType);
+    // load stuff on GPU memory (or in RAM for the CPU engine) and creates multi-level images and computes gradients
+    PlaneSweeping cps(CUDADeviceNo, &ic, mp, pc, sgmScale);
     // init plane sweeping parameters
     SemiGlobalMatchingParams sp(mp, pc, &cps);
 
     //////////////////////////////////////////////////////////////////////////////////////////
 
-    for(const int rc : cams)
+    const int maxTCams = mp->_ini.get<int>("semiGlobalMatching.maxTCams", 10);
+
+    for(int i = 0; i < cams.size(); ++i)
     {
+        const int rc = cams[i];
         std::string depthMapFilepath = sp.getSGM_idDepthMapFileName(mp->getViewId(rc), sgmScale, sgmStep);
         if(!mvsUtils::FileExists(depthMapFilepath))
         {
+            // load the images of the next camera and of its target cameras in the background
+            if(i + 1 < cams.size() && !mvsUtils::FileExists(sp.getSGM_idDepthMapFileName(mp->getViewId(cams[i + 1]), sgmScale, sgmStep)))
+            {
+                ic.refreshImage_async(cams[i + 1]);
+                ic.refreshImages_async(pc->findNearestCamsFromSeeds(cams[i + 1], maxTCams).getData());
+            }
+
             ALICEVISION_LOG_INFO("Compute depth map: " << depthMapFilepath);
             SemiGlobalMatchingRc psgr(true, rc, sgmScale, sgmStep, &sp);
             psgr.sgmrc();
@@ -736,6 +748,7 @@ void computeDepthMapsPSSGM(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, mvsU
 
 void computeDepthMapsPSSGM(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams* pc, const StaticVector<int>& cams)
 {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     int num_gpus = listCUDADevices(true);
     int num_cpu_threads = omp_get_num_procs();
     ALICEVISION_LOG_INFO("Number of GPU devices: " << num_gpus << ", number of CPU threads: " << num_cpu_threads);
@@ -775,6 +788,10 @@ void computeDepthMapsPSSGM(mvsUtils::MultiViewParams* mp, mvsUtils::PreMatchCams
             computeDepthMapsPSSGM(cpu_thread_id, mp, pc, subcams);
         }
     }
+#else
+    // the CPU engine is already parallelized internally
+    computeDepthMapsPSSGM(mp->CUDADeviceNo, mp, pc, cams);
+#endif
 }
 
 } // namespace depthMap
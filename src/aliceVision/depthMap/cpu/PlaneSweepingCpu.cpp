@@ -0,0 +1,1273 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PlaneSweepingCpu.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/mvsData/geometry.hpp>
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+#include <aliceVision/mvsData/Point2d.hpp>
+#include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/depthMap/depthsToSweep.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+typedef PlaneSweepingCpu::LabImage LabImage;
+
+/**
+ * @brief Camera matrices at a given scale (same as cps_fillCamera on the GPU side).
+ */
+struct SweepCamera
+{
+    Matrix3x4 P;
+    Matrix3x3 iP;
+    Point3d C;
+    Point3d Z;
+};
+
+SweepCamera getSweepCamera(const mvsUtils::MultiViewParams* mp, int c, int scale)
+{
+    SweepCamera cam;
+    const Matrix3x3 K = diag3x3(1.0 / (double)scale, 1.0 / (double)scale, 1.0) * mp->KArr[c];
+    cam.P = K * (mp->RArr[c] | (Point3d(0.0, 0.0, 0.0) - mp->RArr[c] * mp->CArr[c]));
+    cam.iP = mp->iRArr[c] * K.inverse();
+    cam.C = mp->CArr[c];
+    cam.Z = (mp->iRArr[c] * Point3d(0.0, 0.0, 1.0)).normalize();
+    return cam;
+}
+
+inline Point2d project(const Matrix3x4& P, const Point3d& X)
+{
+    const Point3d p = P * X;
+    return Point2d(p.x / p.z, p.y / p.z);
+}
+
+inline float sigmoid(float zeroVal, float endVal, float sigwidth, float sigMid, float xval)
+{
+    return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + std::exp(10.0f * ((xval - sigMid) / sigwidth))));
+}
+
+inline float sigmoid2(float zeroVal, float endVal, float sigwidth, float sigMid, float xval)
+{
+    return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + std::exp(10.0f * ((sigMid - xval) / sigwidth))));
+}
+
+inline unsigned char toUChar(float v)
+{
+    return static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, v)));
+}
+
+/**
+ * @brief Linear RGB (0..1) to Lab scaled to 0..255, assuming whitepoint D65 (same as xyz2lab(rgb2xyz()) on the GPU).
+ */
+void rgb2lab(float r, float g, float b, unsigned char* lab)
+{
+    const float X = 0.4124564f * r + 0.3575761f * g + 0.1804375f * b;
+    const float Y = 0.2126729f * r + 0.7151522f * g + 0.0721750f * b;
+    const float Z = 0.0193339f * r + 0.1191920f * g + 0.9503041f * b;
+
+    const float rx = X / 0.95047f;
+    const float ry = Y;
+    const float rz = Z / 1.08883f;
+
+    const float eps = 216.0f / 24389.0f;
+    const float k = 24389.0f / 27.0f;
+    const float fx = rx > eps ? std::cbrt(rx) : (k * rx + 16.0f) / 116.0f;
+    const float fy = ry > eps ? std::cbrt(ry) : (k * ry + 16.0f) / 116.0f;
+    const float fz = rz > eps ? std::cbrt(rz) : (k * rz + 16.0f) / 116.0f;
+
+    lab[0] = toUChar((116.0f * fy - 16.0f) * 2.55f);
+    lab[1] = toUChar(500.0f * (fx - fy) * 2.55f);
+    lab[2] = toUChar(200.0f * (fy - fz) * 2.55f);
+}
+
+inline const unsigned char* getTexel(const LabImage& img, int x, int y)
+{
+    x = std::min(std::max(x, 0), img.width - 1);
+    y = std::min(std::max(y, 0), img.height - 1);
+    return &img.data[4 * (static_cast<std::size_t>(y) * img.width + x)];
+}
+
+/**
+ * @brief Bilinear lookup with pixel centers at integer coordinates and clamped borders,
+ *        equivalent to tex2D(tex, x + 0.5f, y + 0.5f) on a linear filtered texture.
+ */
+inline void sampleLab(const LabImage& img, double x, double y, float* out)
+{
+    const double x0f = std::floor(x);
+    const double y0f = std::floor(y);
+    const float ax = static_cast<float>(x - x0f);
+    const float ay = static_cast<float>(y - y0f);
+    const int x0 = static_cast<int>(x0f);
+    const int y0 = static_cast<int>(y0f);
+
+    const unsigned char* p00 = getTexel(img, x0, y0);
+    const unsigned char* p10 = getTexel(img, x0 + 1, y0);
+    const unsigned char* p01 = getTexel(img, x0, y0 + 1);
+    const unsigned char* p11 = getTexel(img, x0 + 1, y0 + 1);
+
+    for(int k = 0; k < 4; ++k)
+    {
+        const float u = p00[k] + (p10[k] - p00[k]) * ax;
+        const float d = p01[k] + (p11[k] - p01[k]) * ax;
+        out[k] = u + (d - u) * ay;
+    }
+}
+
+inline float euclidean3(const float* c1, const float* c2)
+{
+    return std::sqrt((c1[0] - c2[0]) * (c1[0] - c2[0]) + (c1[1] - c2[1]) * (c1[1] - c2[1]) +
+                     (c1[2] - c2[2]) * (c1[2] - c2[2]));
+}
+
+/**
+ * @brief Store the gradient size of L in the 4th channel (compute_varLofLABtoW_kernel on the GPU).
+ */
+void computeGradientOfL(LabImage& img)
+{
+#pragma omp parallel for
+    for(int y = 0; y < img.height; ++y)
+    {
+        for(int x = 0; x < img.width; ++x)
+        {
+            const float xM1 = getTexel(img, x - 1, y)[0];
+            const float xP1 = getTexel(img, x + 1, y)[0];
+            const float yM1 = getTexel(img, x, y - 1)[0];
+            const float yP1 = getTexel(img, x, y + 1)[0];
+            const float gx = xM1 - xP1;
+            const float gy = yM1 - yP1;
+            img.data[4 * (static_cast<std::size_t>(y) * img.width + x) + 3] = toUChar(std::sqrt(gx * gx + gy * gy));
+        }
+    }
+}
+
+/**
+ * @brief Gaussian smoothing and downscale of the full resolution Lab image
+ *        (downscale_gauss_smooth_lab_kernel on the GPU).
+ */
+void downscaleGaussLab(const LabImage& in, LabImage& out, int downscale, int radius)
+{
+    out.width = in.width / downscale;
+    out.height = in.height / downscale;
+    out.data.assign(4 * static_cast<std::size_t>(out.width) * out.height, 0);
+
+    std::vector<float> gaussian(2 * radius + 1);
+    for(int i = -radius; i <= radius; ++i)
+        gaussian[i + radius] = std::exp(-static_cast<float>(i * i) / 2.0f);
+
+#pragma omp parallel for
+    for(int y = 0; y < out.height; ++y)
+    {
+        for(int x = 0; x < out.width; ++x)
+        {
+            float t[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            float sum = 0.0f;
+            for(int i = -radius; i <= radius; ++i)
+            {
+                for(int j = -radius; j <= radius; ++j)
+                {
+                    // texture coordinates are shifted by half a pixel compared to sampleLab
+                    float curPix[4];
+                    sampleLab(in, (x * downscale + j) + downscale / 2.0 - 0.5,
+                              (y * downscale + i) + downscale / 2.0 - 0.5, curPix);
+                    const float factor = gaussian[i + radius] * gaussian[j + radius];
+                    for(int k = 0; k < 4; ++k)
+                        t[k] += curPix[k] * factor;
+                    sum += factor;
+                }
+            }
+            unsigned char* o = &out.data[4 * (static_cast<std::size_t>(y) * out.width + x)];
+            for(int k = 0; k < 4; ++k)
+                o[k] = toUChar(t[k] / sum);
+        }
+    }
+}
+
+/**
+ * @brief Oriented 3d patch used to compare the reference and target views.
+ */
+struct Patch
+{
+    Point3d p;
+    Point3d n;
+    Point3d x;
+    Point3d y;
+    double d;
+};
+
+inline Point3d get3DPointForPixelAndDepthFromRC(const SweepCamera& rcam, const Point2d& pix, float depth)
+{
+    const Point3d rpv = (rcam.iP * pix).normalize();
+    return rcam.C + rpv * depth;
+}
+
+inline Point3d get3DPointForPixelAndFrontoParellePlaneRC(const SweepCamera& rcam, const Point2d& pix,
+                                                         float fpPlaneDepth)
+{
+    const Point3d planep = rcam.C + rcam.Z * fpPlaneDepth;
+    const Point3d v = (rcam.iP * pix).normalize();
+    return linePlaneIntersect(rcam.C, v, planep, rcam.Z);
+}
+
+inline double computeRcPixSize(const SweepCamera& rcam, const Point3d& p)
+{
+    const Point2d rp1 = project(rcam.P, p) + Point2d(1.0, 0.0);
+    const Point3d refvect = (rcam.iP * rp1).normalize();
+    return pointLineDistance3D(p, rcam.C, refvect);
+}
+
+/**
+ * @brief Distance between the 3D points of the pixels (x, y) and (x + 1, y) at the same depth.
+ */
+inline float neighborDepthPixSize(const SweepCamera& rcam, int x, int y, float depth)
+{
+    const Point3d p1 = get3DPointForPixelAndDepthFromRC(rcam, Point2d(x, y), depth);
+    const Point3d p2 = get3DPointForPixelAndDepthFromRC(rcam, Point2d(x + 1, y), depth);
+    return static_cast<float>((p1 - p2).size());
+}
+
+/**
+ * @brief Depth lookup with clamped borders (same as the depthsTex texture).
+ */
+inline float getClampedDepth(const std::vector<float>& depths, int w, int h, int x, int y)
+{
+    x = std::min(std::max(x, 0), w - 1);
+    y = std::min(std::max(y, 0), h - 1);
+    return depths[y * w + x];
+}
+
+/**
+ * @brief Yoon & Kweon color weight between two Lab texels (CostYKfromLab on the GPU).
+ */
+inline float costYKfromLab(const unsigned char* c1, const unsigned char* c2, float gammaC)
+{
+    const float deltaC = std::sqrt(static_cast<float>((c1[0] - c2[0]) * (c1[0] - c2[0]) +
+                                                      (c1[1] - c2[1]) * (c1[1] - c2[1]) +
+                                                      (c1[2] - c2[2]) * (c1[2] - c2[2])));
+    return std::exp(-deltaC / gammaC);
+}
+
+/**
+ * @brief The patch y axis is orthogonal to the epipolar plane, x and n lie on it.
+ */
+inline Patch computePatch(const SweepCamera& rcam, const SweepCamera& tcam, const Point3d& p)
+{
+    Patch ptch;
+    ptch.p = p;
+    ptch.d = computeRcPixSize(rcam, p);
+
+    const Point3d v1 = (rcam.C - p).normalize();
+    const Point3d v2 = (tcam.C - p).normalize();
+    ptch.y = cross(v1, v2).normalize();
+    ptch.n = ((v1 + v2) / 2.0).normalize();
+    ptch.x = cross(ptch.y, ptch.n).normalize();
+    return ptch;
+}
+
+void move3DPointByTcPixStep(const SweepCamera& rcam, const SweepCamera& tcam, Point3d& p, float tcPixStep)
+{
+    const Point3d prp1 = p + (rcam.C - p) / 2.0;
+
+    const Point2d rp = project(rcam.P, p);
+    const Point2d tpo = project(tcam.P, p);
+    const Point2d tpv = (project(tcam.P, prp1) - tpo).normalize();
+    const Point2d tpd = tpo + tpv * tcPixStep;
+
+    // triangulate the match and keep the point on the reference camera ray
+    const Point3d refvect = (rcam.iP * rp).normalize();
+    const Point3d tarvect = (tcam.iP * tpd).normalize();
+
+    float k, l;
+    Point3d llis, lli1, lli2;
+    if(lineLineIntersect(&k, &l, &llis, &lli1, &lli2, rcam.C, rcam.C + refvect, tcam.C, tcam.C + tarvect))
+        p = rcam.C + refvect * k;
+}
+
+inline void move3DPointByTcOrRcPixStep(const SweepCamera& rcam, const SweepCamera& tcam, Point3d& p, float pixStep,
+                                       bool moveByTcOrRc)
+{
+    if(moveByTcOrRc)
+    {
+        move3DPointByTcPixStep(rcam, tcam, p, pixStep);
+    }
+    else
+    {
+        const double pixSize = pixStep * computeRcPixSize(rcam, p);
+        p = p + (p - rcam.C).normalize() * pixSize;
+    }
+}
+
+/**
+ * @brief Quadratic interpolation of the depth from the similarities of three consecutive depths.
+ * @return refined depth or -1 if the middle similarity is not a local minimum
+ */
+inline float refineDepthSubPixel(const float* depths, const float* sims)
+{
+    const float simM1 = (sims[0] + 1.0f) / 2.0f;
+    const float sim1 = (sims[1] + 1.0f) / 2.0f;
+    const float simP1 = (sims[2] + 1.0f) / 2.0f;
+
+    if((simM1 > sim1) && (simP1 > sim1))
+    {
+        const float dispStep = -((simP1 - simM1) / (2.0f * (simP1 + simM1 - 2.0f * sim1)));
+        const float b = (depths[2] + depths[0]) / 2.0f;
+        const float a = b - depths[0];
+        return a * dispStep + b;
+    }
+    return -1.0f;
+}
+
+/**
+ * @brief Weighted ZNCC of a 3d patch seen from rc and tc (compNCCby3DptsYK on the GPU).
+ *
+ * Samples are gathered first, then the weighted statistics are accumulated over contiguous buffers
+ * so that the second pass can be vectorized. Each thread needs its own instance.
+ */
+class PatchSimilarity
+{
+public:
+    PatchSimilarity(const SweepCamera& rcam, const SweepCamera& tcam, const LabImage& rImg, const LabImage& tImg,
+                    int width, int height, int wsh, float gammaC, float gammaP, float epipShift)
+        : _rcam(&rcam)
+        , _tcam(&tcam)
+        , _rImg(&rImg)
+        , _tImg(&tImg)
+        , _width(width)
+        , _height(height)
+        , _wsh(wsh)
+        , _invGammaC(1.0f / gammaC)
+        , _epipShift(epipShift)
+    {
+        const int patchSize = (2 * wsh + 1) * (2 * wsh + 1);
+        _rL.resize(patchSize);
+        _tL.resize(patchSize);
+        _colorDist.resize(patchSize);
+        _spatialDist.reserve(patchSize);
+        // the spatial term is the same for rc and tc: both are merged in the exponent
+        for(int yp = -wsh; yp <= wsh; ++yp)
+            for(int xp = -wsh; xp <= wsh; ++xp)
+                _spatialDist.push_back(2.0f * std::sqrt(static_cast<float>(xp * xp + yp * yp)) / gammaP);
+    }
+
+    const SweepCamera& rcam() const { return *_rcam; }
+    const SweepCamera& tcam() const { return *_tcam; }
+
+    float compute(const Point3d& p) { return compute(computePatch(*_rcam, *_tcam, p)); }
+
+    float compute(const Patch& ptch)
+    {
+        const Point2d rp = project(_rcam->P, ptch.p);
+        Point2d tp = project(_tcam->P, ptch.p);
+
+        // assuming that ptch.y is orthogonal to the epipolar plane
+        const Point2d tvUp = (project(_tcam->P, ptch.p + ptch.y * (ptch.d * 10.0)) - tp).normalize();
+        const Point2d vEpipShift = tvUp * _epipShift;
+        tp = tp + vEpipShift;
+
+        const double dd = _wsh + 2.0;
+        if((rp.x < dd) || (rp.x > (_width - 1) - dd) || (rp.y < dd) || (rp.y > (_height - 1) - dd) ||
+           (tp.x < dd) || (tp.x > (_width - 1) - dd) || (tp.y < dd) || (tp.y > (_height - 1) - dd))
+        {
+            return 1.0f;
+        }
+
+        float gcr[4];
+        float gct[4];
+        sampleLab(*_rImg, rp.x, rp.y, gcr);
+        sampleLab(*_tImg, tp.x, tp.y, gct);
+
+        // P * (p + x*d*xp + y*d*yp) = h0 + hX*xp + hY*yp
+        const Point3d vX = ptch.x * ptch.d;
+        const Point3d vY = ptch.y * ptch.d;
+        const Point3d rH0 = _rcam->P * ptch.p;
+        const Point3d rHX = _rcam->P * (ptch.p + vX) - rH0;
+        const Point3d rHY = _rcam->P * (ptch.p + vY) - rH0;
+        const Point3d tH0 = _tcam->P * ptch.p;
+        const Point3d tHX = _tcam->P * (ptch.p + vX) - tH0;
+        const Point3d tHY = _tcam->P * (ptch.p + vY) - tH0;
+
+        int k = 0;
+        for(int yp = -_wsh; yp <= _wsh; ++yp)
+        {
+            for(int xp = -_wsh; xp <= _wsh; ++xp)
+            {
+                const Point3d rh = rH0 + rHX * xp + rHY * yp;
+                const Point3d th = tH0 + tHX * xp + tHY * yp;
+
+                float gcr1[4];
+                float gct1[4];
+                sampleLab(*_rImg, rh.x / rh.z, rh.y / rh.z, gcr1);
+                sampleLab(*_tImg, th.x / th.z + vEpipShift.x, th.y / th.z + vEpipShift.y, gct1);
+
+                _rL[k] = gcr1[0];
+                _tL[k] = gct1[0];
+                _colorDist[k] = euclidean3(gcr, gcr1) + euclidean3(gct, gct1);
+                ++k;
+            }
+        }
+
+        float wsum = 0.0f;
+        float xsum = 0.0f;
+        float ysum = 0.0f;
+        float xxsum = 0.0f;
+        float yysum = 0.0f;
+        float xysum = 0.0f;
+        const float* rL = _rL.data();
+        const float* tL = _tL.data();
+        const float* colorDist = _colorDist.data();
+        const float* spatialDist = _spatialDist.data();
+        for(int i = 0; i < k; ++i)
+        {
+            // Yoon & Kweon weights of rc and tc
+            const float w = std::exp(-(colorDist[i] * _invGammaC + spatialDist[i]));
+            wsum += w;
+            xsum += w * rL[i];
+            ysum += w * tL[i];
+            xxsum += w * rL[i] * rL[i];
+            yysum += w * tL[i] * tL[i];
+            xysum += w * rL[i] * tL[i];
+        }
+
+        const float varX = (xxsum - xsum * xsum / wsum) / wsum;
+        const float varY = (yysum - ysum * ysum / wsum) / wsum;
+        const float varXY = (xysum - xsum * ysum / wsum) / wsum;
+
+        float sim = varXY / std::sqrt(varX * varY);
+        sim = std::isinf(sim) ? 1.0f : -sim;
+        return std::fmax(std::fmin(sim, 1.0f), -1.0f);
+    }
+
+private:
+    const SweepCamera* _rcam;
+    const SweepCamera* _tcam;
+    const LabImage* _rImg;
+    const LabImage* _tImg;
+    int _width;
+    int _height;
+    int _wsh;
+    float _invGammaC;
+    float _epipShift;
+
+    std::vector<float> _rL;
+    std::vector<float> _tL;
+    std::vector<float> _colorDist;
+    std::vector<float> _spatialDist;
+};
+
+/**
+ * @brief Aggregate one SGM path into volAgr (ps_updateAggrVolume on the GPU).
+ *
+ * The volume is traversed along x or y, with the depth as label dimension. Lines orthogonal
+ * to the path are processed by blocks so that each thread works on contiguous memory.
+ */
+void updateAggrVolume(std::vector<unsigned char>& volAgr, const unsigned char* volSim, int volDimX, int volDimY,
+                      int volDimZ, int volLUX, int volLUY, const LabImage& rcImg, bool pathAlongY, bool invZ,
+                      unsigned int P1, int lastN)
+{
+    const std::size_t volDimXY = static_cast<std::size_t>(volDimX) * volDimY;
+    const int nLines = pathAlongY ? volDimX : volDimY;
+    const int nPos = pathAlongY ? volDimY : volDimX;
+    const std::size_t lineStride = pathAlongY ? 1 : volDimX;
+    const std::size_t posStride = pathAlongY ? volDimX : 1;
+    const int blockSize = pathAlongY ? 64 : 16;
+    const int nBlocks = (nLines + blockSize - 1) / blockSize;
+
+#pragma omp parallel for schedule(dynamic)
+    for(int b = 0; b < nBlocks; ++b)
+    {
+        const int lineFrom = b * blockSize;
+        const int nb = std::min(blockSize, nLines - lineFrom);
+
+        std::vector<unsigned int> prevCosts(nb * volDimZ);
+        std::vector<unsigned int> costs(nb * volDimZ);
+        std::vector<unsigned int> bestPrevCosts(nb);
+        std::vector<unsigned int> P2s(nb);
+
+        for(int vz = 0; vz < nPos; ++vz)
+        {
+            const int pos = invZ ? nPos - 1 - vz : vz;
+
+            if(vz > 0)
+            {
+                for(int l = 0; l < nb; ++l)
+                    bestPrevCosts[l] = prevCosts[l];
+                for(int d = 1; d < volDimZ; ++d)
+                    for(int l = 0; l < nb; ++l)
+                        bestPrevCosts[l] = std::min(bestPrevCosts[l], prevCosts[d * nb + l]);
+
+                // P2 depends on the color difference in rc between the current and the previous position,
+                // looked up with volume coordinates as done by the GPU implementation
+                const int z = invZ ? nPos - vz : vz;
+                const int z1 = invZ ? z + 1 : z - 1;
+                for(int l = 0; l < nb; ++l)
+                {
+                    const int line = lineFrom + l;
+                    float gcr0[4];
+                    float gcr1[4];
+                    if(pathAlongY)
+                    {
+                        sampleLab(rcImg, volLUX + line, volLUY + z, gcr0);
+                        sampleLab(rcImg, volLUX + line, volLUY + z1, gcr1);
+                    }
+                    else
+                    {
+                        sampleLab(rcImg, volLUX + z, volLUY + line, gcr0);
+                        sampleLab(rcImg, volLUX + z1, volLUY + line, gcr1);
+                    }
+                    P2s[l] = static_cast<unsigned int>(sigmoid(15.0f, 255.0f, 80.0f, 20.0f, euclidean3(gcr0, gcr1)));
+                }
+            }
+
+            for(int d = 0; d < volDimZ; ++d)
+            {
+                const std::size_t offset = d * volDimXY + pos * posStride + lineFrom * lineStride;
+                const unsigned char* sims = volSim + offset;
+                unsigned char* agrs = volAgr.data() + offset;
+                unsigned int* cost = &costs[d * nb];
+
+                for(int l = 0; l < nb; ++l)
+                {
+                    unsigned int pathCost = sims[l * lineStride];
+                    unsigned char out = 255;
+
+                    if(vz > 0)
+                    {
+                        if((d >= 1) && (d < volDimZ - 1))
+                        {
+                            const unsigned int bestCost = bestPrevCosts[l];
+                            unsigned int minCost = std::min(prevCosts[d * nb + l], prevCosts[(d - 1) * nb + l] + P1);
+                            minCost = std::min(minCost, prevCosts[(d + 1) * nb + l] + P1);
+                            minCost = std::min(minCost, bestCost + P2s[l]);
+                            pathCost += minCost - bestCost;
+                        }
+                        else
+                        {
+                            pathCost = 255;
+                        }
+                        out = static_cast<unsigned char>(std::min(255u, pathCost));
+                    }
+                    cost[l] = pathCost;
+
+                    unsigned char& agr = agrs[l * lineStride];
+                    const float val = (agr * static_cast<float>(lastN) + static_cast<float>(out)) / static_cast<float>(lastN + 1);
+                    agr = static_cast<unsigned char>(std::min(255.0f, val));
+                }
+            }
+            std::swap(prevCosts, costs);
+        }
+    }
+}
+
+} // namespace
+
+PlaneSweepingCpu::PlaneSweepingCpu(int _CUDADeviceNo, mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp,
+                                   mvsUtils::PreMatchCams* _pc, int _scales)
+{
+    CUDADeviceNo = _CUDADeviceNo;
+
+    ic = _ic;
+    scales = _scales;
+    mp = _mp;
+    pc = _pc;
+
+    const int maxImageWidth = mp->getMaxImageWidth();
+    const int maxImageHeight = mp->getMaxImageHeight();
+
+    verbose = mp->verbose;
+
+    float oneimagemb = 4.0f * (((float)(maxImageWidth * maxImageHeight) / 1024.0f) / 1024.0f);
+    for(int scale = 2; scale <= scales; ++scale)
+    {
+        oneimagemb += 4.0 * (((float)((maxImageWidth / scale) * (maxImageHeight / scale)) / 1024.0) / 1024.0);
+    }
+    const float maxmbCPU = 1024.0f;
+    nImgsInMemAtTime = (int)(maxmbCPU / oneimagemb);
+    nImgsInMemAtTime = std::max(2, std::min(mp->ncams, nImgsInMemAtTime));
+
+    varianceWSH = mp->_ini.get<int>("global.varianceWSH", 4);
+
+    ALICEVISION_LOG_INFO("PlaneSweepingCpu:" << std::endl
+                         << "\t- nImgsInMemAtTime: " << nImgsInMemAtTime << std::endl
+                         << "\t- scales: " << scales << std::endl
+                         << "\t- varianceWSH: " << varianceWSH << std::endl
+                         << "\t- threads: " << omp_get_max_threads());
+
+    camsImages.resize(nImgsInMemAtTime);
+    camsRcs = new StaticVector<int>();
+    camsRcs->reserve(nImgsInMemAtTime);
+    camsRcs->resize_with(nImgsInMemAtTime, -1);
+    camsTimes = new StaticVector<long>();
+    camsTimes->reserve(nImgsInMemAtTime);
+    camsTimes->resize_with(nImgsInMemAtTime, 0);
+}
+
+PlaneSweepingCpu::~PlaneSweepingCpu(void)
+{
+    delete camsRcs;
+    delete camsTimes;
+
+    mp = NULL;
+}
+
+void PlaneSweepingCpu::fillCameraImages(std::vector<LabImage>& pyramid, int c)
+{
+    pyramid.resize(scales);
+
+    // full resolution image converted to Lab
+    LabImage& img = pyramid[0];
+    img.width = mp->getWidth(c);
+    img.height = mp->getHeight(c);
+    img.data.assign(4 * static_cast<std::size_t>(img.width) * img.height, 0);
+
+    const mvsUtils::ImagesCache::ImgSharedPtr rgbImg = ic->getImg_sync(c);
+
+#pragma omp parallel for
+    for(int y = 0; y < img.height; ++y)
+    {
+        for(int x = 0; x < img.width; ++x)
+        {
+            // same 8 bits quantization as ImagesCache::getPixelValue
+            const Color col = rgbImg->at(x, y) * 255.0f;
+            unsigned char* lab = &img.data[4 * (static_cast<std::size_t>(y) * img.width + x)];
+            rgb2lab(static_cast<unsigned char>(col.r) / 255.0f, static_cast<unsigned char>(col.g) / 255.0f,
+                    static_cast<unsigned char>(col.b) / 255.0f, lab);
+        }
+    }
+
+    if(varianceWSH > 0)
+        computeGradientOfL(img);
+
+    // downscaled levels
+    for(int scale = 1; scale < scales; ++scale)
+    {
+        downscaleGaussLab(pyramid[0], pyramid[scale], scale + 1, scale + 1);
+        if(varianceWSH > 0)
+            computeGradientOfL(pyramid[scale]);
+    }
+}
+
+int PlaneSweepingCpu::addCam(int rc)
+{
+    int id = camsRcs->indexOf(rc);
+    if(id == -1)
+    {
+        // replace the oldest image pyramid
+        id = camsTimes->minValId();
+
+        long t1 = clock();
+
+        fillCameraImages(camsImages[id], rc);
+
+        if(verbose)
+            mvsUtils::printfElapsedTime(t1, "load image pyramid in memory ");
+
+        (*camsRcs)[id] = rc;
+    }
+    (*camsTimes)[id] = clock();
+    return id;
+}
+
+void PlaneSweepingCpu::getMinMaxdepths(int rc, StaticVector<int>* tcams, float& minDepth, float& midDepth,
+                                       float& maxDepth)
+{
+    getMinMaxDepths(mp, rc, tcams, minDepth, midDepth, maxDepth);
+}
+
+StaticVector<float>* PlaneSweepingCpu::getDepthsByPixelSize(int rc, float minDepth, float midDepth, float maxDepth,
+                                                            int scale, int step, int maxDepthsHalf)
+{
+    return depthMap::getDepthsByPixelSize(mp, rc, minDepth, midDepth, maxDepth, scale, step, maxDepthsHalf);
+}
+
+StaticVector<float>* PlaneSweepingCpu::getDepthsRcTc(int rc, int tc, int scale, float midDepth, int maxDepthsHalf)
+{
+    return depthMap::getDepthsRcTc(mp, pc, rc, tc, scale, midDepth, maxDepthsHalf);
+}
+
+bool PlaneSweepingCpu::smoothDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float igammaP,
+                                      int wsh)
+{
+    const int w = mp->getWidth(rc) / scale;
+    const int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("smoothDepthMap rc: " << rc);
+
+    const int rcId = addCam(rc);
+    const SweepCamera rcam = getSweepCamera(mp, rc, scale);
+    const LabImage& rImg = camsImages[rcId][scale - 1];
+    const std::vector<float> depths = depthMap->getData();
+
+    // bilateral filter of the depths weighted by the Lab color and the pixel distance (smoothDepthMap_kernel)
+#pragma omp parallel for
+    for(int y = 0; y < h; ++y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const float depth = depths[y * w + x];
+            if(depth <= 0.0f)
+                continue;
+
+            const float pixSize = neighborDepthPixSize(rcam, x, y, depth);
+            const unsigned char* gcr = getTexel(rImg, x, y);
+            float depthUp = 0.0f;
+            float depthDown = 0.0f;
+
+            for(int yp = -wsh; yp <= wsh; ++yp)
+            {
+                for(int xp = -wsh; xp <= wsh; ++xp)
+                {
+                    const float depthn = getClampedDepth(depths, w, h, x + xp, y + yp);
+                    if(std::abs(depthn - depth) < 10.0f * pixSize)
+                    {
+                        const float wgt = costYKfromLab(gcr, getTexel(rImg, x + xp, y + yp), igammaC) *
+                                          std::exp(-std::sqrt(static_cast<float>(xp * xp + yp * yp)) / igammaP);
+                        depthUp += wgt * depthn;
+                        depthDown += wgt;
+                    }
+                }
+            }
+            (*depthMap)[y * w + x] = depthUp / depthDown;
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::filterDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC,
+                                      float minCostThr, int wsh)
+{
+    const int w = mp->getWidth(rc) / scale;
+    const int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("filterDepthMap rc: " << rc);
+
+    const int rcId = addCam(rc);
+    const SweepCamera rcam = getSweepCamera(mp, rc, scale);
+    const LabImage& rImg = camsImages[rcId][scale - 1];
+    const std::vector<float> depths = depthMap->getData();
+
+    // remove the depths supported by too few neighbors of similar color (filterDepthMap_kernel)
+#pragma omp parallel for
+    for(int y = 0; y < h; ++y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const float depth = depths[y * w + x];
+            float depthDown = 0.0f;
+
+            if(depth > 0.0f)
+            {
+                const float pixSize = neighborDepthPixSize(rcam, x, y, depth);
+                const unsigned char* gcr = getTexel(rImg, x, y);
+
+                for(int yp = -wsh; yp <= wsh; ++yp)
+                {
+                    for(int xp = -wsh; xp <= wsh; ++xp)
+                    {
+                        const float depthn = getClampedDepth(depths, w, h, x + xp, y + yp);
+                        if(std::abs(depthn - depth) < 10.0f * pixSize)
+                            depthDown += costYKfromLab(gcr, getTexel(rImg, x + xp, y + yp), igammaC);
+                    }
+                }
+            }
+            (*depthMap)[y * w + x] = (depthDown < minCostThr) ? -1.0f : depth;
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                                          StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh,
+                                          float gammaC, float gammaP, float epipShift, int xFrom, int wPart)
+{
+    const int w = wPart;
+    const int h = mp->getHeight(rc) / scale;
+    const bool moveByTcOrRc = useTcOrRcPixSize;
+
+    long t1 = clock();
+
+    const int rcId = addCam(rc);
+
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("\t- rc: " << rc << std::endl << "\t- tcams: " << tc);
+
+    const int tcId = addCam(tc);
+
+    const SweepCamera rcam = getSweepCamera(mp, rc, scale);
+    const SweepCamera tcam = getSweepCamera(mp, tc, scale);
+    const PatchSimilarity patchSim(rcam, tcam, camsImages[rcId][scale - 1], camsImages[tcId][scale - 1],
+                                   mp->getWidth(rc) / scale, mp->getHeight(rc) / scale, wsh, gammaC, gammaP, epipShift);
+
+#pragma omp parallel
+    {
+        PatchSimilarity sim(patchSim);
+
+#pragma omp for schedule(dynamic)
+        for(int y = 0; y < h; ++y)
+        {
+            for(int x = 0; x < w; ++x)
+            {
+                const Point2d pix(x + xFrom, y);
+                float& depth = (*rcDepthMap)[y * w + x];
+
+                // keep the best similarity along the steps around the input depth
+                float bestSim = 1.0f;
+                float bestDepth = depth;
+                if(depth > 0.0f)
+                {
+                    for(int i = 0; i < nStepsToRefine; ++i)
+                    {
+                        Point3d p = get3DPointForPixelAndDepthFromRC(rcam, pix, depth);
+                        move3DPointByTcOrRcPixStep(rcam, tcam, p, (float)(i - (nStepsToRefine - 1) / 2), moveByTcOrRc);
+
+                        const float stepSim = sim.compute(p);
+                        if((i == 0) || (stepSim < bestSim))
+                        {
+                            bestSim = stepSim;
+                            bestDepth = (p - rcam.C).size();
+                        }
+                    }
+                }
+
+                // sub-pixel refinement from the similarities of the neighbor steps
+                float outDepth = bestDepth;
+                if(bestDepth > 0.0f)
+                {
+                    const Point3d pMid = get3DPointForPixelAndDepthFromRC(rcam, pix, bestDepth);
+                    Point3d pm1 = pMid;
+                    Point3d pp1 = pMid;
+                    move3DPointByTcOrRcPixStep(rcam, tcam, pm1, -1.0f, moveByTcOrRc);
+                    move3DPointByTcOrRcPixStep(rcam, tcam, pp1, +1.0f, moveByTcOrRc);
+
+                    const float sims[3] = {sim.compute(pm1), bestSim, sim.compute(pp1)};
+                    const float depths[3] = {(float)(pm1 - rcam.C).size(), bestDepth, (float)(pp1 - rcam.C).size()};
+
+                    const float refinedDepth = refineDepthSubPixel(depths, sims);
+                    if(refinedDepth > 0.0f)
+                        outDepth = refinedDepth;
+                }
+
+                (*simMap)[y * w + x] = bestSim;
+                depth = outDepth;
+            }
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+float PlaneSweepingCpu::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX,
+                                            int volDimY, int volDimZ, int volStepXY, int volLUX, int volLUY,
+                                            int volLUZ, StaticVector<float>* depths, int rc, int wsh, float gammaC,
+                                            float gammaP, StaticVector<Voxel>* pixels, int scale, int step,
+                                            StaticVector<int>* tcams, float epipShift)
+{
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("sweepPixelsVolume:" << std::endl
+                              << "\t- scale: " << scale << std::endl
+                              << "\t- step: " << step << std::endl
+                              << "\t- npixels: " << pixels->size() << std::endl
+                              << "\t- volStepXY: " << volStepXY << std::endl
+                              << "\t- volDimX: " << volDimX << std::endl
+                              << "\t- volDimY: " << volDimY << std::endl
+                              << "\t- volDimZ: " << volDimZ);
+
+    const int w = mp->getWidth(rc) / scale;
+    const int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    if((tcams->size() == 0) || (pixels->size() == 0))
+        return -1.0f;
+
+    // as the GPU implementation, only the first target camera is used
+    const int tc = (*tcams)[0];
+    const int rcId = addCam(rc);
+    const int tcId = addCam(tc);
+
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("rc: " << rc << std::endl << "tcams: " << tc);
+
+    const SweepCamera rcam = getSweepCamera(mp, rc, scale);
+    const SweepCamera tcam = getSweepCamera(mp, tc, scale);
+    const PatchSimilarity patchSim(rcam, tcam, camsImages[rcId][scale - 1], camsImages[tcId][scale - 1], w, h, wsh,
+                                   gammaC, gammaP, epipShift);
+
+    const std::size_t volDimXY = static_cast<std::size_t>(volDimX) * volDimY;
+    std::vector<unsigned char>& vol = volume->getDataWritable();
+    vol.assign(volDimXY * volDimZ, 255);
+
+    // group the pixels by tiles of the volume: a voxel is only written by the thread owning its tile
+    // and, for a given depth, neighbor pixels hit the same area of the target image
+    struct TilePixel
+    {
+        Point2d pix;
+        int z;
+        std::size_t volXY;
+    };
+    const int tileSize = 16;
+    const int nTilesX = (volDimX + tileSize - 1) / tileSize;
+    const int nTilesY = (volDimY + tileSize - 1) / tileSize;
+    std::vector<std::vector<TilePixel>> tiles(nTilesX * nTilesY);
+
+    for(int i = 0; i < pixels->size(); ++i)
+    {
+        const Voxel& pix = (*pixels)[i];
+        const int vx = (pix.x - volLUX) / volStepXY;
+        const int vy = (pix.y - volLUY) / volStepXY;
+        if((vx < 0) || (vx >= volDimX) || (vy < 0) || (vy >= volDimY))
+            continue;
+
+        TilePixel tilePixel;
+        tilePixel.pix = Point2d(pix.x, pix.y);
+        tilePixel.z = pix.z;
+        tilePixel.volXY = static_cast<std::size_t>(vy) * volDimX + vx;
+        tiles[(vy / tileSize) * nTilesX + vx / tileSize].push_back(tilePixel);
+    }
+
+    const int ndepths = depths->size();
+
+#pragma omp parallel
+    {
+        PatchSimilarity sim(patchSim);
+
+#pragma omp for schedule(dynamic)
+        for(int t = 0; t < (int)tiles.size(); ++t)
+        {
+            for(int sdptid = 0; sdptid < nDepthsToSearch; ++sdptid)
+            {
+                for(const TilePixel& tilePixel : tiles[t])
+                {
+                    const int depthid = sdptid + tilePixel.z;
+                    const int vz = depthid - volLUZ;
+                    if((depthid >= ndepths) || (vz < 0) || (vz >= volDimZ))
+                        continue;
+
+                    const Point3d p = get3DPointForPixelAndFrontoParellePlaneRC(rcam, tilePixel.pix, (*depths)[depthid]);
+                    const float fsim = sim.compute(p);
+
+                    // similarity from [-1, 1] to [0, 255]
+                    const unsigned char volSim =
+                        static_cast<unsigned char>(std::min(1.0f, std::max(0.0f, (fsim + 1.0f) / 2.0f)) * 255.0f);
+                    unsigned char& v = vol[vz * volDimXY + tilePixel.volXY];
+                    v = std::min(v, volSim);
+                }
+            }
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return (float)(volDimXY * volDimZ) / (1024.0f * 1024.0f);
+}
+
+/**
+ * @param[inout] volume input similarity volume (after Z reduction)
+ */
+bool PlaneSweepingCpu::SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                                            int volDimZ, int volStepXY, int volLUX, int volLUY, int scale,
+                                            unsigned char P1, unsigned char P2)
+{
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("SGM optimizing volume:" << std::endl
+                              << "\t- volDimX: " << volDimX << std::endl
+                              << "\t- volDimY: " << volDimY << std::endl
+                              << "\t- volDimZ: " << volDimZ);
+
+    long t1 = clock();
+
+    const LabImage& rcImg = camsImages[addCam(rc)][scale - 1];
+    const unsigned char* volSim = volume->getData().data();
+    std::vector<unsigned char> volAgr(static_cast<std::size_t>(volDimX) * volDimY * volDimZ, 0);
+
+    // P2 is adapted to the color gradient along the path
+    updateAggrVolume(volAgr, volSim, volDimX, volDimY, volDimZ, volLUX, volLUY, rcImg, true, false, P1, 0);
+    updateAggrVolume(volAgr, volSim, volDimX, volDimY, volDimZ, volLUX, volLUY, rcImg, true, true, P1, 1);
+    updateAggrVolume(volAgr, volSim, volDimX, volDimY, volDimZ, volLUX, volLUY, rcImg, false, false, P1, 2);
+    updateAggrVolume(volAgr, volSim, volDimX, volDimY, volDimZ, volLUX, volLUY, rcImg, false, true, P1, 3);
+
+    std::copy(volAgr.begin(), volAgr.end(), volume->getDataWritable().begin());
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+Point3d PlaneSweepingCpu::getDeviceMemoryInfo()
+{
+    const system::MemoryInfo memInfo = system::getMemoryInfo();
+    const double convertionMb = 1024.0 * 1024.0;
+    return Point3d(memInfo.freeRam / convertionMb, memInfo.totalRam / convertionMb,
+                   (memInfo.totalRam - memInfo.freeRam) / convertionMb);
+}
+
+bool PlaneSweepingCpu::fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                                            const StaticVector<StaticVector<DepthSim>*>* dataMaps,
+                                                            int nSamplesHalf, int nDepthsToRefine, float sigma)
+{
+    long t1 = clock();
+
+    const float samplesPerPixSize = (float)(nSamplesHalf / ((nDepthsToRefine - 1) / 2));
+    const float twoTimesSigmaPowerTwo = 2.0f * sigma * sigma;
+    const StaticVector<DepthSim>& midDepthPixSizeMap = *(*dataMaps)[0];
+    const int nTcs = dataMaps->size() - 1;
+
+#pragma omp parallel
+    {
+        std::vector<float> samplesIds(nTcs);
+        std::vector<float> samplesSims(nTcs);
+
+#pragma omp for
+        for(int i = 0; i < w * h; ++i)
+        {
+            const DepthSim& midDepthPixSize = midDepthPixSizeMap[i];
+            DepthSim& oDepthSim = (*oDepthSimMap)[i];
+
+            if(midDepthPixSize.depth <= 0.0f)
+            {
+                oDepthSim = DepthSim(-1.0f, 1.0f);
+                continue;
+            }
+
+            const float depthStep = midDepthPixSize.sim / samplesPerPixSize;
+
+            // votes of the target cameras, expressed in samples around the middle depth
+            int nVotes = 0;
+            for(int c = 1; c <= nTcs; ++c)
+            {
+                const DepthSim& depthSim = (*(*dataMaps)[c])[i];
+                if(depthSim.depth > 0.0f)
+                {
+                    samplesIds[nVotes] = (midDepthPixSize.depth - depthSim.depth) / depthStep;
+                    samplesSims[nVotes] = -sigmoid(0.0f, 1.0f, 0.7f, -0.7f, depthSim.sim);
+                    ++nVotes;
+                }
+            }
+
+            float bestGsvSample = 0.0f;
+            float bestS = (float)-nSamplesHalf;
+            for(int s = -nSamplesHalf; s <= nSamplesHalf; ++s)
+            {
+                float gsvSample = 0.0f;
+                for(int v = 0; v < nVotes; ++v)
+                {
+                    const float d = samplesIds[v] - (float)s;
+                    gsvSample += samplesSims[v] * std::exp(-(d * d) / twoTimesSigmaPowerTwo);
+                }
+                if((s == -nSamplesHalf) || (gsvSample < bestGsvSample))
+                {
+                    bestGsvSample = gsvSample;
+                    bestS = (float)s;
+                }
+            }
+
+            oDepthSim = DepthSim(midDepthPixSize.depth - bestS * depthStep, bestGsvSample);
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                                          StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc,
+                                                          int nSamplesHalf, int nDepthsToRefine, float sigma,
+                                                          int nIters, int yFrom, int hPart)
+{
+    if(mp->verbose)
+        ALICEVISION_LOG_DEBUG("optimizeDepthSimMapGradientDescent.");
+
+    const int scale = 1;
+    const int w = mp->getWidth(rc);
+    const int h = hPart;
+
+    long t1 = clock();
+
+    const LabImage& rcImg = camsImages[addCam(rc)][scale - 1];
+    const SweepCamera rcam = getSweepCamera(mp, rc, scale);
+
+    const StaticVector<DepthSim>& midDepthPixSizeMap = *(*dataMaps)[0];
+    const StaticVector<DepthSim>& fusedDepthSimMap = *(*dataMaps)[1];
+
+    std::vector<DepthSim> optDepthSimMap(w * h);
+    std::vector<float> optDepthMap(w * h);
+    for(int y = 0; y < h; ++y)
+        for(int x = 0; x < w; ++x)
+            optDepthSimMap[y * w + x] = midDepthPixSizeMap[(y + yFrom) * w + x];
+
+    const auto getDepth = [&](int x, int y) {
+        x = std::min(std::max(x, 0), w - 1);
+        y = std::min(std::max(y, 0), h - 1);
+        return optDepthMap[y * w + x];
+    };
+
+    for(int iter = 0; iter < nIters; ++iter)
+    {
+        for(int i = 0; i < w * h; ++i)
+            optDepthMap[i] = optDepthSimMap[i].depth;
+
+#pragma omp parallel for
+        for(int y = 0; y < h; ++y)
+        {
+            for(int x = 0; x < w; ++x)
+            {
+                const int jO = (y + yFrom) * w + x;
+                const DepthSim& midDepthPixSize = midDepthPixSizeMap[jO];
+                const DepthSim& fusedDepthSim = fusedDepthSimMap[jO];
+                DepthSim& optDepthSim = optDepthSimMap[y * w + x];
+                if(iter == 0)
+                    optDepthSim = DepthSim(midDepthPixSize.depth, fusedDepthSim.sim);
+
+                const float depthOpt = optDepthSim.depth;
+                if(depthOpt <= 0.0f)
+                    continue;
+
+                // smoothing step and energy from the neighbor depths (as the GPU, the 3d points do not
+                // take yFrom into account)
+                float depthSmoothStep = 0.0f;
+                float depthSmoothVal = 180.0f;
+                {
+                    const float d0 = getDepth(x, y);
+                    const float dL = getDepth(x, y - 1);
+                    const float dR = getDepth(x, y + 1);
+                    const float dU = getDepth(x - 1, y);
+                    const float dB = getDepth(x + 1, y);
+
+                    const Point3d p0 = get3DPointForPixelAndDepthFromRC(rcam, Point2d(x, y), d0);
+                    const Point3d pL = get3DPointForPixelAndDepthFromRC(rcam, Point2d(x, y - 1), dL);
+                    const Point3d pR = get3DPointForPixelAndDepthFromRC(rcam, Point2d(x, y + 1), dR);
+                    const Point3d pU = get3DPointForPixelAndDepthFromRC(rcam, Point2d(x - 1, y), dU);
+                    const Point3d pB = get3DPointForPixelAndDepthFromRC(rcam, Point2d(x + 1, y), dB);
+
+                    Point3d cg(0.0, 0.0, 0.0);
+                    int n = 0;
+                    if(dL > 0.0f) { cg = cg + pL; ++n; }
+                    if(dR > 0.0f) { cg = cg + pR; ++n; }
+                    if(dU > 0.0f) { cg = cg + pU; ++n; }
+                    if(dB > 0.0f) { cg = cg + pB; ++n; }
+
+                    if(n > 1)
+                    {
+                        cg = cg / (double)n;
+                        const Point3d vcn = (rcam.C - p0).normalize();
+                        const Point3d pS = closestPointToLine3D(&cg, &p0, &vcn);
+                        depthSmoothStep = (rcam.C - pS).size() - d0;
+                    }
+
+                    float e = 0.0f;
+                    n = 0;
+                    if(dL > 0.0f && dR > 0.0f)
+                    {
+                        e = std::max(e, (float)(180.0 - angleBetwABandAC(p0, pL, pR)));
+                        ++n;
+                    }
+                    if(dU > 0.0f && dB > 0.0f)
+                    {
+                        e = std::max(e, (float)(180.0 - angleBetwABandAC(p0, pU, pB)));
+                        ++n;
+                    }
+                    if(n > 0)
+                        depthSmoothVal = e;
+                }
+
+                const float maxStep = midDepthPixSize.sim / 10.0f;
+                depthSmoothStep = std::copysign(std::min(std::abs(depthSmoothStep), maxStep), depthSmoothStep);
+                const float photoStep = fusedDepthSim.depth - depthOpt;
+                const float depthPhotoStep = std::copysign(std::min(std::abs(photoStep), maxStep), photoStep);
+                const float depthVisStep = midDepthPixSize.depth - depthOpt;
+                const float depthPhotoStepVal = fusedDepthSim.sim;
+
+                const float varianceGray = getTexel(rcImg, x, y + yFrom)[3];
+                const float varianceGrayAndleWeight = sigmoid2(5.0f, 30.0f, 40.0f, 20.0f, varianceGray);
+                const float simWeight = sigmoid(0.0f, 1.0f, 0.7f, -0.7f, depthPhotoStepVal);
+                const float photoWeight = sigmoid(0.0f, 1.0f, 30.0f, varianceGrayAndleWeight, depthSmoothVal);
+                const float smoothWeight = 1.0f - photoWeight;
+                const float visWeight =
+                    1.0f - sigmoid(0.0f, 1.0f, 10.0f, 17.0f, std::abs(depthVisStep / midDepthPixSize.sim));
+
+                const float depthOptStep =
+                    visWeight * depthVisStep +
+                    (1.0f - visWeight) * (photoWeight * simWeight * depthPhotoStep + smoothWeight * depthSmoothStep);
+
+                optDepthSim.depth = depthOpt + depthOptStep;
+                optDepthSim.sim = (1.0f - visWeight) * photoWeight * simWeight * depthPhotoStepVal +
+                                  (1.0f - visWeight) * smoothWeight * (depthSmoothVal / 20.0f);
+            }
+        }
+    }
+
+    for(int y = 0; y < h; ++y)
+        for(int x = 0; x < w; ++x)
+            (*oDepthSimMap)[(y + yFrom) * w + x] = optDepthSimMap[y * w + x];
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc)
+{
+    if(verbose)
+        ALICEVISION_LOG_DEBUG("getSilhoueteeMap: rc: " << rc);
+
+    const int w = mp->getWidth(rc) / scale;
+    const int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    const LabImage& img = camsImages[addCam(rc)][scale - 1];
+
+    unsigned char maskColorLab[3];
+    rgb2lab(maskColor.r / 255.0f, maskColor.g / 255.0f, maskColor.b / 255.0f, maskColorLab);
+
+#pragma omp parallel for
+    for(int y = 0; y < h / step; ++y)
+    {
+        for(int x = 0; x < w / step; ++x)
+        {
+            const unsigned char* col = getTexel(img, x * step, y * step);
+            (*oMap)[y * (w / step) + x] =
+                ((maskColorLab[0] == col[0]) && (maskColorLab[1] == col[1]) && (maskColorLab[2] == col[2]));
+        }
+    }
+
+    if(verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,105 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/Rgb.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsData/Voxel.hpp>
+#include <aliceVision/mvsUtils/ImagesCache.hpp>
+#include <aliceVision/mvsUtils/PreMatchCams.hpp>
+#include <aliceVision/depthMap/DepthSimMap.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief CPU implementation of the plane sweeping engine.
+ *
+ * Exposes the subset of the PlaneSweepingCuda interface used by the depth map
+ * estimation (SemiGlobalMatchingRc / RefineRc) and reproduces the CUDA kernels
+ * semantics, so that both backends can be compared on the same dataset.
+ * Images are kept in memory as Lab pyramids (uchar4 interleaved) and the heavy
+ * loops are parallelized with OpenMP over cache-sized tiles.
+ */
+class PlaneSweepingCpu
+{
+public:
+    /// Lab image with the gradient of L in the 4th channel (same content as the CUDA textures)
+    struct LabImage
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<unsigned char> data;
+    };
+
+    int scales;
+
+    mvsUtils::MultiViewParams* mp;
+    mvsUtils::PreMatchCams* pc;
+
+    int CUDADeviceNo;
+
+    /// image pyramids of the cameras in memory: camsImages[id][scale]
+    std::vector<std::vector<LabImage>> camsImages;
+    StaticVector<int>* camsRcs;
+    StaticVector<long>* camsTimes;
+
+    bool verbose;
+    int nImgsInMemAtTime;
+    int varianceWSH;
+
+    mvsUtils::ImagesCache* ic;
+
+    /**
+     * @param[in] _CUDADeviceNo unused, kept to share the constructor signature with PlaneSweepingCuda
+     */
+    PlaneSweepingCpu(int _CUDADeviceNo, mvsUtils::ImagesCache* _ic, mvsUtils::MultiViewParams* _mp,
+                     mvsUtils::PreMatchCams* _pc, int _scales);
+    ~PlaneSweepingCpu(void);
+
+    int addCam(int rc);
+
+    void getMinMaxdepths(int rc, StaticVector<int>* tcams, float& minDepth, float& midDepth, float& maxDepth);
+    StaticVector<float>* getDepthsByPixelSize(int rc, float minDepth, float midDepth, float maxDepth, int scale,
+                                              int step, int maxDepthsHalf = 1024);
+    StaticVector<float>* getDepthsRcTc(int rc, int tc, int scale, float midDepth, int maxDepthsHalf = 1024);
+
+    bool smoothDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float igammaP, int wsh);
+    bool filterDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float minCostThr, int wsh);
+
+    bool refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                            StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh, float gammaC,
+                            float gammaP, float epipShift, int xFrom, int wPart);
+
+    float sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                              int volDimZ, int volStepXY, int volLUX, int volLUY, int volLUZ,
+                              StaticVector<float>* depths, int rc, int wsh, float gammaC, float gammaP,
+                              StaticVector<Voxel>* pixels, int scale, int step, StaticVector<int>* tcams,
+                              float epipShift);
+    bool SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY, int volDimZ,
+                              int volStepXY, int volLUX, int volLUY, int scale, unsigned char P1, unsigned char P2);
+
+    /// @return (available, total, used) system memory in MB
+    Point3d getDeviceMemoryInfo();
+
+    bool fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                              const StaticVector<StaticVector<DepthSim>*>* dataMaps, int nSamplesHalf,
+                                              int nDepthsToRefine, float sigma);
+    bool optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                            StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc, int nSamplesHalf,
+                                            int nDepthsToRefine, float sigma, int nIters, int yFrom, int hPart);
+    bool getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc);
+
+private:
+    void fillCameraImages(std::vector<LabImage>& pyramid, int c);
+};
+
+} // namespace depthMap
+} // namespace aliceVision
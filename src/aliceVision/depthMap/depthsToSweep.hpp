@@ -0,0 +1,36 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/PreMatchCams.hpp>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Get the depth range of the reference camera from its seeds (or from the baselines if no seeds).
+ *        These helpers only use the cameras geometry, they are shared by all the plane sweeping backends.
+ */
+void getMinMaxDepths(const mvsUtils::MultiViewParams* mp, int rc, const StaticVector<int>* tcams, float& minDepth,
+                     float& midDepth, float& maxDepth);
+
+/**
+ * @brief Get the depths to sweep in [minDepth, maxDepth] with a step of one pixel size (at scale * step).
+ */
+StaticVector<float>* getDepthsByPixelSize(const mvsUtils::MultiViewParams* mp, int rc, float minDepth, float midDepth,
+                                          float maxDepth, int scale, int step, int maxDepthsHalf = 1024);
+
+/**
+ * @brief Get the depths of the principal ray of the reference camera rc visible by a pixel in the target camera tc.
+ */
+StaticVector<float>* getDepthsRcTc(const mvsUtils::MultiViewParams* mp, const mvsUtils::PreMatchCams* pc, int rc, int tc,
+                                   int scale, float midDepth, int maxDepthsHalf = 1024);
+
+} // namespace depthMap
+} // namespace aliceVision
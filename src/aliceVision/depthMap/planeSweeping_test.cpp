@@ -0,0 +1,429 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/config.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+#include <aliceVision/mvsData/Rgb.hpp>
+#include <aliceVision/mvsData/structures.hpp>
+#include <aliceVision/mvsUtils/ImagesCache.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/PreMatchCams.hpp>
+#include <aliceVision/imageIO/image.hpp>
+#include <aliceVision/depthMap/cpu/PlaneSweepingCpu.hpp>
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include <aliceVision/depthMap/cuda/PlaneSweepingCuda.hpp>
+#endif
+
+#include <boost/filesystem.hpp>
+
+#define BOOST_TEST_MODULE depthMapPlaneSweeping
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::depthMap;
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+const int width = 64;
+const int height = 48;
+const double focal = 60.0;
+const double baseline = 1.0;
+const double planeZ = 5.0;
+
+/**
+ * @brief Two cameras looking along z with a horizontal baseline, in front of a textured fronto-parallel plane.
+ */
+class SyntheticScene
+{
+public:
+    SyntheticScene()
+        : _dir(bfs::temp_directory_path() / bfs::unique_path("alicevision_planeSweeping_%%%%-%%%%-%%%%"))
+    {
+        bfs::create_directories(_dir);
+
+        std::ofstream ini((_dir / "mvs.ini").string());
+        ini << "[global]" << std::endl
+            << "ncams=2" << std::endl
+            << "imgExt=png" << std::endl
+            << "verbose=0" << std::endl
+            << "[imageResolutions]" << std::endl;
+        for(int c = 0; c < 2; ++c)
+            ini << c << "=" << width << "x" << height << std::endl;
+        ini.close();
+
+        StaticVector<CameraMatrices> cameras;
+        cameras.reserve(2);
+        for(int c = 0; c < 2; ++c)
+        {
+            CameraMatrices cam;
+            cam.K = diag3x3(focal, focal, 1.0);
+            cam.K.m13 = width / 2.0;
+            cam.K.m23 = height / 2.0;
+            cam.R = diag3x3(1.0, 1.0, 1.0);
+            cam.C = Point3d(c * baseline, 0.0, 0.0);
+            cam.iK = cam.K.inverse();
+            cam.iR = cam.R.inverse();
+            cam.iCam = cam.iR * cam.iK;
+            cam.P = cam.K * (cam.R | (Point3d(0.0, 0.0, 0.0) - cam.R * cam.C));
+            cam.f = focal;
+            cam.k1 = 0.0f;
+            cam.k2 = 0.0f;
+            cameras.push_back(cam);
+
+            imageIO::writeImage((_dir / (std::to_string(c) + ".png")).string(), width, height, render(cam.C));
+        }
+
+        mp.reset(new mvsUtils::MultiViewParams((_dir / "mvs.ini").string(), (_dir / "depthMap").string(),
+                                               (_dir / "depthMapFilter").string(), false, 1, &cameras));
+        pc.reset(new mvsUtils::PreMatchCams(mp.get()));
+        ic.reset(new mvsUtils::ImagesCache(mp.get(), 0));
+    }
+
+    ~SyntheticScene()
+    {
+        ic.reset();
+        bfs::remove_all(_dir);
+    }
+
+    /// distance along the ray of camera 0 from the pixel (x, y) to the plane
+    static double trueDepth(int x, int y)
+    {
+        const double dx = (x - width / 2.0) / focal;
+        const double dy = (y - height / 2.0) / focal;
+        return planeZ * std::sqrt(dx * dx + dy * dy + 1.0);
+    }
+
+    std::unique_ptr<mvsUtils::MultiViewParams> mp;
+    std::unique_ptr<mvsUtils::PreMatchCams> pc;
+    std::unique_ptr<mvsUtils::ImagesCache> ic;
+
+private:
+    static std::vector<rgb> render(const Point3d& C)
+    {
+        std::vector<rgb> image(width * height);
+        for(int y = 0; y < height; ++y)
+        {
+            for(int x = 0; x < width; ++x)
+            {
+                const double X = C.x + planeZ * (x - width / 2.0) / focal;
+                const double Y = C.y + planeZ * (y - height / 2.0) / focal;
+                const double a = std::sin(7.0 * X) * std::cos(5.0 * Y);
+                const double b = std::sin(13.0 * X + 3.0 * Y);
+                image[y * width + x] = rgb(static_cast<unsigned char>(128.0 + 60.0 * a + 50.0 * b),
+                                           static_cast<unsigned char>(128.0 + 90.0 * b),
+                                           static_cast<unsigned char>(128.0 - 40.0 * a + 30.0 * b));
+            }
+        }
+        return image;
+    }
+
+    bfs::path _dir;
+};
+
+/// noisy depths of the plane with isolated outliers and missing depths
+StaticVector<float> getNoisyDepthMap()
+{
+    std::mt19937 generator;
+    std::uniform_real_distribution<float> noise(-0.2f, 0.2f);
+
+    StaticVector<float> depthMap;
+    depthMap.resize(width * height);
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            const int i = y * width + x;
+            float depth = static_cast<float>(SyntheticScene::trueDepth(x, y)) + noise(generator);
+            if(i % 37 == 0)
+                depth *= 1.5f;
+            else if(i % 53 == 0)
+                depth = -1.0f;
+            depthMap[i] = depth;
+        }
+    }
+    return depthMap;
+}
+
+/// the pixels of camera 0 seen by camera 1, away from the image borders
+bool isInside(int x, int y)
+{
+    const int margin = 8;
+    const int disparity = static_cast<int>(std::ceil(focal * baseline / planeZ));
+    return (x >= disparity + margin) && (x < width - margin) && (y >= margin) && (y < height - margin);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(PlaneSweeping_Cpu_recoverPlane)
+{
+    SyntheticScene scene;
+    const int scale = 1;
+    const int wsh = 4;
+    const float gammaC = 15.5f;
+    const float gammaP = 8.0f;
+
+    PlaneSweepingCpu cpu(0, scene.ic.get(), scene.mp.get(), scene.pc.get(), scale);
+
+    // sweep fronto-parallel planes around the plane of the scene
+    StaticVector<float> depths;
+    const int volDimZ = 21;
+    depths.reserve(volDimZ);
+    for(int z = 0; z < volDimZ; ++z)
+        depths.push_back(static_cast<float>(planeZ - 1.0 + 0.1 * z));
+
+    StaticVector<Voxel> pixels;
+    pixels.reserve(width * height);
+    for(int y = 0; y < height; ++y)
+        for(int x = 0; x < width; ++x)
+            pixels.push_back(Voxel(x, y, 0));
+
+    StaticVector<int> tcams;
+    tcams.push_back(1);
+
+    StaticVector<unsigned char> volume;
+    volume.resize(width * height * volDimZ);
+    cpu.sweepPixelsToVolume(volDimZ, &volume, width, height, volDimZ, 1, 0, 0, 0, &depths, 0, wsh, gammaC, gammaP,
+                            &pixels, scale, 1, &tcams, 0.0f);
+
+    // best plane of each pixel, as a depth along the ray of the pixel
+    StaticVector<float> depthMap;
+    depthMap.resize(width * height, -1.0f);
+    int nInside = 0;
+    int nGoodPlane = 0;
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            const int xy = y * width + x;
+            int best = 0;
+            for(int z = 1; z < volDimZ; ++z)
+                if(volume[z * width * height + xy] < volume[best * width * height + xy])
+                    best = z;
+            depthMap[xy] = static_cast<float>(depths[best] / planeZ * SyntheticScene::trueDepth(x, y));
+
+            if(!isInside(x, y))
+                continue;
+            ++nInside;
+            if(std::abs(depths[best] - planeZ) < 0.15)
+                ++nGoodPlane;
+        }
+    }
+    BOOST_CHECK_GE(nGoodPlane, 0.9 * nInside);
+
+    // refine the depths by steps of the size of a pixel of camera 0
+    StaticVector<float> simMap;
+    simMap.resize(width * height);
+    BOOST_CHECK(cpu.refineRcTcDepthMap(false, 15, &simMap, &depthMap, 0, 1, scale, wsh, gammaC, gammaP, 0.0f, 0,
+                                       width));
+
+    int nGoodDepth = 0;
+    for(int y = 0; y < height; ++y)
+        for(int x = 0; x < width; ++x)
+            if(isInside(x, y) && std::abs(depthMap[y * width + x] - SyntheticScene::trueDepth(x, y)) < 0.05)
+                ++nGoodDepth;
+    BOOST_CHECK_GE(nGoodDepth, 0.9 * nInside);
+
+    // isolated outliers are removed by the filtering, the depths of the plane are kept
+    for(int i = 0; i < width * height; i += 37)
+        depthMap[i] *= 1.5f;
+
+    BOOST_CHECK(cpu.filterDepthMap(&depthMap, 0, scale, gammaC, 2.0f, 2));
+
+    int nKept = 0;
+    int nInliers = 0;
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            const int i = y * width + x;
+            if(!isInside(x, y))
+                continue;
+            if(i % 37 == 0)
+            {
+                BOOST_CHECK_EQUAL(depthMap[i], -1.0f);
+                continue;
+            }
+            ++nInliers;
+            if(std::abs(depthMap[i] - SyntheticScene::trueDepth(x, y)) < 0.05)
+                ++nKept;
+        }
+    }
+    BOOST_CHECK_GE(nKept, 0.9 * nInliers);
+}
+
+BOOST_AUTO_TEST_CASE(PlaneSweeping_Cpu_smoothDepthMap)
+{
+    SyntheticScene scene;
+    const int scale = 1;
+
+    PlaneSweepingCpu cpu(0, scene.ic.get(), scene.mp.get(), scene.pc.get(), scale);
+
+    StaticVector<float> depthMap = getNoisyDepthMap();
+    BOOST_CHECK(cpu.smoothDepthMap(&depthMap, 0, scale, 15.5f, 8.0f, 2));
+
+    // the noise of the depths is reduced, the missing depths stay missing
+    const StaticVector<float> noisyDepthMap = getNoisyDepthMap();
+    double noisyError = 0.0;
+    double smoothError = 0.0;
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            const int i = y * width + x;
+            if(noisyDepthMap[i] < 0.0f)
+            {
+                BOOST_CHECK_EQUAL(depthMap[i], noisyDepthMap[i]);
+                continue;
+            }
+            if((i % 37 == 0) || !isInside(x, y))
+                continue;
+            noisyError += std::abs(noisyDepthMap[i] - SyntheticScene::trueDepth(x, y));
+            smoothError += std::abs(depthMap[i] - SyntheticScene::trueDepth(x, y));
+        }
+    }
+    BOOST_CHECK_LT(smoothError, 0.5 * noisyError);
+}
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+
+namespace {
+
+bool hasCudaDevice()
+{
+    if(listCUDADevices(false) > 0)
+        return true;
+    BOOST_TEST_MESSAGE("No CUDA device found, the CPU and CUDA plane sweeping engines are not compared.");
+    return false;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(PlaneSweeping_CpuVsCuda_sweepPixelsToVolume)
+{
+    if(!hasCudaDevice())
+        return;
+
+    SyntheticScene scene;
+    const int scale = 1;
+    const int wsh = 4;
+
+    PlaneSweepingCpu cpu(0, scene.ic.get(), scene.mp.get(), scene.pc.get(), scale);
+    PlaneSweepingCuda cuda(0, scene.ic.get(), scene.mp.get(), scene.pc.get(), scale);
+
+    // fronto-parallel planes around the plane of the scene
+    StaticVector<float> depths;
+    const int volDimZ = 21;
+    depths.reserve(volDimZ);
+    for(int z = 0; z < volDimZ; ++z)
+        depths.push_back(static_cast<float>(planeZ - 1.0 + 0.1 * z));
+
+    StaticVector<Voxel> pixels;
+    pixels.reserve(width * height);
+    for(int y = wsh; y < height - wsh; ++y)
+        for(int x = wsh; x < width - wsh; ++x)
+            pixels.push_back(Voxel(x, y, 0));
+
+    StaticVector<int> tcams;
+    tcams.push_back(1);
+
+    StaticVector<unsigned char> volumeCpu;
+    StaticVector<unsigned char> volumeCuda;
+    volumeCpu.resize(width * height * volDimZ);
+    volumeCuda.resize(width * height * volDimZ);
+
+    cpu.sweepPixelsToVolume(volDimZ, &volumeCpu, width, height, volDimZ, 1, 0, 0, 0, &depths, 0, wsh, 15.5f, 8.0f,
+                            &pixels, scale, 1, &tcams, 0.0f);
+    cuda.sweepPixelsToVolume(volDimZ, &volumeCuda, width, height, volDimZ, 1, 0, 0, 0, &depths, 0, wsh, 15.5f, 8.0f,
+                             &pixels, scale, 1, &tcams, 0.0f);
+
+    double sumDiff = 0.0;
+    int nSameBestDepth = 0;
+    for(int i = 0; i < pixels.size(); ++i)
+    {
+        const int xy = pixels[i].y * width + pixels[i].x;
+        int bestCpu = 0;
+        int bestCuda = 0;
+        for(int z = 0; z < volDimZ; ++z)
+        {
+            const int v = z * width * height + xy;
+            sumDiff += std::abs(volumeCpu[v] - volumeCuda[v]);
+            if(volumeCpu[v] < volumeCpu[bestCpu * width * height + xy])
+                bestCpu = z;
+            if(volumeCuda[v] < volumeCuda[bestCuda * width * height + xy])
+                bestCuda = z;
+        }
+        if(std::abs(bestCpu - bestCuda) <= 1)
+            ++nSameBestDepth;
+    }
+
+    // the similarities are quantized on 8 bits
+    BOOST_CHECK_LT(sumDiff / (pixels.size() * volDimZ), 1.0);
+    BOOST_CHECK_GE(nSameBestDepth, 0.95 * pixels.size());
+}
+
+BOOST_AUTO_TEST_CASE(PlaneSweeping_CpuVsCuda_smoothDepthMap)
+{
+    if(!hasCudaDevice())
+        return;
+
+    SyntheticScene scene;
+    const int scale = 1;
+
+    PlaneSweepingCpu cpu(0, scene.ic.get(), scene.mp.get(), scene.pc.get(), scale);
+    PlaneSweepingCuda cuda(0, scene.ic.get(), scene.mp.get(), scene.pc.get(), scale);
+
+    StaticVector<float> depthMapCpu = getNoisyDepthMap();
+    StaticVector<float> depthMapCuda = getNoisyDepthMap();
+
+    BOOST_CHECK(cpu.smoothDepthMap(&depthMapCpu, 0, scale, 15.5f, 8.0f, 2));
+    BOOST_CHECK(cuda.smoothDepthMap(&depthMapCuda, 0, scale, 15.5f, 8.0f, 2));
+
+    for(int i = 0; i < width * height; ++i)
+        BOOST_CHECK_CLOSE(depthMapCpu[i], depthMapCuda[i], 1e-2);
+}
+
+BOOST_AUTO_TEST_CASE(PlaneSweeping_CpuVsCuda_filterDepthMap)
+{
+    if(!hasCudaDevice())
+        return;
+
+    SyntheticScene scene;
+    const int scale = 1;
+
+    PlaneSweepingCpu cpu(0, scene.ic.get(), scene.mp.get(), scene.pc.get(), scale);
+    PlaneSweepingCuda cuda(0, scene.ic.get(), scene.mp.get(), scene.pc.get(), scale);
+
+    StaticVector<float> depthMapCpu = getNoisyDepthMap();
+    StaticVector<float> depthMapCuda = getNoisyDepthMap();
+
+    BOOST_CHECK(cpu.filterDepthMap(&depthMapCpu, 0, scale, 15.5f, 2.0f, 2));
+    BOOST_CHECK(cuda.filterDepthMap(&depthMapCuda, 0, scale, 15.5f, 2.0f, 2));
+
+    // the isolated outliers are removed by both engines, the other depths are kept unchanged
+    int nDiff = 0;
+    for(int i = 0; i < width * height; ++i)
+    {
+        if(depthMapCpu[i] != depthMapCuda[i])
+            ++nDiff;
+        if(i % 37 == 0)
+            BOOST_CHECK_EQUAL(depthMapCpu[i], -1.0f);
+    }
+    BOOST_CHECK_LE(nDiff, width * height / 100);
+}
+
+#endif
@@ -11,12 +11,14 @@
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/feature/PointFeature.hpp>
 #include <aliceVision/feature/Descriptor.hpp>
+#include <aliceVision/feature/RegionsFile.hpp>
 #include <aliceVision/matching/metric.hpp>
 
 #include <string>
 #include <cstddef>
 #include <typeinfo>
 #include <memory>
+#include <cstring>
 
 
 namespace aliceVision {
@@ -66,6 +68,16 @@ public:
   virtual void LoadFeatures(
     const std::string& sfileNameFeats) = 0;
 
+  //--
+  // IO - binary regions file (see RegionsFile)
+  //--
+
+  /**
+   * @brief Load the regions of a view from a binary regions file.
+   * @note Features and descriptors are copied in bulk from the mapped file, without any parsing.
+   */
+  virtual void Load(const RegionsFile& regionsFile, IndexT viewId) = 0;
+
   //--
   //- Basic description of a descriptor [Type, Length]
   //--
@@ -97,6 +109,19 @@ public:
    */
   virtual const void * DescriptorRawData() const = 0;
 
+  /**
+   * @brief Return a pointer to the first feature of the features array.
+   *
+   * @note: Features are always stored as a flat array of features.
+   */
+  virtual const void* FeaturesRawData() const = 0;
+
+  /// Size in bytes of one feature
+  virtual std::size_t FeatureByteSize() const = 0;
+
+  /// Size in bytes of one descriptor
+  virtual std::size_t DescriptorByteSize() const = 0;
+
   virtual void clearDescriptors() = 0;
 
   /// Return the squared distance between two descriptors
@@ -152,6 +177,10 @@ public:
   /// Return the number of defined regions
   std::size_t RegionCount() const {return _vec_feats.size();}
 
+  const void* FeaturesRawData() const {return _vec_feats.data();}
+
+  std::size_t FeatureByteSize() const {return sizeof(FeatureT);}
+
   /// Mutable and non-mutable FeatureT getters.
   inline std::vector<FeatureT> & Features() { return _vec_feats; }
   inline const std::vector<FeatureT> & Features() const { return _vec_feats; }
@@ -207,6 +236,7 @@ protected:
 public:
   std::string Type_id() const override {return typeid(T).name();}
   std::size_t DescriptorLength() const override {return static_cast<std::size_t>(L);}
+  std::size_t DescriptorByteSize() const override {return sizeof(DescriptorT);}
 
   bool IsScalar() const override { return regionType == ERegionType::Scalar; }
   bool IsBinary() const override { return regionType == ERegionType::Binary; }
@@ -225,6 +255,26 @@ public:
     loadDescsFromBinFile(sfileNameDescs, _vec_descs);
   }
 
+  /// Read the regions and their corresponding descriptors from a binary regions file.
+  void Load(const RegionsFile& regionsFile, IndexT viewId) override
+  {
+    if(regionsFile.featureSize() != sizeof(FeatT) || regionsFile.descriptorSize() != sizeof(DescriptorT))
+      throw std::runtime_error("Can't load view " + std::to_string(viewId) + " from regions file '" + regionsFile.path() + "' : incompatible regions type.");
+
+    const void* feats = nullptr;
+    const void* descs = nullptr;
+    const std::size_t nbRegions = regionsFile.getViewRegions(viewId, feats, descs);
+
+    // features and descriptors are plain arrays of floats/bytes, they can be copied in bulk
+    this->_vec_feats.resize(nbRegions);
+    _vec_descs.resize(nbRegions);
+    if(nbRegions > 0)
+    {
+      std::memcpy(this->_vec_feats.data(), feats, nbRegions * sizeof(FeatT));
+      std::memcpy(_vec_descs.data(), descs, nbRegions * sizeof(DescriptorT));
+    }
+  }
+
   /// Export in two separate files the regions and their corresponding descriptors.
   void Save(
     const std::string& sfileNameFeats,
@@ -0,0 +1,196 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "RegionsFile.hpp"
+#include <aliceVision/feature/Regions.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+const char regionsFileMagic[8] = {'A', 'V', 'R', 'E', 'G', 'I', 'O', 'N'};
+const std::uint64_t regionsFileAlignment = 16;
+
+inline std::uint64_t alignOffset(std::uint64_t offset)
+{
+  return (offset + regionsFileAlignment - 1) / regionsFileAlignment * regionsFileAlignment;
+}
+
+/**
+ * @brief Check that a block of count elements of elementSize bytes at offset fits in the file.
+ * @note The check is done without computing offset + count * elementSize, which can overflow on a corrupted file.
+ */
+inline bool isBlockInFile(std::uint64_t offset, std::uint64_t count, std::uint64_t elementSize, std::uint64_t fileSize)
+{
+  if(offset > fileSize)
+    return false;
+  return elementSize == 0 || count <= (fileSize - offset) / elementSize;
+}
+
+} // namespace
+
+RegionsFile::RegionsFile(const std::string& path)
+  : _file(path)
+{
+  if(_file.size() < sizeof(Header))
+    throw std::runtime_error("Invalid regions file '" + path + "' : file too small.");
+
+  _header = reinterpret_cast<const Header*>(_file.data());
+
+  if(std::memcmp(_header->magic, regionsFileMagic, sizeof(regionsFileMagic)) != 0)
+    throw std::runtime_error("Invalid regions file '" + path + "' : bad magic number.");
+
+  if(_header->version != version)
+    throw std::runtime_error("Invalid regions file '" + path + "' : unsupported version " + std::to_string(_header->version) + ".");
+
+  if(!isBlockInFile(sizeof(Header), _header->nbViews, sizeof(ViewEntry), _file.size()))
+    throw std::runtime_error("Invalid regions file '" + path + "' : truncated view table.");
+
+  _views = reinterpret_cast<const ViewEntry*>(_file.data() + sizeof(Header));
+
+  for(std::size_t i = 0; i < _header->nbViews; ++i)
+  {
+    const ViewEntry& view = _views[i];
+    if(!isBlockInFile(view.featuresOffset, view.nbRegions, _header->featureSize, _file.size()) ||
+       !isBlockInFile(view.descriptorsOffset, view.nbRegions, _header->descriptorSize, _file.size()))
+      throw std::runtime_error("Invalid regions file '" + path + "' : truncated data for view " + std::to_string(view.viewId) + ".");
+  }
+}
+
+std::size_t RegionsFile::featureSize() const
+{
+  return _header->featureSize;
+}
+
+std::size_t RegionsFile::descriptorSize() const
+{
+  return _header->descriptorSize;
+}
+
+std::size_t RegionsFile::getNbViews() const
+{
+  return _header->nbViews;
+}
+
+std::vector<IndexT> RegionsFile::getViewIds() const
+{
+  std::vector<IndexT> viewIds;
+  viewIds.reserve(_header->nbViews);
+  for(std::size_t i = 0; i < _header->nbViews; ++i)
+    viewIds.push_back(_views[i].viewId);
+  return viewIds;
+}
+
+const RegionsFile::ViewEntry* RegionsFile::findView(IndexT viewId) const
+{
+  const ViewEntry* end = _views + _header->nbViews;
+  const ViewEntry* it = std::lower_bound(_views, end, viewId,
+                                         [](const ViewEntry& view, IndexT id){ return view.viewId < id; });
+  if(it == end || it->viewId != viewId)
+    return nullptr;
+  return it;
+}
+
+bool RegionsFile::hasView(IndexT viewId) const
+{
+  return findView(viewId) != nullptr;
+}
+
+std::size_t RegionsFile::getViewRegions(IndexT viewId, const void*& features, const void*& descriptors) const
+{
+  const ViewEntry* view = findView(viewId);
+  if(view == nullptr)
+    throw std::runtime_error("Can't find view " + std::to_string(viewId) + " in regions file '" + path() + "' !");
+
+  features = _file.data() + view->featuresOffset;
+  descriptors = _file.data() + view->descriptorsOffset;
+  return static_cast<std::size_t>(view->nbRegions);
+}
+
+void saveRegionsFile(const std::string& path, const std::map<IndexT, const Regions*>& regionsPerView)
+{
+  RegionsFile::Header header;
+  std::memcpy(header.magic, regionsFileMagic, sizeof(regionsFileMagic));
+  header.version = RegionsFile::version;
+  header.nbViews = static_cast<std::uint32_t>(regionsPerView.size());
+  header.featureSize = 0;
+  header.descriptorSize = 0;
+
+  if(!regionsPerView.empty())
+  {
+    const Regions& firstRegions = *regionsPerView.begin()->second;
+    header.featureSize = static_cast<std::uint32_t>(firstRegions.FeatureByteSize());
+    header.descriptorSize = static_cast<std::uint32_t>(firstRegions.DescriptorByteSize());
+  }
+
+  // view table (std::map keeps the views sorted by id)
+  std::vector<RegionsFile::ViewEntry> views;
+  views.reserve(regionsPerView.size());
+
+  std::uint64_t offset = alignOffset(sizeof(RegionsFile::Header) + regionsPerView.size() * sizeof(RegionsFile::ViewEntry));
+
+  for(const auto& regionsIt : regionsPerView)
+  {
+    const Regions& regions = *regionsIt.second;
+
+    if(regions.FeatureByteSize() != header.featureSize || regions.DescriptorByteSize() != header.descriptorSize)
+      throw std::runtime_error("Can't save regions file '" + path + "' : all views should have the same regions type.");
+
+    RegionsFile::ViewEntry view;
+    view.viewId = regionsIt.first;
+    view.reserved = 0;
+    view.nbRegions = regions.RegionCount();
+    view.featuresOffset = offset;
+    offset = alignOffset(offset + view.nbRegions * header.featureSize);
+    view.descriptorsOffset = offset;
+    offset = alignOffset(offset + view.nbRegions * header.descriptorSize);
+    views.push_back(view);
+  }
+
+  std::ofstream file(path, std::ios::out | std::ios::binary);
+  if(!file.is_open())
+    throw std::runtime_error("Can't save regions file, can't open '" + path + "' !");
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if(!views.empty())
+    file.write(reinterpret_cast<const char*>(views.data()), views.size() * sizeof(RegionsFile::ViewEntry));
+
+  const char padding[regionsFileAlignment] = {0};
+  const auto writeBlock = [&](std::uint64_t blockOffset, const void* data, std::uint64_t size)
+  {
+    const std::uint64_t position = static_cast<std::uint64_t>(file.tellp());
+    file.write(padding, blockOffset - position);
+    if(size > 0)
+      file.write(static_cast<const char*>(data), size);
+  };
+
+  std::size_t i = 0;
+  for(const auto& regionsIt : regionsPerView)
+  {
+    const Regions& regions = *regionsIt.second;
+    const RegionsFile::ViewEntry& view = views[i++];
+    const bool empty = (view.nbRegions == 0);
+
+    writeBlock(view.featuresOffset, empty ? nullptr : regions.FeaturesRawData(), view.nbRegions * header.featureSize);
+    writeBlock(view.descriptorsOffset, empty ? nullptr : regions.DescriptorRawData(), view.nbRegions * header.descriptorSize);
+  }
+  // pad the end of the file, so that the last block is aligned as the others
+  writeBlock(offset, nullptr, 0);
+
+  if(!file.good())
+    throw std::runtime_error("Can't save regions file, '" + path + "' is incorrect !");
+
+  file.close();
+}
+
+} // namespace feature
+} // namespace aliceVision
@@ -0,0 +1,108 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/system/MappedFile.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+class Regions;
+
+/**
+ * @brief Binary container for the regions (features and descriptors) of one or several views.
+ *
+ * The file is memory mapped and the features/descriptors of a view are stored as contiguous
+ * raw arrays, so loading a view does not require any parsing.
+ *
+ * Layout (native endianness):
+ * - header: magic "AVREGION", version, number of views, size in bytes of one feature and of one descriptor
+ * - view table: for each view (sorted by view id), the number of regions and the offsets of its
+ *   features and descriptors arrays
+ * - data: features and descriptors arrays, aligned on 16 bytes
+ *
+ * Files are named "<viewId>.<describerType>.regions" for a single view
+ * and "<describerType>.regions" when several views are packed together.
+ */
+class RegionsFile
+{
+public:
+  static const std::uint32_t version = 1;
+
+  /**
+   * @brief Map the given regions file in memory and check its header.
+   * @param[in] path The regions file path
+   * @throw std::runtime_error if the file can't be opened or is invalid
+   */
+  explicit RegionsFile(const std::string& path);
+
+  const std::string& path() const { return _file.path(); }
+
+  /// @return size in bytes of one feature
+  std::size_t featureSize() const;
+
+  /// @return size in bytes of one descriptor
+  std::size_t descriptorSize() const;
+
+  std::size_t getNbViews() const;
+
+  std::vector<IndexT> getViewIds() const;
+
+  bool hasView(IndexT viewId) const;
+
+  /**
+   * @brief Get the raw features and descriptors arrays of a view.
+   * @param[in] viewId The view id
+   * @param[out] features Pointer to the first feature in the mapped file
+   * @param[out] descriptors Pointer to the first descriptor in the mapped file
+   * @return the number of regions of the view
+   * @throw std::runtime_error if the view is not in the file
+   */
+  std::size_t getViewRegions(IndexT viewId, const void*& features, const void*& descriptors) const;
+
+  struct Header
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t nbViews;
+    std::uint32_t featureSize;
+    std::uint32_t descriptorSize;
+  };
+
+  struct ViewEntry
+  {
+    std::uint32_t viewId;
+    std::uint32_t reserved;
+    std::uint64_t nbRegions;
+    std::uint64_t featuresOffset;
+    std::uint64_t descriptorsOffset;
+  };
+
+private:
+  const ViewEntry* findView(IndexT viewId) const;
+
+  system::MappedFile _file;
+  const Header* _header = nullptr;
+  const ViewEntry* _views = nullptr;
+};
+
+/**
+ * @brief Save the regions of one or several views in a binary regions file.
+ * @param[in] path The output file path
+ * @param[in] regionsPerView The regions to save, all of the same type
+ * @throw std::runtime_error if the file can't be written or the regions types differ
+ */
+void saveRegionsFile(const std::string& path, const std::map<IndexT, const Regions*>& regionsPerView);
+
+} // namespace feature
+} // namespace aliceVision
@@ -122,3 +122,53 @@ BOOST_AUTO_TEST_CASE(descriptorIO_BINARY) {
       BOOST_CHECK_EQUAL(vec_descs[i][j], vec_descs_read[i][j]);
   }
 }
+
+//Test binary regions file with several views
+BOOST_AUTO_TEST_CASE(regionsIO_BINARY_FILE) {
+  typedef ScalarRegions<Feature_T, float, DESC_LENGTH> Regions_T;
+
+  std::vector<Regions_T> regionsPerView(3);
+  std::map<IndexT, const Regions*> regionsToSave;
+  for(std::size_t v = 0; v < regionsPerView.size(); ++v)
+  {
+    // the second view has no region
+    const int card = (v == 1) ? 0 : CARD + v;
+    for(int i = 0; i < card; ++i)
+    {
+      regionsPerView[v].Features().push_back(Feature_T(i, i*2, i*3, v));
+      Desc_T desc;
+      for (int j = 0; j < DESC_LENGTH; ++j)
+        desc[j] = i*DESC_LENGTH+j+v;
+      regionsPerView[v].Descriptors().push_back(desc);
+    }
+    regionsToSave[10 * v] = &regionsPerView[v];
+  }
+
+  //Save them to a file
+  BOOST_CHECK_NO_THROW(saveRegionsFile("tempRegions.regions", regionsToSave));
+
+  //Read the saved data and compare to input (to check write/read IO)
+  const RegionsFile regionsFile("tempRegions.regions");
+  BOOST_CHECK_EQUAL(regionsPerView.size(), regionsFile.getNbViews());
+  BOOST_CHECK(!regionsFile.hasView(1));
+
+  for(std::size_t v = 0; v < regionsPerView.size(); ++v)
+  {
+    Regions_T regionsRead;
+    BOOST_CHECK_NO_THROW(regionsRead.Load(regionsFile, 10 * v));
+    BOOST_CHECK_EQUAL(regionsPerView[v].RegionCount(), regionsRead.RegionCount());
+
+    for(std::size_t i = 0; i < regionsRead.RegionCount(); ++i)
+    {
+      BOOST_CHECK_EQUAL(regionsPerView[v].Features()[i], regionsRead.Features()[i]);
+      BOOST_CHECK(regionsPerView[v].Descriptors()[i] == regionsRead.Descriptors()[i]);
+    }
+  }
+
+  // Try to read a view with another descriptor type
+  BinaryRegions<Feature_T, DESC_LENGTH> binaryRegions;
+  BOOST_CHECK_THROW(binaryRegions.Load(regionsFile, 0), std::exception);
+  // Try to read a non-existing view
+  Regions_T regionsRead;
+  BOOST_CHECK_THROW(regionsRead.Load(regionsFile, 1), std::exception);
+}
@@ -6,11 +6,30 @@
 
 #include "SIFT.hpp"
 
+#include <mutex>
+#include <vector>
+
 namespace aliceVision {
 namespace feature {
 
 int VLFeatInstance::nbInstances = 0;
 
+namespace {
+
+/// SIFT filters not used by an extraction
+std::vector<VlSiftFilt*> siftFiltersPool;
+std::mutex siftFiltersPoolMutex;
+
+void clearSiftFiltersPool()
+{
+  std::lock_guard<std::mutex> lock(siftFiltersPoolMutex);
+  for(VlSiftFilt* filt : siftFiltersPool)
+    vl_sift_delete(filt);
+  siftFiltersPool.clear();
+}
+
+} // namespace
+
 std::size_t getMemoryConsumptionVLFeat(std::size_t width, std::size_t height, const SiftParams& params)
 {
   double scaleFactor = 1.0;
@@ -45,7 +64,44 @@ void VLFeatInstance::destroy()
   assert(nbInstances > 0);
   --nbInstances;
   if(nbInstances <= 0)
+  {
+    clearSiftFiltersPool();
     vl_destructor();
+  }
+}
+
+VlSiftFilt* VLFeatInstance::acquireSiftFilter(int width, int height, const SiftParams& params)
+{
+  {
+    std::lock_guard<std::mutex> lock(siftFiltersPoolMutex);
+
+    // with the same image size, the number of octaves computed by VLFeat (if not specified) is the same
+    for(auto it = siftFiltersPool.begin(); it != siftFiltersPool.end(); ++it)
+    {
+      VlSiftFilt* filt = *it;
+      if(filt->width == width && filt->height == height &&
+         filt->S == params._numScales && filt->o_min == params._firstOctave &&
+         (params._numOctaves < 0 || filt->O == params._numOctaves))
+      {
+        siftFiltersPool.erase(it);
+        return filt;
+      }
+    }
+
+    // no filter can be reused, free the memory of the oldest one
+    if(!siftFiltersPool.empty())
+    {
+      vl_sift_delete(siftFiltersPool.front());
+      siftFiltersPool.erase(siftFiltersPool.begin());
+    }
+  }
+  return vl_sift_new(width, height, params._numOctaves, params._numScales, params._firstOctave);
+}
+
+void VLFeatInstance::releaseSiftFilter(VlSiftFilt* filt)
+{
+  std::lock_guard<std::mutex> lock(siftFiltersPoolMutex);
+  siftFiltersPool.push_back(filt);
 }
 
 } //namespace feature
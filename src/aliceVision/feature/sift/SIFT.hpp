@@ -17,6 +17,8 @@ extern "C" {
 #include "nonFree/sift/vl/sift.h"
 }
 
+#include <algorithm>
+#include <array>
 #include <iostream>
 #include <numeric>
 #include <stdexcept>
@@ -121,6 +123,23 @@ public:
 
   static void destroy();
 
+  /**
+   * @brief Get a SIFT filter for the given image size and scale space parameters.
+   *        The filters given back by the previous extractions are reused,
+   *        so the scale space buffers are only allocated when the image size changes.
+   * @param[in] width The image width
+   * @param[in] height The image height
+   * @param[in] params The SIFT parameters
+   * @return a SIFT filter, to give back with releaseSiftFilter
+   */
+  static VlSiftFilt* acquireSiftFilter(int width, int height, const SiftParams& params);
+
+  /**
+   * @brief Give back a SIFT filter obtained with acquireSiftFilter.
+   * @param[in] filt The SIFT filter
+   */
+  static void releaseSiftFilter(VlSiftFilt* filt);
+
 private:
   static int nbInstances;
 };
@@ -200,14 +219,10 @@ bool extractSIFT(const image::Image<float>& image,
     const image::Image<unsigned char>* mask)
 {
   const int w = image.Width(), h = image.Height();
-  VlSiftFilt *filt = vl_sift_new(w, h, params._numOctaves, params._numScales, params._firstOctave);
-  if (params._edgeThreshold >= 0)
-    vl_sift_set_edge_thresh(filt, params._edgeThreshold);
-  if (params._peakThreshold >= 0)
-    vl_sift_set_peak_thresh(filt, params._peakThreshold/params._numScales);
-
-  Descriptor<vl_sift_pix, 128> vlFeatDescriptor;
-  Descriptor<T, 128> descriptor;
+  VlSiftFilt *filt = VLFeatInstance::acquireSiftFilter(w, h, params);
+  // the filter may have been used with other thresholds, use the VLFeat defaults if not specified
+  vl_sift_set_edge_thresh(filt, (params._edgeThreshold >= 0) ? params._edgeThreshold : 10.0);
+  vl_sift_set_peak_thresh(filt, (params._peakThreshold >= 0) ? params._peakThreshold/params._numScales : 0.0);
 
   // Process SIFT computation
   vl_sift_process_first_octave(filt, image.data());
@@ -222,6 +237,10 @@ bool extractSIFT(const image::Image<float>& image,
   regionsCasted->Features().reserve(reserveSize);
   regionsCasted->Descriptors().reserve(reserveSize);
 
+  // orientations and first output index of each keypoint of the current octave
+  std::vector<std::array<double, 4>> keysAngles;
+  std::vector<std::size_t> keysOffsets;
+
   while (true)
   {
     vl_sift_detect(filt);
@@ -232,46 +251,54 @@ bool extractSIFT(const image::Image<float>& image,
     // Update gradient before launching parallel extraction
     vl_sift_update_gradient(filt);
 
-    #pragma omp parallel for private(vlFeatDescriptor, descriptor)
+    keysAngles.resize(nkeys);
+    keysOffsets.resize(nkeys + 1);
+    keysOffsets[0] = 0;
+
+    // 1. orientations (from 1 to 4 per keypoint), masked keypoints have no orientation
+    #pragma omp parallel for
     for (int i = 0; i < nkeys; ++i)
     {
+      int nangles = 1; // by default (1 upright feature)
+      keysAngles[i].fill(0.0);
 
       // Feature masking
-      if (mask)
-      {
-        const image::Image<unsigned char> & maskIma = *mask;
-        if (maskIma(keys[i].y, keys[i].x) > 0)
-          continue;
-      }
+      if (mask && (*mask)(keys[i].y, keys[i].x) > 0)
+        nangles = 0;
+      else if (orientation)
+        nangles = vl_sift_calc_keypoint_orientations(filt, keysAngles[i].data(), keys+i);
 
-      double angles [4] = {0.0, 0.0, 0.0, 0.0};
-      int nangles = 1; // by default (1 upright feature)
-      if (orientation)
-      { // compute from 1 to 4 orientations
-        nangles = vl_sift_calc_keypoint_orientations(filt, angles, keys+i);
-      }
+      keysOffsets[i + 1] = nangles;
+    }
+
+    // 2. output slots, in the keypoints order
+    std::partial_sum(keysOffsets.begin(), keysOffsets.end(), keysOffsets.begin());
+    const std::size_t firstIndex = regionsCasted->Features().size();
+    regionsCasted->Features().resize(firstIndex + keysOffsets.back());
+    regionsCasted->Descriptors().resize(firstIndex + keysOffsets.back());
+
+    // 3. descriptors, written directly in their slots
+    #pragma omp parallel for
+    for (int i = 0; i < nkeys; ++i)
+    {
+      Descriptor<vl_sift_pix, 128> vlFeatDescriptor;
 
-      for (int q=0 ; q < nangles ; ++q)
+      for (std::size_t q = 0; q < keysOffsets[i + 1] - keysOffsets[i]; ++q)
       {
-        vl_sift_calc_keypoint_descriptor(filt, &vlFeatDescriptor[0], keys+i, angles[q]);
-        const SIOPointFeature fp(keys[i].x, keys[i].y,
-          keys[i].sigma, static_cast<float>(angles[q]));
+        const std::size_t index = firstIndex + keysOffsets[i] + q;
 
-        convertSIFT<T>(&vlFeatDescriptor[0], descriptor, params._rootSift);
-        
-        #pragma omp critical
-        {
-          regionsCasted->Descriptors().push_back(descriptor);
-          regionsCasted->Features().push_back(fp);
-        }
-        
+        vl_sift_calc_keypoint_descriptor(filt, &vlFeatDescriptor[0], keys+i, keysAngles[i][q]);
+        regionsCasted->Features()[index] = SIOPointFeature(keys[i].x, keys[i].y,
+          keys[i].sigma, static_cast<float>(keysAngles[i][q]));
+
+        convertSIFT<T>(&vlFeatDescriptor[0], regionsCasted->Descriptors()[index], params._rootSift);
       }
     }
     
     if (vl_sift_process_next_octave(filt))
       break; // Last octave
   }
-  vl_sift_delete(filt);
+  VLFeatInstance::releaseSiftFilter(filt);
 
   const auto& features = regionsCasted->Features();
   const auto& descriptors = regionsCasted->Descriptors();
@@ -281,7 +308,7 @@ bool extractSIFT(const image::Image<float>& image,
   {
     std::vector<std::size_t> indexSort(features.size());
     std::iota(indexSort.begin(), indexSort.end(), 0);
-    std::sort(indexSort.begin(), indexSort.end(), [&](std::size_t a, std::size_t b){ return features[a].scale() > features[b].scale(); });
+    std::stable_sort(indexSort.begin(), indexSort.end(), [&](std::size_t a, std::size_t b){ return features[a].scale() > features[b].scale(); });
     
     std::vector<typename SIFT_Region_T::FeatureT> sortedFeatures(features.size());
     std::vector<typename SIFT_Region_T::DescriptorT> sortedDescriptors(features.size());
@@ -5,13 +5,13 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "DelaunayGraphCut.hpp"
-// #include <aliceVision/fuseCut/MaxFlow_CSR.hpp>
-#include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_Tetrahedra.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/jetColorMap.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Universe.hpp>
+#include <aliceVision/mvsUtils/DepthMapsCache.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
 #include <aliceVision/imageIO/image.hpp>
 #include <aliceVision/alicevision_omp.hpp>
@@ -291,27 +291,26 @@ void createVerticesWithVisibilities(const StaticVector<int>& cams, std::vector<P
     for(int c = 0; c < cams.size(); ++c)
     {
         ALICEVISION_LOG_INFO("Create visibilities (" << c << "/" << cams.size() << ")");
-        std::vector<float> depthMap;
+        // the maps have been read by fuseFromDepthMaps, they are still in the depth maps cache
+        mvsUtils::DepthMapsCache& depthMapsCache = mvsUtils::DepthMapsCache::getInstance();
+        const std::string depthMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::depthMap, 0);
+        const mvsUtils::DepthMapsCache::MapConstPtr depthMapPtr = depthMapsCache.get(depthMapFilepath);
+        const std::vector<float>& depthMap = depthMapPtr->data;
         std::vector<float> simMap;
-        int width, height;
+        const int width = depthMapPtr->width;
+        const int height = depthMapPtr->height;
+        if(depthMap.empty())
+        {
+            ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
+            continue;
+        }
         {
-            const std::string depthMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::depthMap, 0);
-            imageIO::readImage(depthMapFilepath, width, height, depthMap);
-            if(depthMap.empty())
-            {
-                ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
-                continue;
-            }
-            int wTmp, hTmp;
             const std::string simMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::simMap, 0);
-            imageIO::readImage(simMapFilepath, wTmp, hTmp, simMap);
-            if(wTmp != width || hTmp != height)
+            const mvsUtils::DepthMapsCache::MapConstPtr simMapPtr = depthMapsCache.get(simMapFilepath);
+            if(simMapPtr->width != width || simMapPtr->height != height)
                 throw std::runtime_error("Similarity map size doesn't match the depth map size: " + simMapFilepath + ", " + depthMapFilepath);
-            {
-                std::vector<float> simMapTmp(simMap.size());
-                imageIO::convolveImage(width, height, simMap, simMapTmp, "gaussian", simGaussianSize, simGaussianSize);
-                simMap.swap(simMapTmp);
-            }
+            simMap.resize(simMapPtr->data.size());
+            imageIO::convolveImage(width, height, simMapPtr->data, simMap, "gaussian", simGaussianSize, simGaussianSize);
         }
         // Add visibility
         #pragma omp parallel for
@@ -394,6 +393,7 @@ DelaunayGraphCut::DelaunayGraphCut(mvsUtils::MultiViewParams* _mp, mvsUtils::Pre
     _camsVertexes.resize(mp->ncams, -1);
 
     saveTemporaryBinFiles = mp->_ini.get<bool>("LargeScale.saveTemporaryBinFiles", false);
+    mvsUtils::DepthMapsCache::getInstance().setMaxMemory(mp->_ini.get<int>("depth_maps_cache.maxmbCPU", 4000));
 
     GEO::initialize();
     _tetrahedralization = GEO::Delaunay::create(3, "BDEL");
@@ -810,27 +810,31 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
         #pragma omp parallel for num_threads(3)
         for(int c = 0; c < cams.size(); c++)
         {
-            std::vector<float> depthMap;
+            // depth and sim maps are read through the depth maps cache, they are read again by createVerticesWithVisibilities
+            mvsUtils::DepthMapsCache& depthMapsCache = mvsUtils::DepthMapsCache::getInstance();
             std::vector<float> simMap;
             std::vector<unsigned char> numOfModalsMap;
             int width, height;
+
+            const std::string depthMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::depthMap, 0);
+            const mvsUtils::DepthMapsCache::MapConstPtr depthMapPtr = depthMapsCache.get(depthMapFilepath);
+            const std::vector<float>& depthMap = depthMapPtr->data;
+            width = depthMapPtr->width;
+            height = depthMapPtr->height;
+            if(depthMap.empty())
+            {
+                ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
+                continue;
+            }
             {
-                const std::string depthMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::depthMap, 0);
-                imageIO::readImage(depthMapFilepath, width, height, depthMap);
-                if(depthMap.empty())
-                {
-                    ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
-                    continue;
-                }
                 int wTmp, hTmp;
                 const std::string simMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::simMap, 0);
-                imageIO::readImage(simMapFilepath, wTmp, hTmp, simMap);
-                if(wTmp != width || hTmp != height)
-                    throw std::runtime_error("Wrong sim map dimensions: " + simMapFilepath);
                 {
-                    std::vector<float> simMapTmp(simMap.size());
-                    imageIO::convolveImage(width, height, simMap, simMapTmp, "gaussian", params.simGaussianSizeInit, params.simGaussianSizeInit);
-                    simMap.swap(simMapTmp);
+                    const mvsUtils::DepthMapsCache::MapConstPtr simMapPtr = depthMapsCache.get(simMapFilepath);
+                    if(simMapPtr->width != width || simMapPtr->height != height)
+                        throw std::runtime_error("Wrong sim map dimensions: " + simMapFilepath);
+                    simMap.resize(simMapPtr->data.size());
+                    imageIO::convolveImage(width, height, simMapPtr->data, simMap, "gaussian", params.simGaussianSizeInit, params.simGaussianSizeInit);
                 }
 
                 const std::string nmodMapFilepath = mv_getFileName(mp, c, mvsUtils::EFileType::nmodMap, 0);
@@ -1034,6 +1038,9 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
     _verticesCoords.swap(verticesCoordsPrepare);
     _verticesAttr.swap(verticesAttrPrepare);
 
+    // release the cached maps before the tetrahedralization and the graph cut
+    mvsUtils::DepthMapsCache::getInstance().clear();
+
     if(_verticesCoords.size() == 0)
         throw std::runtime_error("Depth map fusion gives an empty result.");
 
@@ -2477,8 +2484,7 @@ void DelaunayGraphCut::maxflow()
     long t_maxflow = clock();
 
     ALICEVISION_LOG_INFO("Maxflow: start allocation.");
-    // MaxFlow_CSR maxFlowGraph(_cellsAttr.size());
-    MaxFlow_AdjList maxFlowGraph(_cellsAttr.size());
+    MaxFlow_Tetrahedra maxFlowGraph(_cellsAttr.size());
 
     ALICEVISION_LOG_INFO("Maxflow: add nodes.");
     // fill s-t edges
@@ -2529,7 +2535,7 @@ void DelaunayGraphCut::maxflow()
             assert(!std::isnan(wFvFu));
             assert(!std::isnan(wFuFv));
 
-            maxFlowGraph.addEdge(fu.cellIndex, fv.cellIndex, wFuFv, wFvFu);
+            maxFlowGraph.addEdge(fu.cellIndex, fu.localVertexIndex, fv.cellIndex, fv.localVertexIndex, wFuFv, wFvFu);
         }
     }
 
@@ -2540,7 +2546,9 @@ void DelaunayGraphCut::maxflow()
     long t_maxflow_compute = clock();
     // Find graph-cut solution
     ALICEVISION_LOG_INFO("Maxflow: compute.");
-    const float totalFlow = maxFlowGraph.compute();
+    const bool maxflowParallel = mp->_ini.get<bool>("delaunaycut.maxflowParallel", false);
+    const float totalFlow = maxFlowGraph.compute(maxflowParallel ? MaxFlow_Tetrahedra::ESolver::PUSH_RELABEL_PARALLEL
+                                                                 : MaxFlow_Tetrahedra::ESolver::BOYKOV_KOLMOGOROV);
     mvsUtils::printfElapsedTime(t_maxflow_compute, "Maxflow computation ");
     ALICEVISION_LOG_INFO("totalFlow: " << totalFlow);
 
@@ -11,6 +11,7 @@
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Stat3d.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/mvsUtils/DepthMapsCache.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
 #include <aliceVision/imageIO/image.hpp>
 #include <aliceVision/imageIO/imageScaledColors.hpp>
@@ -20,6 +21,9 @@
 #include <boost/accumulators/statistics.hpp>
 
 #include <iostream>
+#include <map>
+#include <memory>
+#include <queue>
 
 namespace aliceVision {
 namespace fuseCut {
@@ -47,7 +51,6 @@ unsigned long computeNumberOfAllPoints(const mvsUtils::MultiViewParams* mp, int
             ALICEVISION_LOG_WARNING("Can't find or invalid 'nbDepthValues' metadata in '" << filename << "'. Recompute the number of valid values.");
 
             imageIO::readImage(mvsUtils::mv_getFileName(mp, rc, mvsUtils::EFileType::depthMap, scale), width, height, depthMap.getDataWritable());
-            // no need to transpose for this operation
             for(int i = 0; i < sizeOfStaticVector<float>(&depthMap); ++i)
                 nbDepthValues += static_cast<unsigned long>(depthMap[i] > 0.0f);
         }
@@ -61,6 +64,7 @@ Fuser::Fuser(const mvsUtils::MultiViewParams* _mp, mvsUtils::PreMatchCams* _pc)
   : mp(_mp)
   , pc(_pc)
 {
+    mvsUtils::DepthMapsCache::getInstance().setMaxMemory(mp->_ini.get<int>("depth_maps_cache.maxmbCPU", 4000));
 }
 
 Fuser::~Fuser()
@@ -77,12 +81,12 @@ Fuser::~Fuser()
  * @param[in]
  * @param[in]
  * @param[out] numOfPtsMap
- * @param[in] depthMap
- * @param[in] simMap
+ * @param[in] depthMap (row-major)
+ * @param[in] simMap (row-major)
  * @param[in] scale
  */
 bool Fuser::updateInSurr(int pixSizeBall, int pixSizeBallWSP, Point3d& p, int rc, int tc,
-                           StaticVector<int>* numOfPtsMap, StaticVector<float>* depthMap, StaticVector<float>* simMap,
+                           StaticVector<int>* numOfPtsMap, const std::vector<float>& depthMap, const std::vector<float>& simMap,
                            int scale)
 {
     int w = mp->getWidth(rc) / scale;
@@ -103,7 +107,7 @@ bool Fuser::updateInSurr(int pixSizeBall, int pixSizeBallWSP, Point3d& p, int rc
 
     int d = pixSizeBall;
 
-    float sim = (*simMap)[cell.x * h + cell.y];
+    float sim = simMap[cell.y * w + cell.x];
     if(sim >= 1.0f)
     {
         d = pixSizeBallWSP;
@@ -118,13 +122,13 @@ bool Fuser::updateInSurr(int pixSizeBall, int pixSizeBallWSP, Point3d& p, int rc
         for(ncell.y = std::max(0, cell.y - d); ncell.y <= std::min(h - 1, cell.y + d); ncell.y++)
         {
             // printf("%i %i %i %i %i %i %i %i\n",ncell.x,ncell.y,w,h,w*h,depthMap->size(),cam,scale);
-            float depth = (*depthMap)[ncell.x * h + ncell.y];
+            float depth = depthMap[ncell.y * w + ncell.x];
             // Point3d p1 = mp->CArr[rc] +
             // (mp->iCamArr[rc]*Point2d((float)ncell.x*(float)scale,(float)ncell.y*(float)scale)).normalize()*depth;
             // if ( (p1-p).size() < pixSize ) {
             if(fabs(pixDepth - depth) < pixSize)
             {
-                (*numOfPtsMap)[ncell.x * h + ncell.y]++;
+                (*numOfPtsMap)[ncell.y * w + ncell.x]++;
             }
         }
     }
@@ -132,15 +136,66 @@ bool Fuser::updateInSurr(int pixSizeBall, int pixSizeBallWSP, Point3d& p, int rc
     return true;
 }
 
+std::vector<int> Fuser::getNeighbourhoodOrder(const StaticVector<int>& cams, int nNearestCams) const
+{
+    std::vector<StaticVector<int>> neighbours(cams.size());
+    std::map<int, int> camIndexes; // <camera, index in cams>
+
+#pragma omp parallel for
+    for(int c = 0; c < cams.size(); c++)
+        neighbours[c] = pc->findNearestCamsFromSeeds(cams[c], nNearestCams);
+
+    for(int c = 0; c < cams.size(); c++)
+        camIndexes[cams[c]] = c;
+
+    // breadth-first traversal of the neighbourhood graph
+    std::vector<int> orderedCams;
+    std::vector<bool> visited(cams.size(), false);
+    orderedCams.reserve(cams.size());
+
+    for(int start = 0; start < cams.size(); start++)
+    {
+        if(visited[start])
+            continue;
+
+        std::queue<int> queue;
+        queue.push(start);
+        visited[start] = true;
+
+        while(!queue.empty())
+        {
+            const int c = queue.front();
+            queue.pop();
+            orderedCams.push_back(cams[c]);
+
+            for(int i = 0; i < neighbours[c].size(); i++)
+            {
+                const auto it = camIndexes.find(neighbours[c][i]);
+                if(it != camIndexes.end() && !visited[it->second])
+                {
+                    visited[it->second] = true;
+                    queue.push(it->second);
+                }
+            }
+        }
+    }
+    return orderedCams;
+}
+
 // minNumOfModals number of other cams including this cam ... minNumOfModals /in 2,3,...
 void Fuser::filterGroups(const StaticVector<int>& cams, int pixSizeBall, int pixSizeBallWSP, int nNearestCams)
 {
     ALICEVISION_LOG_INFO("Precomputing groups.");
     long t1 = clock();
-#pragma omp parallel for
-    for(int c = 0; c < cams.size(); c++)
+
+    // the cameras processed at the same time share most of their neighbours,
+    // so their depth maps are read once in the depth maps cache
+    const std::vector<int> orderedCams = getNeighbourhoodOrder(cams, nNearestCams);
+
+#pragma omp parallel for schedule(dynamic)
+    for(int c = 0; c < orderedCams.size(); c++)
     {
-        int rc = cams[c];
+        int rc = orderedCams[c];
         filterGroupsRC(rc, pixSizeBall, pixSizeBallWSP, nNearestCams);
     }
 
@@ -159,18 +214,13 @@ bool Fuser::filterGroupsRC(int rc, int pixSizeBall, int pixSizeBallWSP, int nNea
     int w = mp->getWidth(rc);
     int h = mp->getHeight(rc);
 
-    StaticVector<float> depthMap;
-    StaticVector<float> simMap;
+    mvsUtils::DepthMapsCache& depthMapsCache = mvsUtils::DepthMapsCache::getInstance();
 
-    {
-        int width, height;
-
-        imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::depthMap, 1), width, height, depthMap.getDataWritable());
-        imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::simMap, 1), width, height, simMap.getDataWritable());
-
-        imageIO::transposeImage(width, height, depthMap.getDataWritable());
-        imageIO::transposeImage(width, height, simMap.getDataWritable());
-    }
+    // depth and sim maps, row-major
+    const mvsUtils::DepthMapsCache::MapConstPtr depthMapPtr = depthMapsCache.get(mv_getFileName(mp, rc, mvsUtils::EFileType::depthMap, 1));
+    const mvsUtils::DepthMapsCache::MapConstPtr simMapPtr = depthMapsCache.get(mv_getFileName(mp, rc, mvsUtils::EFileType::simMap, 1));
+    const std::vector<float>& depthMap = depthMapPtr->data;
+    const std::vector<float>& simMap = simMapPtr->data;
 
     std::vector<unsigned char> numOfModalsMap(w * h, 0);
 
@@ -194,28 +244,19 @@ bool Fuser::filterGroupsRC(int rc, int pixSizeBall, int pixSizeBallWSP, int nNea
         numOfPtsMap->resize_with(w * h, 0);
         int tc = tcams[c];
 
-        StaticVector<float> tcdepthMap;
+        const mvsUtils::DepthMapsCache::MapConstPtr tcdepthMap = depthMapsCache.get(mv_getFileName(mp, tc, mvsUtils::EFileType::depthMap, 1));
 
+        if(!tcdepthMap->data.empty())
         {
-            int width, height;
-
-            imageIO::readImage(mv_getFileName(mp, tc, mvsUtils::EFileType::depthMap, 1), width, height, tcdepthMap.getDataWritable());
-
-            // transpose image in-place, width/height are no more valid after this function.
-            imageIO::transposeImage(width, height, tcdepthMap.getDataWritable());
-        }
-
-        if(!tcdepthMap.empty())
-        {
-            for(int i = 0; i < sizeOfStaticVector<float>(&tcdepthMap); i++)
+            for(int i = 0; i < tcdepthMap->data.size(); i++)
             {
-                int x = i / h;
-                int y = i % h;
-                float depth = tcdepthMap[i];
+                int x = i % tcdepthMap->width;
+                int y = i / tcdepthMap->width;
+                float depth = tcdepthMap->data[i];
                 if(depth > 0.0f)
                 {
                     Point3d p = mp->CArr[tc] + (mp->iCamArr[tc] * Point2d((float)x, (float)y)).normalize() * depth;
-                    updateInSurr(pixSizeBall, pixSizeBallWSP, p, rc, tc, numOfPtsMap, &depthMap, &simMap, 1);
+                    updateInSurr(pixSizeBall, pixSizeBallWSP, p, rc, tc, numOfPtsMap, depthMap, simMap, 1);
                 }
             }
 
@@ -226,10 +267,7 @@ bool Fuser::filterGroupsRC(int rc, int pixSizeBall, int pixSizeBallWSP, int nNea
         }
     }
 
-    {
-      imageIO::transposeImage(h, w, numOfModalsMap);
-      imageIO::writeImage(mv_getFileName(mp, rc, mvsUtils::EFileType::nmodMap), w, h, numOfModalsMap);
-    }
+    imageIO::writeImage(mv_getFileName(mp, rc, mvsUtils::EFileType::nmodMap), w, h, numOfModalsMap);
 
     delete numOfPtsMap;
 
@@ -254,6 +292,9 @@ void Fuser::filterDepthMaps(const StaticVector<int>& cams, int minNumOfModals, i
         filterDepthMapsRC(rc, minNumOfModals, minNumOfModalsWSP2SSP);
     }
 
+    // the scale 1 maps are not used anymore by this process
+    mvsUtils::DepthMapsCache::getInstance().clear();
+
     mvsUtils::printfElapsedTime(t1);
 }
 
@@ -264,20 +305,16 @@ bool Fuser::filterDepthMapsRC(int rc, int minNumOfModals, int minNumOfModalsWSP2
     int w = mp->getWidth(rc);
     int h = mp->getHeight(rc);
 
-    std::vector<float> depthMap;
-    std::vector<float> simMap;
+    mvsUtils::DepthMapsCache& depthMapsCache = mvsUtils::DepthMapsCache::getInstance();
+
+    // filtered copies of the cached maps, all the maps are row-major
+    std::vector<float> depthMap = depthMapsCache.get(mv_getFileName(mp, rc, mvsUtils::EFileType::depthMap, 1))->data;
+    std::vector<float> simMap = depthMapsCache.get(mv_getFileName(mp, rc, mvsUtils::EFileType::simMap, 1))->data;
     std::vector<unsigned char> numOfModalsMap;
 
     {
         int width, height;
-
-        imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::depthMap, 1), width, height, depthMap);
-        imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::simMap, 1), width, height, simMap);
         imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::nmodMap), width, height, numOfModalsMap);
-
-        imageIO::transposeImage(width, height, depthMap);
-        imageIO::transposeImage(width, height, simMap);
-        imageIO::transposeImage(width, height, numOfModalsMap);
     }
 
     int nbDepthValues = 0;
@@ -310,9 +347,6 @@ bool Fuser::filterDepthMapsRC(int rc, int minNumOfModals, int minNumOfModalsWSP2
           ++nbDepthValues;
     }
 
-    imageIO::transposeImage(h, w, depthMap);
-    imageIO::transposeImage(h, w, simMap);
-
     oiio::ParamValueList metadata;
     metadata.push_back(oiio::ParamValue("AliceVision:nbDepthValues", oiio::TypeDesc::INT32, 1, &nbDepthValues));
     metadata.push_back(oiio::ParamValue("AliceVision:downscale", mp->getDownscaleFactor(rc)));
@@ -352,20 +386,17 @@ float Fuser::computeAveragePixelSizeInHexahedron(Point3d* hexah, int step, int s
     for(int c = 0; c < cams.size(); c++)
     {
         int rc = cams[c];
-        int h = mp->getHeight(rc) / scaleuse;
+        int w = mp->getWidth(rc) / scaleuse;
         StaticVector<float> rcdepthMap;
         {
             int width, height;
-
             imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::depthMap, scale), width, height, rcdepthMap.getDataWritable());
-
-            imageIO::transposeImage(width, height, rcdepthMap.getDataWritable());
         }
 
         for(int i = 0; i < rcdepthMap.size(); i++)
         {
-            int x = i / h;
-            int y = i % h;
+            int x = i % w;
+            int y = i / w;
             float depth = rcdepthMap[i];
             if(depth > 0.0f)
             {
@@ -417,21 +448,18 @@ void Fuser::divideSpace(Point3d* hexah, float& minPixSize)
     Stat3d s3d = Stat3d();
     for(int rc = 0; rc < mp->ncams; rc++)
     {
-        int h = mp->getHeight(rc);
+        int w = mp->getWidth(rc);
 
         StaticVector<float> depthMap;
         {
             int width, height;
-
             imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::depthMap, scale), width, height, depthMap.getDataWritable());
-
-            imageIO::transposeImage(width, height, depthMap.getDataWritable());
         }
 
         for(int i = 0; i < sizeOfStaticVector<float>(&depthMap); i += stepPts)
         {
-            int x = i / h;
-            int y = i % h;
+            int x = i % w;
+            int y = i / w;
             float depth = depthMap[i];
             if(depth > 0.0f)
             {
@@ -463,21 +491,18 @@ void Fuser::divideSpace(Point3d* hexah, float& minPixSize)
 
     for(int rc = 0; rc < mp->ncams; ++rc)
     {
-        int h = mp->getHeight(rc);
+        int w = mp->getWidth(rc);
 
         StaticVector<float> depthMap;
         {
             int width, height;
-
             imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::depthMap, scale), width, height, depthMap.getDataWritable());
-
-            imageIO::transposeImage(width, height, depthMap.getDataWritable());
         }
 
         for(int i = 0; i < depthMap.size(); i += stepPts)
         {
-            int x = i / h;
-            int y = i % h;
+            int x = i % w;
+            int y = i / w;
             float depth = depthMap[i];
             if(depth > 0.0f)
             {
@@ -620,9 +645,6 @@ std::string generateTempPtsSimsFiles(std::string tmpDir, mvsUtils::MultiViewPara
 
                 imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::depthMap, scale), width, height, depthMap.getDataWritable());
                 imageIO::readImage(mv_getFileName(mp, rc, mvsUtils::EFileType::simMap, scale), width, height, simMap.getDataWritable());
-
-                imageIO::transposeImage(width, height, depthMap.getDataWritable());
-                imageIO::transposeImage(width, height, simMap.getDataWritable());
             }
 
             if(addRandomNoise)
@@ -646,8 +668,8 @@ std::string generateTempPtsSimsFiles(std::string tmpDir, mvsUtils::MultiViewPara
                 for(int id = 0; id < idsAlive->size(); id++)
                 {
                     int i = (*idsAlive)[(*randIdsAlive)[id]];
-                    int x = i / h;
-                    int y = i % h;
+                    int x = i % w;
+                    int y = i / w;
                     double depth = depthMap[i];
 
                     double sim = simMap[i];
@@ -705,7 +727,7 @@ std::string generateTempPtsSimsFiles(std::string tmpDir, mvsUtils::MultiViewPara
                 {
                     for(int y = 0; y < h; y++)
                     {
-                        int i = x * h + y;
+                        int i = y * w + x;
                         double depth = depthMap[i];
                         double sim = simMap[i];
                         if(depth > 0.0f)
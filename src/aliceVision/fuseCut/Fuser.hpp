@@ -12,6 +12,8 @@
 #include <aliceVision/mvsData/Voxel.hpp>
 #include <aliceVision/mvsUtils/PreMatchCams.hpp>
 
+#include <vector>
+
 namespace aliceVision {
 namespace fuseCut {
 
@@ -43,7 +45,10 @@ public:
 
 private:
     bool updateInSurr(int pixSizeBall, int pixSizeBallWSP, Point3d& p, int rc, int tc, StaticVector<int>* numOfPtsMap,
-                      StaticVector<float>* depthMap, StaticVector<float>* simMap, int scale);
+                      const std::vector<float>& depthMap, const std::vector<float>& simMap, int scale);
+
+    /// @return the cameras ordered by a breadth-first traversal of their neighbourhood graph
+    std::vector<int> getNeighbourhoodOrder(const StaticVector<int>& cams, int nNearestCams) const;
 };
 
 std::string generateTempPtsSimsFiles(std::string tmpDir, mvsUtils::MultiViewParams* mp, bool addRandomNoise = false,
@@ -0,0 +1,811 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MaxFlow_Tetrahedra.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <limits>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace fuseCut {
+
+namespace {
+
+const MaxFlow_Tetrahedra::NodeType noNode = std::numeric_limits<MaxFlow_Tetrahedra::NodeType>::max();
+
+// special values of the Boykov-Kolmogorov parent arcs
+const MaxFlow_Tetrahedra::ArcType noParent = std::numeric_limits<MaxFlow_Tetrahedra::ArcType>::max();
+const MaxFlow_Tetrahedra::ArcType terminalParent = noParent - 1;
+const MaxFlow_Tetrahedra::ArcType orphanParent = noParent - 2;
+const MaxFlow_Tetrahedra::ArcType noArc = noParent - 3;
+
+const int infiniteDist = std::numeric_limits<int>::max();
+
+/// Push-relabel: number of discharged nodes (relative to the number of nodes) between two global relabelings
+const double globalRelabelFrequency = 1.0;
+
+/**
+ * @brief Concatenate the per-thread node lists.
+ */
+void gatherNodes(std::vector<std::vector<MaxFlow_Tetrahedra::NodeType>>& threadNodes,
+                 std::vector<MaxFlow_Tetrahedra::NodeType>& nodes)
+{
+    nodes.clear();
+    for(auto& tn : threadNodes)
+    {
+        nodes.insert(nodes.end(), tn.begin(), tn.end());
+        tn.clear();
+    }
+}
+
+} // namespace
+
+MaxFlow_Tetrahedra::MaxFlow_Tetrahedra(std::size_t numNodes)
+    : _numNodes(numNodes)
+{
+    if(numNodes * 4 >= noArc || numNodes >= static_cast<std::size_t>(std::numeric_limits<int>::max()))
+        throw std::runtime_error("MaxFlow_Tetrahedra: too many nodes (" + std::to_string(numNodes) + ").");
+
+    _arcHead.resize(numNodes * 4, noNode);
+    _arcMirror.resize(numNodes * 4, 0);
+    _residual.resize(numNodes * 4, 0.0f);
+    _terminalResidual.resize(numNodes, 0.0f);
+
+    updatePeakMemoryUsage(0);
+}
+
+std::size_t MaxFlow_Tetrahedra::getGraphMemoryUsage() const
+{
+    return _arcHead.capacity() * sizeof(NodeType) +
+           _arcMirror.capacity() * sizeof(unsigned char) +
+           _residual.capacity() * sizeof(ValueType) +
+           _terminalResidual.capacity() * sizeof(ValueType) +
+           _isTarget.capacity() / 8;
+}
+
+void MaxFlow_Tetrahedra::updatePeakMemoryUsage(std::size_t solverMemoryUsage)
+{
+    _peakMemoryUsage = std::max(_peakMemoryUsage, getGraphMemoryUsage() + solverMemoryUsage);
+}
+
+MaxFlow_Tetrahedra::ValueType MaxFlow_Tetrahedra::compute(ESolver solver)
+{
+    ALICEVISION_LOG_INFO("# vertices: " << _numNodes << ", # arcs: " << _arcHead.size());
+
+    double flow = 0.0;
+    if(solver == ESolver::PUSH_RELABEL_PARALLEL)
+    {
+        ALICEVISION_LOG_INFO("Compute parallel push-relabel max flow (" << omp_get_max_threads() << " threads).");
+        flow = computePushRelabel();
+    }
+    else
+    {
+        ALICEVISION_LOG_INFO("Compute boykov_kolmogorov_max_flow.");
+        flow = computeBoykovKolmogorov();
+    }
+
+    std::size_t nbTargets = 0;
+    for(std::size_t n = 0; n < _numNodes; ++n)
+    {
+        if(_isTarget[n])
+            ++nbTargets;
+    }
+    ALICEVISION_LOG_INFO("# full (target) nodes: " << nbTargets << ", # empty (source) nodes: " << (_numNodes - nbTargets));
+    ALICEVISION_LOG_INFO("Maxflow peak memory usage: " << (_peakMemoryUsage / (1024 * 1024)) << " MB.");
+
+    return static_cast<ValueType>(flow);
+}
+
+// ---------------------------------------------------------------------------
+// Boykov-Kolmogorov
+//
+// Y. Boykov and V. Kolmogorov, "An Experimental Comparison of Min-Cut/Max-Flow
+// Algorithms for Energy Minimization in Vision", PAMI 2004.
+// The parent of a node is the arc from this node to its parent in the search tree.
+// ---------------------------------------------------------------------------
+
+void MaxFlow_Tetrahedra::bkSetActive(NodeType n)
+{
+    // the last node of the queue points to itself
+    if(_bkNext[n] != noNode)
+        return;
+    if(_bkQueueLast != noNode)
+        _bkNext[_bkQueueLast] = n;
+    else
+        _bkQueueFirst = n;
+    _bkQueueLast = n;
+    _bkNext[n] = n;
+}
+
+MaxFlow_Tetrahedra::NodeType MaxFlow_Tetrahedra::bkNextActive()
+{
+    while(_bkQueueFirst != noNode)
+    {
+        const NodeType n = _bkQueueFirst;
+        if(_bkNext[n] == n)
+            _bkQueueFirst = _bkQueueLast = noNode;
+        else
+            _bkQueueFirst = _bkNext[n];
+        _bkNext[n] = noNode;
+
+        // skip the nodes which became free
+        if(_bkParent[n] != noParent)
+            return n;
+    }
+    return noNode;
+}
+
+double MaxFlow_Tetrahedra::bkAugment(ArcType middleArc)
+{
+    // find the bottleneck capacity
+    ValueType bottleneck = _residual[middleArc];
+
+    NodeType n = middleArc / 4; // source tree
+    for(;;)
+    {
+        const ArcType a = _bkParent[n];
+        if(a == terminalParent)
+            break;
+        bottleneck = std::min(bottleneck, _residual[getReverseArc(a)]);
+        n = _arcHead[a];
+    }
+    bottleneck = std::min(bottleneck, _terminalResidual[n]);
+
+    n = _arcHead[middleArc]; // sink tree
+    for(;;)
+    {
+        const ArcType a = _bkParent[n];
+        if(a == terminalParent)
+            break;
+        bottleneck = std::min(bottleneck, _residual[a]);
+        n = _arcHead[a];
+    }
+    bottleneck = std::min(bottleneck, -_terminalResidual[n]);
+
+    // augment
+    _residual[getReverseArc(middleArc)] += bottleneck;
+    _residual[middleArc] -= bottleneck;
+
+    n = middleArc / 4; // source tree
+    for(;;)
+    {
+        const ArcType a = _bkParent[n];
+        if(a == terminalParent)
+            break;
+        const ArcType reverseArc = getReverseArc(a);
+        _residual[a] += bottleneck;
+        _residual[reverseArc] -= bottleneck;
+        if(_residual[reverseArc] == 0)
+        {
+            _bkParent[n] = orphanParent;
+            _bkOrphans.push_front(n);
+        }
+        n = _arcHead[a];
+    }
+    _terminalResidual[n] -= bottleneck;
+    if(_terminalResidual[n] == 0)
+    {
+        _bkParent[n] = orphanParent;
+        _bkOrphans.push_front(n);
+    }
+
+    n = _arcHead[middleArc]; // sink tree
+    for(;;)
+    {
+        const ArcType a = _bkParent[n];
+        if(a == terminalParent)
+            break;
+        _residual[getReverseArc(a)] += bottleneck;
+        _residual[a] -= bottleneck;
+        if(_residual[a] == 0)
+        {
+            _bkParent[n] = orphanParent;
+            _bkOrphans.push_front(n);
+        }
+        n = _arcHead[a];
+    }
+    _terminalResidual[n] += bottleneck;
+    if(_terminalResidual[n] == 0)
+    {
+        _bkParent[n] = orphanParent;
+        _bkOrphans.push_front(n);
+    }
+
+    return bottleneck;
+}
+
+void MaxFlow_Tetrahedra::bkProcessSourceOrphan(NodeType n)
+{
+    ArcType minArc = noArc;
+    int minDist = infiniteDist;
+
+    // try to find a new valid parent
+    for(int k = 0; k < 4; ++k)
+    {
+        const ArcType a0 = getArc(n, k);
+        NodeType j = _arcHead[a0];
+        if(j == noNode || !(_residual[getReverseArc(a0)] > 0))
+            continue;
+        if(_bkIsSink[j] || _bkParent[j] == noParent)
+            continue;
+
+        // check the origin of j
+        int d = 0;
+        for(;;)
+        {
+            if(_bkTimestamp[j] == _bkTime)
+            {
+                d += _bkDist[j];
+                break;
+            }
+            const ArcType a = _bkParent[j];
+            ++d;
+            if(a == terminalParent)
+            {
+                _bkTimestamp[j] = _bkTime;
+                _bkDist[j] = 1;
+                break;
+            }
+            if(a == orphanParent)
+            {
+                d = infiniteDist;
+                break;
+            }
+            j = _arcHead[a];
+        }
+
+        if(d < infiniteDist) // j originates from the source
+        {
+            if(d < minDist)
+            {
+                minArc = a0;
+                minDist = d;
+            }
+            // set the marks along the path
+            for(j = _arcHead[a0]; _bkTimestamp[j] != _bkTime; j = _arcHead[_bkParent[j]])
+            {
+                _bkTimestamp[j] = _bkTime;
+                _bkDist[j] = d--;
+            }
+        }
+    }
+
+    if(minArc != noArc)
+    {
+        _bkParent[n] = minArc;
+        _bkTimestamp[n] = _bkTime;
+        _bkDist[n] = minDist + 1;
+        return;
+    }
+
+    // no parent found, process the neighbors
+    _bkParent[n] = noParent;
+    for(int k = 0; k < 4; ++k)
+    {
+        const ArcType a0 = getArc(n, k);
+        const NodeType j = _arcHead[a0];
+        if(j == noNode || _bkIsSink[j])
+            continue;
+        const ArcType a = _bkParent[j];
+        if(a == noParent)
+            continue;
+        if(_residual[getReverseArc(a0)] > 0)
+            bkSetActive(j);
+        if(a != terminalParent && a != orphanParent && _arcHead[a] == n)
+        {
+            _bkParent[j] = orphanParent;
+            _bkOrphans.push_back(j);
+        }
+    }
+}
+
+void MaxFlow_Tetrahedra::bkProcessSinkOrphan(NodeType n)
+{
+    ArcType minArc = noArc;
+    int minDist = infiniteDist;
+
+    // try to find a new valid parent
+    for(int k = 0; k < 4; ++k)
+    {
+        const ArcType a0 = getArc(n, k);
+        NodeType j = _arcHead[a0];
+        if(j == noNode || !(_residual[a0] > 0))
+            continue;
+        if(!_bkIsSink[j] || _bkParent[j] == noParent)
+            continue;
+
+        // check the origin of j
+        int d = 0;
+        for(;;)
+        {
+            if(_bkTimestamp[j] == _bkTime)
+            {
+                d += _bkDist[j];
+                break;
+            }
+            const ArcType a = _bkParent[j];
+            ++d;
+            if(a == terminalParent)
+            {
+                _bkTimestamp[j] = _bkTime;
+                _bkDist[j] = 1;
+                break;
+            }
+            if(a == orphanParent)
+            {
+                d = infiniteDist;
+                break;
+            }
+            j = _arcHead[a];
+        }
+
+        if(d < infiniteDist) // j originates from the sink
+        {
+            if(d < minDist)
+            {
+                minArc = a0;
+                minDist = d;
+            }
+            // set the marks along the path
+            for(j = _arcHead[a0]; _bkTimestamp[j] != _bkTime; j = _arcHead[_bkParent[j]])
+            {
+                _bkTimestamp[j] = _bkTime;
+                _bkDist[j] = d--;
+            }
+        }
+    }
+
+    if(minArc != noArc)
+    {
+        _bkParent[n] = minArc;
+        _bkTimestamp[n] = _bkTime;
+        _bkDist[n] = minDist + 1;
+        return;
+    }
+
+    // no parent found, process the neighbors
+    _bkParent[n] = noParent;
+    for(int k = 0; k < 4; ++k)
+    {
+        const ArcType a0 = getArc(n, k);
+        const NodeType j = _arcHead[a0];
+        if(j == noNode || !_bkIsSink[j])
+            continue;
+        const ArcType a = _bkParent[j];
+        if(a == noParent)
+            continue;
+        if(_residual[a0] > 0)
+            bkSetActive(j);
+        if(a != terminalParent && a != orphanParent && _arcHead[a] == n)
+        {
+            _bkParent[j] = orphanParent;
+            _bkOrphans.push_back(j);
+        }
+    }
+}
+
+double MaxFlow_Tetrahedra::computeBoykovKolmogorov()
+{
+    _bkParent.assign(_numNodes, noParent);
+    _bkNext.assign(_numNodes, noNode);
+    _bkTimestamp.assign(_numNodes, 0);
+    _bkDist.assign(_numNodes, 0);
+    _bkIsSink.assign(_numNodes, false);
+    _bkQueueFirst = _bkQueueLast = noNode;
+    _bkTime = 0;
+
+    const std::size_t solverMemoryUsage = _bkParent.capacity() * sizeof(ArcType) +
+                                          _bkNext.capacity() * sizeof(NodeType) +
+                                          _bkTimestamp.capacity() * sizeof(int) +
+                                          _bkDist.capacity() * sizeof(int) +
+                                          _bkIsSink.capacity() / 8;
+    updatePeakMemoryUsage(solverMemoryUsage);
+
+    for(NodeType n = 0; n < _numNodes; ++n)
+    {
+        if(_terminalResidual[n] == 0)
+            continue;
+        _bkIsSink[n] = (_terminalResidual[n] < 0);
+        _bkParent[n] = terminalParent;
+        _bkDist[n] = 1;
+        bkSetActive(n);
+    }
+
+    double flow = _flow;
+    std::size_t maxNbOrphans = 0;
+    NodeType currentNode = noNode;
+
+    for(;;)
+    {
+        NodeType n = currentNode;
+        if(n != noNode)
+        {
+            _bkNext[n] = noNode; // remove the active flag
+            if(_bkParent[n] == noParent)
+                n = noNode;
+        }
+        if(n == noNode)
+        {
+            n = bkNextActive();
+            if(n == noNode)
+                break;
+        }
+
+        // growth
+        ArcType middleArc = noArc;
+        if(!_bkIsSink[n])
+        {
+            for(int k = 0; k < 4; ++k)
+            {
+                const ArcType a = getArc(n, k);
+                const NodeType j = _arcHead[a];
+                if(j == noNode || !(_residual[a] > 0))
+                    continue;
+                if(_bkParent[j] == noParent)
+                {
+                    _bkIsSink[j] = false;
+                    _bkParent[j] = getReverseArc(a);
+                    _bkTimestamp[j] = _bkTimestamp[n];
+                    _bkDist[j] = _bkDist[n] + 1;
+                    bkSetActive(j);
+                }
+                else if(_bkIsSink[j])
+                {
+                    middleArc = a;
+                    break;
+                }
+                else if(_bkTimestamp[j] <= _bkTimestamp[n] && _bkDist[j] > _bkDist[n])
+                {
+                    // heuristic: trying to make the distance from j to the source shorter
+                    _bkParent[j] = getReverseArc(a);
+                    _bkTimestamp[j] = _bkTimestamp[n];
+                    _bkDist[j] = _bkDist[n] + 1;
+                }
+            }
+        }
+        else
+        {
+            for(int k = 0; k < 4; ++k)
+            {
+                const ArcType a = getArc(n, k);
+                const NodeType j = _arcHead[a];
+                if(j == noNode)
+                    continue;
+                const ArcType reverseArc = getReverseArc(a);
+                if(!(_residual[reverseArc] > 0))
+                    continue;
+                if(_bkParent[j] == noParent)
+                {
+                    _bkIsSink[j] = true;
+                    _bkParent[j] = reverseArc;
+                    _bkTimestamp[j] = _bkTimestamp[n];
+                    _bkDist[j] = _bkDist[n] + 1;
+                    bkSetActive(j);
+                }
+                else if(!_bkIsSink[j])
+                {
+                    middleArc = reverseArc;
+                    break;
+                }
+                else if(_bkTimestamp[j] <= _bkTimestamp[n] && _bkDist[j] > _bkDist[n])
+                {
+                    // heuristic: trying to make the distance from j to the sink shorter
+                    _bkParent[j] = reverseArc;
+                    _bkTimestamp[j] = _bkTimestamp[n];
+                    _bkDist[j] = _bkDist[n] + 1;
+                }
+            }
+        }
+
+        ++_bkTime;
+
+        if(middleArc == noArc)
+        {
+            currentNode = noNode;
+            continue;
+        }
+
+        // keep the current node active to continue its growth after the augmentation
+        _bkNext[n] = n;
+        currentNode = n;
+
+        flow += bkAugment(middleArc);
+
+        // adoption
+        maxNbOrphans = std::max(maxNbOrphans, _bkOrphans.size());
+        while(!_bkOrphans.empty())
+        {
+            const NodeType orphan = _bkOrphans.front();
+            _bkOrphans.pop_front();
+            if(_bkIsSink[orphan])
+                bkProcessSinkOrphan(orphan);
+            else
+                bkProcessSourceOrphan(orphan);
+        }
+    }
+    updatePeakMemoryUsage(solverMemoryUsage + maxNbOrphans * sizeof(NodeType));
+
+    // the sink tree contains all the nodes that can reach the target in the residual graph
+    _isTarget.resize(_numNodes);
+    for(NodeType n = 0; n < _numNodes; ++n)
+        _isTarget[n] = (_bkParent[n] != noParent && _bkIsSink[n]);
+
+    // release the solver memory
+    std::vector<ArcType>().swap(_bkParent);
+    std::vector<NodeType>().swap(_bkNext);
+    std::vector<int>().swap(_bkTimestamp);
+    std::vector<int>().swap(_bkDist);
+    std::vector<bool>().swap(_bkIsSink);
+    std::deque<NodeType>().swap(_bkOrphans);
+
+    return flow;
+}
+
+// ---------------------------------------------------------------------------
+// Synchronous parallel push-relabel
+//
+// Each round discharges all the active nodes in parallel, using the labels of the
+// previous round. The flow pushed on an arc is only written in the arc of the pushing
+// node and received by the adjacent node in a second pass, so no lock is needed.
+// Exact labels are regularly recomputed by a parallel breadth-first search from the
+// target, which also detects the end of the algorithm: no node with an excess can
+// reach the target anymore.
+// ---------------------------------------------------------------------------
+
+void MaxFlow_Tetrahedra::prGlobalRelabel()
+{
+    const int nbNodes = static_cast<int>(_numNodes);
+    // the distance to the target is at most the number of nodes (path through all the nodes)
+    const NodeType maxLabel = static_cast<NodeType>(_numNodes) + 1;
+
+    std::vector<std::vector<NodeType>> threadNodes(omp_get_max_threads());
+    std::vector<NodeType> frontier;
+
+    // nodes directly linked to the target
+    #pragma omp parallel for
+    for(int n = 0; n < nbNodes; ++n)
+    {
+        if(_terminalResidual[n] < 0)
+        {
+            _prLabel[n] = 1;
+            _prTouched[n] = 1;
+            threadNodes[omp_get_thread_num()].push_back(n);
+        }
+        else
+        {
+            _prLabel[n] = maxLabel;
+            _prTouched[n] = 0;
+        }
+    }
+    gatherNodes(threadNodes, frontier);
+
+    NodeType label = 1;
+    while(!frontier.empty())
+    {
+        ++label;
+        #pragma omp parallel for
+        for(int i = 0; i < static_cast<int>(frontier.size()); ++i)
+        {
+            const NodeType n = frontier[i];
+            for(int k = 0; k < 4; ++k)
+            {
+                const ArcType a = getArc(n, k);
+                const NodeType j = _arcHead[a];
+                // j can reach n if the arc from j to n is not saturated
+                if(j == noNode || !(_residual[getReverseArc(a)] > 0))
+                    continue;
+                if(_prTouched[j].exchange(1) == 0)
+                {
+                    _prLabel[j] = label;
+                    threadNodes[omp_get_thread_num()].push_back(j);
+                }
+            }
+        }
+        gatherNodes(threadNodes, frontier);
+    }
+
+    #pragma omp parallel for
+    for(int n = 0; n < nbNodes; ++n)
+        _prTouched[n] = 0;
+}
+
+void MaxFlow_Tetrahedra::prGetActiveNodes(std::vector<NodeType>& activeNodes)
+{
+    const int nbNodes = static_cast<int>(_numNodes);
+    const NodeType maxLabel = static_cast<NodeType>(_numNodes) + 1;
+
+    std::vector<std::vector<NodeType>> threadNodes(omp_get_max_threads());
+
+    #pragma omp parallel for
+    for(int n = 0; n < nbNodes; ++n)
+    {
+        if(_prExcess[n] > 0 && _prLabel[n] < maxLabel)
+            threadNodes[omp_get_thread_num()].push_back(n);
+    }
+    gatherNodes(threadNodes, activeNodes);
+}
+
+double MaxFlow_Tetrahedra::computePushRelabel()
+{
+    const int nbNodes = static_cast<int>(_numNodes);
+    const NodeType maxLabel = static_cast<NodeType>(_numNodes) + 1;
+
+    _prExcess.resize(_numNodes);
+    _prLabel.resize(_numNodes);
+    _prNewLabel.resize(_numNodes);
+    _prPushed.assign(_numNodes * 4, 0.0f);
+    _prTouched.reset(new std::atomic<unsigned char>[_numNodes]);
+
+    // the source arcs are saturated: positive terminal residuals become excess
+    #pragma omp parallel for
+    for(int n = 0; n < nbNodes; ++n)
+    {
+        _prExcess[n] = std::max(_terminalResidual[n], 0.0f);
+        _terminalResidual[n] = std::min(_terminalResidual[n], 0.0f);
+    }
+
+    const std::size_t solverMemoryUsage = _prExcess.capacity() * sizeof(ValueType) +
+                                          _prLabel.capacity() * sizeof(NodeType) +
+                                          _prNewLabel.capacity() * sizeof(NodeType) +
+                                          _prPushed.capacity() * sizeof(ValueType) +
+                                          _numNodes * sizeof(std::atomic<unsigned char>) +
+                                          _numNodes * sizeof(NodeType) * 2; // active and touched nodes lists
+    updatePeakMemoryUsage(solverMemoryUsage);
+
+    std::vector<std::vector<NodeType>> threadNodes(omp_get_max_threads());
+    std::vector<NodeType> activeNodes;
+    std::vector<NodeType> touchedNodes;
+
+    double flow = _flow;
+    std::size_t nbRounds = 0;
+    std::size_t nbGlobalRelabels = 0;
+    std::size_t workSinceGlobalRelabel = 0;
+
+    prGlobalRelabel();
+    ++nbGlobalRelabels;
+    prGetActiveNodes(activeNodes);
+
+    for(;;)
+    {
+        if(activeNodes.empty() || workSinceGlobalRelabel > globalRelabelFrequency * _numNodes)
+        {
+            // exact labels: also reactivates the nodes that can reach the target again
+            prGlobalRelabel();
+            ++nbGlobalRelabels;
+            workSinceGlobalRelabel = 0;
+            prGetActiveNodes(activeNodes);
+            if(activeNodes.empty())
+                break;
+        }
+        ++nbRounds;
+        workSinceGlobalRelabel += activeNodes.size();
+
+        double targetFlow = 0.0;
+
+        // discharge the active nodes, using the labels of the previous round
+        #pragma omp parallel reduction(+:targetFlow)
+        {
+            std::vector<NodeType>& threadTouchedNodes = threadNodes[omp_get_thread_num()];
+
+            #pragma omp for schedule(dynamic, 256)
+            for(int i = 0; i < static_cast<int>(activeNodes.size()); ++i)
+            {
+                const NodeType n = activeNodes[i];
+                ValueType excess = _prExcess[n];
+                NodeType label = _prLabel[n];
+
+                while(excess > 0 && label < maxLabel)
+                {
+                    // push to the target
+                    if(label == 1 && _terminalResidual[n] < 0)
+                    {
+                        const ValueType delta = std::min(excess, -_terminalResidual[n]);
+                        _terminalResidual[n] += delta;
+                        excess -= delta;
+                        targetFlow += delta;
+                    }
+                    // push to the neighbors
+                    for(int k = 0; k < 4 && excess > 0; ++k)
+                    {
+                        const ArcType a = getArc(n, k);
+                        const NodeType j = _arcHead[a];
+                        if(j == noNode || !(_residual[a] > 0) || label != _prLabel[j] + 1)
+                            continue;
+                        const ValueType delta = std::min(excess, _residual[a]);
+                        _residual[a] -= delta;
+                        _prPushed[a] += delta;
+                        excess -= delta;
+                        if(_prTouched[j].exchange(1) == 0)
+                            threadTouchedNodes.push_back(j);
+                    }
+                    if(excess > 0)
+                    {
+                        // relabel
+                        NodeType newLabel = maxLabel;
+                        if(_terminalResidual[n] < 0)
+                            newLabel = 1;
+                        for(int k = 0; k < 4; ++k)
+                        {
+                            const ArcType a = getArc(n, k);
+                            const NodeType j = _arcHead[a];
+                            if(j != noNode && _residual[a] > 0)
+                                newLabel = std::min(newLabel, _prLabel[j] + 1);
+                        }
+                        label = newLabel;
+                    }
+                }
+                _prExcess[n] = excess;
+                _prNewLabel[n] = label;
+                if(excess > 0 && label < maxLabel && _prTouched[n].exchange(1) == 0)
+                    threadTouchedNodes.push_back(n);
+            }
+
+            #pragma omp for
+            for(int i = 0; i < static_cast<int>(activeNodes.size()); ++i)
+            {
+                const NodeType n = activeNodes[i];
+                _prLabel[n] = _prNewLabel[n];
+            }
+        }
+        flow += targetFlow;
+        gatherNodes(threadNodes, touchedNodes);
+
+        // receive the flow pushed to the touched nodes
+        #pragma omp parallel
+        {
+            std::vector<NodeType>& threadActiveNodes = threadNodes[omp_get_thread_num()];
+
+            #pragma omp for schedule(dynamic, 256)
+            for(int i = 0; i < static_cast<int>(touchedNodes.size()); ++i)
+            {
+                const NodeType n = touchedNodes[i];
+                _prTouched[n] = 0;
+
+                ValueType received = 0.0f;
+                for(int k = 0; k < 4; ++k)
+                {
+                    const ArcType a = getArc(n, k);
+                    if(_arcHead[a] == noNode)
+                        continue;
+                    const ArcType reverseArc = getReverseArc(a);
+                    const ValueType pushed = _prPushed[reverseArc];
+                    if(pushed > 0)
+                    {
+                        _prPushed[reverseArc] = 0.0f;
+                        _residual[a] += pushed;
+                        received += pushed;
+                    }
+                }
+                _prExcess[n] += received;
+
+                if(_prExcess[n] > 0 && _prLabel[n] < maxLabel)
+                    threadActiveNodes.push_back(n);
+            }
+        }
+        gatherNodes(threadNodes, activeNodes);
+    }
+
+    ALICEVISION_LOG_INFO("Push-relabel: " << nbRounds << " rounds, " << nbGlobalRelabels << " global relabels.");
+
+    // after the last global relabel, the labeled nodes are the ones that can reach the target
+    _isTarget.resize(_numNodes);
+    for(NodeType n = 0; n < _numNodes; ++n)
+        _isTarget[n] = (_prLabel[n] < maxLabel);
+
+    // release the solver memory
+    std::vector<ValueType>().swap(_prExcess);
+    std::vector<NodeType>().swap(_prLabel);
+    std::vector<NodeType>().swap(_prNewLabel);
+    std::vector<ValueType>().swap(_prPushed);
+    _prTouched.reset();
+
+    return flow;
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
@@ -0,0 +1,183 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Maxflow computation specialized for the adjacency graph of the cells of a tetrahedralization.
+ *
+ * Each node (cell) has at most 4 neighbors, one per facet. The arcs are stored in flat arrays
+ * indexed by (cell * 4 + facet) and the reverse arc of an arc is the same facet seen from the
+ * adjacent cell (see DelaunayGraphCut::mirrorFacet), so there is no adjacency list to build and
+ * no temporary map to retrieve the reverse edges.
+ *
+ * Two solvers are available:
+ * - BOYKOV_KOLMOGOROV: sequential, same algorithm as boost::boykov_kolmogorov_max_flow
+ * - PUSH_RELABEL_PARALLEL: synchronous push-relabel with global relabeling, running on all the threads
+ *
+ * Both solvers give the same cut: a node is on the target side if it can reach the target
+ * in the residual graph, as the white vertices of MaxFlow_AdjList.
+ *
+ * @see MaxFlow_AdjList, MaxFlow_CSR
+ */
+class MaxFlow_Tetrahedra
+{
+public:
+    using NodeType = unsigned int;
+    using ValueType = float;
+    using ArcType = std::uint32_t;
+
+    enum class ESolver
+    {
+        BOYKOV_KOLMOGOROV,
+        PUSH_RELABEL_PARALLEL
+    };
+
+    /**
+     * @param[in] numNodes The number of cells
+     * @throw std::runtime_error if there are too many cells for 32 bits arc indexes
+     */
+    explicit MaxFlow_Tetrahedra(std::size_t numNodes);
+
+    inline void addNode(NodeType n, ValueType source, ValueType sink)
+    {
+        assert(source >= 0 && sink >= 0);
+        // the common part of the terminal capacities is directly part of the flow
+        _flow += std::min(source, sink);
+        _terminalResidual[n] = source - sink;
+    }
+
+    /**
+     * @brief Add an edge between two adjacent cells.
+     * @param[in] n1 The first cell
+     * @param[in] facet1 The local index of the shared facet in n1
+     * @param[in] n2 The adjacent cell
+     * @param[in] facet2 The local index of the shared facet in n2
+     * @param[in] capacity The capacity from n1 to n2
+     * @param[in] reverseCapacity The capacity from n2 to n1
+     * @note Adding the same edge several times accumulates the capacities, as parallel edges would do.
+     */
+    inline void addEdge(NodeType n1, int facet1, NodeType n2, int facet2, ValueType capacity, ValueType reverseCapacity)
+    {
+        assert(capacity >= 0 && reverseCapacity >= 0);
+        assert(facet1 >= 0 && facet1 < 4 && facet2 >= 0 && facet2 < 4);
+
+        const ArcType arc = getArc(n1, facet1);
+        const ArcType reverseArc = getArc(n2, facet2);
+
+        _arcHead[arc] = n2;
+        _arcMirror[arc] = static_cast<unsigned char>(facet2);
+        _residual[arc] += capacity;
+
+        _arcHead[reverseArc] = n1;
+        _arcMirror[reverseArc] = static_cast<unsigned char>(facet1);
+        _residual[reverseArc] += reverseCapacity;
+    }
+
+    /**
+     * @brief Compute the maxflow / mincut.
+     * @param[in] solver The solver to use
+     * @return the value of the flow
+     */
+    ValueType compute(ESolver solver = ESolver::BOYKOV_KOLMOGOROV);
+
+    /// is empty
+    inline bool isSource(NodeType n) const
+    {
+        return !_isTarget[n];
+    }
+    /// is full
+    inline bool isTarget(NodeType n) const
+    {
+        return _isTarget[n];
+    }
+
+    /// @return the memory peak of the graph and the solver buffers, in bytes
+    inline std::size_t getPeakMemoryUsage() const
+    {
+        return _peakMemoryUsage;
+    }
+
+private:
+    inline ArcType getArc(NodeType n, int facet) const
+    {
+        return static_cast<ArcType>(n) * 4 + facet;
+    }
+    /// @return the arc in the opposite direction
+    inline ArcType getReverseArc(ArcType arc) const
+    {
+        return getArc(_arcHead[arc], _arcMirror[arc]);
+    }
+    /// @return the memory used by the graph itself, in bytes
+    std::size_t getGraphMemoryUsage() const;
+
+    void updatePeakMemoryUsage(std::size_t solverMemoryUsage);
+
+    // Boykov-Kolmogorov solver
+    double computeBoykovKolmogorov();
+    void bkSetActive(NodeType n);
+    NodeType bkNextActive();
+    double bkAugment(ArcType middleArc);
+    void bkProcessSourceOrphan(NodeType n);
+    void bkProcessSinkOrphan(NodeType n);
+
+    // push-relabel solver
+    double computePushRelabel();
+    /// exact distance labels to the target in the residual graph (breadth-first search from the target)
+    void prGlobalRelabel();
+    /// nodes with an excess of flow that can still reach the target
+    void prGetActiveNodes(std::vector<NodeType>& activeNodes);
+
+    std::size_t _numNodes;
+    double _flow = 0.0;
+    std::size_t _peakMemoryUsage = 0;
+
+    /// adjacent cell of each arc (cell * 4 + facet)
+    std::vector<NodeType> _arcHead;
+    /// local index of the facet in the adjacent cell, to retrieve the reverse arc
+    std::vector<unsigned char> _arcMirror;
+    /// residual capacity of each arc
+    std::vector<ValueType> _residual;
+    /// residual capacity from the source if positive, to the target if negative
+    std::vector<ValueType> _terminalResidual;
+    /// mincut result
+    std::vector<bool> _isTarget;
+
+    // Boykov-Kolmogorov search trees
+    std::vector<ArcType> _bkParent;
+    std::vector<NodeType> _bkNext;
+    std::vector<int> _bkTimestamp;
+    std::vector<int> _bkDist;
+    std::vector<bool> _bkIsSink;
+    std::deque<NodeType> _bkOrphans;
+    NodeType _bkQueueFirst;
+    NodeType _bkQueueLast;
+    int _bkTime = 0;
+
+    // push-relabel state
+    std::vector<ValueType> _prExcess;
+    std::vector<NodeType> _prLabel;
+    std::vector<NodeType> _prNewLabel;
+    /// flow pushed on each arc during the current round, not yet received by the adjacent cell
+    std::vector<ValueType> _prPushed;
+    std::unique_ptr<std::atomic<unsigned char>[]> _prTouched;
+};
+
+} // namespace fuseCut
+} // namespace aliceVision
@@ -0,0 +1,228 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_Tetrahedra.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#define BOOST_TEST_MODULE fuseCutMaxFlow
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::fuseCut;
+
+namespace {
+
+/**
+ * @brief Graph with at most 4 neighbors per node, the facet of each edge is given explicitly.
+ * @note The capacities are integers, so the residual graphs of all the solvers are exact
+ *       and the min cuts can be compared node by node.
+ */
+struct Graph
+{
+    struct Edge
+    {
+        int n1, facet1, n2, facet2;
+        float capacity, reverseCapacity;
+    };
+
+    explicit Graph(int numNodes)
+        : source(numNodes, 0.0f)
+        , sink(numNodes, 0.0f)
+    {}
+
+    std::vector<float> source;
+    std::vector<float> sink;
+    std::vector<Edge> edges;
+};
+
+/**
+ * @brief Random graph: the facets of all the nodes are shuffled and linked by pairs.
+ */
+Graph createRandomGraph(int numNodes, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> terminalCapacity(0, 20);
+    std::uniform_int_distribution<int> edgeCapacity(0, 10);
+    std::bernoulli_distribution hasTerminal(0.3);
+
+    Graph graph(numNodes);
+    for(int n = 0; n < numNodes; ++n)
+    {
+        if(hasTerminal(generator))
+            graph.source[n] = static_cast<float>(terminalCapacity(generator));
+        if(hasTerminal(generator))
+            graph.sink[n] = static_cast<float>(terminalCapacity(generator));
+    }
+
+    std::vector<std::pair<int, int>> facets;
+    for(int n = 0; n < numNodes; ++n)
+        for(int f = 0; f < 4; ++f)
+            facets.emplace_back(n, f);
+    std::shuffle(facets.begin(), facets.end(), generator);
+
+    std::vector<std::vector<int>> neighbors(numNodes);
+    for(std::size_t i = 0; i + 1 < facets.size(); i += 2)
+    {
+        const std::pair<int, int>& f1 = facets[i];
+        const std::pair<int, int>& f2 = facets[i + 1];
+        // no loop and no parallel edges: these facets stay on the border
+        if(f1.first == f2.first ||
+           std::find(neighbors[f1.first].begin(), neighbors[f1.first].end(), f2.first) != neighbors[f1.first].end())
+            continue;
+        neighbors[f1.first].push_back(f2.first);
+        neighbors[f2.first].push_back(f1.first);
+
+        graph.edges.push_back({f1.first, f1.second, f2.first, f2.second, static_cast<float>(edgeCapacity(generator)),
+                               static_cast<float>(edgeCapacity(generator))});
+    }
+    return graph;
+}
+
+/**
+ * @brief Compute the max flow with MaxFlow_AdjList and both solvers of MaxFlow_Tetrahedra
+ *        and check that they give the same flow and the same cut.
+ */
+void checkSolvers(const Graph& graph)
+{
+    const int numNodes = static_cast<int>(graph.source.size());
+
+    MaxFlow_AdjList adjList(numNodes);
+    // MaxFlow_AdjList only keeps the difference of the terminal capacities
+    double commonTerminalFlow = 0.0;
+    for(int n = 0; n < numNodes; ++n)
+    {
+        adjList.addNode(n, graph.source[n], graph.sink[n]);
+        commonTerminalFlow += std::min(graph.source[n], graph.sink[n]);
+    }
+    for(const Graph::Edge& e : graph.edges)
+        adjList.addEdge(e.n1, e.n2, e.capacity, e.reverseCapacity);
+    const double expectedFlow = adjList.compute() + commonTerminalFlow;
+
+    for(const MaxFlow_Tetrahedra::ESolver solver : {MaxFlow_Tetrahedra::ESolver::BOYKOV_KOLMOGOROV,
+                                                    MaxFlow_Tetrahedra::ESolver::PUSH_RELABEL_PARALLEL})
+    {
+        MaxFlow_Tetrahedra maxFlow(numNodes);
+        for(int n = 0; n < numNodes; ++n)
+            maxFlow.addNode(n, graph.source[n], graph.sink[n]);
+        for(const Graph::Edge& e : graph.edges)
+            maxFlow.addEdge(e.n1, e.facet1, e.n2, e.facet2, e.capacity, e.reverseCapacity);
+
+        const double flow = maxFlow.compute(solver);
+        BOOST_CHECK_CLOSE(flow, expectedFlow, 1e-4);
+
+        int nbDifferentNodes = 0;
+        for(int n = 0; n < numNodes; ++n)
+        {
+            if(maxFlow.isTarget(n) != adjList.isTarget(n))
+                ++nbDifferentNodes;
+            BOOST_CHECK_NE(maxFlow.isTarget(n), maxFlow.isSource(n));
+        }
+        BOOST_CHECK_EQUAL(nbDifferentNodes, 0);
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MaxFlow_Tetrahedra_chain)
+{
+    // source -> 0 -> 1 -> 2 -> 3 -> target, the bottleneck is the edge 2 -> 3
+    Graph graph(4);
+    graph.source[0] = 5.0f;
+    graph.sink[3] = 5.0f;
+    graph.edges.push_back({0, 1, 1, 0, 3.0f, 0.0f});
+    graph.edges.push_back({1, 3, 2, 2, 4.0f, 0.0f});
+    graph.edges.push_back({2, 0, 3, 1, 2.0f, 0.0f});
+
+    for(const MaxFlow_Tetrahedra::ESolver solver : {MaxFlow_Tetrahedra::ESolver::BOYKOV_KOLMOGOROV,
+                                                    MaxFlow_Tetrahedra::ESolver::PUSH_RELABEL_PARALLEL})
+    {
+        MaxFlow_Tetrahedra maxFlow(4);
+        for(int n = 0; n < 4; ++n)
+            maxFlow.addNode(n, graph.source[n], graph.sink[n]);
+        for(const Graph::Edge& e : graph.edges)
+            maxFlow.addEdge(e.n1, e.facet1, e.n2, e.facet2, e.capacity, e.reverseCapacity);
+
+        BOOST_CHECK_CLOSE(maxFlow.compute(solver), 2.0f, 1e-4);
+        BOOST_CHECK(maxFlow.isSource(0));
+        BOOST_CHECK(maxFlow.isSource(1));
+        BOOST_CHECK(maxFlow.isSource(2));
+        BOOST_CHECK(maxFlow.isTarget(3));
+    }
+
+    checkSolvers(graph);
+}
+
+BOOST_AUTO_TEST_CASE(MaxFlow_Tetrahedra_terminals)
+{
+    // nodes linked to both terminals and a node without any edge
+    Graph graph(3);
+    graph.source[0] = 3.0f;
+    graph.sink[0] = 5.0f;
+    graph.source[1] = 7.0f;
+    graph.sink[1] = 1.0f;
+    graph.edges.push_back({0, 2, 1, 3, 1.0f, 1.0f});
+
+    // 3 + 1 through the terminals of nodes 0 and 1, 1 through the edge 1 -> 0
+    checkSolvers(graph);
+
+    MaxFlow_Tetrahedra maxFlow(3);
+    for(int n = 0; n < 3; ++n)
+        maxFlow.addNode(n, graph.source[n], graph.sink[n]);
+    for(const Graph::Edge& e : graph.edges)
+        maxFlow.addEdge(e.n1, e.facet1, e.n2, e.facet2, e.capacity, e.reverseCapacity);
+    BOOST_CHECK_CLOSE(maxFlow.compute(), 5.0f, 1e-4);
+    BOOST_CHECK(maxFlow.isTarget(0));
+    BOOST_CHECK(maxFlow.isSource(1));
+}
+
+BOOST_AUTO_TEST_CASE(MaxFlow_Tetrahedra_grid)
+{
+    // 4x4 grid, the source is on the left column and the target on the right column
+    const int size = 4;
+    Graph graph(size * size);
+    for(int y = 0; y < size; ++y)
+    {
+        graph.source[y * size] = 10.0f;
+        graph.sink[y * size + size - 1] = 10.0f;
+        for(int x = 0; x < size; ++x)
+        {
+            const int n = y * size + x;
+            // facets: 0 right, 1 left, 2 down, 3 up
+            if(x + 1 < size)
+                graph.edges.push_back({n, 0, n + 1, 1, static_cast<float>(1 + (x + y) % 3), 1.0f});
+            if(y + 1 < size)
+                graph.edges.push_back({n, 2, n + size, 3, 2.0f, 2.0f});
+        }
+    }
+    checkSolvers(graph);
+}
+
+BOOST_AUTO_TEST_CASE(MaxFlow_Tetrahedra_random)
+{
+    for(unsigned int seed = 0; seed < 20; ++seed)
+    {
+        const Graph graph = createRandomGraph(50 + 50 * seed, seed);
+        checkSolvers(graph);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MaxFlow_Tetrahedra_random_threads)
+{
+    // the parallel push-relabel cut does not depend on the number of threads
+    const Graph graph = createRandomGraph(2000, 42);
+    for(int nbThreads : {1, 2, 4})
+    {
+        omp_set_num_threads(nbThreads);
+        checkSolvers(graph);
+    }
+}
@@ -7,72 +7,125 @@
 
 #include "convolution.hpp"
 
+#include <algorithm>
+#include <vector>
+
 namespace aliceVision {
 namespace image {
 
-void SeparableConvolution2d(const RowMatrixXf& image,
-                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
-                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
-                            RowMatrixXf* out) {
-  const int sigma_y = static_cast<int>( kernel_y.cols() );
-  const int half_sigma_y = static_cast<int>( kernel_y.cols() ) / 2;
+namespace {
 
-  // Convolving a vertical filter across rows is the same thing as transpose
-  // multiply i.e. kernel_y^t * rows. This will give us the convoled value for
-  // each row. However, care must be taken at the top and bottom borders.
-  const Eigen::Matrix<float, 1, Eigen::Dynamic> reverse_kernel_y = kernel_y.reverse();
+/// Number of columns computed at once (the accumulated values stay in the L1 cache)
+const int blockSize = 256;
 
-  #pragma omp parallel for schedule(dynamic)
-  for (int i = 0; i < half_sigma_y; i++)
+/**
+ * @brief Weighted sum of lines on a block of columns: acc[x] = sum_k kernel[k] * lines[k][x]
+ *        The kernel size is known at compile time: the loop on the kernel
+ *        is unrolled and the loop on the columns is vectorized.
+ */
+template<int KernelSize>
+inline void convolveBlock(const float* const* lines, const float* kernel, int /*kernelSize*/, int x0, int n, float* acc)
+{
+  for(int x = 0; x < n; ++x)
   {
-    const int forward_size = i + half_sigma_y + 1;
-    const int reverse_size = sigma_y - forward_size;
-    out->row(i) = kernel_y.tail(forward_size) *
-                  image.block(0, 0, forward_size, image.cols()) +
-                  reverse_kernel_y.tail(reverse_size) *
-                  image.block(1, 0, reverse_size, image.cols());
-
-    // Apply the same technique for the end rows.
-    out->row(image.rows() - i - 1) =
-      kernel_y.head(forward_size) *
-      image.block(image.rows() - forward_size, 0, forward_size, image.cols())
-      +
-      reverse_kernel_y.head(reverse_size) *
-      image.block(image.rows() - reverse_size - 1, 0, reverse_size, image.cols());
+    float sum = kernel[0] * lines[0][x0 + x];
+    for(int i = 1; i < KernelSize; ++i)
+      sum += kernel[i] * lines[i][x0 + x];
+    acc[x] = sum;
   }
+}
+
+/// Weighted sum of lines on a block of columns, for an arbitrary kernel size
+template<>
+inline void convolveBlock<0>(const float* const* lines, const float* kernel, int kernelSize, int x0, int n, float* acc)
+{
+  Eigen::Map<Eigen::ArrayXf> sum(acc, n);
+  sum = kernel[0] * Eigen::Map<const Eigen::ArrayXf>(lines[0] + x0, n);
+  for(int i = 1; i < kernelSize; ++i)
+    sum += kernel[i] * Eigen::Map<const Eigen::ArrayXf>(lines[i] + x0, n);
+}
 
-  // Applying the rest of the y filter.
-  #pragma omp parallel for schedule(dynamic)
-  for (int row = half_sigma_y; row < image.rows() - half_sigma_y; row++)
+template<int KernelSize>
+void convolveLines(const float* const* lines, const float* kernel, int kernelSize, int size, float* out)
+{
+  float acc[blockSize];
+  for(int x0 = 0; x0 < size; x0 += blockSize)
   {
-    out->row(row) =  kernel_y * image.block(row - half_sigma_y, 0, sigma_y, out->cols());
+    const int n = std::min(blockSize, size - x0);
+    convolveBlock<KernelSize>(lines, kernel, kernelSize, x0, n, acc);
+    std::copy(acc, acc + n, out + x0);
   }
+}
 
-  const int sigma_x = static_cast<int>(kernel_x.cols());
-  const int half_sigma_x = static_cast<int>(kernel_x.cols() / 2);
+/**
+ * @brief Weighted sum of lines: out[x] = sum_k kernel[k] * lines[k][x], for x in [0, size[
+ *        with specialized kernels for the common kernel sizes.
+ */
+void convolveLines(const float* const* lines, const float* kernel, int kernelSize, int size, float* out)
+{
+  switch(kernelSize)
+  {
+    case 3:  convolveLines<3>(lines, kernel, kernelSize, size, out);  break;
+    case 5:  convolveLines<5>(lines, kernel, kernelSize, size, out);  break;
+    case 7:  convolveLines<7>(lines, kernel, kernelSize, size, out);  break;
+    case 9:  convolveLines<9>(lines, kernel, kernelSize, size, out);  break;
+    case 11: convolveLines<11>(lines, kernel, kernelSize, size, out); break;
+    case 13: convolveLines<13>(lines, kernel, kernelSize, size, out); break;
+    case 15: convolveLines<15>(lines, kernel, kernelSize, size, out); break;
+    default: convolveLines<0>(lines, kernel, kernelSize, size, out);
+  }
+}
 
-  // Convolving with the horizontal filter is easy. Rather than using the kernel
-  // as a sliding window, we use the row pixels as a sliding window around the
-  // filter. We prepend and append the proper border values so that we are sure
-  // to end up with the correct convolved values.
-  Eigen::RowVectorXf temp_row(image.cols() + sigma_x - 1);
+/// Mirror an index outside [0, size[ (the border element is not repeated)
+inline int mirrorIndex(int i, int size)
+{
+  if(i < 0)
+    i = -i;
+  else if(i >= size)
+    i = 2 * (size - 1) - i;
+  return std::min(std::max(i, 0), size - 1);
+}
+
+} // namespace
+
+void SeparableConvolution2d(const RowMatrixXf& image,
+                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
+                            const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
+                            RowMatrixXf* out)
+{
+  const int rows = static_cast<int>(image.rows());
+  const int cols = static_cast<int>(image.cols());
 
-  #pragma omp parallel for firstprivate(temp_row), schedule(dynamic)
-  for (int row = 0; row < out->rows(); row++)
+  const int sigma_y = static_cast<int>(kernel_y.cols());
+  const int half_sigma_y = sigma_y / 2;
+  const int sigma_x = static_cast<int>(kernel_x.cols());
+  const int half_sigma_x = sigma_x / 2;
+
+  #pragma omp parallel
   {
-    temp_row.head(half_sigma_x) =
-      out->row(row).segment(1, half_sigma_x).reverse();
-    temp_row.segment(half_sigma_x, image.cols()) = out->row(row);
-    temp_row.tail(half_sigma_x) =
-      out->row(row)
-      .segment(image.cols() - 2 - half_sigma_x, half_sigma_x)
-      .reverse();
-
-    // Convolve the row. We perform the first step here explicitly so that we
-    // avoid setting the row equal to zero.
-    out->row(row) = kernel_x(0) * temp_row.head(image.cols());
-    for (int i = 1; i < sigma_x; i++) {
-      out->row(row) += kernel_x(i) * temp_row.segment(i, image.cols());
+    std::vector<const float*> lines(std::max(sigma_x, sigma_y));
+    // vertically filtered row, with the borders needed by the horizontal filter
+    Eigen::RowVectorXf temp_row(cols + sigma_x - 1);
+
+    #pragma omp for schedule(static)
+    for(int row = 0; row < rows; ++row)
+    {
+      // Vertical filter: weighted sum of the neighbouring rows,
+      // the rows outside of the image are mirrored.
+      for(int i = 0; i < sigma_y; ++i)
+        lines[i] = image.data() + mirrorIndex(row + i - half_sigma_y, rows) * cols;
+      convolveLines(lines.data(), kernel_y.data(), sigma_y, cols, temp_row.data() + half_sigma_x);
+
+      // Horizontal filter: we prepend and append the border values
+      // and use the row pixels as a sliding window around the filter.
+      temp_row.head(half_sigma_x) =
+        temp_row.segment(half_sigma_x + 1, half_sigma_x).reverse();
+      temp_row.tail(half_sigma_x) =
+        temp_row.segment(cols - 2, half_sigma_x).reverse();
+
+      for(int i = 0; i < sigma_x; ++i)
+        lines[i] = temp_row.data() + i;
+      convolveLines(lines.data(), kernel_x.data(), sigma_x, cols, out->data() + row * cols);
     }
   }
 }
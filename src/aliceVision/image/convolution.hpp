@@ -13,8 +13,11 @@
 #include <aliceVision/image/Image.hpp>
 #include <aliceVision/config.hpp>
 
-#include <vector>
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <type_traits>
+#include <vector>
 
 /**
  ** @file Standard 2D image convolution functions :
@@ -91,33 +94,39 @@ void ImageHorizontalConvolution( const ImageTypeIn & img , const Kernel & kernel
   const int kernel_width = kernel.size() ;
   const int half_kernel_width = kernel_width / 2 ;
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( cols + kernel_width );
-
-  for( int row = 0 ; row < rows ; ++row )
+  #pragma omp parallel
   {
-    // Copy line
-    const pix_t start_pix = img.coeffRef( row , 0 ) ;
-    for( int k = 0 ; k < half_kernel_width ; ++k ) // pad before
-    {
-      line[ k ] = start_pix ;
-    }
-    memcpy(&line[0] + half_kernel_width, img.data() + row * cols, sizeof(pix_t) * cols);
-    const pix_t end_pix = img.coeffRef( row , cols - 1 ) ;
-    for( int k = 0 ; k < half_kernel_width ; ++k ) // pad after
+    std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( cols + kernel_width );
+
+    #pragma omp for schedule(static)
+    for( int row = 0 ; row < rows ; ++row )
     {
-      line[ k + half_kernel_width + cols ] = end_pix ;
-    }
+      // Copy line
+      const pix_t start_pix = img.coeffRef( row , 0 ) ;
+      for( int k = 0 ; k < half_kernel_width ; ++k ) // pad before
+      {
+        line[ k ] = start_pix ;
+      }
+      memcpy(&line[0] + half_kernel_width, img.data() + row * cols, sizeof(pix_t) * cols);
+      const pix_t end_pix = img.coeffRef( row , cols - 1 ) ;
+      for( int k = 0 ; k < half_kernel_width ; ++k ) // pad after
+      {
+        line[ k + half_kernel_width + cols ] = end_pix ;
+      }
 
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , cols , kernel_width );
+      // Apply convolution
+      conv_buffer_( &line[0] , kernel.data() , cols , kernel_width );
 
-    memcpy(out.data() + row * cols, &line[0], sizeof(pix_t) * cols);
+      memcpy(out.data() + row * cols, &line[0], sizeof(pix_t) * cols);
+    }
   }
 }
 
 /**
  ** Vertical (1d) convolution
  ** assume kernel has odd size
+ ** The image is traversed row by row: each output row is computed from
+ ** kernel_width input rows read in the memory order (no column gathering).
  ** @param img Input image
  ** @param kernel convolution kernel
  ** @param out Output image
@@ -126,6 +135,7 @@ template< typename ImageTypeIn , typename ImageTypeOut, typename Kernel >
 void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel , ImageTypeOut & out)
 {
   typedef typename ImageTypeIn::Tpixel pix_t ;
+  typedef typename std::decay< decltype( *kernel.data() ) >::type kernel_t ;
 
   const int kernel_width = kernel.size() ;
   const int half_kernel_width = kernel_width / 2 ;
@@ -135,30 +145,36 @@ void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel ,
 
   out.resize( cols , rows ) ;
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( rows + kernel_width );
-
-  for( int col = 0 ; col < cols ; ++col )
+  #pragma omp parallel
   {
-    // Copy column
-    for( int k = 0 ; k < half_kernel_width ; ++k )
-    {
-      line[ k ] = img.coeffRef( 0 , col ) ;
-    }
-    for( int k = 0 ; k < rows ; ++k )
-    {
-      line[ k + half_kernel_width ] = img.coeffRef( k , col ) ;
-    }
-    for( int k = 0 ; k < half_kernel_width ; ++k )
-    {
-      line[ k + half_kernel_width + rows ] = img.coeffRef( rows - 1 , col ) ;
-    }
-
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , rows , kernel_width );
+    std::vector<const pix_t*> src_rows( kernel_width );
+    std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( cols );
 
+    #pragma omp for schedule(static)
     for( int row = 0 ; row < rows ; ++row )
     {
-      out.coeffRef( row , col ) = line[row];
+      // Input rows (border rows are copied)
+      for( int k = 0 ; k < kernel_width ; ++k )
+      {
+        const int src_row = std::min( std::max( row + k - half_kernel_width , 0 ) , rows - 1 ) ;
+        src_rows[ k ] = img.data() + src_row * cols ;
+      }
+
+      // Apply convolution
+      for( int col = 0 ; col < cols ; ++col )
+      {
+        kernel_t sum( 0 );
+        for( int k = 0 ; k < kernel_width ; ++k )
+        {
+          sum += src_rows[ k ][ col ] * kernel[ k ];
+        }
+        line[ col ] = sum ;
+      }
+
+      for( int col = 0 ; col < cols ; ++col )
+      {
+        out.coeffRef( row , col ) = line[ col ] ;
+      }
     }
   }
 }
@@ -190,7 +206,12 @@ void ImageSeparableConvolution( const ImageType & img ,
 
 typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXf;
 
-/// Specialization for Float based image (for arbitrary sized kernel)
+/**
+ ** Specialization for Float based image (for arbitrary sized kernel)
+ ** The two passes are done row by row without intermediate image,
+ ** with unrolled kernels for the common kernel sizes (3 to 15).
+ ** The borders are mirrored.
+ **/
 void SeparableConvolution2d(const RowMatrixXf& image,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
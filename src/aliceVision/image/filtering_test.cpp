@@ -8,6 +8,7 @@
 #include "aliceVision/image/all.hpp"
 
 #include <iostream>
+#include <random>
 
 #define BOOST_TEST_MODULE ImageFiltering
 #include <boost/test/included/unit_test.hpp>
@@ -17,6 +18,48 @@ using namespace aliceVision;
 using namespace aliceVision::image;
 using namespace std;
 
+/**
+ * @brief Previous implementation of SeparableConvolution2d (vertical pass on the whole image,
+ *        then horizontal pass), used as reference for the row-major single pass implementation.
+ */
+void previousSeparableConvolution2d(const RowMatrixXf& image,
+                                    const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
+                                    const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
+                                    RowMatrixXf* out)
+{
+  const int sigma_y = static_cast<int>(kernel_y.cols());
+  const int half_sigma_y = sigma_y / 2;
+  const Eigen::Matrix<float, 1, Eigen::Dynamic> reverse_kernel_y = kernel_y.reverse();
+
+  for(int i = 0; i < half_sigma_y; i++)
+  {
+    const int forward_size = i + half_sigma_y + 1;
+    const int reverse_size = sigma_y - forward_size;
+    out->row(i) = kernel_y.tail(forward_size) * image.block(0, 0, forward_size, image.cols()) +
+                  reverse_kernel_y.tail(reverse_size) * image.block(1, 0, reverse_size, image.cols());
+    out->row(image.rows() - i - 1) =
+      kernel_y.head(forward_size) * image.block(image.rows() - forward_size, 0, forward_size, image.cols()) +
+      reverse_kernel_y.head(reverse_size) * image.block(image.rows() - reverse_size - 1, 0, reverse_size, image.cols());
+  }
+  for(int row = half_sigma_y; row < image.rows() - half_sigma_y; row++)
+    out->row(row) = kernel_y * image.block(row - half_sigma_y, 0, sigma_y, out->cols());
+
+  const int sigma_x = static_cast<int>(kernel_x.cols());
+  const int half_sigma_x = sigma_x / 2;
+  Eigen::RowVectorXf temp_row(image.cols() + sigma_x - 1);
+
+  for(int row = 0; row < out->rows(); row++)
+  {
+    temp_row.head(half_sigma_x) = out->row(row).segment(1, half_sigma_x).reverse();
+    temp_row.segment(half_sigma_x, image.cols()) = out->row(row);
+    temp_row.tail(half_sigma_x) = out->row(row).segment(image.cols() - 2 - half_sigma_x, half_sigma_x).reverse();
+
+    out->row(row) = kernel_x(0) * temp_row.head(image.cols());
+    for(int i = 1; i < sigma_x; i++)
+      out->row(row) += kernel_x(i) * temp_row.segment(i, image.cols());
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Image_Convolution)
 {
   Image<unsigned char> in(250,250);
@@ -135,3 +178,33 @@ BOOST_AUTO_TEST_CASE(Image_Convolution_Sobel_X_Y)
   outFilteredCast = Image<unsigned char>(outFiltered.cast<unsigned char>());
   BOOST_CHECK_NO_THROW(writeImage("out_SobelY.png", outFilteredCast));
 }
+
+BOOST_AUTO_TEST_CASE(Image_SeparableConvolution2d_PreviousImplementation)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> distribution(0.f, 255.f);
+
+  RowMatrixXf image(97, 131);
+  for(int i = 0; i < image.size(); ++i)
+    image.data()[i] = distribution(generator);
+
+  // specialized kernel sizes and generic kernel sizes
+  for(int kernelSize : {3, 5, 9, 15, 17, 31})
+  {
+    Eigen::Matrix<float, 1, Eigen::Dynamic> kernel_x(kernelSize);
+    Eigen::Matrix<float, 1, Eigen::Dynamic> kernel_y(kernelSize);
+    for(int i = 0; i < kernelSize; ++i)
+    {
+      kernel_x(i) = distribution(generator) / 255.f - 0.5f;
+      kernel_y(i) = distribution(generator) / 255.f;
+    }
+
+    RowMatrixXf expected(image.rows(), image.cols());
+    RowMatrixXf out(image.rows(), image.cols());
+    previousSeparableConvolution2d(image, kernel_x, kernel_y, &expected);
+    SeparableConvolution2d(image, kernel_x, kernel_y, &out);
+
+    const float maxValue = expected.cwiseAbs().maxCoeff();
+    BOOST_CHECK_SMALL((out - expected).cwiseAbs().maxCoeff() / maxValue, 1e-5f);
+  }
+}
@@ -10,10 +10,10 @@
 #include "aliceVision/numeric/numeric.hpp"
 #include "aliceVision/matching/ArrayMatcher.hpp"
 #include "aliceVision/matching/metric.hpp"
-#include "aliceVision/stl/indexedSort.hpp"
 #include <aliceVision/config.hpp>
+#include <algorithm>
 #include <memory>
-#include <iostream>
+#include <vector>
 
 namespace aliceVision {
 namespace matching {
@@ -64,32 +64,39 @@ class ArrayMatcher_bruteForce  : public ArrayMatcher<Scalar, Metric>
     if (memMapping.get() == nullptr)
       return false;
 
-      //matrix representation of the input data;
-      Eigen::Map<BaseMat> mat_query((Scalar*)query, 1, (*memMapping).cols() );
-      Metric metric;
-      std::vector<DistanceType> vec_dist((*memMapping).rows(), 0.0);
-    for (int i = 0; i < (*memMapping).rows(); ++i)
+    // Keep the running minimum (first index on equal distances)
+    Metric metric;
+    const int nbRows = (*memMapping).rows();
+    const int dimension = (*memMapping).cols();
+    const Scalar * rowPtr = (*memMapping).data();
+    DistanceType bestDistance = metric(query, rowPtr, dimension);
+    int bestIndex = 0;
+    for (int i = 1; i < nbRows; ++i)
     {
-        // Compute Distance Metric
-        vec_dist[i] = metric( (Scalar*)query, (*memMapping).row(i).data(), (*memMapping).cols() );
-      }
-      if (!vec_dist.empty())
+      rowPtr += dimension;
+      const DistanceType dist = metric(query, rowPtr, dimension);
+      if (dist < bestDistance)
       {
-        // Find the minimum distance :
-        typename std::vector<DistanceType>::const_iterator min_iter =
-          min_element( vec_dist.begin(), vec_dist.end());
-        *indice =std::distance(
-          typename std::vector<DistanceType>::const_iterator(vec_dist.begin()),
-          min_iter);
-        *distance = static_cast<DistanceType>(*min_iter);
+        bestDistance = dist;
+        bestIndex = i;
       }
-      return true;
+    }
+    *indice = bestIndex;
+    *distance = bestDistance;
+    return true;
   }
 
 
 /**
    * Search the N nearest Neighbor of the scalar array query.
    *
+   * The distances are computed by blocks of queries against blocks of dataset rows
+   * that fit in the cache, and only the N best candidates of each query are kept
+   * (sorted by ascending distance, then ascending index), so no distance
+   * vector has to be allocated and sorted for each query.
+   * If the dataset has fewer rows than NN, NN is clamped to the number of rows:
+   * the output contains min(NN, rows) valid neighbours per query.
+   *
    * \param[in]   query     The query array
    * \param[in]   nbQuery   The number of query rows
    * \param[out]  indices   The corresponding (query, neighbor) indices
@@ -110,40 +117,84 @@ class ArrayMatcher_bruteForce  : public ArrayMatcher<Scalar, Metric>
       return false;
     }
 
-    if (NN > (*memMapping).rows() || nbQuery < 1) {
+    if (nbQuery < 1) {
       return false;
     }
 
-    //matrix representation of the input data;
-    Eigen::Map<BaseMat> mat_query((Scalar*)query, nbQuery, (*memMapping).cols());
-    Metric metric;
+    const int nbRows = (*memMapping).rows();
+    // never return unfilled neighbour slots
+    NN = std::min(NN, static_cast<size_t>(nbRows));
+
+    const int dimension = (*memMapping).cols();
+    const Scalar * dataset = (*memMapping).data();
+
+    // A block of dataset rows (~128KB) is reused by a block of queries while it stays in cache
+    const int queryBlockSize = 32;
+    const int rowBlockSize = std::max(1, static_cast<int>((128 * 1024) / (dimension * sizeof(Scalar))));
+    const int nbQueryBlocks = (nbQuery + queryBlockSize - 1) / queryBlockSize;
 
     pvec_distances->resize(nbQuery * NN);
     pvec_indices->resize(nbQuery * NN);
 
-    #pragma omp parallel for schedule(dynamic)
-    for (int queryIndex=0; queryIndex < nbQuery; ++queryIndex) 
-    {
-      std::vector<DistanceType> vec_distance((*memMapping).rows(), 0.0);
-      const Scalar * queryPtr = mat_query.row(queryIndex).data();
-      const Scalar * rowPtr = (*memMapping).data();
-      for (int i = 0; i < (*memMapping).rows(); ++i)
-      {
-        vec_distance[i] = metric( queryPtr,
-          rowPtr, (*memMapping).cols() );
-        rowPtr += (*memMapping).cols();
-      }
+    if (NN == 0)
+      return true;
 
-      // Find the N minimum distances:
-      const int maxMinFound = (int) std::min( size_t(NN), vec_distance.size());
-      using namespace stl::indexed_sort;
-      std::vector< sort_index_packet_ascend< DistanceType, int> > packet_vec(vec_distance.size());
-      sort_index_helper(packet_vec, &vec_distance[0], maxMinFound);
+    #pragma omp parallel
+    {
+      Metric metric;
+      // N best candidates of each query of the current block, sorted by ascending distance
+      std::vector<DistanceType> bestDistances(queryBlockSize * NN);
+      std::vector<int> bestIndices(queryBlockSize * NN);
 
-      for (int i = 0; i < maxMinFound; ++i)
+      #pragma omp for schedule(dynamic)
+      for (int queryBlock = 0; queryBlock < nbQueryBlocks; ++queryBlock)
       {
-        (*pvec_distances)[queryIndex*NN+i] = packet_vec[i].val;
-        (*pvec_indices)[queryIndex*NN+i] = IndMatch(queryIndex, packet_vec[i].index);
+        const int queryBegin = queryBlock * queryBlockSize;
+        const int queryEnd = std::min(nbQuery, queryBegin + queryBlockSize);
+
+        std::fill(bestIndices.begin(), bestIndices.end(), -1);
+
+        for (int rowBegin = 0; rowBegin < nbRows; rowBegin += rowBlockSize)
+        {
+          const int rowEnd = std::min(nbRows, rowBegin + rowBlockSize);
+
+          for (int queryIndex = queryBegin; queryIndex < queryEnd; ++queryIndex)
+          {
+            const Scalar * queryPtr = query + static_cast<std::size_t>(queryIndex) * dimension;
+            const Scalar * rowPtr = dataset + static_cast<std::size_t>(rowBegin) * dimension;
+            DistanceType * queryBestDistances = &bestDistances[(queryIndex - queryBegin) * NN];
+            int * queryBestIndices = &bestIndices[(queryIndex - queryBegin) * NN];
+
+            for (int i = rowBegin; i < rowEnd; ++i, rowPtr += dimension)
+            {
+              const DistanceType dist = metric(queryPtr, rowPtr, dimension);
+
+              // Rows are visited by ascending index, so a candidate only replaces
+              // the last one if strictly closer (same order as a stable sort)
+              if (queryBestIndices[NN-1] != -1 && !(dist < queryBestDistances[NN-1]))
+                continue;
+
+              std::size_t k = NN - 1;
+              while (k > 0 && (queryBestIndices[k-1] == -1 || dist < queryBestDistances[k-1]))
+              {
+                queryBestDistances[k] = queryBestDistances[k-1];
+                queryBestIndices[k] = queryBestIndices[k-1];
+                --k;
+              }
+              queryBestDistances[k] = dist;
+              queryBestIndices[k] = i;
+            }
+          }
+        }
+
+        for (int queryIndex = queryBegin; queryIndex < queryEnd; ++queryIndex)
+        {
+          for (std::size_t i = 0; i < NN; ++i)
+          {
+            (*pvec_distances)[queryIndex*NN+i] = bestDistances[(queryIndex - queryBegin) * NN + i];
+            (*pvec_indices)[queryIndex*NN+i] = IndMatch(queryIndex, bestIndices[(queryIndex - queryBegin) * NN + i]);
+          }
+        }
       }
     }
     return true;
@@ -0,0 +1,248 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MatchesFile.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace matching {
+
+namespace {
+
+const char matchesFileMagic[8] = {'A', 'V', 'M', 'A', 'T', 'C', 'H', '\0'};
+
+inline bool pairLess(const MatchesFile::PairEntry& entry, const Pair& pair)
+{
+  return (entry.I < pair.first) || (entry.I == pair.first && entry.J < pair.second);
+}
+
+inline bool isDescTypeSelected(feature::EImageDescriberType descType,
+                               const std::vector<feature::EImageDescriberType>& descTypesFilter)
+{
+  return descTypesFilter.empty() ||
+         std::find(descTypesFilter.begin(), descTypesFilter.end(), descType) != descTypesFilter.end();
+}
+
+/**
+ * @brief Check that a block of count elements of elementSize bytes at offset fits in the file.
+ * @note The check is done without computing offset + count * elementSize, which can overflow on a corrupted file.
+ */
+inline bool isBlockInFile(std::uint64_t offset, std::uint64_t count, std::uint64_t elementSize, std::uint64_t fileSize)
+{
+  if(offset > fileSize)
+    return false;
+  return elementSize == 0 || count <= (fileSize - offset) / elementSize;
+}
+
+} // namespace
+
+MatchesFile::MatchesFile(const std::string& path)
+  : _file(path)
+{
+  if(_file.size() < sizeof(Header))
+    throw std::runtime_error("Invalid matches file '" + path + "' : file too small.");
+
+  _header = reinterpret_cast<const Header*>(_file.data());
+
+  if(std::memcmp(_header->magic, matchesFileMagic, sizeof(matchesFileMagic)) != 0)
+    throw std::runtime_error("Invalid matches file '" + path + "' : bad magic number.");
+
+  if(_header->version != version)
+    throw std::runtime_error("Invalid matches file '" + path + "' : unsupported version " + std::to_string(_header->version) + ".");
+
+  if(!isBlockInFile(sizeof(Header), _header->nbPairs, sizeof(PairEntry), _file.size()))
+    throw std::runtime_error("Invalid matches file '" + path + "' : truncated pair table.");
+
+  _pairs = reinterpret_cast<const PairEntry*>(_file.data() + sizeof(Header));
+}
+
+std::size_t MatchesFile::getNbPairs() const
+{
+  return _header->nbPairs;
+}
+
+PairSet MatchesFile::getPairs() const
+{
+  PairSet pairs;
+  for(std::size_t i = 0; i < _header->nbPairs; ++i)
+    pairs.insert(pairs.end(), std::make_pair(_pairs[i].I, _pairs[i].J));
+  return pairs;
+}
+
+const MatchesFile::PairEntry* MatchesFile::findPair(const Pair& pair) const
+{
+  const PairEntry* end = _pairs + _header->nbPairs;
+  const PairEntry* it = std::lower_bound(_pairs, end, pair, pairLess);
+  if(it == end || it->I != pair.first || it->J != pair.second)
+    return nullptr;
+  return it;
+}
+
+bool MatchesFile::hasPair(const Pair& pair) const
+{
+  return findPair(pair) != nullptr;
+}
+
+const MatchesFile::DescTypeEntry* MatchesFile::getDescTypeEntry(std::uint64_t offset) const
+{
+  // the matches are stored after the header and the pair table
+  if(offset < sizeof(Header) + _header->nbPairs * sizeof(PairEntry))
+    throw std::runtime_error("Invalid matches file '" + path() + "' : bad data offset.");
+
+  if(!isBlockInFile(offset, 1, sizeof(DescTypeEntry), _file.size()))
+    throw std::runtime_error("Invalid matches file '" + path() + "' : truncated data.");
+
+  const DescTypeEntry* entry = reinterpret_cast<const DescTypeEntry*>(_file.data() + offset);
+
+  if(!isBlockInFile(offset + sizeof(DescTypeEntry), entry->nbMatches, 2 * sizeof(std::uint32_t), _file.size()))
+    throw std::runtime_error("Invalid matches file '" + path() + "' : truncated data.");
+
+  return entry;
+}
+
+std::size_t MatchesFile::getNbMatches(const Pair& pair, feature::EImageDescriberType descType) const
+{
+  const PairEntry* pairEntry = findPair(pair);
+  if(pairEntry == nullptr)
+    return 0;
+
+  std::uint64_t offset = pairEntry->offset;
+  for(std::size_t d = 0; d < pairEntry->nbDescTypes; ++d)
+  {
+    const DescTypeEntry* entry = getDescTypeEntry(offset);
+    if(entry->descType == static_cast<std::uint32_t>(descType))
+      return entry->nbMatches;
+    offset += sizeof(DescTypeEntry) + entry->nbMatches * 2 * sizeof(std::uint32_t);
+  }
+  return 0;
+}
+
+bool MatchesFile::getMatches(const Pair& pair,
+                             MatchesPerDescType& matches,
+                             const std::vector<feature::EImageDescriberType>& descTypesFilter,
+                             int maxNbMatches) const
+{
+  const PairEntry* pairEntry = findPair(pair);
+  if(pairEntry == nullptr)
+    return false;
+
+  std::uint64_t offset = pairEntry->offset;
+  for(std::size_t d = 0; d < pairEntry->nbDescTypes; ++d)
+  {
+    const DescTypeEntry* entry = getDescTypeEntry(offset);
+    const feature::EImageDescriberType descType = static_cast<feature::EImageDescriberType>(entry->descType);
+    const std::uint32_t* data = reinterpret_cast<const std::uint32_t*>(_file.data() + offset + sizeof(DescTypeEntry));
+    offset += sizeof(DescTypeEntry) + entry->nbMatches * 2 * sizeof(std::uint32_t);
+
+    if(!isDescTypeSelected(descType, descTypesFilter))
+      continue;
+
+    std::size_t nbMatches = entry->nbMatches;
+    if(maxNbMatches > 0)
+      nbMatches = std::min(nbMatches, static_cast<std::size_t>(maxNbMatches));
+
+    IndMatches& descMatches = matches[descType];
+    descMatches.resize(nbMatches);
+    for(std::size_t i = 0; i < nbMatches; ++i)
+      descMatches[i] = IndMatch(data[2 * i], data[2 * i + 1]);
+  }
+  return true;
+}
+
+void MatchesFile::load(PairwiseMatches& matches,
+                       const std::set<IndexT>& viewsKeysFilter,
+                       const std::vector<feature::EImageDescriberType>& descTypesFilter,
+                       int maxNbMatches) const
+{
+  for(std::size_t i = 0; i < _header->nbPairs; ++i)
+  {
+    const Pair pair(_pairs[i].I, _pairs[i].J);
+
+    if(!viewsKeysFilter.empty() &&
+       (viewsKeysFilter.find(pair.first) == viewsKeysFilter.end() ||
+        viewsKeysFilter.find(pair.second) == viewsKeysFilter.end()))
+      continue;
+
+    MatchesPerDescType pairMatches;
+    getMatches(pair, pairMatches, descTypesFilter, maxNbMatches);
+
+    // as filterMatchesByDesc, drop the pairs without any match of the selected describer types
+    if(!pairMatches.empty() || descTypesFilter.empty())
+      matches[pair] = std::move(pairMatches);
+  }
+}
+
+void saveMatchesFile(const std::string& path,
+                     const PairwiseMatches::const_iterator& matchBegin,
+                     const PairwiseMatches::const_iterator& matchEnd)
+{
+  const std::size_t nbPairs = std::distance(matchBegin, matchEnd);
+
+  MatchesFile::Header header;
+  std::memcpy(header.magic, matchesFileMagic, sizeof(matchesFileMagic));
+  header.version = MatchesFile::version;
+  header.nbPairs = static_cast<std::uint32_t>(nbPairs);
+
+  // pair table (PairwiseMatches is sorted by pair)
+  std::vector<MatchesFile::PairEntry> pairs;
+  pairs.reserve(nbPairs);
+
+  std::uint64_t offset = sizeof(MatchesFile::Header) + nbPairs * sizeof(MatchesFile::PairEntry);
+
+  for(PairwiseMatches::const_iterator match = matchBegin; match != matchEnd; ++match)
+  {
+    MatchesFile::PairEntry entry;
+    entry.I = match->first.first;
+    entry.J = match->first.second;
+    entry.nbDescTypes = static_cast<std::uint32_t>(match->second.size());
+    entry.reserved = 0;
+    entry.offset = offset;
+    for(const auto& m : match->second)
+      offset += sizeof(MatchesFile::DescTypeEntry) + m.second.size() * 2 * sizeof(std::uint32_t);
+    pairs.push_back(entry);
+  }
+
+  std::ofstream stream(path, std::ios::out | std::ios::binary);
+  if(!stream.is_open())
+    throw std::runtime_error("Can't save matches file, can't open '" + path + "' !");
+
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if(!pairs.empty())
+    stream.write(reinterpret_cast<const char*>(pairs.data()), pairs.size() * sizeof(MatchesFile::PairEntry));
+
+  std::vector<std::uint32_t> buffer;
+  for(PairwiseMatches::const_iterator match = matchBegin; match != matchEnd; ++match)
+  {
+    for(const auto& m : match->second)
+    {
+      MatchesFile::DescTypeEntry entry;
+      entry.descType = static_cast<std::uint32_t>(m.first);
+      entry.nbMatches = static_cast<std::uint32_t>(m.second.size());
+      stream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+
+      buffer.resize(2 * m.second.size());
+      for(std::size_t i = 0; i < m.second.size(); ++i)
+      {
+        buffer[2 * i] = m.second[i]._i;
+        buffer[2 * i + 1] = m.second[i]._j;
+      }
+      if(!buffer.empty())
+        stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(std::uint32_t));
+    }
+  }
+
+  if(!stream.good())
+    throw std::runtime_error("Can't save matches file, '" + path + "' is incorrect !");
+
+  stream.close();
+}
+
+}  // namespace matching
+}  // namespace aliceVision
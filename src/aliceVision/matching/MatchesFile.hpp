@@ -0,0 +1,128 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/matching/IndMatch.hpp>
+#include <aliceVision/system/MappedFile.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief Binary pairwise matches file (.bin), memory mapped.
+ *
+ * A sorted pair table gives the offset of the matches of each pair, so the matches
+ * of a single pair can be decoded without reading the rest of the file.
+ *
+ * Layout (native endianness):
+ * - header: magic "AVMATCH", version, number of pairs
+ * - pair table: for each pair (I, J), sorted, the number of describer types and the offset of its data
+ * - data: for each pair and each describer type, the describer type, the number of matches
+ *   and the matches as (i, j) pairs of uint32
+ */
+class MatchesFile
+{
+public:
+  static const std::uint32_t version = 1;
+
+  /**
+   * @brief Map the given matches file in memory and check its header.
+   * @param[in] path The matches file path
+   * @throw std::runtime_error if the file can't be opened or is invalid
+   */
+  explicit MatchesFile(const std::string& path);
+
+  const std::string& path() const { return _file.path(); }
+
+  std::size_t getNbPairs() const;
+
+  /// @return the image pairs stored in the file
+  PairSet getPairs() const;
+
+  bool hasPair(const Pair& pair) const;
+
+  /**
+   * @brief Get the number of matches of a pair for a describer type, without decoding them.
+   * @return the number of matches (0 if the pair or the describer type is not in the file)
+   */
+  std::size_t getNbMatches(const Pair& pair, feature::EImageDescriberType descType) const;
+
+  /**
+   * @brief Decode the matches of one pair.
+   * @param[in] pair The image pair
+   * @param[out] matches The matches of the pair per describer type
+   * @param[in] descTypesFilter Describer types to decode (all if empty)
+   * @param[in] maxNbMatches Only decode the N first matches per describer type (all if 0)
+   * @return false if the pair is not in the file
+   */
+  bool getMatches(const Pair& pair,
+                  MatchesPerDescType& matches,
+                  const std::vector<feature::EImageDescriberType>& descTypesFilter = {},
+                  int maxNbMatches = 0) const;
+
+  /**
+   * @brief Decode the matches of all the pairs passing the filters.
+   * @param[out] matches The output matches, decoded pairs are added to the container
+   * @param[in] viewsKeysFilter Only decode the pairs with both views in this set (all if empty)
+   * @param[in] descTypesFilter Describer types to decode (all if empty)
+   * @param[in] maxNbMatches Only decode the N first matches per describer type (all if 0)
+   */
+  void load(PairwiseMatches& matches,
+            const std::set<IndexT>& viewsKeysFilter = {},
+            const std::vector<feature::EImageDescriberType>& descTypesFilter = {},
+            int maxNbMatches = 0) const;
+
+  struct Header
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t nbPairs;
+  };
+
+  struct PairEntry
+  {
+    std::uint32_t I;
+    std::uint32_t J;
+    std::uint32_t nbDescTypes;
+    std::uint32_t reserved;
+    std::uint64_t offset;
+  };
+
+  struct DescTypeEntry
+  {
+    std::uint32_t descType;
+    std::uint32_t nbMatches;
+  };
+
+private:
+  const PairEntry* findPair(const Pair& pair) const;
+
+  /// @return the describer type entry at the given offset (checks the file bounds)
+  const DescTypeEntry* getDescTypeEntry(std::uint64_t offset) const;
+
+  system::MappedFile _file;
+  const Header* _header = nullptr;
+  const PairEntry* _pairs = nullptr;
+};
+
+/**
+ * @brief Save pairwise matches in a binary matches file.
+ * @param[in] path The output file path
+ * @param[in] matchBegin First pair to save
+ * @param[in] matchEnd Pair after the last pair to save
+ * @throw std::runtime_error if the file can't be written
+ */
+void saveMatchesFile(const std::string& path,
+                     const PairwiseMatches::const_iterator& matchBegin,
+                     const PairwiseMatches::const_iterator& matchEnd);
+
+}  // namespace matching
+}  // namespace aliceVision
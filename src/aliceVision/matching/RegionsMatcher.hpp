@@ -141,6 +141,11 @@ public:
     matching::IndMatches vec_nIndice;
     std::vector<DistanceType> vec_fDistance;
 
+    // the ratio test needs 2 neighbours per query
+    // (the matchers skip the queries without enough candidates, but never return a single neighbour)
+    if (regions_.RegionCount() < NNN__)
+      return false;
+
     // Search the 2 closest features neighbours for each query descriptor
     if (!matcher_.SearchNeighbours(queries, queryregions_.RegionCount(), &vec_nIndice, &vec_fDistance, NNN__))
       return false;
@@ -7,6 +7,7 @@
 
 #include "aliceVision/matching/IndMatch.hpp"
 #include "aliceVision/matching/io.hpp"
+#include "aliceVision/matching/MatchesFile.hpp"
 
 #include <boost/filesystem/operations.hpp>
 
@@ -15,6 +16,12 @@
 #include <boost/test/floating_point_comparison.hpp>
 #include <boost/filesystem.hpp>
 
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
 using namespace aliceVision;
 using namespace aliceVision::matching;
 using namespace aliceVision::feature;
@@ -87,6 +94,146 @@ BOOST_AUTO_TEST_CASE(IndMatch_IO)
   boost::filesystem::remove_all(testFolder);
 }
 
+BOOST_AUTO_TEST_CASE(IndMatch_IO_Binary)
+{
+  const std::string testFolder = "matchingTestBin";
+
+  for(bool matchFilePerImage : {false, true})
+  {
+    boost::filesystem::create_directory(testFolder);
+
+    PairwiseMatches matches;
+    matches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}};
+    matches[std::make_pair(0,1)][EImageDescriberType::SIFT] = {{2,3}};
+    matches[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}, {2,2}};
+    matches[std::make_pair(2,3)][EImageDescriberType::UNKNOWN] = {{4,5}};
+
+    BOOST_CHECK(Save(matches, testFolder, "bin", matchFilePerImage));
+
+    // Load all
+    {
+      PairwiseMatches loadedMatches;
+      BOOST_CHECK(Load(loadedMatches, {0, 1, 2, 3}, {testFolder}, {}));
+      BOOST_CHECK_EQUAL(3, loadedMatches.size());
+      for(const auto& matchesIt : matches)
+      {
+        for(const auto& descMatchesIt : matchesIt.second)
+        {
+          const IndMatches& loaded = loadedMatches.at(matchesIt.first).at(descMatchesIt.first);
+          BOOST_CHECK(descMatchesIt.second == loaded);
+        }
+      }
+    }
+
+    // Load with filters applied on the pair index
+    {
+      PairwiseMatches loadedMatches;
+      BOOST_CHECK(Load(loadedMatches, {0, 1, 2}, {testFolder}, {EImageDescriberType::UNKNOWN}, 2));
+      BOOST_CHECK_EQUAL(2, loadedMatches.size());
+      BOOST_CHECK_EQUAL(0, loadedMatches.count(std::make_pair(2,3)));
+      BOOST_CHECK_EQUAL(1, loadedMatches.at(std::make_pair(0,1)).size());
+      BOOST_CHECK_EQUAL(2, loadedMatches.at(std::make_pair(0,1)).at(EImageDescriberType::UNKNOWN).size());
+      BOOST_CHECK_EQUAL(2, loadedMatches.at(std::make_pair(1,2)).at(EImageDescriberType::UNKNOWN).size());
+    }
+
+    // Fetch a single pair
+    if(!matchFilePerImage)
+    {
+      const MatchesFile matchesFile((fs::path(testFolder) / "matches.bin").string());
+      BOOST_CHECK_EQUAL(3, matchesFile.getNbPairs());
+      BOOST_CHECK(!matchesFile.hasPair(std::make_pair(0,2)));
+      BOOST_CHECK_EQUAL(3, matchesFile.getNbMatches(std::make_pair(1,2), EImageDescriberType::UNKNOWN));
+      BOOST_CHECK_EQUAL(0, matchesFile.getNbMatches(std::make_pair(1,2), EImageDescriberType::SIFT));
+
+      MatchesPerDescType pairMatches;
+      BOOST_CHECK(matchesFile.getMatches(std::make_pair(0,1), pairMatches));
+      BOOST_CHECK(matches.at(std::make_pair(0,1)).at(EImageDescriberType::SIFT) == pairMatches.at(EImageDescriberType::SIFT));
+    }
+
+    boost::filesystem::remove_all(testFolder);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(IndMatch_IO_Binary_Corrupted)
+{
+  const std::string testFolder = "matchingTestBinCorrupted";
+  boost::filesystem::create_directory(testFolder);
+  const std::string path = (fs::path(testFolder) / "matches.bin").string();
+
+  PairwiseMatches matches;
+  matches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}};
+  matches[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}, {2,2}};
+  saveMatchesFile(path, matches.begin(), matches.end());
+
+  std::string data;
+  {
+    std::ifstream stream(path, std::ios::in | std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+  }
+  const auto writeFile = [&path](const std::string& content)
+  {
+    std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    stream.write(content.data(), content.size());
+  };
+
+  const std::size_t nbPairsOffset = offsetof(MatchesFile::Header, nbPairs);
+  const std::size_t pairTableOffset = sizeof(MatchesFile::Header);
+  const std::size_t lastPairOffset = pairTableOffset + sizeof(MatchesFile::PairEntry) + offsetof(MatchesFile::PairEntry, offset);
+  std::uint64_t lastPairDataOffset;
+  std::memcpy(&lastPairDataOffset, &data[lastPairOffset], sizeof(lastPairDataOffset));
+  const std::size_t lastNbMatchesOffset = lastPairDataOffset + offsetof(MatchesFile::DescTypeEntry, nbMatches);
+
+  MatchesPerDescType pairMatches;
+
+  // truncated pair table
+  writeFile(data.substr(0, pairTableOffset + sizeof(MatchesFile::PairEntry)));
+  BOOST_CHECK_THROW(MatchesFile{path}, std::runtime_error);
+
+  // number of pairs overflowing the pair table size
+  {
+    std::string corrupted = data;
+    const std::uint32_t nbPairs = std::numeric_limits<std::uint32_t>::max();
+    std::memcpy(&corrupted[nbPairsOffset], &nbPairs, sizeof(nbPairs));
+    writeFile(corrupted);
+    BOOST_CHECK_THROW(MatchesFile{path}, std::runtime_error);
+  }
+
+  // truncated matches of the last pair
+  {
+    writeFile(data.substr(0, data.size() - sizeof(std::uint32_t)));
+    const MatchesFile matchesFile(path);
+    BOOST_CHECK(matchesFile.getMatches(std::make_pair(0,1), pairMatches));
+    BOOST_CHECK_THROW(matchesFile.getMatches(std::make_pair(1,2), pairMatches), std::runtime_error);
+  }
+
+  // offsets in the header, in the pair table, out of the file and overflowing
+  for(const std::uint64_t offset : {std::uint64_t(0), std::uint64_t(pairTableOffset),
+                                    std::uint64_t(data.size()), std::numeric_limits<std::uint64_t>::max() - 4})
+  {
+    std::string corrupted = data;
+    std::memcpy(&corrupted[lastPairOffset], &offset, sizeof(offset));
+    writeFile(corrupted);
+    const MatchesFile matchesFile(path);
+    BOOST_CHECK_THROW(matchesFile.getMatches(std::make_pair(1,2), pairMatches), std::runtime_error);
+    BOOST_CHECK_THROW(matchesFile.getNbMatches(std::make_pair(1,2), EImageDescriberType::UNKNOWN), std::runtime_error);
+  }
+
+  // number of matches overflowing the data size
+  {
+    std::string corrupted = data;
+    const std::uint32_t nbMatches = std::numeric_limits<std::uint32_t>::max();
+    std::memcpy(&corrupted[lastNbMatchesOffset], &nbMatches, sizeof(nbMatches));
+    writeFile(corrupted);
+    const MatchesFile matchesFile(path);
+    BOOST_CHECK_THROW(matchesFile.getMatches(std::make_pair(1,2), pairMatches), std::runtime_error);
+
+    PairwiseMatches loadedMatches;
+    BOOST_CHECK_THROW(matchesFile.load(loadedMatches), std::runtime_error);
+  }
+
+  boost::filesystem::remove_all(testFolder);
+}
+
 BOOST_AUTO_TEST_CASE(IndMatch_DuplicateRemoval_NoRemoval)
 {
   std::vector<IndMatch> vec_indMatch;
@@ -7,6 +7,7 @@
 
 #include "io.hpp"
 #include <aliceVision/matching/IndMatch.hpp>
+#include <aliceVision/matching/MatchesFile.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
 
@@ -23,14 +24,33 @@ namespace fs = boost::filesystem;
 namespace aliceVision {
 namespace matching {
 
-bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
+bool LoadMatchFile(PairwiseMatches& matches,
+                   const std::string& filepath,
+                   const std::set<IndexT>& viewsKeysFilter,
+                   const std::vector<feature::EImageDescriberType>& descTypesFilter,
+                   const int maxNbMatches)
 {
   const std::string ext = fs::extension(filepath);
 
   if(!fs::exists(filepath))
     return false;
 
-  if(ext == ".txt")
+  if(ext == ".bin")
+  {
+    // only decode the pairs and describer types passing the filters
+    try
+    {
+      const MatchesFile matchesFile(filepath);
+      matchesFile.load(matches, viewsKeysFilter, descTypesFilter, maxNbMatches);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_WARNING(e.what());
+      return false;
+    }
+    return true;
+  }
+  else if(ext == ".txt")
   {
     std::ifstream stream(filepath.c_str());
     if (!stream.is_open())
@@ -137,7 +157,9 @@ bool LoadMatchFilePerImage(
   PairwiseMatches& matches,
   const std::set<IndexT>& viewsKeys,
   const std::string& folder,
-  const std::string& basename)
+  const std::string& basename,
+  const std::vector<feature::EImageDescriberType>& descTypesFilter,
+  const int maxNbMatches)
 {
   int nbLoadedMatchFiles = 0;
   // Load one match file per image
@@ -147,9 +169,13 @@ bool LoadMatchFilePerImage(
     std::set<IndexT>::const_iterator it = viewsKeys.begin();
     std::advance(it, i);
     const IndexT idView = *it;
-    const std::string matchFilename = std::to_string(idView) + "." + basename;
     PairwiseMatches fileMatches;
-    if(!LoadMatchFile(fileMatches, (fs::path(folder) / matchFilename).string() ))
+    // binary file first, then text file
+    std::string matchFilename = std::to_string(idView) + "." + basename + ".bin";
+    if(!fs::exists(fs::path(folder) / matchFilename))
+      matchFilename = std::to_string(idView) + "." + basename + ".txt";
+
+    if(!LoadMatchFile(fileMatches, (fs::path(folder) / matchFilename).string(), viewsKeys, descTypesFilter, maxNbMatches))
     {
       #pragma omp critical
       {
@@ -192,16 +218,19 @@ bool Load(
   const int maxNbMatches)
 {
   bool res = false;
-  const std::string fileName = "matches.txt";
+  const std::string basename = "matches";
 
   for(const std::string& folder : folders)
   {
-    const fs::path filePath = fs::path(folder) / fileName;
+    const fs::path binFilePath = fs::path(folder) / (basename + ".bin");
+    const fs::path txtFilePath = fs::path(folder) / (basename + ".txt");
 
-    if(fs::exists(filePath))
-      res = LoadMatchFile(matches, filePath.string());
+    if(fs::exists(binFilePath))
+      res = LoadMatchFile(matches, binFilePath.string(), viewsKeysFilter, descTypesFilter, maxNbMatches);
+    else if(fs::exists(txtFilePath))
+      res = LoadMatchFile(matches, txtFilePath.string(), viewsKeysFilter, descTypesFilter, maxNbMatches);
     else
-      res = LoadMatchFilePerImage(matches, viewsKeysFilter, folder, fileName);
+      res = LoadMatchFilePerImage(matches, viewsKeysFilter, folder, basename, descTypesFilter, maxNbMatches);
   }
 
   if(!res)
@@ -267,6 +296,21 @@ private:
     fs::rename(tmpPath, filepath);
   }
 
+  void saveBin(
+    const std::string& filepath,
+    const PairwiseMatches::const_iterator& matchBegin,
+    const PairwiseMatches::const_iterator& matchEnd)
+  {
+    const fs::path bPath = fs::path(filepath);
+    const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+
+    // write temporary file
+    saveMatchesFile(tmpPath, matchBegin, matchEnd);
+
+    // rename temporary file
+    fs::rename(tmpPath, filepath);
+  }
+
 public:
   MatchExporter(
     const PairwiseMatches& matches,
@@ -287,6 +331,8 @@ public:
 
     if(m_ext == ".txt")
       saveTxt(filepath, m_matches.begin(), m_matches.end());
+    else if(m_ext == ".bin")
+      saveBin(filepath, m_matches.begin(), m_matches.end());
     else
       throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
   }
@@ -312,6 +358,8 @@ public:
       
       if(m_ext == ".txt")
         saveTxt(filepath, matchBegin, match);
+      else if(m_ext == ".bin")
+        saveBin(filepath, matchBegin, match);
       else
         throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
 
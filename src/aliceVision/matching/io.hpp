@@ -16,30 +16,51 @@ namespace matching {
 
   
 /**
- * @brief Load a match file.
+ * @brief Load a match file (.txt or .bin).
+ *
+ * With the binary format, the filters are applied on the pair index
+ * and only the selected matches are decoded.
  *
  * @param[out] matches: container for the output matches
- * @param[in] folder: folder containing the match files
+ * @param[in] filepath: the match file path
+ * @param[in] viewsKeysFilter: only load the pairs with both views in this set (binary format only)
+ * @param[in] descTypesFilter: only load these describer types (binary format only)
+ * @param[in] maxNbMatches: only load the N first matches for each desc. type (binary format only)
  */
 bool LoadMatchFile(
   PairwiseMatches& matches,
-  const std::string& folder,
-  const std::string& filename);
+  const std::string& filepath,
+  const std::set<IndexT>& viewsKeysFilter = {},
+  const std::vector<feature::EImageDescriberType>& descTypesFilter = {},
+  const int maxNbMatches = 0);
 
 /**
  * @brief Load the match file for each image.
  *
+ * The binary file (<viewId>.<basename>.bin) is used if available,
+ * otherwise the text file (<viewId>.<basename>.txt).
+ *
  * @param[out] matches: container for the output matches
+ * @param[in] viewsKeys: the views to load
  * @param[in] folder: folder containing the match files
+ * @param[in] basename: match files basename
+ * @param[in] descTypesFilter: only load these describer types (binary format only)
+ * @param[in] maxNbMatches: only load the N first matches for each desc. type (binary format only)
  */
 bool LoadMatchFilePerImage(
   PairwiseMatches& matches,
   const std::set<IndexT>& viewsKeys,
-  const std::string& folder);
+  const std::string& folder,
+  const std::string& basename,
+  const std::vector<feature::EImageDescriberType>& descTypesFilter = {},
+  const int maxNbMatches = 0);
 
 /**
  * @brief Load match files.
  *
+ * For each folder, matches.bin is used if available, then matches.txt,
+ * then the match files per image.
+ *
  * @param[out] matches: container for the output matches
  * @param[in] sfm_data
  * @param[in] folder: folder containing the match files
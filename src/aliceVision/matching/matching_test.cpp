@@ -9,7 +9,12 @@
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
+#include "aliceVision/matching/RegionsMatcher.hpp"
+#include "aliceVision/feature/regionsFactory.hpp"
 #include <iostream>
+#include <random>
+#include <vector>
+#include <algorithm>
 
 #define BOOST_TEST_MODULE matching
 #include <boost/test/included/unit_test.hpp>
@@ -82,6 +87,81 @@ BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_Simple_Dim4)
   BOOST_CHECK_SMALL(static_cast<double>(fDistance), 1e-8); //distance
 }
 
+template <typename Scalar, typename Metric>
+void checkBruteForceAgainstSort(int nbRows, int nbQuery, int dimension, size_t NN, int maxValue)
+{
+  typedef typename Metric::ResultType DistanceType;
+
+  std::mt19937 randomNumberGenerator(nbRows * 31 + dimension);
+  std::uniform_int_distribution<int> distribution(0, maxValue);
+
+  // small value range to get equal distances
+  std::vector<Scalar> dataset(nbRows * dimension);
+  std::vector<Scalar> query(nbQuery * dimension);
+  for(Scalar& value : dataset)
+    value = static_cast<Scalar>(distribution(randomNumberGenerator));
+  for(Scalar& value : query)
+    value = static_cast<Scalar>(distribution(randomNumberGenerator));
+
+  ArrayMatcher_bruteForce<Scalar, Metric> matcher;
+  BOOST_CHECK( matcher.Build(&dataset[0], nbRows, dimension) );
+
+  IndMatches vec_nIndice;
+  vector<DistanceType> vec_fDistance;
+  BOOST_CHECK( matcher.SearchNeighbours(&query[0], nbQuery, &vec_nIndice, &vec_fDistance, NN) );
+  BOOST_CHECK_EQUAL( nbQuery * NN, vec_nIndice.size());
+  BOOST_CHECK_EQUAL( nbQuery * NN, vec_fDistance.size());
+
+  // reference: stable sort of all the distances of each query
+  L2_Simple<Scalar> referenceMetric;
+  for(int q = 0; q < nbQuery; ++q)
+  {
+    std::vector<std::pair<DistanceType, int>> distances(nbRows);
+    for(int i = 0; i < nbRows; ++i)
+      distances[i] = std::make_pair(referenceMetric(&query[q * dimension], &dataset[i * dimension], dimension), i);
+    std::stable_sort(distances.begin(), distances.end(),
+                     [](const std::pair<DistanceType, int>& a, const std::pair<DistanceType, int>& b){ return a.first < b.first; });
+
+    for(size_t k = 0; k < NN; ++k)
+    {
+      BOOST_CHECK_EQUAL(IndMatch(q, distances[k].second), vec_nIndice[q * NN + k]);
+      BOOST_CHECK_EQUAL(distances[k].first, vec_fDistance[q * NN + k]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_Blocked_NN)
+{
+  // more rows and queries than a block, dimension not multiple of the SIMD width
+  checkBruteForceAgainstSort<unsigned char, L2_Vectorized<unsigned char>>(3000, 70, 128, 2, 255);
+  checkBruteForceAgainstSort<unsigned char, L2_Vectorized<unsigned char>>(1000, 33, 37, 2, 3);
+  checkBruteForceAgainstSort<float, L2_Simple<float>>(2000, 40, 128, 3, 4);
+  checkBruteForceAgainstSort<float, L2_Simple<float>>(5, 3, 2, 5, 1);
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_NN_MoreThanRows)
+{
+  const float array[] = {0, 1, 5};
+  ArrayMatcher_bruteForce<float> matcher;
+  BOOST_CHECK( matcher.Build(array, 3, 1) );
+
+  // NN is clamped to the number of rows, no invalid index is returned
+  const float query[] = {2, 6};
+  IndMatches vec_nIndice;
+  vector<float> vec_fDistance;
+  BOOST_CHECK( matcher.SearchNeighbours(query, 2, &vec_nIndice, &vec_fDistance, 5) );
+
+  BOOST_CHECK_EQUAL( 6, vec_nIndice.size());
+  BOOST_CHECK_EQUAL( 6, vec_fDistance.size());
+
+  BOOST_CHECK_EQUAL(IndMatch(0,1), vec_nIndice[0]);
+  BOOST_CHECK_EQUAL(IndMatch(0,0), vec_nIndice[1]);
+  BOOST_CHECK_EQUAL(IndMatch(0,2), vec_nIndice[2]);
+  BOOST_CHECK_EQUAL(IndMatch(1,2), vec_nIndice[3]);
+  BOOST_CHECK_EQUAL(IndMatch(1,1), vec_nIndice[4]);
+  BOOST_CHECK_EQUAL(IndMatch(1,0), vec_nIndice[5]);
+}
+
 BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_kdtreeFlann_Simple__NN)
 {
   const float array[] = {0, 1, 2, 5, 6};
@@ -148,3 +228,52 @@ BOOST_AUTO_TEST_CASE(Matching_Cascade_Hashing_Simple_EmptyArrays)
   float fDistance = -1.0f;
   BOOST_CHECK(! matcher.SearchNeighbour( &array[0], &nIndice, &fDistance) );
 }
+
+BOOST_AUTO_TEST_CASE(Matching_RegionsMatcher_CascadeHashing)
+{
+  // the cascade hasher skips the queries without enough candidates:
+  // the other queries of the pair must still be matched
+  const int nbFeatures = 200;
+  const int nbOutliers = 50;
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> descValue(0, 255);
+  std::uniform_int_distribution<int> noise(-2, 2);
+
+  feature::SIFT_Regions database;
+  for(int i = 0; i < nbFeatures; ++i)
+  {
+    feature::SIFT_Regions::DescriptorT desc;
+    for(std::size_t k = 0; k < desc.size(); ++k)
+      desc[k] = static_cast<unsigned char>(descValue(generator));
+    database.Features().emplace_back(static_cast<float>(i), static_cast<float>(2 * i));
+    database.Descriptors().push_back(desc);
+  }
+
+  // the query descriptors are the database descriptors in reverse order with some noise, followed by outliers
+  feature::SIFT_Regions query;
+  for(int i = 0; i < nbFeatures + nbOutliers; ++i)
+  {
+    feature::SIFT_Regions::DescriptorT desc;
+    for(std::size_t k = 0; k < desc.size(); ++k)
+    {
+      if(i < nbFeatures)
+      {
+        const int value = database.Descriptors()[nbFeatures - 1 - i][k] + noise(generator);
+        desc[k] = static_cast<unsigned char>(std::min(255, std::max(0, value)));
+      }
+      else
+        desc[k] = static_cast<unsigned char>(descValue(generator));
+    }
+    query.Features().emplace_back(static_cast<float>(i), static_cast<float>(2 * i + 1));
+    query.Descriptors().push_back(desc);
+  }
+
+  typedef ArrayMatcher_cascadeHashing<unsigned char, L2_Vectorized<unsigned char>> MatcherT;
+  RegionsMatcher<MatcherT> matcher(database, true);
+
+  IndMatches matches;
+  BOOST_CHECK(matcher.Match(0.8f, query, matches));
+  BOOST_CHECK_GE(matches.size(), static_cast<std::size_t>(nbFeatures / 2));
+  for(const IndMatch& match : matches)
+    BOOST_CHECK_EQUAL(match._i, nbFeatures - 1 - match._j);
+}
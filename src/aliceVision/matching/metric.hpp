@@ -14,6 +14,10 @@
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
 #include <aliceVision/system/Logger.hpp>
 #include <xmmintrin.h>
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 #endif
 
 #include <cstddef>
@@ -134,6 +138,72 @@ struct L2_Vectorized<float>
   }
 };
 
+namespace optim_ss2{
+
+  // Euclidean distance between unsigned char arrays (SSE2/AVX2 method) (squared result)
+  // The differences are computed on 16 bits and squared/accumulated on 32 bits integers,
+  // so the result is exact (as the scalar version for descriptors up to 256 components).
+  inline float l2_sse_uchar(const unsigned char * b1, const unsigned char * b2, int size)
+  {
+    int i = 0;
+    int result = 0;
+#if defined(__AVX2__)
+    __m256i cumSum = _mm256_setzero_si256();
+    for(; i + 16 <= size; i += 16)
+    {
+      const __m256i srcA = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b1 + i)));
+      const __m256i srcB = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b2 + i)));
+      //-- Subtract
+      const __m256i diff = _mm256_sub_epi16(srcA, srcB);
+      //-- Multiply and sum adjacent pairs
+      cumSum = _mm256_add_epi32(cumSum, _mm256_madd_epi16(diff, diff));
+    }
+    __m128i cumSum128 = _mm_add_epi32(_mm256_castsi256_si128(cumSum), _mm256_extracti128_si256(cumSum, 1));
+#else
+    const __m128i zero = _mm_setzero_si128();
+    __m128i cumSum128 = _mm_setzero_si128();
+    for(; i + 16 <= size; i += 16)
+    {
+      const __m128i srcA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b1 + i));
+      const __m128i srcB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b2 + i));
+      //-- Subtract
+      const __m128i diffLow = _mm_sub_epi16(_mm_unpacklo_epi8(srcA, zero), _mm_unpacklo_epi8(srcB, zero));
+      const __m128i diffHigh = _mm_sub_epi16(_mm_unpackhi_epi8(srcA, zero), _mm_unpackhi_epi8(srcB, zero));
+      //-- Multiply and sum adjacent pairs
+      cumSum128 = _mm_add_epi32(cumSum128, _mm_madd_epi16(diffLow, diffLow));
+      cumSum128 = _mm_add_epi32(cumSum128, _mm_madd_epi16(diffHigh, diffHigh));
+    }
+#endif
+    //-- horizontal sum
+    cumSum128 = _mm_add_epi32(cumSum128, _mm_shuffle_epi32(cumSum128, _MM_SHUFFLE(1, 0, 3, 2)));
+    cumSum128 = _mm_add_epi32(cumSum128, _mm_shuffle_epi32(cumSum128, _MM_SHUFFLE(2, 3, 0, 1)));
+    result = _mm_cvtsi128_si32(cumSum128);
+
+    // Process the last elements
+    for(; i < size; ++i)
+    {
+      const int diff = static_cast<int>(b1[i]) - static_cast<int>(b2[i]);
+      result += diff * diff;
+    }
+    return static_cast<float>(result);
+  }
+} // namespace optim_ss2
+
+// Template specification to run SSE2 L2 squared distance
+//  on unsigned char vector
+template<>
+struct L2_Vectorized<unsigned char>
+{
+  typedef unsigned char ElementType;
+  typedef Accumulator<unsigned char>::Type ResultType;
+
+  template <typename Iterator1, typename Iterator2>
+  inline ResultType operator()(Iterator1 a, Iterator2 b, size_t size) const
+  {
+    return optim_ss2::l2_sse_uchar(a,b,size);
+  }
+};
+
 #endif // ALICEVISION_HAVE_SSE
 
 }  // namespace matching
@@ -12,9 +12,14 @@
 #include <aliceVision/feature/RegionsPerView.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/matchingImageCollection/GeometricFilterMatrix.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <utility>
 #include <vector>
 #include <map>
 
@@ -48,46 +53,83 @@ void robustModelEstimation(
 {
   out_geometricMatches.clear();
 
-  boost::progress_display progressBar(putativeMatches.size(), std::cout, "Robust Model Estimation\n");
-  
-#pragma omp parallel for schedule(dynamic)
-  for (int i = 0; i < (int)putativeMatches.size(); ++i)
+  // flat list of the pairs, sorted by decreasing number of putative matches:
+  // the most expensive pairs are estimated first to balance the load of the threads
+  typedef std::pair<std::size_t, PairwiseMatches::const_iterator> NbMatchesPair;
+  std::vector<NbMatchesPair> pairs;
+  pairs.reserve(putativeMatches.size());
+  for(PairwiseMatches::const_iterator iter = putativeMatches.begin(); iter != putativeMatches.end(); ++iter)
   {
-    PairwiseMatches::const_iterator iter = putativeMatches.begin();
-    std::advance(iter, i);
+    std::size_t nbMatches = 0;
+    for(const auto& matches : iter->second)
+      nbMatches += matches.second.size();
+    pairs.emplace_back(nbMatches, iter);
+  }
+  std::stable_sort(pairs.begin(), pairs.end(),
+                   [](const NbMatchesPair& a, const NbMatchesPair& b)
+                   {
+                     return a.first > b.first;
+                   });
+
+  // results per thread, merged at the end
+  std::vector<std::vector<std::pair<Pair, MatchesPerDescType>>> geometricMatchesPerThread(omp_get_max_threads());
+
+  boost::progress_display progressBar(putativeMatches.size(), std::cout, "Robust Model Estimation\n");
+  std::atomic<std::size_t> nbEstimatedPairs(0);
+  std::size_t nbDisplayedPairs = 0; // only updated by the master thread
 
-    const Pair currentPair = iter->first;
-    const MatchesPerDescType& putativeMatchesPerType = iter->second;
-    const Pair& imagePair = iter->first;
+#pragma omp parallel
+  {
+    std::vector<std::pair<Pair, MatchesPerDescType>>& threadGeometricMatches = geometricMatchesPerThread[omp_get_thread_num()];
 
-    // apply the geometric filter (robust model estimation)
+#pragma omp for schedule(dynamic)
+    for (int i = 0; i < (int)pairs.size(); ++i)
     {
-      MatchesPerDescType inliers;
-      GeometryFunctor geometricFilter = functor; // use a copy since we are in a multi-thread context
-      const EstimationStatus state = geometricFilter.geometricEstimation(sfmData, regionsPerView, imagePair, putativeMatchesPerType, inliers);
-      if(state.hasStrongSupport)
-      {
-        if(guidedMatching)
-        {
-          MatchesPerDescType guidedGeometricInliers;
-          geometricFilter.Geometry_guided_matching(sfmData, regionsPerView, imagePair, distanceRatio, guidedGeometricInliers);
-          //ALICEVISION_LOG_DEBUG("#before/#after: " << putative_inliers.size() << "/" << guided_geometric_inliers.size());
-          std::swap(inliers, guidedGeometricInliers);
-        }
+      const Pair& imagePair = pairs[i].second->first;
+      const MatchesPerDescType& putativeMatchesPerType = pairs[i].second->second;
 
-#pragma omp critical
+      // apply the geometric filter (robust model estimation)
+      {
+        MatchesPerDescType inliers;
+        GeometryFunctor geometricFilter = functor; // use a copy since we are in a multi-thread context
+        const EstimationStatus state = geometricFilter.geometricEstimation(sfmData, regionsPerView, imagePair, putativeMatchesPerType, inliers);
+        if(state.hasStrongSupport)
         {
-          out_geometricMatches.emplace(currentPair, std::move(inliers));
+          if(guidedMatching)
+          {
+            MatchesPerDescType guidedGeometricInliers;
+            geometricFilter.Geometry_guided_matching(sfmData, regionsPerView, imagePair, distanceRatio, guidedGeometricInliers);
+            //ALICEVISION_LOG_DEBUG("#before/#after: " << putative_inliers.size() << "/" << guided_geometric_inliers.size());
+            std::swap(inliers, guidedGeometricInliers);
+          }
+          threadGeometricMatches.emplace_back(imagePair, std::move(inliers));
         }
-
       }
-    }
 
-#pragma omp critical
-    {
-      ++progressBar;
+      ++nbEstimatedPairs;
+      // the progress bar is not thread-safe
+      if(omp_get_thread_num() == 0)
+      {
+        for(const std::size_t nbPairs = nbEstimatedPairs; nbDisplayedPairs < nbPairs; ++nbDisplayedPairs)
+          ++progressBar;
+      }
     }
   }
+
+  for(; nbDisplayedPairs < pairs.size(); ++nbDisplayedPairs)
+    ++progressBar;
+
+  // merge the results, in the pairs order
+  std::vector<std::pair<Pair, MatchesPerDescType>> geometricMatches;
+  for(std::vector<std::pair<Pair, MatchesPerDescType>>& threadGeometricMatches : geometricMatchesPerThread)
+    std::move(threadGeometricMatches.begin(), threadGeometricMatches.end(), std::back_inserter(geometricMatches));
+  std::sort(geometricMatches.begin(), geometricMatches.end(),
+            [](const std::pair<Pair, MatchesPerDescType>& a, const std::pair<Pair, MatchesPerDescType>& b)
+            {
+              return a.first < b.first;
+            });
+  for(std::pair<Pair, MatchesPerDescType>& pairMatches : geometricMatches)
+    out_geometricMatches.emplace_hint(out_geometricMatches.end(), pairMatches.first, std::move(pairMatches.second));
 }
 
 } // namespace matchingImageCollection
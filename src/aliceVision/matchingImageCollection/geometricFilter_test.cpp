@@ -0,0 +1,173 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/matchingImageCollection/GeometricFilter.hpp"
+#include "aliceVision/alicevision_omp.hpp"
+
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE matchingImageCollectionGeometricFilter
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::matching;
+using namespace aliceVision::matchingImageCollection;
+
+namespace {
+
+/**
+ * @brief Deterministic geometric filter: keeps the matches between features of the same parity.
+ *        The pairs with less than minNbInliers inliers have no strong support.
+ */
+struct ParityGeometricFilter
+{
+  std::size_t minNbInliers = 10;
+
+  EstimationStatus geometricEstimation(const sfmData::SfMData* sfmData,
+                                       const feature::RegionsPerView& regionsPerView,
+                                       const Pair& pairIndex,
+                                       const MatchesPerDescType& putativeMatchesPerType,
+                                       MatchesPerDescType& out_geometricInliersPerType)
+  {
+    std::size_t nbInliers = 0;
+    for(const auto& putativeMatches : putativeMatchesPerType)
+    {
+      for(const IndMatch& match : putativeMatches.second)
+      {
+        if((match._i + match._j) % 2 != 0)
+          continue;
+        out_geometricInliersPerType[putativeMatches.first].push_back(match);
+        ++nbInliers;
+      }
+    }
+    return EstimationStatus(nbInliers > 0, nbInliers >= minNbInliers);
+  }
+
+  /// the guided matches only depend on the pair
+  bool Geometry_guided_matching(const sfmData::SfMData* sfmData,
+                                const feature::RegionsPerView& regionsPerView,
+                                const Pair& imageIdsPair,
+                                const double dDistanceRatio,
+                                MatchesPerDescType& matches)
+  {
+    matches[feature::EImageDescriberType::SIFT].emplace_back(imageIdsPair.first, imageIdsPair.second);
+    return true;
+  }
+};
+
+PairwiseMatches createPutativeMatches(std::size_t nbPairs, unsigned int seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<IndexT> view(0, 100);
+  std::uniform_int_distribution<int> nbMatches(0, 60);
+  std::uniform_int_distribution<IndexT> feature(0, 1000);
+  std::bernoulli_distribution hasAkaze(0.3);
+
+  PairwiseMatches putativeMatches;
+  while(putativeMatches.size() < nbPairs)
+  {
+    const IndexT I = view(generator);
+    const IndexT J = view(generator);
+    if(I >= J)
+      continue;
+    MatchesPerDescType& matches = putativeMatches[Pair(I, J)];
+    matches.clear();
+    for(feature::EImageDescriberType descType : {feature::EImageDescriberType::SIFT, feature::EImageDescriberType::AKAZE})
+    {
+      if(descType == feature::EImageDescriberType::AKAZE && !hasAkaze(generator))
+        continue;
+      IndMatches& descMatches = matches[descType];
+      for(int m = nbMatches(generator); m > 0; --m)
+        descMatches.emplace_back(feature(generator), feature(generator));
+    }
+  }
+  return putativeMatches;
+}
+
+void checkSameMatches(const PairwiseMatches& matchesA, const PairwiseMatches& matchesB)
+{
+  BOOST_REQUIRE_EQUAL(matchesA.size(), matchesB.size());
+  for(auto itA = matchesA.begin(), itB = matchesB.begin(); itA != matchesA.end(); ++itA, ++itB)
+  {
+    BOOST_CHECK(itA->first == itB->first);
+    BOOST_REQUIRE_EQUAL(itA->second.size(), itB->second.size());
+    for(auto descA = itA->second.begin(), descB = itB->second.begin(); descA != itA->second.end(); ++descA, ++descB)
+    {
+      BOOST_CHECK(descA->first == descB->first);
+      BOOST_CHECK(descA->second == descB->second);
+    }
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(GeometricFilter_sameAsSequential)
+{
+  const PairwiseMatches putativeMatches = createPutativeMatches(500, 42);
+  const feature::RegionsPerView regionsPerView;
+  const ParityGeometricFilter functor;
+
+  for(const bool guidedMatching : {false, true})
+  {
+    // sequential estimation of each pair
+    PairwiseMatches expectedMatches;
+    for(const auto& pairMatches : putativeMatches)
+    {
+      ParityGeometricFilter geometricFilter = functor;
+      MatchesPerDescType inliers;
+      const EstimationStatus state = geometricFilter.geometricEstimation(nullptr, regionsPerView, pairMatches.first, pairMatches.second, inliers);
+      if(!state.hasStrongSupport)
+        continue;
+      if(guidedMatching)
+      {
+        inliers.clear();
+        geometricFilter.Geometry_guided_matching(nullptr, regionsPerView, pairMatches.first, 0.6, inliers);
+      }
+      expectedMatches[pairMatches.first] = inliers;
+    }
+    BOOST_CHECK(!expectedMatches.empty());
+    BOOST_CHECK_LT(expectedMatches.size(), putativeMatches.size());
+
+    // the result does not depend on the number of threads
+    for(const int nbThreads : {1, 2, 4, 8})
+    {
+      omp_set_num_threads(nbThreads);
+      PairwiseMatches geometricMatches;
+      robustModelEstimation(geometricMatches, nullptr, regionsPerView, functor, putativeMatches, guidedMatching);
+      checkSameMatches(geometricMatches, expectedMatches);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GeometricFilter_deterministic)
+{
+  // pairs with the same number of matches, estimated in any order by the threads
+  PairwiseMatches putativeMatches;
+  for(IndexT I = 0; I < 20; ++I)
+  {
+    for(IndexT J = I + 1; J < 20; ++J)
+    {
+      IndMatches& matches = putativeMatches[Pair(I, J)][feature::EImageDescriberType::SIFT];
+      for(IndexT m = 0; m < 20; ++m)
+        matches.emplace_back(m + I, m + J + (m % 3 == 0 ? 1 : 0));
+    }
+  }
+  const feature::RegionsPerView regionsPerView;
+
+  omp_set_num_threads(1);
+  PairwiseMatches referenceMatches;
+  robustModelEstimation(referenceMatches, nullptr, regionsPerView, ParityGeometricFilter(), putativeMatches);
+  BOOST_CHECK(!referenceMatches.empty());
+
+  omp_set_num_threads(4);
+  for(int run = 0; run < 10; ++run)
+  {
+    PairwiseMatches geometricMatches;
+    robustModelEstimation(geometricMatches, nullptr, regionsPerView, ParityGeometricFilter(), putativeMatches);
+    checkSameMatches(geometricMatches, referenceMatches);
+  }
+}
@@ -23,7 +23,9 @@
 
 #include <boost/algorithm/string/case_conv.hpp> 
 
+#include <future>
 #include <map>
+#include <memory>
 #include <set>
 
 namespace aliceVision {
@@ -234,15 +236,6 @@ void Texturing::generateUVs(mvsUtils::MultiViewParams& mp)
     deleteArrayOfArrays<int>(&updatedPointsCams);
 }
 
-void Texturing::generateTextures(const mvsUtils::MultiViewParams &mp,
-                                 const boost::filesystem::path &outPath, EImageFileType textureFileType)
-{
-    mvsUtils::ImagesCache imageCache(&mp, 0, false);
-    for(size_t atlasID = 0; atlasID < _atlases.size(); ++atlasID)
-        generateTexture(mp, atlasID, imageCache, outPath, textureFileType);
-}
-
-
 /// accumulates colors and keeps count for providing average
 struct AccuColor {
     Color colorSum;
@@ -258,18 +251,77 @@ struct AccuColor {
         return count > 0 ? colorSum / (float)count : colorSum;
     }
 
-    void operator+(const Color& other)
+    AccuColor& operator+=(const Color& other)
     {
         add(other);
+        return *this;
     }
+};
 
-    AccuColor& operator+=(const Color& other)
+/// accumulated colors of a texture atlas
+struct Texturing::AccuImage
+{
+    /// accumulated colors per pixel
+    std::vector<AccuColor> colors;
+
+    void resize(unsigned int textureSide)
     {
-        add(other);
-        return *this;
+        colors.assign(std::size_t(textureSide) * textureSide, AccuColor());
+    }
+
+    /// @return the memory used by an atlas of the given size
+    static std::size_t memorySize(unsigned int textureSide)
+    {
+        return std::size_t(textureSide) * textureSide * sizeof(AccuColor);
     }
 };
 
+void Texturing::generateTextures(const mvsUtils::MultiViewParams &mp,
+                                 const boost::filesystem::path &outPath, EImageFileType textureFileType)
+{
+    mvsUtils::ImagesCache imageCache(&mp, 0);
+
+    // Number of atlases accumulated together (with a single pass on the cameras).
+    // When there are several passes, the atlases of a pass are written while
+    // the next pass is computed, so half of the memory budget is used by each.
+    // The atlases are then spread evenly over the passes.
+    const std::size_t atlasMemorySize = AccuImage::memorySize(texParams.textureSide);
+    std::size_t nbAtlasesPerPass = std::max(std::size_t(1), (std::size_t(texParams.atlasesMemoryBudget) << 20) / atlasMemorySize);
+    if(nbAtlasesPerPass < _atlases.size())
+        nbAtlasesPerPass = std::max(std::size_t(1), nbAtlasesPerPass / 2);
+    const std::size_t nbPasses = std::max(std::size_t(1), (_atlases.size() + nbAtlasesPerPass - 1) / nbAtlasesPerPass);
+    nbAtlasesPerPass = std::max(std::size_t(1), (_atlases.size() + nbPasses - 1) / nbPasses);
+
+    ALICEVISION_LOG_INFO("Generating " << _atlases.size() << " texture atlases, " << nbAtlasesPerPass << " atlas(es) per pass on the cameras"
+                         << " (" << nbPasses << " pass(es), " << (atlasMemorySize >> 20) << " MB per atlas).");
+
+    std::future<void> pendingWrites;
+    for(size_t firstAtlasID = 0; firstAtlasID < _atlases.size(); firstAtlasID += nbAtlasesPerPass)
+    {
+        std::vector<size_t> atlasIDs;
+        for(size_t atlasID = firstAtlasID; atlasID < std::min(firstAtlasID + nbAtlasesPerPass, _atlases.size()); ++atlasID)
+            atlasIDs.push_back(atlasID);
+
+        ALICEVISION_LOG_INFO("Pass " << firstAtlasID / nbAtlasesPerPass + 1 << "/" << nbPasses << " on the cameras: atlases "
+                             << atlasIDs.front() + 1 << " to " << atlasIDs.back() + 1 << ".");
+
+        std::shared_ptr<std::vector<AccuImage>> accuImages = std::make_shared<std::vector<AccuImage>>();
+        generateAtlasesColors(mp, atlasIDs, imageCache, *accuImages);
+
+        // wait for the previous atlases
+        if(pendingWrites.valid())
+            pendingWrites.get();
+
+        // write the atlases in the background, while the images of the next atlases are read
+        pendingWrites = std::async(std::launch::async, [this, atlasIDs, accuImages, &outPath, textureFileType]()
+        {
+            for(size_t i = 0; i < atlasIDs.size(); ++i)
+                writeTexture((*accuImages)[i], atlasIDs[i], outPath, textureFileType);
+        });
+    }
+    if(pendingWrites.valid())
+        pendingWrites.get();
+}
 
 void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
                                 size_t atlasID, mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, EImageFileType textureFileType)
@@ -277,13 +329,75 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
     if(atlasID >= _atlases.size())
         throw std::runtime_error("Invalid atlas ID " + std::to_string(atlasID));
 
-    unsigned int textureSize = texParams.textureSide * texParams.textureSide;
-    std::vector<int> colorIDs(textureSize, -1);
+    std::vector<AccuImage> accuImages;
+    generateAtlasesColors(mp, {atlasID}, imageCache, accuImages);
+    writeTexture(accuImages.front(), atlasID, outPath, textureFileType);
+}
+
+void Texturing::generateAtlasesColors(const mvsUtils::MultiViewParams& mp, const std::vector<size_t>& atlasIDs,
+                                      mvsUtils::ImagesCache& imageCache, std::vector<AccuImage>& accuImages) const
+{
+    // per atlas, triangles to texture with each camera
+    std::vector<std::vector<std::vector<unsigned int>>> camTriangles(atlasIDs.size());
+
+    #pragma omp parallel for
+    for(int i = 0; i < atlasIDs.size(); ++i)
+    {
+        ALICEVISION_LOG_INFO("Selecting cameras for atlas " << atlasIDs[i] + 1 << "/" << _atlases.size()
+                  << " (" << _atlases[atlasIDs[i]].size() << " triangles).");
+        selectTrianglesCameras(mp, atlasIDs[i], camTriangles[i]);
+    }
+
+    // cameras used by at least one atlas
+    std::vector<int> cameras;
+    for(int camId = 0; camId < mp.ncams; ++camId)
+    {
+        for(const auto& atlasCamTriangles : camTriangles)
+        {
+            if(!atlasCamTriangles[camId].empty())
+            {
+                cameras.push_back(camId);
+                break;
+            }
+        }
+    }
 
-    std::vector<std::vector<unsigned int>> camTriangles(mp.ncams);
+    accuImages.resize(atlasIDs.size());
+    for(AccuImage& accuImage : accuImages)
+        accuImage.resize(texParams.textureSide);
 
-    ALICEVISION_LOG_INFO("Generating texture for atlas " << atlasID + 1 << "/" << _atlases.size()
-              << " (" << _atlases[atlasID].size() << " triangles).");
+    ALICEVISION_LOG_INFO("Reading pixel color.");
+
+    // each camera image is read once and splatted into all the atlases
+    for(size_t c = 0; c < cameras.size(); ++c)
+    {
+        const int camId = cameras[c];
+
+        // load the image of the next camera in the background
+        if(c + 1 < cameras.size())
+            imageCache.refreshImage_async(cameras[c + 1]);
+
+        const mvsUtils::ImagesCache::ImgSharedPtr img = imageCache.getImg_sync(camId);
+
+        for(size_t i = 0; i < atlasIDs.size(); ++i)
+        {
+            const std::vector<unsigned int>& triangles = camTriangles[i][camId];
+            if(triangles.empty())
+                continue;
+
+            ALICEVISION_LOG_INFO(" - camera " << camId + 1 << "/" << mp.ncams << ", atlas " << atlasIDs[i] + 1
+                                 << " (" << triangles.size() << " triangles)");
+            fillTextureFromImage(mp, camId, *img, triangles, accuImages[i]);
+            // release the memory of the triangles list
+            camTriangles[i][camId] = std::vector<unsigned int>();
+        }
+    }
+}
+
+void Texturing::selectTrianglesCameras(const mvsUtils::MultiViewParams& mp, size_t atlasID,
+                                       std::vector<std::vector<unsigned int>>& camTriangles) const
+{
+    camTriangles.assign(mp.ncams, std::vector<unsigned int>());
 
     // iterate over atlas' triangles
     for(size_t i = 0; i < _atlases[atlasID].size(); ++i)
@@ -393,94 +507,94 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
             camTriangles[camId].push_back(triangleId);
         }
     }
+}
 
-    ALICEVISION_LOG_INFO("Reading pixel color.");
-
-    std::vector<AccuColor> perPixelColors(textureSize);
-
-    // iterate over triangles for each camera
-    int camId = 0;
-    for(const std::vector<unsigned int>& triangles : camTriangles)
+void Texturing::fillTextureFromImage(const mvsUtils::MultiViewParams& mp, int camId, const mvsUtils::ImagesCache::Img& img,
+                                     const std::vector<unsigned int>& triangles, AccuImage& accuImage) const
+{
+    #pragma omp parallel for
+    for(int ti = 0; ti < triangles.size(); ++ti)
     {
-        ALICEVISION_LOG_INFO(" - camera " << camId + 1 << "/" << mp.ncams << " (" << triangles.size() << " triangles)");
+        const unsigned int triangleId = triangles[ti];
+        // retrieve triangle 3D and UV coordinates
+        Point2d triPixs[3];
+        Point3d triPts[3];
 
-        imageCache.refreshData(camId);
-        #pragma omp parallel for
-        for(int ti = 0; ti < triangles.size(); ++ti)
+        for(int k = 0; k < 3; k++)
         {
-            const unsigned int triangleId = triangles[ti];
-            // retrieve triangle 3D and UV coordinates
-            Point2d triPixs[3];
-            Point3d triPts[3];
+            const int pointIndex = (*me->tris)[triangleId].v[k];
+            triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
+            const int uvPointIndex = trisUvIds[triangleId].m[k];
+            triPixs[k] = uvCoords[uvPointIndex] * texParams.textureSide;   // UV coordinates
+        }
 
-            for(int k = 0; k < 3; k++)
+        // compute triangle bounding box in pixel indexes
+        // min values: floor(value)
+        // max values: ceil(value)
+        Pixel LU, RD;
+        LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+        LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+        RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+        RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+
+        // sanity check: clamp values to [0; textureSide]
+        int texSide = static_cast<int>(texParams.textureSide);
+        LU.x = clamp(LU.x, 0, texSide);
+        LU.y = clamp(LU.y, 0, texSide);
+        RD.x = clamp(RD.x, 0, texSide);
+        RD.y = clamp(RD.y, 0, texSide);
+
+        // iterate over bounding box's pixels
+        for(int y = LU.y; y < RD.y; y++)
+        {
+            for(int x = LU.x; x < RD.x; x++)
             {
-                const int pointIndex = (*me->tris)[triangleId].v[k];
-                triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
-                const int uvPointIndex = trisUvIds[triangleId].m[k];
-                triPixs[k] = uvCoords[uvPointIndex] * texParams.textureSide;   // UV coordinates
-            }
+                Pixel pix(x, y); // top-left corner of the pixel
+                Point2d barycCoords;
 
-            // compute triangle bounding box in pixel indexes
-            // min values: floor(value)
-            // max values: ceil(value)
-            Pixel LU, RD;
-            LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-            LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-            RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-            RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-
-            // sanity check: clamp values to [0; textureSide]
-            int texSide = static_cast<int>(texParams.textureSide);
-            LU.x = clamp(LU.x, 0, texSide);
-            LU.y = clamp(LU.y, 0, texSide);
-            RD.x = clamp(RD.x, 0, texSide);
-            RD.y = clamp(RD.y, 0, texSide);
-
-            // iterate over bounding box's pixels
-            for(int y = LU.y; y < RD.y; y++)
-            {
-                for(int x = LU.x; x < RD.x; x++)
+                // test if the pixel is inside triangle
+                // and retrieve its barycentric coordinates
+                if(!isPixelInTriangle(triPixs, pix, barycCoords))
                 {
-                    Pixel pix(x, y); // top-left corner of the pixel
-                    Point2d barycCoords;
-
-                    // test if the pixel is inside triangle
-                    // and retrieve its barycentric coordinates
-                    if(!isPixelInTriangle(triPixs, pix, barycCoords))
-                    {
-                        continue;
-                    }
-
-                    // remap 'y' to image coordinates system (inverted Y axis)
-                    const unsigned int y_ = (texParams.textureSide - 1) - y;
-                    // 1D pixel index
-                    unsigned int xyoffset = y_ * texParams.textureSide + x;
-                    // get 3D coordinates
-                    Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
-                    // get 2D coordinates in source image
-                    Point2d pixRC;
-                    mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
-                    // exclude out of bounds pixels
-                    if(!mp.isPixelInImage(pixRC, camId))
-                        continue;
-                    Color color = imageCache.getPixelValueInterpolated(&pixRC, camId);
-                    // If the color is pure zero, we consider it as an invalid pixel.
-                    // After correction of radial distortion, some pixels are invalid.
-                    // TODO: use an alpha channel instead.
-                    if(color == Color(0.f, 0.f, 0.f))
-                        continue;
-                    // fill the accumulated color map for this pixel
-                    perPixelColors[xyoffset] += color;
-                    // fill the colorID map
-                    colorIDs[xyoffset] = xyoffset;
+                    continue;
                 }
+
+                // remap 'y' to image coordinates system (inverted Y axis)
+                const unsigned int y_ = (texParams.textureSide - 1) - y;
+                // 1D pixel index
+                unsigned int xyoffset = y_ * texParams.textureSide + x;
+                // get 3D coordinates
+                Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
+                // get 2D coordinates in source image
+                Point2d pixRC;
+                mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
+                // exclude out of bounds pixels
+                if(!mp.isPixelInImage(pixRC, camId))
+                    continue;
+                Color color = img.getInterpolated(pixRC);
+                // If the color is pure zero, we consider it as an invalid pixel.
+                // After correction of radial distortion, some pixels are invalid.
+                // TODO: use an alpha channel instead.
+                if(color == Color(0.f, 0.f, 0.f))
+                    continue;
+                // fill the accumulated color map for this pixel
+                accuImage.colors[xyoffset] += color;
             }
         }
-        // increment current cam index
-        camId++;
     }
-    camTriangles.clear();
+}
+
+void Texturing::writeTexture(AccuImage& accuImage, size_t atlasID, const bfs::path& outPath, EImageFileType textureFileType) const
+{
+    const unsigned int textureSize = texParams.textureSide * texParams.textureSide;
+
+    // colorID map: pixel used for the color of each pixel (-1 if none)
+    std::vector<int> colorIDs(textureSize, -1);
+    for(unsigned int i = 0; i < textureSize; ++i)
+    {
+        if(accuImage.colors[i].count > 0)
+            colorIDs[i] = i;
+    }
 
     if(!texParams.fillHoles && texParams.padding > 0)
     {
@@ -540,7 +654,7 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
             Color color;
             if(colorID >= 0)
             {
-                color = perPixelColors[colorID].average();
+                color = accuImage.colors[colorID].average();
                 if(texParams.fillHoles)
                     alphaBuffer[xyoffset] = 1.0f;
             }
@@ -548,8 +662,9 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
         }
     }
 
-    perPixelColors.clear();
-    colorIDs.clear();
+    // release the accumulated colors
+    std::vector<AccuColor>().swap(accuImage.colors);
+    std::vector<int>().swap(colorIDs);
 
     std::string textureName = "texture_" + std::to_string(atlasID) + "." + EImageFileType_enumToString(textureFileType);
     bfs::path texturePath = outPath / textureName;
@@ -74,6 +74,7 @@ struct TexturingParams
     unsigned int padding = 15;
     unsigned int downscale = 2;
     bool fillHoles = false;
+    unsigned int atlasesMemoryBudget = 4096; //< memory (in MB) for the texture atlases accumulated with a single pass on the cameras
 };
 
 struct Texturing
@@ -154,6 +155,33 @@ public:
 
     /// Save textured mesh as an OBJ + MTL file
     void saveAsOBJ(const bfs::path& dir, const std::string& basename, EImageFileType textureFileType = EImageFileType::PNG);
+
+private:
+    /// accumulated colors of a texture atlas
+    struct AccuImage;
+
+    /**
+     * @brief Accumulate the colors of several texture atlases.
+     *        Each camera image is read once and used for all the atlases.
+     *
+     * @param[in] mp the multi-view parameters
+     * @param[in] atlasIDs the texture atlas indexes
+     * @param[in] imageCache the camera images cache
+     * @param[out] accuImages the accumulated colors, one per atlas
+     */
+    void generateAtlasesColors(const mvsUtils::MultiViewParams& mp, const std::vector<size_t>& atlasIDs,
+                               mvsUtils::ImagesCache& imageCache, std::vector<AccuImage>& accuImages) const;
+
+    /// Select the cameras used to texture each triangle of the atlas, the triangles are listed per camera
+    void selectTrianglesCameras(const mvsUtils::MultiViewParams& mp, size_t atlasID,
+                                std::vector<std::vector<unsigned int>>& camTriangles) const;
+
+    /// Accumulate the colors of the camera image on the given triangles
+    void fillTextureFromImage(const mvsUtils::MultiViewParams& mp, int camId, const mvsUtils::ImagesCache::Img& img,
+                              const std::vector<unsigned int>& triangles, AccuImage& accuImage) const;
+
+    /// Compute the final (average) colors of the atlas and write the texture file
+    void writeTexture(AccuImage& accuImage, size_t atlasID, const bfs::path& outPath, EImageFileType textureFileType) const;
 };
 
 } // namespace mesh
@@ -97,6 +97,23 @@ struct SampsonError {
     return Square(y.dot(F_x)) / (  F_x.head<2>().squaredNorm()
                                 + Ft_y.head<2>().squaredNorm());
   }
+
+  // Vectorized error of all the correspondences, points stored one per row.
+  static void Errors(const Mat3 &F, const MatX2 &x1, const MatX2 &x2, vector<double> &errors) {
+    errors.resize(x1.rows());
+    const auto x = x1.col(0).array();
+    const auto y = x1.col(1).array();
+    const auto u = x2.col(0).array();
+    const auto v = x2.col(1).array();
+    // F * x1 and F^t * x2 lines
+    const auto a = F(0,0) * x + F(0,1) * y + F(0,2);
+    const auto b = F(1,0) * x + F(1,1) * y + F(1,2);
+    const auto c = F(2,0) * x + F(2,1) * y + F(2,2);
+    const auto at = F(0,0) * u + F(1,0) * v + F(2,0);
+    const auto bt = F(0,1) * u + F(1,1) * v + F(2,1);
+    Eigen::Map<Eigen::ArrayXd>(errors.data(), errors.size()) =
+      (a * u + b * v + c).square() / (a.square() + b.square() + at.square() + bt.square());
+  }
 };
 
 struct SymmetricEpipolarDistanceError {
@@ -110,6 +127,24 @@ struct SymmetricEpipolarDistanceError {
                                 + 1.0 / Ft_y.head<2>().squaredNorm())
       / 4.0;  // The divide by 4 is to make this match the Sampson distance.
   }
+
+  // Vectorized error of all the correspondences, points stored one per row.
+  static void Errors(const Mat3 &F, const MatX2 &x1, const MatX2 &x2, vector<double> &errors) {
+    errors.resize(x1.rows());
+    const auto x = x1.col(0).array();
+    const auto y = x1.col(1).array();
+    const auto u = x2.col(0).array();
+    const auto v = x2.col(1).array();
+    // F * x1 and F^t * x2 lines
+    const auto a = F(0,0) * x + F(0,1) * y + F(0,2);
+    const auto b = F(1,0) * x + F(1,1) * y + F(1,2);
+    const auto c = F(2,0) * x + F(2,1) * y + F(2,2);
+    const auto at = F(0,0) * u + F(1,0) * v + F(2,0);
+    const auto bt = F(0,1) * u + F(1,1) * v + F(2,1);
+    Eigen::Map<Eigen::ArrayXd>(errors.data(), errors.size()) =
+      (a * u + b * v + c).square() * ((a.square() + b.square()).inverse()
+                                    + (at.square() + bt.square()).inverse()) / 4.0;
+  }
 };
 
 struct EpipolarDistanceError {
@@ -121,6 +156,19 @@ struct EpipolarDistanceError {
     Vec3 F_x = F * x;
     return Square(F_x.dot(y)) /  F_x.head<2>().squaredNorm();
   }
+
+  // Vectorized error of all the correspondences, points stored one per row.
+  static void Errors(const Mat3 &F, const MatX2 &x1, const MatX2 &x2, vector<double> &errors) {
+    errors.resize(x1.rows());
+    const auto x = x1.col(0).array();
+    const auto y = x1.col(1).array();
+    // epipolar lines F * x1 in image 2
+    const auto a = F(0,0) * x + F(0,1) * y + F(0,2);
+    const auto b = F(1,0) * x + F(1,1) * y + F(1,2);
+    const auto c = F(2,0) * x + F(2,1) * y + F(2,2);
+    Eigen::Map<Eigen::ArrayXd>(errors.data(), errors.size()) =
+      (a * x2.col(0).array() + b * x2.col(1).array() + c).square() / (a.square() + b.square());
+  }
 };
 typedef EpipolarDistanceError SimpleError;
 
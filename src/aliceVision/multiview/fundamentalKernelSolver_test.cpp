@@ -121,3 +121,26 @@ BOOST_AUTO_TEST_CASE(EightPointTest_Normalized_EasyCase) {
   typedef fundamental::kernel::NormalizedEightPointKernel Kernel;
   BOOST_CHECK(ExpectKernelProperties<Kernel>(x1, x2));
 }
+
+// Check that the vectorized errors are equal to the errors computed point by point.
+template<typename ErrorT>
+void ExpectVectorizedErrors(const Mat3 &F, const Mat &x1, const Mat &x2) {
+  vector<double> errors;
+  ErrorT::Errors(F, x1.transpose(), x2.transpose(), errors);
+  BOOST_CHECK_EQUAL(x1.cols(), errors.size());
+  for (int i = 0; i < x1.cols(); ++i) {
+    BOOST_CHECK_CLOSE(ErrorT::Error(F, x1.col(i), x2.col(i)), errors[i], 1e-8);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FundamentalErrors_Vectorized) {
+  std::srand(0);
+  for (int trial = 0; trial < 10; ++trial) {
+    const Mat3 F = Mat3::Random();
+    const Mat x1 = Mat::Random(2, 100) * 1000.0;
+    const Mat x2 = Mat::Random(2, 100) * 1000.0;
+    ExpectVectorizedErrors<fundamental::kernel::SampsonError>(F, x1, x2);
+    ExpectVectorizedErrors<fundamental::kernel::SymmetricEpipolarDistanceError>(F, x1, x2);
+    ExpectVectorizedErrors<fundamental::kernel::EpipolarDistanceError>(F, x1, x2);
+  }
+}
@@ -42,6 +42,18 @@ struct AsymmetricError {
     Vec2 x2_est = x2h_est.head<2>() / x2h_est[2];
     return (x2 - x2_est).squaredNorm();
   }
+
+  // Vectorized error of all the correspondences, points stored one per row.
+  static void Errors(const Mat &H, const MatX2 &x1, const MatX2 &x2, vector<double> &errors) {
+    errors.resize(x1.rows());
+    const auto x = x1.col(0).array();
+    const auto y = x1.col(1).array();
+    const auto u = H(0,0) * x + H(0,1) * y + H(0,2);
+    const auto v = H(1,0) * x + H(1,1) * y + H(1,2);
+    const auto w = H(2,0) * x + H(2,1) * y + H(2,2);
+    Eigen::Map<Eigen::ArrayXd>(errors.data(), errors.size()) =
+      (x2.col(0).array() - u / w).square() + (x2.col(1).array() - v / w).square();
+  }
 };
 
 // Kernel that works on original data point
@@ -90,3 +90,20 @@ BOOST_AUTO_TEST_CASE(HomographyKernelTest_Fitting_Normalized) {
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(HomographyKernelTest_AsymmetricError_Vectorized) {
+  // Check that the vectorized errors are equal to the errors computed point by point.
+  std::srand(0);
+  for (int trial = 0; trial < 10; ++trial) {
+    const Mat3 H = Mat3::Random();
+    const Mat x1 = Mat::Random(2, 100) * 1000.0;
+    const Mat x2 = Mat::Random(2, 100) * 1000.0;
+
+    vector<double> errors;
+    homography::kernel::AsymmetricError::Errors(H, x1.transpose(), x2.transpose(), errors);
+    BOOST_CHECK_EQUAL(x1.cols(), errors.size());
+    for (int i = 0; i < x1.cols(); ++i) {
+      BOOST_CHECK_CLOSE(homography::kernel::AsymmetricError::Error(H, x1.col(i), x2.col(i)), errors[i], 1e-8);
+    }
+  }
+}
@@ -37,6 +37,29 @@ struct SixPointResectionSolver {
   }
 };
 
+/**
+ * Squared reprojection error of the 2D-3D correspondences: |pt2D - Project(P,pt3D)|^2
+ */
+struct ResectionSquaredResidualError {
+  static double Error(const Mat34 & P, const Vec2 & pt2D, const Vec3 & pt3D) {
+    const Vec2 x = Project(P, pt3D);
+    return (x - pt2D).squaredNorm();
+  }
+
+  // Vectorized error of all the correspondences, points stored one per row.
+  static void Errors(const Mat34 & P, const MatX2 & pt2D, const MatX3 & pt3D, std::vector<double> & errors) {
+    errors.resize(pt2D.rows());
+    const auto X = pt3D.col(0).array();
+    const auto Y = pt3D.col(1).array();
+    const auto Z = pt3D.col(2).array();
+    const auto u = P(0,0) * X + P(0,1) * Y + P(0,2) * Z + P(0,3);
+    const auto v = P(1,0) * X + P(1,1) * Y + P(1,2) * Z + P(1,3);
+    const auto w = P(2,0) * X + P(2,1) * Y + P(2,2) * Z + P(2,3);
+    Eigen::Map<Eigen::ArrayXd>(errors.data(), errors.size()) =
+      (u / w - pt2D.col(0).array()).square() + (v / w - pt2D.col(1).array()).square();
+  }
+};
+
 //-- Generic Solver for the 6pt Resection algorithm using linear least squares.
 template<typename SolverArg,
   typename ErrorArg,
@@ -202,3 +202,21 @@ BOOST_AUTO_TEST_CASE(EuclideanResection_Points6AllRandomInput) {
   }
 
 }
+
+BOOST_AUTO_TEST_CASE(Resection_SquaredResidualError_Vectorized) {
+  // Check that the vectorized errors are equal to the errors computed point by point.
+  typedef aliceVision::resection::kernel::ResectionSquaredResidualError ErrorT;
+  std::srand(0);
+  for (int trial = 0; trial < 10; ++trial) {
+    const Mat34 P = Mat34::Random();
+    const Mat x = Mat::Random(2, 100) * 1000.0;
+    const Mat X = Mat::Random(3, 100) * 10.0;
+
+    std::vector<double> errors;
+    ErrorT::Errors(P, x.transpose(), X.transpose(), errors);
+    BOOST_CHECK_EQUAL(x.cols(), errors.size());
+    for (int i = 0; i < x.cols(); ++i) {
+      BOOST_CHECK_CLOSE(ErrorT::Error(P, x.col(i), X.col(i)), errors[i], 1e-8);
+    }
+  }
+}
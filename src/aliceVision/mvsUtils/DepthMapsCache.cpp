@@ -0,0 +1,116 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DepthMapsCache.hpp"
+#include <aliceVision/imageIO/image.hpp>
+
+#include <exception>
+
+namespace aliceVision {
+namespace mvsUtils {
+
+DepthMapsCache& DepthMapsCache::getInstance()
+{
+    static DepthMapsCache cache;
+    return cache;
+}
+
+void DepthMapsCache::setMaxMemory(std::size_t maxMemoryMB)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _maxMemory = maxMemoryMB << 20;
+    evict();
+}
+
+DepthMapsCache::MapConstPtr DepthMapsCache::get(const std::string& filename)
+{
+    std::unique_ptr<std::promise<MapConstPtr>> promise;
+    std::shared_future<MapConstPtr> map;
+    unsigned int generation = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _entries.find(filename);
+        if(it != _entries.end())
+        {
+            // the map becomes the most recently used
+            _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+            map = it->second.map;
+        }
+        else
+        {
+            promise.reset(new std::promise<MapConstPtr>());
+            Entry& entry = _entries[filename];
+            entry.map = promise->get_future().share();
+            _lru.push_front(filename);
+            entry.lruIt = _lru.begin();
+            generation = entry.generation = ++_generation;
+            map = entry.map;
+        }
+    }
+
+    if(promise)
+    {
+        // read the map outside of the lock, the other threads requesting this file wait for the future
+        try
+        {
+            std::shared_ptr<Map> newMap = std::make_shared<Map>();
+            imageIO::readImage(filename, newMap->width, newMap->height, newMap->data);
+            const std::size_t memory = newMap->data.size() * sizeof(float);
+            promise->set_value(newMap);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _entries.find(filename);
+            if(it != _entries.end() && it->second.generation == generation)
+            {
+                it->second.memory = memory;
+                _memory += memory;
+                evict();
+            }
+        }
+        catch(...)
+        {
+            promise->set_exception(std::current_exception());
+
+            // remove the file from the cache, so the next request tries to read it again
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _entries.find(filename);
+            if(it != _entries.end() && it->second.generation == generation)
+            {
+                _lru.erase(it->second.lruIt);
+                _entries.erase(it);
+            }
+        }
+    }
+    return map.get();
+}
+
+void DepthMapsCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+    _lru.clear();
+    _memory = 0;
+}
+
+void DepthMapsCache::evict()
+{
+    auto it = _lru.end();
+    while(_memory > _maxMemory && it != _lru.begin())
+    {
+        --it;
+        auto entryIt = _entries.find(*it);
+        // the maps being read are not accounted yet
+        if(entryIt->second.memory == 0)
+            continue;
+        _memory -= entryIt->second.memory;
+        _entries.erase(entryIt);
+        it = _lru.erase(it);
+    }
+}
+
+} // namespace mvsUtils
+} // namespace aliceVision
@@ -0,0 +1,95 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace aliceVision {
+namespace mvsUtils {
+
+/**
+ * @brief Process-wide cache of decoded depth / similarity maps, indexed by filename.
+ *
+ * The maps are kept in the file layout (row-major, index = y * width + x), so they can be
+ * used by the filtering and fusion functions without any conversion.
+ * The cache only helps when a map is read several times by the same process: the depth map
+ * filtering and the meshing are separate executables, nothing is shared between them.
+ * The users clear the cache once they are done with the maps.
+ * The memory used by the cached maps is bounded, the least recently used maps are removed first.
+ *
+ * The maps are returned as shared pointers on constant data: a map removed from the cache stays
+ * valid until its last user releases it. A map requested by several threads is read once,
+ * the file is read outside of the lock.
+ */
+class DepthMapsCache
+{
+public:
+    /// single channel float map, in the file layout
+    struct Map
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<float> data;
+    };
+
+    using MapConstPtr = std::shared_ptr<const Map>;
+
+    /// @return the process-wide cache
+    static DepthMapsCache& getInstance();
+
+    /**
+     * @brief Set the maximum memory used by the cached maps.
+     * @param[in] maxMemoryMB maximum memory in MB
+     */
+    void setMaxMemory(std::size_t maxMemoryMB);
+
+    /**
+     * @brief Get a map, read it if it is not in the cache.
+     * @note thread-safe
+     * @throw std::runtime_error if the file can't be read
+     */
+    MapConstPtr get(const std::string& filename);
+
+    /// Remove all the maps from the cache
+    void clear();
+
+private:
+    DepthMapsCache() = default;
+
+    struct Entry
+    {
+        /// map being read or read
+        std::shared_future<MapConstPtr> map;
+        /// position in the LRU list
+        std::list<std::string>::iterator lruIt;
+        /// memory used by the map (0 while it is being read)
+        std::size_t memory = 0;
+        /// incremented at each insertion in the cache
+        unsigned int generation = 0;
+    };
+
+    /// remove the least recently used maps until the memory is below the maximum (lock held)
+    void evict();
+
+    std::mutex _mutex;
+    std::unordered_map<std::string, Entry> _entries;
+    /// filenames in the cache, from the most to the least recently used
+    std::list<std::string> _lru;
+    std::size_t _memory = 0;
+    std::size_t _maxMemory = std::size_t(4000) << 20;
+    unsigned int _generation = 0;
+};
+
+} // namespace mvsUtils
+} // namespace aliceVision
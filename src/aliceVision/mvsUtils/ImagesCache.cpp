@@ -8,17 +8,49 @@
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
 
+#include <algorithm>
+#include <exception>
+
 namespace aliceVision {
 namespace mvsUtils {
 
-int ImagesCache::getPixelId(int x, int y, int imgid)
+Color ImagesCache::Img::getInterpolated(const Point2d& pix) const
+{
+    const int xp = static_cast<int>(pix.x);
+    const int yp = static_cast<int>(pix.y);
+
+    // precision to 4 decimal places
+    const float ui = pix.x - static_cast<float>(xp);
+    const float vi = pix.y - static_cast<float>(yp);
+
+    const Color lu = at(xp,     yp    );
+    const Color ru = at(xp + 1, yp    );
+    const Color rd = at(xp + 1, yp + 1);
+    const Color ld = at(xp,     yp + 1);
+
+    // bilinear interpolation of the pixel intensity value
+    const Color u = lu + (ru - lu) * ui;
+    const Color d = ld + (rd - ld) * ui;
+    const Color out = u + (d - u) * vi;
+
+    return out;
+}
+
+rgb ImagesCache::Img::getRgb(const Pixel& pix) const
+{
+    const Color floatRGB = at(pix.x, pix.y) * 255.0f;
+
+    return rgb(static_cast<unsigned char>(floatRGB.r),
+               static_cast<unsigned char>(floatRGB.g),
+               static_cast<unsigned char>(floatRGB.b));
+}
+
+int ImagesCache::getPixelId(int x, int y, int imgid) const
 {
-    if(!transposed)
-        return x * mp->getHeight(imgid) + y;
     return y * mp->getWidth(imgid) + x;
 }
 
-ImagesCache::ImagesCache(const MultiViewParams* _mp, int _bandType, bool _transposed)
+ImagesCache::ImagesCache(const MultiViewParams* _mp, int _bandType)
   : mp(_mp)
 {
     std::vector<std::string> _imagesNames;
@@ -26,25 +58,22 @@ ImagesCache::ImagesCache(const MultiViewParams* _mp, int _bandType, bool _transp
     {
         _imagesNames.push_back(mv_getFileNamePrefix(_mp->mvDir, _mp, rc) + "." + _mp->getImageExtension());
     }
-    initIC(_bandType, _imagesNames, _transposed);
+    initIC(_bandType, _imagesNames);
 }
 
-ImagesCache::ImagesCache(const MultiViewParams* _mp, int _bandType, std::vector<std::string>& _imagesNames,
-                                 bool _transposed)
+ImagesCache::ImagesCache(const MultiViewParams* _mp, int _bandType, std::vector<std::string>& _imagesNames)
   : mp(_mp)
 {
-    initIC(_bandType, _imagesNames, _transposed);
+    initIC(_bandType, _imagesNames);
 }
 
-void ImagesCache::initIC(int _bandType, std::vector<std::string>& _imagesNames,
-                             bool _transposed)
+void ImagesCache::initIC(int _bandType, std::vector<std::string>& _imagesNames)
 {
     float oneimagemb = (sizeof(Color) * mp->getMaxImageWidth() * mp->getMaxImageHeight()) / 1024.f / 1024.f;
     float maxmbCPU = (float)mp->_ini.get<int>("images_cache.maxmbCPU", 5000);
     int _npreload = std::max((int)(maxmbCPU / oneimagemb), mp->_ini.get<int>("grow.minNumOfConsistentCams", 10));
-    N_PRELOADED_IMAGES = std::min(mp->ncams, _npreload);
+    N_PRELOADED_IMAGES = std::max(1, std::min(mp->ncams, _npreload));
 
-    transposed = _transposed;
     bandType = _bandType;
 
     for(int rc = 0; rc < mp->ncams; rc++)
@@ -52,115 +81,228 @@ void ImagesCache::initIC(int _bandType, std::vector<std::string>& _imagesNames,
         imagesNames.push_back(_imagesNames[rc]);
     }
 
-    imgs = new Color*[N_PRELOADED_IMAGES];
+    _entries.resize(mp->ncams);
 
-    camIdMapId = new StaticVector<int>();
-    camIdMapId->reserve(mp->ncams);
-    mapIdCamId = new StaticVector<int>();
-    mapIdCamId->reserve(N_PRELOADED_IMAGES);
-    mapIdClock = new StaticVector<long>();
-    mapIdClock->reserve(N_PRELOADED_IMAGES);
-
-    for(int i = 0; i < mp->ncams; ++i)
+    const int nbShards = std::max(1, mp->_ini.get<int>("images_cache.nbShards", 8));
+    for(int s = 0; s < nbShards; ++s)
     {
-        camIdMapId->push_back(-1);
+        _shards.emplace_back(new Shard());
     }
 
-    for (int ni = 0; ni < N_PRELOADED_IMAGES; ++ni)
+    const int nbPrefetchThreads = mp->_ini.get<int>("images_cache.nbPrefetchThreads", 2);
+    for(int t = 0; t < nbPrefetchThreads; ++t)
     {
-        imgs[ni] = nullptr;
-
-        (*camIdMapId)[ni] = -1;
-        mapIdCamId->push_back(-1);
-        mapIdClock->push_back(clock());
+        _prefetchThreads.emplace_back(&ImagesCache::prefetchWorker, this);
     }
 }
 
 ImagesCache::~ImagesCache()
 {
-    for(int ni = 0; ni < N_PRELOADED_IMAGES; ni++)
     {
-        delete[] imgs[ni];
+        std::lock_guard<std::mutex> lock(_prefetchMutex);
+        _prefetchStop = true;
     }
-    delete[] imgs;
+    _prefetchCondition.notify_all();
 
-    delete camIdMapId;
-    delete mapIdCamId;
-    delete mapIdClock;
+    for(std::thread& thread : _prefetchThreads)
+    {
+        thread.join();
+    }
 }
 
-void ImagesCache::refreshData(int camId)
+std::shared_future<ImagesCache::ImgSharedPtr> ImagesCache::getOrInsert(int camId, std::unique_ptr<std::promise<ImgSharedPtr>>& promise,
+                                                                       unsigned int& generation)
 {
-    // printf("camId %i\n",camId);
-    // test if the image is in the memory
-    if((*camIdMapId)[camId] == -1)
+    Shard& shard = getShard(camId);
+
+    while(true)
     {
-        // remove the oldest one
-        int mapId = mapIdClock->minValId();
-        int oldCamId = (*mapIdCamId)[mapId];
-        if(oldCamId>=0)
-            (*camIdMapId)[oldCamId] = -1;
-
-        // replace with new new
-        (*camIdMapId)[camId] = mapId;
-        (*mapIdCamId)[mapId] = camId;
-        (*mapIdClock)[mapId] = clock();
-
-        // reload data from files
-        long t1 = clock();
-        if (imgs[mapId] == nullptr)
         {
-            const std::size_t maxSize = mp->getMaxImageWidth() * mp->getMaxImageHeight();
-            imgs[mapId] = new Color[maxSize];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            Entry& entry = _entries.at(camId);
+
+            if(entry.img.valid())
+            {
+                // the camera becomes the most recently used
+                shard.lru.splice(shard.lru.begin(), shard.lru, entry.lruIt);
+                entry.lastUse = ++_useCounter;
+                generation = entry.generation;
+                return entry.img;
+            }
+
+            // reserve a place in the cache
+            int nbImages = _nbImages;
+            while(nbImages < N_PRELOADED_IMAGES && !_nbImages.compare_exchange_weak(nbImages, nbImages + 1))
+            {}
+
+            if(nbImages < N_PRELOADED_IMAGES)
+            {
+                promise.reset(new std::promise<ImgSharedPtr>());
+                entry.img = promise->get_future().share();
+                shard.lru.push_front(camId);
+                entry.lruIt = shard.lru.begin();
+                entry.lastUse = ++_useCounter;
+                generation = ++entry.generation;
+                return entry.img;
+            }
         }
 
-        const std::string imagePath = imagesNames.at(camId);
-        memcpyRGBImageFromFileToArr(camId, imgs[mapId], imagePath, mp, transposed, bandType);
+        // the cache is full, the shards are locked one at a time
+        evictLeastRecentlyUsed();
+    }
+}
+
+void ImagesCache::evictLeastRecentlyUsed()
+{
+    Shard* oldestShard = nullptr;
+    unsigned long long oldestUse = 0;
 
-        ALICEVISION_LOG_DEBUG("Add " << imagePath << " to image cache. " << formatElapsedTime(t1));
+    for(std::unique_ptr<Shard>& shard : _shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        if(shard->lru.empty())
+            continue;
+        const unsigned long long lastUse = _entries[shard->lru.back()].lastUse;
+        if(oldestShard == nullptr || lastUse < oldestUse)
+        {
+            oldestShard = shard.get();
+            oldestUse = lastUse;
+        }
     }
+
+    // the cache may have been modified by the other threads in the meantime,
+    // the least recently used camera of the selected shard is removed anyway
+    if(oldestShard == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock(oldestShard->mutex);
+    if(oldestShard->lru.empty())
+        return;
+
+    // the image is released when it is not used anymore
+    _entries[oldestShard->lru.back()].img = std::shared_future<ImgSharedPtr>();
+    oldestShard->lru.pop_back();
+    --_nbImages;
 }
 
-Color ImagesCache::getPixelValueInterpolated(const Point2d* pix, int camId)
+ImagesCache::ImgSharedPtr ImagesCache::loadImg(int camId) const
 {
-    refreshData(camId);
+    long t1 = clock();
 
-    // get the image index in the memory
-    const int i = (*camIdMapId)[camId];
-    const Color* img = imgs[i];
-    
-    const int xp = static_cast<int>(pix->x);
-    const int yp = static_cast<int>(pix->y);
+    ImgSharedPtr img = std::make_shared<Img>(mp->getWidth(camId), mp->getHeight(camId));
 
-    // precision to 4 decimal places
-    const float ui = pix->x - static_cast<float>(xp);
-    const float vi = pix->y - static_cast<float>(yp);
+    const std::string& imagePath = imagesNames.at(camId);
+    memcpyRGBImageFromFileToArr(camId, img->data(), imagePath, mp, bandType);
 
-    const Color lu = img[getPixelId(xp,     yp,     camId)];
-    const Color ru = img[getPixelId(xp + 1, yp,     camId)];
-    const Color rd = img[getPixelId(xp + 1, yp + 1, camId)];
-    const Color ld = img[getPixelId(xp,     yp + 1, camId)];
+    ALICEVISION_LOG_DEBUG("Add " << imagePath << " to image cache. " << formatElapsedTime(t1));
+    return img;
+}
 
-    // bilinear interpolation of the pixel intensity value
-    const Color u = lu + (ru - lu) * ui;
-    const Color d = ld + (rd - ld) * ui;
-    const Color out = u + (d - u) * vi;
+ImagesCache::ImgSharedPtr ImagesCache::getImg_sync(int camId)
+{
+    std::unique_ptr<std::promise<ImgSharedPtr>> promise;
+    unsigned int generation = 0;
+    std::shared_future<ImgSharedPtr> img = getOrInsert(camId, promise, generation);
 
-    return out;
+    if(promise)
+    {
+        // load the image outside of the lock, the other threads requesting this camera wait for the future
+        try
+        {
+            promise->set_value(loadImg(camId));
+        }
+        catch(...)
+        {
+            promise->set_exception(std::current_exception());
+
+            // remove the camera from the cache, so the next request tries to load it again
+            Shard& shard = getShard(camId);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            Entry& entry = _entries[camId];
+            if(entry.img.valid() && entry.generation == generation)
+            {
+                entry.img = std::shared_future<ImgSharedPtr>();
+                shard.lru.erase(entry.lruIt);
+                --_nbImages;
+            }
+        }
+    }
+    return img.get();
 }
 
-rgb ImagesCache::getPixelValue(const Pixel& pix, int camId)
+void ImagesCache::refreshImage_async(int camId)
 {
-    refreshData(camId);
+    if(_prefetchThreads.empty())
+        return;
+
+    {
+        Shard& shard = getShard(camId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        Entry& entry = _entries.at(camId);
+        if(entry.img.valid())
+        {
+            shard.lru.splice(shard.lru.begin(), shard.lru, entry.lruIt);
+            entry.lastUse = ++_useCounter;
+            return;
+        }
+    }
 
-    // get the image index in the memory
-    const int imageId = (*camIdMapId)[camId];
-    const Color* img = imgs[imageId];
-    const Color floatRGB = img[getPixelId(pix.x, pix.y, camId)] * 255.0f;
+    {
+        std::lock_guard<std::mutex> lock(_prefetchMutex);
+        if(std::find(_prefetchQueue.begin(), _prefetchQueue.end(), camId) != _prefetchQueue.end())
+            return;
+        _prefetchQueue.push_back(camId);
+    }
+    _prefetchCondition.notify_one();
+}
 
-    return rgb(static_cast<unsigned char>(floatRGB.r),
-               static_cast<unsigned char>(floatRGB.g),
-               static_cast<unsigned char>(floatRGB.b));
+void ImagesCache::refreshImages_async(const std::vector<int>& camIds)
+{
+    for(const int camId : camIds)
+    {
+        refreshImage_async(camId);
+    }
+}
+
+void ImagesCache::prefetchWorker()
+{
+    while(true)
+    {
+        int camId;
+        {
+            std::unique_lock<std::mutex> lock(_prefetchMutex);
+            _prefetchCondition.wait(lock, [this]{ return _prefetchStop || !_prefetchQueue.empty(); });
+            if(_prefetchStop)
+                return;
+            camId = _prefetchQueue.front();
+            _prefetchQueue.pop_front();
+        }
+
+        try
+        {
+            getImg_sync(camId);
+        }
+        catch(const std::exception& e)
+        {
+            // the error is raised again when the image is requested
+            ALICEVISION_LOG_WARNING("Can't prefetch the image of the camera " << camId << ": " << e.what());
+        }
+    }
+}
+
+void ImagesCache::refreshData(int camId)
+{
+    getImg_sync(camId);
+}
+
+Color ImagesCache::getPixelValueInterpolated(const Point2d* pix, int camId)
+{
+    return getImg_sync(camId)->getInterpolated(*pix);
+}
+
+rgb ImagesCache::getPixelValue(const Pixel& pix, int camId)
+{
+    return getImg_sync(camId)->getRgb(pix);
 }
 
 } // namespace mvsUtils
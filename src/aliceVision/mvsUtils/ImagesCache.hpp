@@ -7,40 +7,162 @@
 #pragma once
 
 #include <aliceVision/mvsData/Color.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Rgb.hpp>
-#include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mvsUtils/MultiViewParams.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace aliceVision {
 namespace mvsUtils {
 
+/**
+ * @brief Least recently used cache of the camera images, shared by the threads.
+ *
+ * The cameras are split in shards (camId % nbShards), each one with its own lock and its own
+ * LRU list, so the threads working on different cameras don't wait for each other.
+ * The capacity is shared by all the shards: when the cache is full, the least recently used
+ * camera of all the shards is removed, whatever the distribution of the camera ids.
+ * The images are loaded outside of the locks; a camera requested by several threads is loaded once.
+ *
+ * The images are returned as shared pointers: an image evicted from the cache stays valid
+ * until its last user releases it.
+ *
+ * The images of the next cameras to process can be queued with refreshImage_async,
+ * they are then loaded by background threads.
+ */
 class ImagesCache
 {
 public:
+    /// camera image, stored row-major (in the image file layout)
+    class Img
+    {
+    public:
+        Img(int width, int height)
+          : _width(width)
+          , _height(height)
+          , _data(static_cast<std::size_t>(width) * height)
+        {}
+
+        inline int getWidth() const { return _width; }
+        inline int getHeight() const { return _height; }
+
+        inline std::size_t getPixelId(int x, int y) const
+        {
+            return static_cast<std::size_t>(y) * _width + x;
+        }
+
+        inline const Color& at(int x, int y) const { return _data[getPixelId(x, y)]; }
+
+        inline Color* data() { return _data.data(); }
+        inline const Color* data() const { return _data.data(); }
+
+        /// bilinear interpolation of the color at the given subpixel position
+        Color getInterpolated(const Point2d& pix) const;
+
+        /// 8 bits color at the given pixel
+        rgb getRgb(const Pixel& pix) const;
+
+    private:
+        int _width;
+        int _height;
+        std::vector<Color> _data;
+    };
+
+    using ImgSharedPtr = std::shared_ptr<Img>;
+
     const MultiViewParams* mp;
 
     int N_PRELOADED_IMAGES;
-    Color** imgs;
-
-    StaticVector<int>* camIdMapId;
-    StaticVector<int>* mapIdCamId;
-    StaticVector<long>* mapIdClock;
     std::vector<std::string> imagesNames;
 
     int bandType;
-    bool transposed;
 
-    ImagesCache(const MultiViewParams* _mp, int _bandType, bool _transposed = false);
-    ImagesCache(const MultiViewParams* _mp, int _bandType, std::vector<std::string>& _imagesNames,
-                    bool _transposed = false);
-    void initIC(int _bandType, std::vector<std::string>& _imagesNames, bool _transposed);
+    ImagesCache(const MultiViewParams* _mp, int _bandType);
+    ImagesCache(const MultiViewParams* _mp, int _bandType, std::vector<std::string>& _imagesNames);
+    void initIC(int _bandType, std::vector<std::string>& _imagesNames);
     ~ImagesCache();
 
-    int getPixelId(int x, int y, int imgid);
+    /**
+     * @brief Get the image of a camera, load it if it is not in the cache.
+     * @note thread-safe
+     * @throw std::runtime_error if the image can't be loaded
+     */
+    ImgSharedPtr getImg_sync(int camId);
+
+    /**
+     * @brief Queue the loading of the image of a camera on the background threads.
+     * @note thread-safe, an image already in the cache only becomes the most recently used
+     */
+    void refreshImage_async(int camId);
+    void refreshImages_async(const std::vector<int>& camIds);
+
+    /// @return the number of images in the cache, loaded or being loaded
+    inline int getNbImages() const { return _nbImages; }
+
+    int getPixelId(int x, int y, int imgid) const;
     void refreshData(int camId);
     Color getPixelValueInterpolated(const Point2d* pix, int camId);
     rgb getPixelValue(const Pixel& pix, int camId);
+
+private:
+    /// state of a camera in its shard
+    struct Entry
+    {
+        /// image being loaded or loaded, invalid if not in the cache
+        std::shared_future<ImgSharedPtr> img;
+        /// position in the LRU list of the shard
+        std::list<int>::iterator lruIt;
+        /// incremented at each insertion in the cache
+        unsigned int generation = 0;
+        /// value of the use counter at the last request of the camera
+        unsigned long long lastUse = 0;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        /// cameras in the cache, from the most to the least recently used
+        std::list<int> lru;
+    };
+
+    inline Shard& getShard(int camId) { return *_shards[camId % _shards.size()]; }
+
+    /// @return the image of the camera, already loaded or being loaded by another thread, or insert it in the cache
+    /// @param[out] promise valid if the caller has to load the image
+    /// @param[out] generation generation of the entry
+    std::shared_future<ImgSharedPtr> getOrInsert(int camId, std::unique_ptr<std::promise<ImgSharedPtr>>& promise,
+                                                 unsigned int& generation);
+
+    /// remove the least recently used camera of all the shards, locking one shard at a time
+    void evictLeastRecentlyUsed();
+
+    ImgSharedPtr loadImg(int camId) const;
+
+    void prefetchWorker();
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+    /// per camera, guarded by the mutex of its shard
+    std::vector<Entry> _entries;
+    /// number of cameras in the cache, at most N_PRELOADED_IMAGES
+    std::atomic<int> _nbImages{0};
+    std::atomic<unsigned long long> _useCounter{0};
+
+    std::vector<std::thread> _prefetchThreads;
+    std::deque<int> _prefetchQueue;
+    std::mutex _prefetchMutex;
+    std::condition_variable _prefetchCondition;
+    bool _prefetchStop = false;
 };
 
 } // namespace mvsUtils
@@ -0,0 +1,157 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mvsUtils/DepthMapsCache.hpp>
+#include <aliceVision/imageIO/image.hpp>
+
+#include <boost/filesystem.hpp>
+
+#define BOOST_TEST_MODULE mvsUtilsDepthMapsCache
+#include <boost/test/included/unit_test.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::mvsUtils;
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+// 1 MB per map in the cache
+const int width = 512;
+const int height = 512;
+
+/**
+ * @brief Depth maps with a constant value, the value of each map is its index.
+ *        The process-wide cache is cleared before and after the test.
+ */
+class DepthMaps
+{
+public:
+    DepthMaps()
+        : _dir(bfs::temp_directory_path() / bfs::unique_path("alicevision_depthMapsCache_%%%%-%%%%-%%%%"))
+    {
+        bfs::create_directories(_dir);
+        DepthMapsCache::getInstance().clear();
+    }
+
+    ~DepthMaps()
+    {
+        DepthMapsCache::getInstance().clear();
+        DepthMapsCache::getInstance().setMaxMemory(4000);
+        bfs::remove_all(_dir);
+    }
+
+    std::string getPath(int index) const
+    {
+        return (_dir / (std::to_string(index) + "_depthMap.exr")).string();
+    }
+
+    std::string write(int index) const
+    {
+        const std::string path = getPath(index);
+        imageIO::writeImage(path, width, height, std::vector<float>(width * height, static_cast<float>(index)));
+        return path;
+    }
+
+private:
+    bfs::path _dir;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(DepthMapsCache_concurrentRead)
+{
+    DepthMaps depthMaps;
+    DepthMapsCache& cache = DepthMapsCache::getInstance();
+
+    const int nbMaps = 3;
+    std::vector<std::string> paths;
+    for(int i = 0; i < nbMaps; ++i)
+        paths.push_back(depthMaps.write(i));
+
+    // all the threads request the same maps at the same time: each map is read once
+    const int nbThreads = 8;
+    std::vector<std::vector<DepthMapsCache::MapConstPtr>> threadMaps(nbThreads);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < nbThreads; ++t)
+    {
+        threads.emplace_back([&cache, &paths, &threadMaps, t]() {
+            for(const std::string& path : paths)
+                threadMaps[t].push_back(cache.get(path));
+        });
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+
+    for(int i = 0; i < nbMaps; ++i)
+    {
+        const DepthMapsCache::MapConstPtr& map = threadMaps[0][i];
+        BOOST_CHECK_EQUAL(map->width, width);
+        BOOST_CHECK_EQUAL(map->height, height);
+        BOOST_CHECK_EQUAL(map->data.at(0), static_cast<float>(i));
+        for(int t = 1; t < nbThreads; ++t)
+            BOOST_CHECK(threadMaps[t][i] == map);
+        // still in the cache
+        BOOST_CHECK(cache.get(paths[i]) == map);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DepthMapsCache_eviction)
+{
+    DepthMaps depthMaps;
+    DepthMapsCache& cache = DepthMapsCache::getInstance();
+    cache.setMaxMemory(3);
+
+    std::vector<DepthMapsCache::MapConstPtr> maps;
+    for(int i = 0; i < 3; ++i)
+        maps.push_back(cache.get(depthMaps.write(i)));
+
+    // map 0 becomes the most recently used, map 1 is removed
+    BOOST_CHECK(cache.get(depthMaps.getPath(0)) == maps[0]);
+    const DepthMapsCache::MapConstPtr map3 = cache.get(depthMaps.write(3));
+
+    BOOST_CHECK(cache.get(depthMaps.getPath(0)) == maps[0]);
+    BOOST_CHECK(cache.get(depthMaps.getPath(2)) == maps[2]);
+    BOOST_CHECK(cache.get(depthMaps.getPath(3)) == map3);
+
+    // the removed map stays valid for its users
+    BOOST_CHECK_EQUAL(maps[1]->data.at(0), 1.0f);
+
+    // it is read again, the least recently used map 0 is removed
+    const DepthMapsCache::MapConstPtr map1 = cache.get(depthMaps.getPath(1));
+    BOOST_CHECK(map1 != maps[1]);
+    BOOST_CHECK_EQUAL(map1->data.at(0), 1.0f);
+
+    // reducing the maximum memory removes the least recently used map 2
+    cache.setMaxMemory(2);
+    BOOST_CHECK(cache.get(depthMaps.getPath(3)) == map3);
+    BOOST_CHECK(cache.get(depthMaps.getPath(1)) == map1);
+    BOOST_CHECK(cache.get(depthMaps.getPath(2)) != maps[2]);
+
+    // the cleared maps are read again
+    cache.clear();
+    BOOST_CHECK(cache.get(depthMaps.getPath(3)) != map3);
+}
+
+BOOST_AUTO_TEST_CASE(DepthMapsCache_retryAfterFailure)
+{
+    DepthMaps depthMaps;
+    DepthMapsCache& cache = DepthMapsCache::getInstance();
+
+    // missing file: the error is not kept in the cache
+    const std::string path = depthMaps.getPath(5);
+    BOOST_CHECK_THROW(cache.get(path), std::runtime_error);
+    BOOST_CHECK_THROW(cache.get(path), std::runtime_error);
+
+    depthMaps.write(5);
+    const DepthMapsCache::MapConstPtr map = cache.get(path);
+    BOOST_CHECK_EQUAL(map->data.at(0), 5.0f);
+    BOOST_CHECK(cache.get(path) == map);
+}
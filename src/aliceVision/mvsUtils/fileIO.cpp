@@ -13,6 +13,8 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 
+#include <algorithm>
+
 namespace aliceVision {
 namespace mvsUtils {
 
@@ -346,7 +348,7 @@ Matrix3x4 load3x4MatrixFromFile(FILE* fi)
     return m;
 }
 
-void memcpyRGBImageFromFileToArr(int camId, Color* imgArr, const std::string& fileNameOrigStr, const MultiViewParams* mp, bool transpose, int bandType)
+void memcpyRGBImageFromFileToArr(int camId, Color* imgArr, const std::string& fileNameOrigStr, const MultiViewParams* mp, int bandType)
 {
     int origWidth, origHeight;
     std::vector<Color> cimg;
@@ -404,19 +406,10 @@ void memcpyRGBImageFromFileToArr(int camId, Color* imgArr, const std::string& fi
         }
     }
 
-    for(int y = 0; y < height; y++)
-    {
-        for(int x = 0; x < width; x++)
-        {
-            const Color color = cimg.at(y * width + x);
-
-            if(transpose)
-                imgArr[y * width + x] = color;
-            else
-                imgArr[x * height + y] = color;
-
-        }
-    }
+    // the camera image has the file layout (row-major)
+    if(cimg.size() < static_cast<std::size_t>(width) * height)
+        throw std::runtime_error("Wrong image dimensions: " + fileNameOrigStr);
+    std::copy(cimg.begin(), cimg.begin() + static_cast<std::size_t>(width) * height, imgArr);
 }
 
 
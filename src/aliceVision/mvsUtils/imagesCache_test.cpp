@@ -0,0 +1,234 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+#include <aliceVision/mvsData/Rgb.hpp>
+#include <aliceVision/mvsData/structures.hpp>
+#include <aliceVision/mvsUtils/ImagesCache.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/imageIO/image.hpp>
+
+#include <boost/filesystem.hpp>
+
+#define BOOST_TEST_MODULE mvsUtilsImagesCache
+#include <boost/test/included/unit_test.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::mvsUtils;
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+// 0.75 MB per image in the cache
+const int width = 256;
+const int height = 256;
+const int nbCameras = 8;
+// images_cache.maxmbCPU = 3, so 4 images in the cache
+const int capacity = 4;
+
+/**
+ * @brief Cameras with uniform images, the color of each image is its camera id.
+ */
+class Scene
+{
+public:
+    Scene()
+        : _dir(bfs::temp_directory_path() / bfs::unique_path("alicevision_imagesCache_%%%%-%%%%-%%%%"))
+    {
+        bfs::create_directories(_dir);
+
+        std::ofstream ini((_dir / "mvs.ini").string());
+        ini << "[global]" << std::endl
+            << "ncams=" << nbCameras << std::endl
+            << "imgExt=png" << std::endl
+            << "verbose=0" << std::endl
+            << "[grow]" << std::endl
+            << "minNumOfConsistentCams=1" << std::endl
+            << "[images_cache]" << std::endl
+            << "maxmbCPU=3" << std::endl
+            << "nbShards=2" << std::endl
+            << "[imageResolutions]" << std::endl;
+        for(int c = 0; c < nbCameras; ++c)
+            ini << c << "=" << width << "x" << height << std::endl;
+        ini.close();
+
+        StaticVector<CameraMatrices> cameras;
+        cameras.reserve(nbCameras);
+        for(int c = 0; c < nbCameras; ++c)
+        {
+            CameraMatrices cam;
+            cam.K = diag3x3(100.0, 100.0, 1.0);
+            cam.K.m13 = width / 2.0;
+            cam.K.m23 = height / 2.0;
+            cam.R = diag3x3(1.0, 1.0, 1.0);
+            cam.C = Point3d(c, 0.0, 0.0);
+            cam.iK = cam.K.inverse();
+            cam.iR = cam.R.inverse();
+            cam.iCam = cam.iR * cam.iK;
+            cam.P = cam.K * (cam.R | (Point3d(0.0, 0.0, 0.0) - cam.R * cam.C));
+            cam.f = 100.0;
+            cam.k1 = 0.0f;
+            cam.k2 = 0.0f;
+            cameras.push_back(cam);
+
+            writeImage(c, width, height);
+        }
+
+        mp.reset(new MultiViewParams((_dir / "mvs.ini").string(), (_dir / "depthMap").string(),
+                                     (_dir / "depthMapFilter").string(), false, 1, &cameras));
+    }
+
+    ~Scene()
+    {
+        bfs::remove_all(_dir);
+    }
+
+    void writeImage(int camId, int w, int h) const
+    {
+        const std::vector<rgb> image(w * h, rgb(camId, camId, camId));
+        imageIO::writeImage((_dir / (std::to_string(camId) + ".png")).string(), w, h, image);
+    }
+
+    static int getCamId(const ImagesCache::ImgSharedPtr& img)
+    {
+        return static_cast<int>(img->at(0, 0).r * 255.0f + 0.5f);
+    }
+
+    std::unique_ptr<MultiViewParams> mp;
+
+private:
+    bfs::path _dir;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ImagesCache_concurrentLoad)
+{
+    Scene scene;
+    ImagesCache ic(scene.mp.get(), 0);
+    BOOST_CHECK_EQUAL(ic.N_PRELOADED_IMAGES, capacity);
+
+    // all the threads request the same cameras at the same time: each image is loaded once
+    const int nbThreads = 8;
+    std::vector<std::vector<ImagesCache::ImgSharedPtr>> threadImages(nbThreads);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < nbThreads; ++t)
+    {
+        threads.emplace_back([&ic, &threadImages, t]() {
+            for(int c = 0; c < capacity; ++c)
+                threadImages[t].push_back(ic.getImg_sync(c));
+        });
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+
+    for(int c = 0; c < capacity; ++c)
+    {
+        BOOST_CHECK_EQUAL(Scene::getCamId(threadImages[0][c]), c);
+        for(int t = 1; t < nbThreads; ++t)
+            BOOST_CHECK(threadImages[t][c] == threadImages[0][c]);
+        // still in the cache
+        BOOST_CHECK(ic.getImg_sync(c) == threadImages[0][c]);
+    }
+    BOOST_CHECK_EQUAL(ic.getNbImages(), capacity);
+}
+
+BOOST_AUTO_TEST_CASE(ImagesCache_eviction)
+{
+    Scene scene;
+    ImagesCache ic(scene.mp.get(), 0);
+
+    std::vector<ImagesCache::ImgSharedPtr> images;
+    for(int c = 0; c < capacity; ++c)
+        images.push_back(ic.getImg_sync(c));
+    BOOST_CHECK_EQUAL(ic.getNbImages(), capacity);
+
+    // camera 0 becomes the most recently used, camera 1 is removed
+    BOOST_CHECK(ic.getImg_sync(0) == images[0]);
+    const ImagesCache::ImgSharedPtr img4 = ic.getImg_sync(capacity);
+    BOOST_CHECK_EQUAL(Scene::getCamId(img4), capacity);
+    BOOST_CHECK_EQUAL(ic.getNbImages(), capacity);
+
+    BOOST_CHECK(ic.getImg_sync(0) == images[0]);
+    BOOST_CHECK(ic.getImg_sync(2) == images[2]);
+    BOOST_CHECK(ic.getImg_sync(3) == images[3]);
+    BOOST_CHECK(ic.getImg_sync(capacity) == img4);
+
+    // the removed image stays valid for its users and is loaded again
+    BOOST_CHECK_EQUAL(Scene::getCamId(images[1]), 1);
+    const ImagesCache::ImgSharedPtr img1 = ic.getImg_sync(1);
+    BOOST_CHECK(img1 != images[1]);
+    BOOST_CHECK_EQUAL(Scene::getCamId(img1), 1);
+    BOOST_CHECK_EQUAL(ic.getNbImages(), capacity);
+
+    // the capacity is shared by all the cameras, whatever their ids
+    for(int c = 0; c < nbCameras; c += 2)
+        ic.getImg_sync(c);
+    const std::vector<ImagesCache::ImgSharedPtr> evenImages = {ic.getImg_sync(0), ic.getImg_sync(2),
+                                                               ic.getImg_sync(4), ic.getImg_sync(6)};
+    BOOST_CHECK(ic.getImg_sync(0) == evenImages[0]);
+    BOOST_CHECK(ic.getImg_sync(2) == evenImages[1]);
+    BOOST_CHECK(ic.getImg_sync(4) == evenImages[2]);
+    BOOST_CHECK(ic.getImg_sync(6) == evenImages[3]);
+    BOOST_CHECK_EQUAL(ic.getNbImages(), capacity);
+}
+
+BOOST_AUTO_TEST_CASE(ImagesCache_retryAfterFailure)
+{
+    Scene scene;
+    ImagesCache ic(scene.mp.get(), 0);
+
+    // bad image dimension
+    scene.writeImage(2, width / 2, height);
+    BOOST_CHECK_THROW(ic.getImg_sync(2), std::runtime_error);
+    BOOST_CHECK_THROW(ic.getImg_sync(2), std::runtime_error);
+    BOOST_CHECK_EQUAL(ic.getNbImages(), 0);
+
+    // the failed load is not kept in the cache
+    scene.writeImage(2, width, height);
+    const ImagesCache::ImgSharedPtr img = ic.getImg_sync(2);
+    BOOST_CHECK_EQUAL(Scene::getCamId(img), 2);
+    BOOST_CHECK(ic.getImg_sync(2) == img);
+    BOOST_CHECK_EQUAL(ic.getNbImages(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(ImagesCache_prefetch)
+{
+    Scene scene;
+    ImagesCache ic(scene.mp.get(), 0);
+
+    std::vector<int> camIds;
+    for(int c = 0; c < nbCameras; ++c)
+        camIds.push_back(c);
+    ic.refreshImages_async(camIds);
+
+    // wait for the background threads, the cache never goes over its capacity
+    const auto start = std::chrono::steady_clock::now();
+    while(ic.getNbImages() < capacity && std::chrono::steady_clock::now() - start < std::chrono::seconds(30))
+    {
+        BOOST_CHECK_LE(ic.getNbImages(), capacity);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    BOOST_CHECK_EQUAL(ic.getNbImages(), capacity);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    BOOST_CHECK_EQUAL(ic.getNbImages(), capacity);
+
+    // the prefetched images are the right ones
+    for(int c = 0; c < nbCameras; ++c)
+    {
+        BOOST_CHECK_EQUAL(Scene::getCamId(ic.getImg_sync(c)), c);
+        BOOST_CHECK_LE(ic.getNbImages(), capacity);
+    }
+}
@@ -94,6 +94,8 @@ typedef Eigen::Matrix<double, 2, Eigen::Dynamic> Mat2X;
 typedef Eigen::Matrix<double, 3, Eigen::Dynamic> Mat3X;
 typedef Eigen::Matrix<double, 4, Eigen::Dynamic> Mat4X;
 
+typedef Eigen::Matrix<double, Eigen::Dynamic, 2> MatX2;
+typedef Eigen::Matrix<double, Eigen::Dynamic, 3> MatX3;
 typedef Eigen::Matrix<double, Eigen::Dynamic, 9> MatX9;
 
 //-- Sparse Matrix (Column major, and row major)
@@ -36,7 +36,10 @@
 
 
 #include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <limits>
@@ -44,7 +47,9 @@
 #include <vector>
 
 #include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/robustEstimation/ransacTools.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 namespace aliceVision {
 namespace robustEstimation{
@@ -145,6 +150,213 @@ inline ErrorIndex bestNFA(
 }
 
 
+/**
+ * @brief Find the best NFA without sorting all the residuals.
+ *
+ * The residuals are binned in a fixed logarithmic histogram (exponent and first mantissa
+ * bits of their float representation). In each bin, the NFA is bounded using the bin
+ * extreme residuals, and only the residuals of the bins that may contain the best NFA
+ * are sorted. The result is the same as bestNFA on the sorted residuals.
+ *
+ * The buffers are kept between the calls, use one instance per estimation loop.
+ */
+class NFAHistogram
+{
+public:
+  /**
+   * @brief Find best NFA and its index wrt square error threshold in the residuals.
+   * @see bestNFA
+   * @param[in] residuals The residuals, in any order
+   * @return the best NFA and the number of inliers
+   */
+  ErrorIndex bestNFA(
+    int startIndex, //number of point required for estimation
+    double logalpha0,
+    const std::vector<double>& residuals,
+    double loge0,
+    double maxThreshold,
+    const std::vector<float> &logc_n,
+    const std::vector<float> &logc_k,
+    double multError = 1.0)
+  {
+    assert(multError >= 0.0);
+    const std::size_t n = residuals.size();
+
+    if(_count.empty())
+    {
+      _count.assign(_nbBins, 0);
+      _isCandidate.assign(_nbBins, 0);
+      _minError.resize(_nbBins);
+      _maxError.resize(_nbBins);
+    }
+
+    // fill the histogram with the residuals below the threshold
+    _bins.resize(n);
+    _usedBins.clear();
+    for(std::size_t i = 0; i < n; ++i)
+    {
+      const double error = residuals[i];
+      if(!(error <= maxThreshold))
+      {
+        _bins[i] = _nbBins;
+        continue;
+      }
+      const std::uint32_t bin = binIndex(error);
+      _bins[i] = bin;
+      if(_count[bin]++ == 0)
+      {
+        _usedBins.push_back(bin);
+        _minError[bin] = error;
+        _maxError[bin] = error;
+      }
+      else
+      {
+        _minError[bin] = std::min(_minError[bin], error);
+        _maxError[bin] = std::max(_maxError[bin], error);
+      }
+    }
+    std::sort(_usedBins.begin(), _usedBins.end());
+
+    // the NFA of the last residual of a bin is exact (the bin maximum error):
+    // it gives an upper bound of the best NFA
+    double upperBound = std::numeric_limits<double>::infinity();
+    {
+      std::size_t k = 0;
+      for(std::uint32_t bin : _usedBins)
+      {
+        k += _count[bin];
+        if(k > (std::size_t)startIndex)
+          upperBound = std::min(upperBound, nfa(startIndex, logalpha0, _maxError[bin], loge0, k, logc_n, logc_k, multError));
+      }
+    }
+    // margin for the rounding errors of the lower bounds
+    upperBound += 1e-6 * (1.0 + std::abs(upperBound));
+
+    // the NFA in a bin is bounded by the bin minimum error and the minimum of logc_n + logc_k:
+    // the bins that cannot contain the best NFA are skipped
+    bool hasCandidates = false;
+    {
+      std::size_t k = 0;
+      for(std::uint32_t bin : _usedBins)
+      {
+        const std::size_t firstK = std::max(k + 1, (std::size_t)startIndex + 1);
+        k += _count[bin];
+        if(firstK > k)
+          continue;
+
+        const double logalpha = logalpha0 + multError * log10(_minError[bin] + std::numeric_limits<float>::epsilon());
+        double minLogc = std::numeric_limits<double>::infinity();
+        for(std::size_t j = firstK; j <= k; ++j)
+          minLogc = std::min(minLogc, (double)logc_n[j] + (double)logc_k[j]);
+        const double lowerBound = loge0 +
+                                  std::min(logalpha * (double)(firstK - startIndex), logalpha * (double)(k - startIndex)) +
+                                  minLogc;
+        if(lowerBound <= upperBound)
+        {
+          _isCandidate[bin] = 1;
+          hasCandidates = true;
+        }
+      }
+    }
+
+    ErrorIndex bestIndex(std::numeric_limits<double>::infinity(), startIndex);
+
+    if(hasCandidates)
+    {
+      // sort the residuals of the candidate bins
+      _candidateErrors.clear();
+      for(std::size_t i = 0; i < n; ++i)
+      {
+        if(_bins[i] < _nbBins && _isCandidate[_bins[i]])
+          _candidateErrors.push_back(residuals[i]);
+      }
+      std::sort(_candidateErrors.begin(), _candidateErrors.end());
+
+      // evaluate the NFA in the candidate bins, in increasing order of k (as bestNFA)
+      std::size_t k = 0;
+      std::vector<double>::const_iterator error = _candidateErrors.begin();
+      for(std::uint32_t bin : _usedBins)
+      {
+        if(!_isCandidate[bin])
+        {
+          k += _count[bin];
+          continue;
+        }
+        for(std::size_t j = 0; j < _count[bin]; ++j, ++error)
+        {
+          ++k;
+          if(k <= (std::size_t)startIndex)
+            continue;
+          const ErrorIndex index(nfa(startIndex, logalpha0, *error, loge0, k, logc_n, logc_k, multError), k);
+          if(index.first < bestIndex.first)
+            bestIndex = index;
+        }
+      }
+    }
+
+    // reset the histogram
+    for(std::uint32_t bin : _usedBins)
+    {
+      _count[bin] = 0;
+      _isCandidate[bin] = 0;
+    }
+
+    return bestIndex;
+  }
+
+private:
+  /// number of bins per octave: 2^_nbMantissaBits
+  static const int _nbMantissaBits = 3;
+  /// positive floats (and +inf) bins
+  static const std::uint32_t _nbBins = 1u << (8 + _nbMantissaBits);
+
+  /// logarithmic bin of a (positive) error, increasing with the error
+  static std::uint32_t binIndex(double error)
+  {
+    const float value = static_cast<float>(error);
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x7fffffffu) >> (23 - _nbMantissaBits);
+  }
+
+  /// NFA of the k-th sorted residual (same computation as bestNFA)
+  static double nfa(int startIndex, double logalpha0, double error, double loge0, std::size_t k,
+                    const std::vector<float> &logc_n, const std::vector<float> &logc_k, double multError)
+  {
+    const double logalpha = logalpha0 +
+      multError * log10(error + std::numeric_limits<float>::epsilon());
+    return loge0 +
+           logalpha * (double) (k - startIndex) +
+           logc_n[k] +
+           logc_k[k];
+  }
+
+  std::vector<std::uint32_t> _count;
+  std::vector<std::uint8_t> _isCandidate;
+  std::vector<double> _minError;
+  std::vector<double> _maxError;
+  /// bin of each residual (_nbBins if above the threshold)
+  std::vector<std::uint32_t> _bins;
+  /// non-empty bins
+  std::vector<std::uint32_t> _usedBins;
+  std::vector<double> _candidateErrors;
+};
+
+/// An AC-RANSAC hypothesis: a sample, its models and their evaluation
+template<typename Model>
+struct ACRansacHypothesis
+{
+  std::vector<std::size_t> sample;
+  /// up to max_models solutions
+  std::vector<Model> models;
+  /// number of residuals below the precision of each model (before the a contrario mode)
+  std::vector<std::size_t> nbInliers;
+  /// most meaningful discrimination inliers/outliers of each model
+  std::vector<ErrorIndex> nfa;
+  /// residuals of each model, only kept when the hypotheses are evaluated one at a time
+  std::vector<std::vector<double>> residuals;
+};
+
 /**
  * @brief ACRANSAC routine (ErrorThreshold, NFA)
  *
@@ -154,6 +366,9 @@ inline ErrorIndex bestNFA(
  * @param[out] model returned model if found
  * @param[in] precision upper bound of the precision (squared error)
  * @param[in] bVerbose display console log
+ * @param[in] parallel if not null, the hypotheses are generated and evaluated
+ *            by batches across the threads (@see ParallelEvaluation).
+ *            Called from inside a parallel region, the batches are evaluated by the calling thread.
  *
  * @return (errorMax, minNFA)
  */
@@ -163,7 +378,8 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
   size_t nIter = 1024,
   typename Kernel::Model * model = nullptr,
   double precision = std::numeric_limits<double>::infinity(),
-  bool bVerbose = false)
+  bool bVerbose = false,
+  const ParallelEvaluation* parallel = nullptr)
 {
   vec_inliers.clear();
 
@@ -176,7 +392,8 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
     std::numeric_limits<double>::infinity() :
     precision * kernel.normalizer2()(0,0) * kernel.normalizer2()(0,0);
 
-  std::vector<ErrorIndex> vec_residuals(nData); // [residual,index]
+  std::vector<ErrorIndex> vec_residuals; // [residual,index]
+  vec_residuals.reserve(nData);
   std::vector<double> vec_residuals_(nData);
 
   // Possible sampling indices [0,..,nData] (will change in the optimization phase)
@@ -198,66 +415,129 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
 
   bool bACRansacMode = (precision == std::numeric_limits<double>::infinity());
 
+  // Hypotheses generated and evaluated at once
+  const size_t batchSize = parallel ? std::max<size_t>(parallel->batchSize, 1) : 1;
+  std::vector<ACRansacHypothesis<typename Kernel::Model>> hypotheses(batchSize);
+  size_t hypothesisIndex = 0;
+
+  // Per thread residuals
+  // (no nested parallelism: inside a parallel region the batches are evaluated by the calling thread)
+  const bool parallelBatches = parallel && !omp_in_parallel();
+  const int nbThreads = parallelBatches ? omp_get_max_threads() : 1;
+  std::vector<std::vector<double>> threadResiduals(nbThreads, std::vector<double>(nData));
+  std::vector<NFAHistogram> threadNFAHistograms(nbThreads);
+
   // Main estimation loop.
-  for (size_t iter=0; iter < nIter; ++iter)
+  for (size_t iter=0; iter < nIter; )
   {
-    std::vector< std::size_t> vec_sample(sizeSample); // Sample indices
-    if (bACRansacMode)
-      UniformSample(sizeSample, vec_index, vec_sample); // Get random sample
-    else
-      UniformSample(sizeSample, nData, vec_sample); // Get random sample
-
-    std::vector<typename Kernel::Model> vec_models; // Up to max_models solutions
-    kernel.Fit(vec_sample, &vec_models);
-
-    // Evaluate models
-    bool better = false;
-    for (size_t k = 0; k < vec_models.size(); ++k)
+    // Generate and evaluate a batch of hypotheses with the current sampling
+    const size_t nbHypotheses = std::min(batchSize, nIter - iter);
+    const bool bACRansacModeBatch = bACRansacMode;
+
+    #pragma omp parallel for schedule(dynamic) if(parallelBatches && nbHypotheses > 1)
+    for (int h = 0; h < static_cast<int>(nbHypotheses); ++h)
     {
-      // Residuals computation and ordering
-      kernel.Errors(vec_models[k], vec_residuals_);
+      ACRansacHypothesis<typename Kernel::Model>& hypothesis = hypotheses[h];
+      NFAHistogram& nfaHistogram = threadNFAHistograms[omp_get_thread_num()];
 
-      if (!bACRansacMode)
+      if (parallel)
       {
-        unsigned int nInlier = 0;
-        for (size_t i = 0; i < nData; ++i)
-        {
-          if (vec_residuals_[i] <= maxThreshold)
-            ++nInlier;
-        }
-        if (nInlier > 2.5 * sizeSample) // does the model is meaningful
-          bACRansacMode = true;
+        std::mt19937 generator = parallel->generator(hypothesisIndex + h);
+        if (bACRansacModeBatch)
+          UniformSample(sizeSample, vec_index, hypothesis.sample, generator); // Get random sample
+        else
+          UniformSample(sizeSample, nData, hypothesis.sample, generator); // Get random sample
       }
-      if (bACRansacMode)
+      else
+      {
+        if (bACRansacModeBatch)
+          UniformSample(sizeSample, vec_index, hypothesis.sample); // Get random sample
+        else
+          UniformSample(sizeSample, nData, hypothesis.sample); // Get random sample
+      }
+
+      hypothesis.models.clear();
+      kernel.Fit(hypothesis.sample, &hypothesis.models);
+      hypothesis.nbInliers.assign(hypothesis.models.size(), 0);
+      hypothesis.nfa.assign(hypothesis.models.size(), ErrorIndex(std::numeric_limits<double>::infinity(), 0));
+      // a single hypothesis keeps its residuals for the update of the best model
+      hypothesis.residuals.resize(nbHypotheses == 1 ? hypothesis.models.size() : 0, std::vector<double>(nData));
+
+      // Evaluate models
+      // (the a contrario mode can also be enabled by a previous hypothesis of the batch)
+      bool bACRansacModeHypothesis = bACRansacModeBatch || nbHypotheses > 1;
+      for (size_t k = 0; k < hypothesis.models.size(); ++k)
       {
-        for (size_t i = 0; i < nData; ++i)
+        std::vector<double>& residuals = (nbHypotheses == 1) ? hypothesis.residuals[k] : threadResiduals[omp_get_thread_num()];
+
+        // Residuals computation
+        kernel.Errors(hypothesis.models[k], residuals);
+
+        if (!bACRansacModeBatch)
         {
-          const double error = vec_residuals_[i];
-          vec_residuals[i] = ErrorIndex(error, i);
+          for (size_t i = 0; i < nData; ++i)
+          {
+            if (residuals[i] <= maxThreshold)
+              ++hypothesis.nbInliers[k];
+          }
+          if (hypothesis.nbInliers[k] > 2.5 * sizeSample) // does the model is meaningful
+            bACRansacModeHypothesis = true;
+        }
+        if (bACRansacModeHypothesis)
+        {
+          // Most meaningful discrimination inliers/outliers
+          // (the residuals are only partially ordered)
+          hypothesis.nfa[k] = nfaHistogram.bestNFA(
+            sizeSample,
+            kernel.logalpha0(),
+            residuals,
+            loge0,
+            maxThreshold,
+            vec_logc_n,
+            vec_logc_k,
+            kernel.multError());
         }
-        std::sort(vec_residuals.begin(), vec_residuals.end());
-
-        // Most meaningful discrimination inliers/outliers
-        const ErrorIndex best = bestNFA(
-          sizeSample,
-          kernel.logalpha0(),
-          vec_residuals,
-          loge0,
-          maxThreshold,
-          vec_logc_n,
-          vec_logc_k,
-          kernel.multError());
-
-        if (best.first < minNFA /*&& vec_residuals[best.second-1].first < errorMax*/)
+      }
+    }
+    hypothesisIndex += nbHypotheses;
+
+    // Update the best model with the hypotheses, in order
+    for (size_t h = 0; h < nbHypotheses && iter < nIter; ++h, ++iter)
+    {
+      const ACRansacHypothesis<typename Kernel::Model>& hypothesis = hypotheses[h];
+      bool better = false;
+
+      for (size_t k = 0; k < hypothesis.models.size(); ++k)
+      {
+        if (!bACRansacMode && hypothesis.nbInliers[k] > 2.5 * sizeSample) // does the model is meaningful
+          bACRansacMode = true;
+
+        const ErrorIndex& best = hypothesis.nfa[k];
+        if (bACRansacMode && best.first < minNFA /*&& vec_residuals[best.second-1].first < errorMax*/)
         {
-          // A better model was found
+          // A better model was found: order its best.second smallest residuals
+          // (the residuals of a batch are not kept, they are computed again)
+          const std::vector<double>* residuals = &vec_residuals_;
+          if (hypothesis.residuals.empty())
+            kernel.Errors(hypothesis.models[k], vec_residuals_);
+          else
+            residuals = &hypothesis.residuals[k];
+          vec_residuals.clear();
+          for (size_t i = 0; i < nData; ++i)
+          {
+            const double error = (*residuals)[i];
+            if (error <= maxThreshold)
+              vec_residuals.emplace_back(error, i);
+          }
+          std::partial_sort(vec_residuals.begin(), vec_residuals.begin() + best.second, vec_residuals.end());
+
           better = true;
           minNFA = best.first;
           vec_inliers.resize(best.second);
           for (size_t i=0; i<best.second; ++i)
             vec_inliers[i] = vec_residuals[i].second;
           errorMax = vec_residuals[best.second-1].first; // Error threshold
-          if(model) *model = vec_models[k];
+          if(model) *model = hypothesis.models[k];
 
           if(bVerbose)
           {
@@ -266,34 +546,37 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
               << " precisionNormalized=" << errorMax
               << " precision=" << kernel.unormalizeError(errorMax)
               << " (iter=" << iter
-              << ",sample=" << vec_sample
+              << ",sample=" << hypothesis.sample
               << ")");
           }
         }
-      } //if(bACRansacMode)
-    } //for(size_t k...
-    
-    // Early exit test -> no meaningful model found after nIterReserve*2 iterations
-    if (!bACRansacMode && iter > nIterReserve*2)
-      break;
-
-    // ACRANSAC optimization: draw samples among best set of inliers so far
-    if (bACRansacMode && ((better && minNFA<0) || (iter+1==nIter && nIterReserve)))
-    {
-      if (vec_inliers.empty())
+      } //for(size_t k...
+
+      // Early exit test -> no meaningful model found after nIterReserve*2 iterations
+      if (!bACRansacMode && iter > nIterReserve*2)
       {
-        // No model found at all so far
-        ++nIter; // Continue to look for any model, even not meaningful
-        --nIterReserve;
+        nIter = iter + 1;
+        continue;
       }
-      else
+
+      // ACRANSAC optimization: draw samples among best set of inliers so far
+      if (bACRansacMode && ((better && minNFA<0) || (iter+1==nIter && nIterReserve)))
       {
-        // ACRANSAC optimization: draw samples among best set of inliers so far
-        vec_index = vec_inliers;
-        if(nIterReserve)
+        if (vec_inliers.empty())
+        {
+          // No model found at all so far
+          ++nIter; // Continue to look for any model, even not meaningful
+          --nIterReserve;
+        }
+        else
         {
-          nIter = iter + 1 + nIterReserve;
-          nIterReserve = 0;
+          // ACRANSAC optimization: draw samples among best set of inliers so far
+          vec_index = vec_inliers;
+          if(nIterReserve)
+          {
+            nIter = iter + 1 + nIterReserve;
+            nIterReserve = 0;
+          }
         }
       }
     }
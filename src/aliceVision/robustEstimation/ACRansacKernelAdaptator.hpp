@@ -85,6 +85,32 @@ inline bool hasStrongSupport(const matching::MatchesPerDescType& matchesPerDesc,
 }
 
 
+namespace detail {
+
+/**
+ * @brief Errors of all the correspondences with the vectorized ErrorT::Errors,
+ *        used if the error functor provides it.
+ * @note The points are given twice: one per column (AoS) and one per row (SoA, x y z stored contiguously).
+ */
+template<typename ErrorT, typename ModelT, typename SoA1T, typename SoA2T>
+inline auto computeErrors(const ModelT& model, const Mat& x1, const Mat& x2, const SoA1T& x1SoA, const SoA2T& x2SoA,
+                          std::vector<double>& errors, int) -> decltype(ErrorT::Errors(model, x1SoA, x2SoA, errors))
+{
+  ErrorT::Errors(model, x1SoA, x2SoA, errors);
+}
+
+/// fallback: errors evaluated point by point with ErrorT::Error
+template<typename ErrorT, typename ModelT, typename SoA1T, typename SoA2T>
+inline void computeErrors(const ModelT& model, const Mat& x1, const Mat& x2, const SoA1T& x1SoA, const SoA2T& x2SoA,
+                          std::vector<double>& errors, long)
+{
+  errors.resize(x1.cols());
+  for(std::size_t sample = 0; sample < x1.cols(); ++sample)
+    errors[sample] = ErrorT::Error(model, x1.col(sample), x2.col(sample));
+}
+
+} // namespace detail
+
 /// Two view Kernel adapter for the A contrario model estimator
 /// Handle data normalization and compute the corresponding logalpha 0
 ///  that depends of the error model (point to line, or point to point)
@@ -114,6 +140,8 @@ public:
 
     NormalizePointsFromImageSize(x1, &x1_, &N1_, w1, h1);
     NormalizePointsFromImageSize(x2, &x2_, &N2_, w2, h2);
+    x1SoA_ = x1_.transpose();
+    x2SoA_ = x2_.transpose();
 
     // LogAlpha0 is used to make error data scale invariant
     if(bPointToLine)
@@ -154,9 +182,7 @@ public:
 
   void Errors(const Model & model, std::vector<double> & vec_errors) const
   {
-    vec_errors.resize(x1_.cols());
-    for(std::size_t sample = 0; sample < x1_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(model, x1_.col(sample), x2_.col(sample));
+    detail::computeErrors<ErrorT>(model, x1_, x2_, x1SoA_, x2SoA_, vec_errors, 0);
   }
 
   std::size_t NumSamples() const
@@ -180,6 +206,7 @@ public:
 
 protected:
   Mat x1_, x2_; // Normalized input data
+  MatX2 x1SoA_, x2SoA_; // Normalized input data, one point per row for the vectorized errors
   Mat3 N1_, N2_; // Matrix used to normalize data
   double logalpha0_; // Alpha0 is used to make the error adaptive to the image size
   bool bPointToLine_; // Store if error model is pointToLine or point to point
@@ -216,6 +243,8 @@ public:
     assert(x2d_.cols() == x3D_.cols());
 
     NormalizePointsFromImageSize(x2d, &x2d_, &N1_, w, h);
+    x2dSoA_ = x2d_.transpose();
+    x3DSoA_ = x3D_.transpose();
   }
 
   enum
@@ -242,9 +271,7 @@ public:
 
   void Errors(const Model & model, std::vector<double> & vec_errors) const
   {
-    vec_errors.resize(x2d_.cols());
-    for(std::size_t sample = 0; sample < x2d_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(model, x2d_.col(sample), x3D_.col(sample));
+    detail::computeErrors<ErrorT>(model, x2d_, x3D_, x2dSoA_, x3DSoA_, vec_errors, 0);
   }
 
   std::size_t NumSamples() const
@@ -267,6 +294,8 @@ public:
 private:
   Mat x2d_;
   const Mat& x3D_;
+  MatX2 x2dSoA_; // one point per row for the vectorized errors
+  MatX3 x3DSoA_;
   Mat3 N1_; // Matrix used to normalize data
   double logalpha0_; // Alpha0 is used to make the error adaptive to the image size
 };
@@ -296,6 +325,8 @@ public:
 
     // Normalize points by inverse(K)
     ApplyTransformationToPoints(x2d, N1_, &x2d_);
+    x2dSoA_ = x2d_.transpose();
+    x3DSoA_ = x3D_.transpose();
   }
 
   enum
@@ -322,9 +353,7 @@ public:
 
   void Errors(const Model & model, std::vector<double> & vec_errors) const
   {
-    vec_errors.resize(x2d_.cols());
-    for(std::size_t sample = 0; sample < x2d_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(model, x2d_.col(sample), x3D_.col(sample));
+    detail::computeErrors<ErrorT>(model, x2d_, x3D_, x2dSoA_, x3DSoA_, vec_errors, 0);
   }
 
   std::size_t NumSamples() const { return x2d_.cols(); }
@@ -344,6 +373,8 @@ public:
 protected:
   Mat x2d_;
   const Mat& x3D_;
+  MatX2 x2dSoA_; // one point per row for the vectorized errors
+  MatX3 x3DSoA_;
   Mat3 N1_; // Matrix used to normalize data
   double logalpha0_; // Alpha0 is used to make the error adaptive to the image size
   Mat3 K_; // Intrinsic camera parameter
@@ -376,6 +407,8 @@ public:
 
     ApplyTransformationToPoints(x1_, K1_.inverse(), &x1k_);
     ApplyTransformationToPoints(x2_, K2_.inverse(), &x2k_);
+    x1SoA_ = x1_.transpose();
+    x2SoA_ = x2_.transpose();
 
     //Point to line probability (line is the epipolar line)
     const double D = sqrt(w2 * (double)w2 + h2 * (double)h2); // diameter
@@ -411,9 +444,7 @@ public:
   {
     Mat3 F;
     FundamentalFromEssential(model, K1_, K2_, &F);
-    vec_errors.resize(x1_.cols());
-    for(std::size_t sample = 0; sample < x1_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(F, this->x1_.col(sample), this->x2_.col(sample));
+    detail::computeErrors<ErrorT>(F, x1_, x2_, x1SoA_, x2SoA_, vec_errors, 0);
   }
 
   std::size_t NumSamples() const { return x1_.cols(); }
@@ -426,6 +457,7 @@ public:
 
 private:
   Mat x1_, x2_, x1k_, x2k_; // image point and camera plane point.
+  MatX2 x1SoA_, x2SoA_; // image point, one per row for the vectorized errors
   Mat3 N1_, N2_; // Matrix used to normalize data
   double logalpha0_; // Alpha0 is used to make the error adaptive to the image size
   Mat3 K1_, K2_; // Intrinsic camera parameter
@@ -9,11 +9,13 @@
 #include "aliceVision/robustEstimation/randSampling.hpp"
 #include "aliceVision/robustEstimation/ACRansac.hpp"
 #include "aliceVision/robustEstimation/ransacTools.hpp"
+#include "aliceVision/alicevision_omp.hpp"
 #include <limits>
 #include <numeric>
 #include <iostream>
 #include <vector>
 #include <iterator>
+#include <random>
 
 namespace aliceVision {
 namespace robustEstimation{
@@ -255,6 +257,8 @@ double iterativeReweightedLeastSquares(const Kernel &kernel,
  * @param[in] mtheta A threshold multiplier used for IRLS.
  * @param[in] numRep The number of re-sampling/re-estimation of the model.
  * @param[in] minSampleSize Size of the inner sample used for re-estimation.
+ * @param[in] verbose Enable/Disable log messages
+ * @param[in,out] generator If not null, the random generator used to draw the samples.
  * @return the best score of the best model as computed by Scorer.
  */
 template<typename Kernel, typename Scorer>
@@ -265,7 +269,8 @@ double localOptimization(const Kernel &kernel,
                          double mtheta = std::sqrt(2),
                          std::size_t numRep = 10,
                          std::size_t minSampleSize = 10,
-                         bool verbose = false)
+                         bool verbose = false,
+                         std::mt19937* generator = nullptr)
 {
   const std::size_t total_samples = kernel.NumSamples();
   const std::size_t min_samples = Kernel::MINIMUM_LSSAMPLES;
@@ -327,7 +332,10 @@ double localOptimization(const Kernel &kernel,
   for(std::size_t i = 0; i < numRep; ++i)
   {
     std::vector<std::size_t> sample;
-    UniformSample(sampleSize, inliersBase, sample);
+    if(generator)
+      UniformSample(sampleSize, inliersBase, sample, *generator);
+    else
+      UniformSample(sampleSize, inliersBase, sample);
     assert(sampleSize > Kernel::MINIMUM_LSSAMPLES);
     assert(sample.size() > Kernel::MINIMUM_LSSAMPLES);
   
@@ -379,6 +387,9 @@ double localOptimization(const Kernel &kernel,
  * @param[in] bVerbose Enable/Disable log messages
  * @param[in] max_iterations Maximum number of iterations for the ransac part.
  * @param[in] outliers_probability The wanted probability of picking outliers.
+ * @param[in] parallel If not null, the hypotheses are generated and scored by
+ * batches across the threads (@see ParallelEvaluation). Called from inside a
+ * parallel region, the batches are scored by the calling thread.
  * @return The best model found.
  */
 template<typename Kernel, typename Scorer>
@@ -388,7 +399,8 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
                                 double *best_score = NULL,
                                 bool bVerbose = false,
                                 std::size_t max_iterations = 100,
-                                double outliers_probability = 1e-2)
+                                double outliers_probability = 1e-2,
+                                const ParallelEvaluation* parallel = nullptr)
 {
   assert(outliers_probability < 1.0);
   assert(outliers_probability > 0.0);
@@ -416,76 +428,135 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
   std::vector<std::size_t> all_samples(total_samples);
   std::iota(all_samples.begin(), all_samples.end(), 0);
 
-  for(iteration = 0; iteration < max_iterations; ++iteration) 
-  {
-    std::vector<std::size_t> sample;
-    UniformSample(min_samples, total_samples, sample);
+  // Hypotheses generated and scored at once: sample, models and their number of inliers / score
+  const std::size_t batchSize = parallel ? std::max<std::size_t>(parallel->batchSize, 1) : 1;
+  std::vector<std::vector<std::size_t>> samples(batchSize);
+  std::vector<std::vector<typename Kernel::Model>> models(batchSize);
+  std::vector<std::vector<std::size_t>> numInliers(batchSize);
+  std::vector<std::vector<double>> scores(batchSize);
+  // inliers of each model, only kept when the hypotheses are scored one at a time
+  std::vector<std::vector<std::size_t>> modelsInliers;
 
-    std::vector<typename Kernel::Model> models;
-    kernel.Fit(sample, &models);
+  // no nested parallelism: inside a parallel region the batches are scored by the calling thread
+  const bool parallelBatches = parallel && !omp_in_parallel();
+
+  for(iteration = 0; iteration < max_iterations; )
+  {
+    const std::size_t nbHypotheses = std::min(batchSize, max_iterations - iteration);
 
-    // Compute the inlier list for each fit.
-    for(std::size_t i = 0; i < models.size(); ++i) 
+    #pragma omp parallel for schedule(dynamic) if(parallelBatches && nbHypotheses > 1)
+    for(int h = 0; h < static_cast<int>(nbHypotheses); ++h)
     {
-      std::vector<std::size_t> inliers;
-      double score = scorer.Score(kernel, models[i], all_samples, &inliers);
-      if(bVerbose)
+      std::vector<std::size_t>& sample = samples[h];
+      if(parallel)
+      {
+        std::mt19937 generator = parallel->generator(iteration + h);
+        UniformSample(min_samples, total_samples, sample, generator);
+      }
+      else
       {
-        ALICEVISION_LOG_DEBUG("sample=" << sample);
-        ALICEVISION_LOG_DEBUG("model " << i << " e: " << score);
+        UniformSample(min_samples, total_samples, sample);
       }
 
-      if (bestNumInliers <= inliers.size()) 
+      models[h].clear();
+      kernel.Fit(sample, &models[h]);
+
+      // Compute the inlier list for each fit.
+      numInliers[h].resize(models[h].size());
+      scores[h].resize(models[h].size());
+      if(nbHypotheses == 1)
+        modelsInliers.resize(models[h].size());
+      std::vector<std::size_t> inliers;
+      for(std::size_t i = 0; i < models[h].size(); ++i)
       {
-        bestModel = models[i];
-        //** LOCAL OPTIMIZATION
-        if(bVerbose)
-        {
-          ALICEVISION_LOG_DEBUG("Before Optim: num inliers: " << inliers.size() 
-                  << " score: " << score
-                  << " Kernel::MINIMUM_LSSAMPLES: " << Kernel::MINIMUM_LSSAMPLES 
-                 );
+        inliers.clear();
+        scores[h][i] = scorer.Score(kernel, models[h][i], all_samples, &inliers);
+        numInliers[h][i] = inliers.size();
+        if(nbHypotheses == 1)
+          modelsInliers[i].swap(inliers);
+      }
+    }
 
-          ALICEVISION_LOG_DEBUG("Model:\n" << bestModel);
-        }
-        
-        if(inliers.size() > Kernel::MINIMUM_LSSAMPLES)
-        {
-          score = localOptimization(kernel, scorer, bestModel, inliers);
-        }
-        
+    // Update the best model with the hypotheses, in order
+    for(std::size_t h = 0; h < nbHypotheses && iteration < max_iterations; ++h, ++iteration)
+    {
+      const std::vector<std::size_t>& sample = samples[h];
+
+      for(std::size_t i = 0; i < models[h].size(); ++i)
+      {
+        double score = scores[h][i];
         if(bVerbose)
         {
-          ALICEVISION_LOG_DEBUG("After Optim: num inliers: " << inliers.size()
-                  << " score: " << score);
-          ALICEVISION_LOG_DEBUG("Model:\n" << bestModel);
+          ALICEVISION_LOG_DEBUG("sample=" << sample);
+          ALICEVISION_LOG_DEBUG("model " << i << " e: " << score);
         }
-        
-        bestNumInliers = inliers.size();
-        bestInlierRatio = inliers.size() / double(total_samples);
 
-        if (best_inliers) 
+        if (bestNumInliers <= numInliers[h][i])
         {
-          best_inliers->swap(inliers);
-        }
+          bestModel = models[h][i];
+          std::vector<std::size_t> inliers;
+          if(nbHypotheses == 1)
+            inliers.swap(modelsInliers[i]);
+          else
+            scorer.Score(kernel, bestModel, all_samples, &inliers); // the inliers of a batch are not kept
+
+          //** LOCAL OPTIMIZATION
+          if(bVerbose)
+          {
+            ALICEVISION_LOG_DEBUG("Before Optim: num inliers: " << inliers.size() 
+                    << " score: " << score
+                    << " Kernel::MINIMUM_LSSAMPLES: " << Kernel::MINIMUM_LSSAMPLES 
+                   );
+
+            ALICEVISION_LOG_DEBUG("Model:\n" << bestModel);
+          }
+          
+          if(inliers.size() > Kernel::MINIMUM_LSSAMPLES)
+          {
+            if(parallel)
+            {
+              std::mt19937 generator = parallel->generator(iteration, 1);
+              score = localOptimization(kernel, scorer, bestModel, inliers, std::sqrt(2), 10, 10, false, &generator);
+            }
+            else
+            {
+              score = localOptimization(kernel, scorer, bestModel, inliers);
+            }
+          }
+          
+          if(bVerbose)
+          {
+            ALICEVISION_LOG_DEBUG("After Optim: num inliers: " << inliers.size()
+                    << " score: " << score);
+            ALICEVISION_LOG_DEBUG("Model:\n" << bestModel);
+          }
+          
+          bestNumInliers = inliers.size();
+          bestInlierRatio = inliers.size() / double(total_samples);
+
+          if (best_inliers) 
+          {
+            best_inliers->swap(inliers);
+          }
 
-        if(bVerbose)
-        {
-          ALICEVISION_LOG_DEBUG(" inliers=" << bestNumInliers << "/" << total_samples
-                    << " (iter=" << iteration
-                    << " ,i=" << i
-                    << " ,sample=" << sample
-                    << ")");
-        }
-        if (bestInlierRatio) 
-        {
-          max_iterations = IterationsRequired(min_samples,
-                                              outliers_probability,
-                                              bestInlierRatio);
-          // safeguard to not get stuck in a big number of iterations
-          max_iterations = std::min(max_iterations, really_max_iterations);
           if(bVerbose)
-            ALICEVISION_LOG_DEBUG("New max_iteration: " << max_iterations);
+          {
+            ALICEVISION_LOG_DEBUG(" inliers=" << bestNumInliers << "/" << total_samples
+                      << " (iter=" << iteration
+                      << " ,i=" << i
+                      << " ,sample=" << sample
+                      << ")");
+          }
+          if (bestInlierRatio) 
+          {
+            max_iterations = IterationsRequired(min_samples,
+                                                outliers_probability,
+                                                bestInlierRatio);
+            // safeguard to not get stuck in a big number of iterations
+            max_iterations = std::min(max_iterations, really_max_iterations);
+            if(bVerbose)
+              ALICEVISION_LOG_DEBUG("New max_iteration: " << max_iterations);
+          }
         }
       }
     }
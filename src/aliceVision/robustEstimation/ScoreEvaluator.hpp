@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <vector>
+
 namespace aliceVision {
 namespace robustEstimation{
 
@@ -25,10 +27,13 @@ public:
                std::vector<T> *inliers,
                double threshold) const
   {
+    std::vector<double> errors;
+    computeErrors(kernel, model, samples, errors, 0);
+
     double cost = 0.0;
     for (size_t j = 0; j < samples.size(); ++j) 
     {
-      double error = kernel.Error(samples[j], model);
+      const double error = errors[j];
       if (error < threshold) 
       {
         cost += error;
@@ -55,6 +60,34 @@ public:
   double getThreshold() const {return threshold_;} 
   
 private:
+  /// errors of the samples from the (vectorized) errors of all the kernel samples, if the kernel provides Errors()
+  template <typename K, typename T>
+  static auto computeErrors(const K &kernel,
+                            const typename Kernel::Model &model,
+                            const std::vector<T> &samples,
+                            std::vector<double> &errors,
+                            int) -> decltype(kernel.Errors(model, errors))
+  {
+    std::vector<double> allErrors;
+    kernel.Errors(model, allErrors);
+    errors.resize(samples.size());
+    for (size_t j = 0; j < samples.size(); ++j)
+      errors[j] = allErrors[samples[j]];
+  }
+
+  /// fallback: errors evaluated sample by sample
+  template <typename K, typename T>
+  static void computeErrors(const K &kernel,
+                            const typename Kernel::Model &model,
+                            const std::vector<T> &samples,
+                            std::vector<double> &errors,
+                            long)
+  {
+    errors.resize(samples.size());
+    for (size_t j = 0; j < samples.size(); ++j)
+      errors[j] = kernel.Error(samples[j], model);
+  }
+
   double threshold_;
 };
 
@@ -11,6 +11,7 @@
 #include <aliceVision/robustEstimation/LineKernel.hpp>
 #include <aliceVision/robustEstimation/ACRansac.hpp>
 #include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <glog/logging.h>
 
 #include "lineTestGenerator.hpp"
@@ -362,3 +363,98 @@ BOOST_AUTO_TEST_CASE(RansacLineFitter_ACRANSACSimu)
 
   }
 }
+
+// Test that the histogram based NFA evaluation gives the same result as the sorted residuals
+BOOST_AUTO_TEST_CASE(ACRANSAC_NFAHistogram)
+{
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> exponentDist(-6.0, 4.0);
+  std::uniform_real_distribution<double> ratioDist(0.0, 1.0);
+
+  NFAHistogram nfaHistogram;
+  const int sizeSample = 7;
+
+  for(int trial = 0; trial < 200; ++trial)
+  {
+    const std::size_t nData = sizeSample + 1 + gen() % 3000;
+    const double inlierRatio = ratioDist(gen);
+    const double multError = (trial % 2) ? 1.0 : 0.5;
+    const double maxThreshold = (trial % 3) ? std::pow(10.0, exponentDist(gen)) : std::numeric_limits<double>::infinity();
+
+    // inliers with small residuals, outliers with large residuals, some ties
+    std::vector<double> residuals(nData);
+    for(double& residual : residuals)
+    {
+      residual = (ratioDist(gen) < inlierRatio) ? std::pow(10.0, exponentDist(gen) - 4.0) : std::pow(10.0, exponentDist(gen) + 4.0);
+      if(ratioDist(gen) < 0.05)
+        residual = std::round(residual);
+    }
+
+    std::vector<float> vec_logc_n, vec_logc_k;
+    makelogcombi(sizeSample, nData, vec_logc_k, vec_logc_n);
+    const double loge0 = log10(3.0 * (nData - sizeSample));
+    const double logalpha0 = -2.0;
+
+    std::vector<ErrorIndex> sortedResiduals(nData);
+    for(std::size_t i = 0; i < nData; ++i)
+      sortedResiduals[i] = ErrorIndex(residuals[i], i);
+    std::sort(sortedResiduals.begin(), sortedResiduals.end());
+
+    const ErrorIndex expected = bestNFA(sizeSample, logalpha0, sortedResiduals, loge0, maxThreshold, vec_logc_n, vec_logc_k, multError);
+    const ErrorIndex result = nfaHistogram.bestNFA(sizeSample, logalpha0, residuals, loge0, maxThreshold, vec_logc_n, vec_logc_k, multError);
+
+    BOOST_CHECK_EQUAL(result.second, expected.second);
+    BOOST_CHECK_EQUAL(result.first, expected.first);
+  }
+}
+
+// Test that the parallel evaluation gives the same result whatever the number of threads
+BOOST_AUTO_TEST_CASE(ACRANSAC_ParallelEvaluation)
+{
+  const int W = 100;
+  const int H = 100;
+  Mat points;
+  generateLine(points, 1000, W, H, 0.01, 0.5);
+
+  const ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(points, W, H);
+  const ParallelEvaluation parallel(42, 16);
+  const int maxThreads = omp_get_max_threads();
+
+  std::vector<std::size_t> refInliers;
+  Vec2 refLine;
+  omp_set_num_threads(1);
+  const std::pair<double,double> refRet = ACRANSAC(lineKernel, refInliers, 1000, &refLine, std::numeric_limits<double>::infinity(), false, &parallel);
+  BOOST_CHECK(!refInliers.empty());
+
+  for(int nbThreads : {2, 3, 8})
+  {
+    omp_set_num_threads(nbThreads);
+    std::vector<std::size_t> vec_inliers;
+    Vec2 line;
+    const std::pair<double,double> ret = ACRANSAC(lineKernel, vec_inliers, 1000, &line, std::numeric_limits<double>::infinity(), false, &parallel);
+
+    BOOST_CHECK(vec_inliers == refInliers);
+    BOOST_CHECK_EQUAL(line[0], refLine[0]);
+    BOOST_CHECK_EQUAL(line[1], refLine[1]);
+    BOOST_CHECK_EQUAL(ret.first, refRet.first);
+    BOOST_CHECK_EQUAL(ret.second, refRet.second);
+  }
+  omp_set_num_threads(maxThreads);
+
+  // called from a parallel region, the batches are evaluated by the calling thread
+  #pragma omp parallel num_threads(2)
+  {
+    std::vector<std::size_t> vec_inliers;
+    Vec2 line;
+    const std::pair<double,double> ret = ACRANSAC(lineKernel, vec_inliers, 1000, &line, std::numeric_limits<double>::infinity(), false, &parallel);
+
+    #pragma omp critical
+    {
+      BOOST_CHECK(vec_inliers == refInliers);
+      BOOST_CHECK_EQUAL(line[0], refLine[0]);
+      BOOST_CHECK_EQUAL(line[1], refLine[1]);
+      BOOST_CHECK_EQUAL(ret.first, refRet.first);
+      BOOST_CHECK_EQUAL(ret.second, refRet.second);
+    }
+  }
+}
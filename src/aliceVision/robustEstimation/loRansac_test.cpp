@@ -12,6 +12,7 @@
 #include "lineTestGenerator.hpp"
 
 #include "aliceVision/numeric/numeric.hpp"
+#include "aliceVision/alicevision_omp.hpp"
 
 #include <iostream>
 #include <random>
@@ -161,3 +162,55 @@ BOOST_AUTO_TEST_CASE(LoRansacLineFitter_RealCaseLoRansac)
     BOOST_CHECK_EQUAL(expectedInliers, vec_inliers.size());
   }
 }
+
+// Test that the parallel evaluation gives the same result whatever the number of threads
+BOOST_AUTO_TEST_CASE(LoRansacLineFitter_ParallelEvaluation)
+{
+  const std::size_t numPoints = 1000;
+  const double outlierRatio = .5;
+  const double gaussianNoiseLevel = 0.01;
+
+  Vec2 GTModel;
+  GTModel << -2, .3;
+
+  std::mt19937 gen;
+  Mat2X xy(2, numPoints);
+  vector<std::size_t> vec_inliersGT;
+  generateLine(numPoints, outlierRatio, gaussianNoiseLevel, GTModel, gen, xy, vec_inliersGT);
+
+  const LineKernelLoRansac kernel(xy);
+  const ScoreEvaluator<LineKernel> scorer(3 * gaussianNoiseLevel);
+  const ParallelEvaluation parallel(42, 16);
+  const int maxThreads = omp_get_max_threads();
+
+  std::vector<std::size_t> refInliers;
+  omp_set_num_threads(1);
+  const Vec2 refModel = LO_RANSAC(kernel, scorer, &refInliers, nullptr, false, 100, 1e-2, &parallel);
+  BOOST_CHECK_EQUAL(numPoints - (std::size_t) (numPoints * outlierRatio), refInliers.size());
+
+  for(int nbThreads : {2, 3, 8})
+  {
+    omp_set_num_threads(nbThreads);
+    std::vector<std::size_t> vec_inliers;
+    const Vec2 model = LO_RANSAC(kernel, scorer, &vec_inliers, nullptr, false, 100, 1e-2, &parallel);
+
+    BOOST_CHECK(vec_inliers == refInliers);
+    BOOST_CHECK_EQUAL(model[0], refModel[0]);
+    BOOST_CHECK_EQUAL(model[1], refModel[1]);
+  }
+  omp_set_num_threads(maxThreads);
+
+  // called from a parallel region, the batches are scored by the calling thread
+  #pragma omp parallel num_threads(2)
+  {
+    std::vector<std::size_t> vec_inliers;
+    const Vec2 model = LO_RANSAC(kernel, scorer, &vec_inliers, nullptr, false, 100, 1e-2, &parallel);
+
+    #pragma omp critical
+    {
+      BOOST_CHECK(vec_inliers == refInliers);
+      BOOST_CHECK_EQUAL(model[0], refModel[0]);
+      BOOST_CHECK_EQUAL(model[1], refModel[1]);
+    }
+  }
+}
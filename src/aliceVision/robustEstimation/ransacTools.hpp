@@ -9,6 +9,9 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
 
 namespace aliceVision {
 namespace robustEstimation{
@@ -34,5 +37,40 @@ inline size_t IterationsRequired(
     std::log(1.0 - std::pow(inlier_ratio, static_cast<int>(min_samples))));
 }
 
+/**
+ * @brief Opt-in parallel evaluation of the RANSAC hypotheses.
+ *
+ * The hypotheses are generated and scored by batches across the threads.
+ * Each hypothesis draws its sample from its own generator, seeded from the
+ * seed and the hypothesis index, and the results of a batch are merged in the
+ * hypotheses order: the estimation is reproducible for a given seed, whatever
+ * the number of threads.
+ * There is no nested parallelism: when the estimation is called from inside a
+ * parallel region, the batches are evaluated by the calling thread (same results).
+ */
+struct ParallelEvaluation
+{
+  explicit ParallelEvaluation(std::uint32_t seed = 0, std::size_t batchSize = 64)
+    : seed(seed)
+    , batchSize(batchSize)
+  {}
+
+  /**
+   * @brief Random generator of a hypothesis.
+   * @param[in] hypothesis The hypothesis index
+   * @param[in] stream Index of the random stream, to draw independent sequences for the same hypothesis
+   */
+  std::mt19937 generator(std::size_t hypothesis, std::uint32_t stream = 0) const
+  {
+    std::seed_seq seq{seed, stream, static_cast<std::uint32_t>(hypothesis), static_cast<std::uint32_t>(std::uint64_t(hypothesis) >> 32)};
+    return std::mt19937(seq);
+  }
+
+  /// seed of the hypotheses generators
+  std::uint32_t seed;
+  /// number of hypotheses generated and scored at once (must not depend on the number of threads)
+  std::size_t batchSize;
+};
+
 } // namespace robustEstimation
 } // namespace aliceVision
@@ -6,6 +6,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/config.hpp>
@@ -18,65 +19,54 @@ namespace sfm {
 using namespace aliceVision::camera;
 using namespace aliceVision::geometry;
 
-/// Create the appropriate cost functor according the provided input camera intrinsic model
+/// Create the appropriate cost function according the provided input camera intrinsic model
+/// @note the cost functions use analytic jacobians, see ResidualErrorFunctor.hpp for the reference functors
 ceres::CostFunction* createCostFunctionFromIntrinsics(IntrinsicBase* intrinsic, const Vec2& observation)
 {
   switch(intrinsic->getType())
   {
     case PINHOLE_CAMERA:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_Pinhole, 2, 3, 6, 3>(
-        new ResidualErrorFunctor_Pinhole(observation.data()));
+      return new ResidualErrorCostFunction_Pinhole(observation.data());
     break;
     case PINHOLE_CAMERA_RADIAL1:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeRadialK1, 2, 4, 6, 3>(
-        new ResidualErrorFunctor_PinholeRadialK1(observation.data()));
+      return new ResidualErrorCostFunction_PinholeRadialK1(observation.data());
     break;
     case PINHOLE_CAMERA_RADIAL3:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeRadialK3, 2, 6, 6, 3>(
-        new ResidualErrorFunctor_PinholeRadialK3(observation.data()));
+      return new ResidualErrorCostFunction_PinholeRadialK3(observation.data());
     break;
     case PINHOLE_CAMERA_BROWN:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeBrownT2, 2, 8, 6, 3>(
-        new ResidualErrorFunctor_PinholeBrownT2(observation.data()));
+      return new ResidualErrorCostFunction_PinholeBrownT2(observation.data());
     break;
     case PINHOLE_CAMERA_FISHEYE:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye, 2, 7, 6, 3>(
-        new ResidualErrorFunctor_PinholeFisheye(observation.data()));
+      return new ResidualErrorCostFunction_PinholeFisheye(observation.data());
     case PINHOLE_CAMERA_FISHEYE1:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye1, 2, 4, 6, 3>(
-        new ResidualErrorFunctor_PinholeFisheye1(observation.data()));
+      return new ResidualErrorCostFunction_PinholeFisheye1(observation.data());
     default:
       throw std::logic_error("Unrecognized intrinsic type in BA.");
   }
 }
 
-/// Create the appropriate cost functor according the provided input rig camera intrinsic model
+/// Create the appropriate cost function according the provided input rig camera intrinsic model
 ceres::CostFunction* createRigCostFunctionFromIntrinsics(IntrinsicBase* intrinsic, const Vec2& observation)
 {
   switch(intrinsic->getType())
   {
     case PINHOLE_CAMERA:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_Pinhole, 2, 3, 6, 6, 3>(
-        new ResidualErrorFunctor_Pinhole(observation.data()));
+      return new RigResidualErrorCostFunction_Pinhole(observation.data());
     break;
     case PINHOLE_CAMERA_RADIAL1:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeRadialK1, 2, 4, 6, 6, 3>(
-        new ResidualErrorFunctor_PinholeRadialK1(observation.data()));
+      return new RigResidualErrorCostFunction_PinholeRadialK1(observation.data());
     break;
     case PINHOLE_CAMERA_RADIAL3:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeRadialK3, 2, 6, 6, 6, 3>(
-        new ResidualErrorFunctor_PinholeRadialK3(observation.data()));
+      return new RigResidualErrorCostFunction_PinholeRadialK3(observation.data());
     break;
     case PINHOLE_CAMERA_BROWN:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeBrownT2, 2, 8, 6, 6, 3>(
-        new ResidualErrorFunctor_PinholeBrownT2(observation.data()));
+      return new RigResidualErrorCostFunction_PinholeBrownT2(observation.data());
     break;
     case PINHOLE_CAMERA_FISHEYE:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye, 2, 7, 6, 6, 3>(
-        new ResidualErrorFunctor_PinholeFisheye(observation.data()));
+      return new RigResidualErrorCostFunction_PinholeFisheye(observation.data());
     case PINHOLE_CAMERA_FISHEYE1:
-      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye1, 2, 4, 6, 6, 3>(
-        new ResidualErrorFunctor_PinholeFisheye1(observation.data()));
+      return new RigResidualErrorCostFunction_PinholeFisheye1(observation.data());
     default:
       throw std::logic_error("Unrecognized intrinsic type in BA.");
   }
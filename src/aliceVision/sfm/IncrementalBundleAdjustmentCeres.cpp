@@ -0,0 +1,599 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/IncrementalBundleAdjustmentCeres.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <ceres/rotation.h>
+
+#include <algorithm>
+#include <set>
+
+namespace aliceVision {
+namespace sfm {
+
+using ParameterBlockState = IncrementalBundleAdjustmentCeres::ParameterBlockState;
+
+namespace {
+
+/// Linear solver ordering groups, the landmarks are eliminated first
+enum EOrderingGroup
+{
+  ORDERING_LANDMARKS = 0,
+  ORDERING_POSES = 1,
+  ORDERING_INTRINSICS = 2
+};
+
+/**
+ * @brief Get the angle axis and translation parameters of a pose.
+ */
+void getPoseParams(const geometry::Pose3& pose, std::vector<double>& params)
+{
+  const Mat3& R = pose.rotation();
+  const Vec3& t = pose.translation();
+
+  params.resize(6); // angleAxis + translation
+  ceres::RotationMatrixToAngleAxis((const double*)R.data(), &params[0]);
+  params[3] = t(0);
+  params[4] = t(1);
+  params[5] = t(2);
+}
+
+/**
+ * @brief Get the pose from its angle axis and translation parameters.
+ */
+geometry::Pose3 getPoseFromParams(const std::vector<double>& params)
+{
+  Mat3 R;
+  ceres::AngleAxisToRotationMatrix(&params[0], R.data());
+  const Vec3 t(params[3], params[4], params[5]);
+  return geometry::poseFromRT(R, t);
+}
+
+/**
+ * @brief Get the parametrization of a pose parameter block.
+ * @see BundleAdjustmentCeres addPose
+ */
+ParameterBlockState getPoseState(BA_Refine refineOptions, bool locked)
+{
+  ParameterBlockState state;
+
+  if(locked || (!(refineOptions & BA_REFINE_TRANSLATION) && !(refineOptions & BA_REFINE_ROTATION)))
+  {
+    state.constant = true;
+    return state;
+  }
+
+  // Don't refine rotations (if BA_REFINE_ROTATION is not specified)
+  if(!(refineOptions & BA_REFINE_ROTATION))
+    state.constantParams.insert(state.constantParams.end(), {0, 1, 2});
+
+  // Don't refine translations (if BA_REFINE_TRANSLATION is not specified)
+  if(!(refineOptions & BA_REFINE_TRANSLATION))
+    state.constantParams.insert(state.constantParams.end(), {3, 4, 5});
+
+  return state;
+}
+
+/**
+ * @brief Get the parametrization of an intrinsic parameter block.
+ * @see BundleAdjustmentCeres::createProblem
+ */
+ParameterBlockState getIntrinsicState(BA_Refine refineOptions, const camera::IntrinsicBase& intrinsic, std::size_t nbParams, std::size_t usage)
+{
+  ParameterBlockState state;
+
+  const bool refineIntrinsicsOpticalCenter = (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) || (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA);
+  const bool refineIntrinsics = (refineOptions & BA_REFINE_INTRINSICS_FOCAL) ||
+                                (refineOptions & BA_REFINE_INTRINSICS_DISTORTION) ||
+                                refineIntrinsicsOpticalCenter;
+
+  if(!refineIntrinsics || intrinsic.isLocked())
+  {
+    state.constant = true;
+    return state;
+  }
+
+  // Focal length
+  if(refineOptions & BA_REFINE_INTRINSICS_FOCAL)
+  {
+    if(intrinsic.initialFocalLengthPix() > 0)
+    {
+      // If we have an initial guess, we only authorize a margin around this value.
+      const unsigned int maxFocalErr = 0.2 * std::max(intrinsic.w(), intrinsic.h());
+      state.lowerBounds.emplace_back(0, (double)intrinsic.initialFocalLengthPix() - maxFocalErr);
+      state.upperBounds.emplace_back(0, (double)intrinsic.initialFocalLengthPix() + maxFocalErr);
+    }
+    else
+    {
+      // We assume that we use a converging lens, so the focal length should be positive.
+      state.lowerBounds.emplace_back(0, 0.0);
+    }
+  }
+  else
+  {
+    state.constantParams.push_back(0);
+  }
+
+  const std::size_t minImagesForOpticalCenter = 3;
+
+  // Optical center
+  if((refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) ||
+     ((refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA) && usage > minImagesForOpticalCenter))
+  {
+    // Refine optical center within 10% of the image size.
+    const double opticalCenterMinPercent = 0.45;
+    const double opticalCenterMaxPercent = 0.55;
+
+    state.lowerBounds.emplace_back(1, opticalCenterMinPercent * intrinsic.w());
+    state.upperBounds.emplace_back(1, opticalCenterMaxPercent * intrinsic.w());
+    state.lowerBounds.emplace_back(2, opticalCenterMinPercent * intrinsic.h());
+    state.upperBounds.emplace_back(2, opticalCenterMaxPercent * intrinsic.h());
+  }
+  else
+  {
+    state.constantParams.insert(state.constantParams.end(), {1, 2});
+  }
+
+  // Lens distortion
+  if(!(refineOptions & BA_REFINE_INTRINSICS_DISTORTION))
+  {
+    for(std::size_t i = 3; i < nbParams; ++i)
+      state.constantParams.push_back(i);
+  }
+
+  return state;
+}
+
+} // namespace
+
+IncrementalBundleAdjustmentCeres::IncrementalBundleAdjustmentCeres(const BundleAdjustmentCeres::BA_options& options)
+  : _options(options)
+  // Set a LossFunction to be less penalized by false measurements
+  , _lossFunction(new ceres::HuberLoss(Square(4.0)))
+{}
+
+void IncrementalBundleAdjustmentCeres::clear()
+{
+  _problem.reset();
+  _ordering.reset();
+  _poses.clear();
+  _subPoses.clear();
+  _intrinsics.clear();
+  _landmarks.clear();
+}
+
+void IncrementalBundleAdjustmentCeres::addParameterBlock(ParameterBlock& block, int group)
+{
+  double* parameterBlock = &block.params[0];
+  const int nbParams = block.params.size();
+
+  _problem->AddParameterBlock(parameterBlock, nbParams);
+  _ordering->AddElementToGroup(parameterBlock, group);
+
+  if(block.state.constant)
+  {
+    _problem->SetParameterBlockConstant(parameterBlock);
+  }
+  else
+  {
+    if(!block.state.constantParams.empty())
+      _problem->SetParameterization(parameterBlock, new ceres::SubsetParameterization(nbParams, block.state.constantParams));
+
+    for(const auto& bound : block.state.lowerBounds)
+      _problem->SetParameterLowerBound(parameterBlock, bound.first, bound.second);
+    for(const auto& bound : block.state.upperBounds)
+      _problem->SetParameterUpperBound(parameterBlock, bound.first, bound.second);
+  }
+  block.inProblem = true;
+}
+
+void IncrementalBundleAdjustmentCeres::removeParameterBlock(ParameterBlock& block)
+{
+  if(!block.inProblem)
+    return;
+
+  double* parameterBlock = &block.params[0];
+  _problem->RemoveParameterBlock(parameterBlock);
+  _ordering->Remove(parameterBlock);
+  block.inProblem = false;
+}
+
+void IncrementalBundleAdjustmentCeres::updateProblem(const sfmData::SfMData& sfmData, BA_Refine refineOptions)
+{
+  // Ensure we are not using incompatible options:
+  //  - BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS and BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA cannot be used at the same time
+  assert(!((refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) && (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA)));
+
+  if(!_problem)
+  {
+    ceres::Problem::Options problemOptions;
+    // the loss function is shared by all the residual blocks
+    problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+    // residual and parameter blocks are removed at each update
+    problemOptions.enable_fast_removal = true;
+
+    _problem.reset(new ceres::Problem(problemOptions));
+    _ordering.reset(new ceres::ParameterBlockOrdering);
+  }
+
+  //----------
+  // Update the poses, rig sub-poses and intrinsics parameters.
+  // The parameter blocks removed from the scene or with a new parametrization are invalidated,
+  // their residual blocks are removed before the parameter blocks.
+  //----------
+
+  std::set<IndexT> invalidPoses;
+  std::set<std::pair<IndexT, IndexT>> invalidSubPoses;
+  std::set<IndexT> invalidIntrinsics;
+
+  for(auto& poseIt : _poses)
+  {
+    if(sfmData.getPoses().count(poseIt.first) == 0)
+      invalidPoses.insert(poseIt.first);
+  }
+
+  for(const auto& poseIt : sfmData.getPoses())
+  {
+    ParameterBlock& block = _poses[poseIt.first];
+    getPoseParams(poseIt.second.getTransform(), block.params);
+
+    const ParameterBlockState state = getPoseState(refineOptions, poseIt.second.isLocked());
+    if(block.inProblem && block.state != state)
+      invalidPoses.insert(poseIt.first);
+    block.state = state;
+  }
+
+  for(auto& rigIt : _subPoses)
+  {
+    for(auto& subPoseIt : rigIt.second)
+    {
+      const auto rigInSceneIt = sfmData.getRigs().find(rigIt.first);
+      if(rigInSceneIt == sfmData.getRigs().end() ||
+         subPoseIt.first >= rigInSceneIt->second.getNbSubPoses() ||
+         rigInSceneIt->second.getSubPose(subPoseIt.first).status == sfmData::ERigSubPoseStatus::UNINITIALIZED)
+        invalidSubPoses.emplace(rigIt.first, subPoseIt.first);
+    }
+  }
+
+  for(const auto& rigIt : sfmData.getRigs())
+  {
+    const sfmData::Rig& rig = rigIt.second;
+
+    for(std::size_t subPoseId = 0; subPoseId < rig.getNbSubPoses(); ++subPoseId)
+    {
+      const sfmData::RigSubPose& rigSubPose = rig.getSubPose(subPoseId);
+
+      if(rigSubPose.status == sfmData::ERigSubPoseStatus::UNINITIALIZED)
+        continue;
+
+      ParameterBlock& block = _subPoses[rigIt.first][subPoseId];
+      getPoseParams(rigSubPose.pose, block.params);
+
+      const ParameterBlockState state = getPoseState(refineOptions, rigSubPose.status == sfmData::ERigSubPoseStatus::CONSTANT);
+      if(block.inProblem && block.state != state)
+        invalidSubPoses.emplace(rigIt.first, subPoseId);
+      block.state = state;
+    }
+  }
+
+  // only the intrinsics used by a reconstructed view are in the problem
+  HashMap<IndexT, std::size_t> intrinsicsUsage;
+  for(const auto& viewIt : sfmData.getViews())
+  {
+    if(sfmData.isPoseAndIntrinsicDefined(viewIt.second.get()))
+      ++intrinsicsUsage[viewIt.second->getIntrinsicId()];
+  }
+
+  for(auto& intrinsicIt : _intrinsics)
+  {
+    if(intrinsicsUsage.count(intrinsicIt.first) == 0)
+      invalidIntrinsics.insert(intrinsicIt.first);
+  }
+
+  for(const auto& usageIt : intrinsicsUsage)
+  {
+    const camera::IntrinsicBase& intrinsic = *sfmData.getIntrinsics().at(usageIt.first);
+    assert(isValid(intrinsic.getType()));
+
+    ParameterBlock& block = _intrinsics[usageIt.first];
+    const std::vector<double> params = intrinsic.getParams();
+
+    if(!block.inProblem)
+      block.params = params;
+    else if(block.params.size() == params.size())
+      std::copy(params.begin(), params.end(), block.params.begin());
+    else
+      invalidIntrinsics.insert(usageIt.first); // another camera model, the parameters are reset once the block is removed
+
+    const ParameterBlockState state = getIntrinsicState(refineOptions, intrinsic, params.size(), usageIt.second);
+    if(block.inProblem && block.state != state)
+      invalidIntrinsics.insert(usageIt.first);
+    block.state = state;
+  }
+
+  //----------
+  // Remove the residual blocks of the removed observations, of the modified observations
+  // and of the observations depending on an invalidated parameter block.
+  // Remove the landmarks removed from the scene.
+  //----------
+
+  std::size_t nbRemovedResiduals = 0;
+
+  for(auto landmarkIt = _landmarks.begin(); landmarkIt != _landmarks.end();)
+  {
+    LandmarkBlock& landmarkBlock = landmarkIt->second;
+    const auto landmarkInSceneIt = sfmData.structure.find(landmarkIt->first);
+
+    if(landmarkInSceneIt == sfmData.structure.end())
+    {
+      // the parameter block removal removes its residual blocks
+      nbRemovedResiduals += landmarkBlock.observations.size();
+      _problem->RemoveParameterBlock(landmarkBlock.X.data());
+      _ordering->Remove(landmarkBlock.X.data());
+      landmarkIt = _landmarks.erase(landmarkIt);
+      continue;
+    }
+
+    const sfmData::Observations& observations = landmarkInSceneIt->second.observations;
+
+    for(auto observationIt = landmarkBlock.observations.begin(); observationIt != landmarkBlock.observations.end();)
+    {
+      const IndexT viewId = observationIt->first;
+      const ObservationBlock& observationBlock = observationIt->second;
+      const auto observationInSceneIt = observations.find(viewId);
+
+      bool valid = (observationInSceneIt != observations.end()) &&
+                   (observationInSceneIt->second.x == observationBlock.x) &&
+                   (invalidPoses.count(observationBlock.poseId) == 0) &&
+                   (invalidIntrinsics.count(observationBlock.intrinsicId) == 0);
+
+      if(valid)
+      {
+        const sfmData::View& view = *sfmData.getViews().at(viewId);
+        valid = (view.getPoseId() == observationBlock.poseId) &&
+                (view.getIntrinsicId() == observationBlock.intrinsicId) &&
+                (!view.isPartOfRig() || invalidSubPoses.count(std::make_pair(view.getRigId(), view.getSubPoseId())) == 0);
+      }
+
+      if(valid)
+      {
+        ++observationIt;
+        continue;
+      }
+
+      _problem->RemoveResidualBlock(observationBlock.residualBlock);
+      ++nbRemovedResiduals;
+      observationIt = landmarkBlock.observations.erase(observationIt);
+    }
+    ++landmarkIt;
+  }
+
+  //----------
+  // Remove the invalidated poses, rig sub-poses and intrinsics, and add the missing ones.
+  //----------
+
+  for(const IndexT poseId : invalidPoses)
+  {
+    removeParameterBlock(_poses.at(poseId));
+    if(sfmData.getPoses().count(poseId) == 0)
+      _poses.erase(poseId);
+  }
+
+  for(const auto& subPoseId : invalidSubPoses)
+  {
+    auto& rigSubPoses = _subPoses.at(subPoseId.first);
+    ParameterBlock& block = rigSubPoses.at(subPoseId.second);
+    removeParameterBlock(block);
+
+    const auto rigInSceneIt = sfmData.getRigs().find(subPoseId.first);
+    if(rigInSceneIt == sfmData.getRigs().end() ||
+       subPoseId.second >= rigInSceneIt->second.getNbSubPoses() ||
+       rigInSceneIt->second.getSubPose(subPoseId.second).status == sfmData::ERigSubPoseStatus::UNINITIALIZED)
+    {
+      rigSubPoses.erase(subPoseId.second);
+      if(rigSubPoses.empty())
+        _subPoses.erase(subPoseId.first);
+    }
+  }
+
+  for(const IndexT intrinsicId : invalidIntrinsics)
+  {
+    ParameterBlock& block = _intrinsics.at(intrinsicId);
+    removeParameterBlock(block);
+    if(intrinsicsUsage.count(intrinsicId) == 0)
+      _intrinsics.erase(intrinsicId);
+    else
+      block.params = sfmData.getIntrinsics().at(intrinsicId)->getParams();
+  }
+
+  for(auto& poseIt : _poses)
+  {
+    if(!poseIt.second.inProblem)
+      addParameterBlock(poseIt.second, ORDERING_POSES);
+  }
+
+  for(auto& rigIt : _subPoses)
+  {
+    for(auto& subPoseIt : rigIt.second)
+    {
+      if(!subPoseIt.second.inProblem)
+        addParameterBlock(subPoseIt.second, ORDERING_POSES);
+    }
+  }
+
+  for(auto& intrinsicIt : _intrinsics)
+  {
+    if(!intrinsicIt.second.inProblem)
+      addParameterBlock(intrinsicIt.second, ORDERING_INTRINSICS);
+  }
+
+  //----------
+  // Add the new landmarks and the residual blocks of the new observations.
+  //----------
+
+  std::size_t nbAddedResiduals = 0;
+
+  for(const auto& landmarkIt : sfmData.structure)
+  {
+    const sfmData::Landmark& landmark = landmarkIt.second;
+    const bool newLandmark = (_landmarks.count(landmarkIt.first) == 0);
+    LandmarkBlock& landmarkBlock = _landmarks[landmarkIt.first];
+    landmarkBlock.X = landmark.X;
+
+    double* landmarkParams = landmarkBlock.X.data();
+
+    if(newLandmark)
+    {
+      _problem->AddParameterBlock(landmarkParams, 3);
+      _ordering->AddElementToGroup(landmarkParams, ORDERING_LANDMARKS);
+    }
+
+    if(refineOptions & BA_REFINE_STRUCTURE)
+      _problem->SetParameterBlockVariable(landmarkParams);
+    else
+      _problem->SetParameterBlockConstant(landmarkParams);
+
+    for(const auto& observationIt : landmark.observations)
+    {
+      const IndexT viewId = observationIt.first;
+
+      if(landmarkBlock.observations.count(viewId) != 0)
+        continue;
+
+      const sfmData::View& view = *sfmData.getViews().at(viewId);
+
+      const auto poseIt = _poses.find(view.getPoseId());
+      const auto intrinsicIt = _intrinsics.find(view.getIntrinsicId());
+
+      if(poseIt == _poses.end() || intrinsicIt == _intrinsics.end())
+        continue;
+
+      camera::IntrinsicBase* intrinsic = sfmData.getIntrinsics().at(view.getIntrinsicId()).get();
+
+      ObservationBlock observationBlock;
+      observationBlock.x = observationIt.second.x;
+      observationBlock.poseId = view.getPoseId();
+      observationBlock.intrinsicId = view.getIntrinsicId();
+
+      if(view.isPartOfRig())
+      {
+        const auto rigIt = _subPoses.find(view.getRigId());
+        if(rigIt == _subPoses.end() || rigIt->second.count(view.getSubPoseId()) == 0)
+          continue;
+
+        observationBlock.residualBlock = _problem->AddResidualBlock(
+          createRigCostFunctionFromIntrinsics(intrinsic, observationBlock.x),
+          _lossFunction.get(),
+          &intrinsicIt->second.params[0],
+          &poseIt->second.params[0],
+          &rigIt->second.at(view.getSubPoseId()).params[0], // subpose of the cameras rig
+          landmarkParams);
+      }
+      else
+      {
+        observationBlock.residualBlock = _problem->AddResidualBlock(
+          createCostFunctionFromIntrinsics(intrinsic, observationBlock.x),
+          _lossFunction.get(),
+          &intrinsicIt->second.params[0],
+          &poseIt->second.params[0],
+          landmarkParams);
+      }
+
+      landmarkBlock.observations.emplace(viewId, observationBlock);
+      ++nbAddedResiduals;
+    }
+  }
+
+  ALICEVISION_LOG_DEBUG("IncrementalBundleAdjustmentCeres: problem updated" << std::endl
+                        << "\t- # removed residual blocks: " << nbRemovedResiduals << std::endl
+                        << "\t- # added residual blocks: " << nbAddedResiduals << std::endl
+                        << "\t- # residual blocks: " << _problem->NumResidualBlocks());
+}
+
+bool IncrementalBundleAdjustmentCeres::Adjust(sfmData::SfMData& sfmData, BA_Refine refineOptions)
+{
+  updateProblem(sfmData, refineOptions);
+
+  // Configure a BA engine and run it
+  ceres::Solver::Options options;
+  options.preconditioner_type = _options._preconditioner_type;
+  options.linear_solver_type = _options._linear_solver_type;
+  options.sparse_linear_algebra_library_type = _options._sparse_linear_algebra_library_type;
+  options.minimizer_progress_to_stdout = _options._bVerbose;
+  options.logging_type = ceres::SILENT;
+  options.num_threads = _options._nbThreads;
+  options.num_linear_solver_threads = _options._nbThreads;
+  // the solver removes the constant blocks from its ordering, give it a copy of the persistent one
+  options.linear_solver_ordering.reset(new ceres::ParameterBlockOrdering(*_ordering));
+
+  // Solve BA
+  ceres::Solver::Summary summary;
+  ceres::Solve(options, _problem.get(), &summary);
+  if(_options._bCeres_Summary)
+    ALICEVISION_LOG_DEBUG(summary.FullReport());
+
+  // If no error, get back refined parameters
+  if(!summary.IsSolutionUsable())
+  {
+    ALICEVISION_LOG_WARNING("Bundle Adjustment failed.");
+    return false;
+  }
+
+  // Solution is usable
+  if(_options._bVerbose)
+  {
+    // Display statistics about the minimization
+    ALICEVISION_LOG_DEBUG(
+      "Bundle Adjustment statistics (approximated RMSE):\n"
+      "\t- # views: " << sfmData.views.size() << "\n"
+      "\t- # poses: " << sfmData.getPoses().size() << "\n"
+      "\t- # intrinsics: " << sfmData.intrinsics.size() << "\n"
+      "\t- # tracks: " << sfmData.structure.size() << "\n"
+      "\t- # residuals: " << summary.num_residuals << "\n"
+      "\t- initial RMSE: " << std::sqrt( summary.initial_cost / summary.num_residuals) << "\n"
+      "\t- final RMSE: " << std::sqrt( summary.final_cost / summary.num_residuals) << "\n"
+      "\t- time (s): " << summary.total_time_in_seconds);
+  }
+
+  // Update camera poses with refined data
+  if((refineOptions & BA_REFINE_ROTATION) || (refineOptions & BA_REFINE_TRANSLATION))
+  {
+    for(auto& poseIt : sfmData.getPoses())
+      poseIt.second.setTransform(getPoseFromParams(_poses.at(poseIt.first).params));
+
+    for(const auto& rigIt : _subPoses)
+    {
+      sfmData::Rig& rig = sfmData.getRigs().at(rigIt.first);
+
+      for(const auto& subPoseIt : rigIt.second)
+        rig.getSubPose(subPoseIt.first).pose = getPoseFromParams(subPoseIt.second.params);
+    }
+  }
+
+  // Update camera intrinsics with refined data
+  const bool refineIntrinsicsOpticalCenter = (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) || (refineOptions & BA_REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA);
+  const bool refineIntrinsics = (refineOptions & BA_REFINE_INTRINSICS_FOCAL) ||
+                                (refineOptions & BA_REFINE_INTRINSICS_DISTORTION) ||
+                                refineIntrinsicsOpticalCenter;
+  if(refineIntrinsics)
+  {
+    for(const auto& intrinsicIt : _intrinsics)
+      sfmData.intrinsics.at(intrinsicIt.first)->updateFromParams(intrinsicIt.second.params);
+  }
+
+  // Update landmarks with refined data
+  if(refineOptions & BA_REFINE_STRUCTURE)
+  {
+    for(auto& landmarkIt : sfmData.structure)
+      landmarkIt.second.X = _landmarks.at(landmarkIt.first).X;
+  }
+  return true;
+}
+
+} // namespace sfm
+} // namespace aliceVision
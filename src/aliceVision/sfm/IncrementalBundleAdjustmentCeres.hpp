@@ -0,0 +1,154 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/sfm/BundleAdjustment.hpp>
+#include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+
+#include <ceres/ceres.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+
+namespace sfmData {
+class SfMData;
+} // namespace sfmData
+
+namespace sfm {
+
+/**
+ * @brief Bundle adjustment keeping its ceres problem between the calls to Adjust.
+ *
+ * The sequential SfM solves the same scene again and again, with a few new views and landmarks
+ * and a few rejected observations at each iteration. Instead of building a new ceres problem
+ * at each call, the problem is updated from the differences with the previous call:
+ * - the residual blocks of the new observations are added, the ones of the removed observations are removed
+ * - the parameter blocks of the new poses, intrinsics and landmarks are added, the removed ones are removed
+ * - the parameter blocks whose parametrization changes (refine options, lock, ...) are rebuilt
+ * The parameter values are always reset from the scene before solving, so the scene can be
+ * modified between two calls (resection, triangulation, outliers rejection).
+ *
+ * @note The scene must not be adjusted by another bundle adjustment object between two calls,
+ *       otherwise the parameters are only reset from the scene values.
+ */
+class IncrementalBundleAdjustmentCeres : public BundleAdjustment
+{
+public:
+  IncrementalBundleAdjustmentCeres(const BundleAdjustmentCeres::BA_options& options = BundleAdjustmentCeres::BA_options());
+
+  /**
+   * @brief Set the solver options used by the next calls to Adjust.
+   * @param[in] options The bundle adjustment options
+   */
+  void setOptions(const BundleAdjustmentCeres::BA_options& options)
+  {
+    _options = options;
+  }
+
+  /**
+   * @brief Remove all the parameter and residual blocks from the problem.
+   */
+  void clear();
+
+  /**
+   * @see BundleAdjustment::Adjust
+   */
+  bool Adjust(sfmData::SfMData& sfmData, BA_Refine refineOptions = BA_REFINE_ALL);
+
+  /// Parametrization of a parameter block, the block is rebuilt if it changes
+  struct ParameterBlockState
+  {
+    bool constant = false;
+    std::vector<int> constantParams;
+    std::vector<std::pair<int, double>> lowerBounds;
+    std::vector<std::pair<int, double>> upperBounds;
+
+    bool operator==(const ParameterBlockState& other) const
+    {
+      return constant == other.constant &&
+             constantParams == other.constantParams &&
+             lowerBounds == other.lowerBounds &&
+             upperBounds == other.upperBounds;
+    }
+
+    bool operator!=(const ParameterBlockState& other) const
+    {
+      return !(*this == other);
+    }
+  };
+
+private:
+
+  /// Pose, rig sub-pose or intrinsic parameter block
+  struct ParameterBlock
+  {
+    std::vector<double> params;
+    ParameterBlockState state;
+    /// the block is in the ceres problem
+    bool inProblem = false;
+  };
+
+  /// Residual block of a landmark observation
+  struct ObservationBlock
+  {
+    ceres::ResidualBlockId residualBlock;
+    Vec2 x;
+    IndexT poseId;
+    IndexT intrinsicId;
+  };
+
+  /// Landmark parameter block with the residual blocks of its observations
+  struct LandmarkBlock
+  {
+    Vec3 X;
+    /// residual blocks per view id
+    HashMap<IndexT, ObservationBlock> observations;
+  };
+
+  /**
+   * @brief Update the ceres problem from the differences between the scene and the previous call.
+   * @param[in] sfmData The scene to adjust
+   * @param[in] refineOptions The parameters to refine
+   */
+  void updateProblem(const sfmData::SfMData& sfmData, BA_Refine refineOptions);
+
+  /**
+   * @brief Add a parameter block with its parametrization in the ceres problem.
+   * @param[in,out] block The parameter block to add
+   * @param[in] group The group of the block in the linear solver ordering
+   */
+  void addParameterBlock(ParameterBlock& block, int group);
+
+  /**
+   * @brief Remove a parameter block from the ceres problem.
+   * @note All the residual blocks depending on the parameter block have to be removed before.
+   * @param[in,out] block The parameter block to remove
+   */
+  void removeParameterBlock(ParameterBlock& block);
+
+  BundleAdjustmentCeres::BA_options _options;
+
+  /// ceres problem kept between the calls
+  std::unique_ptr<ceres::Problem> _problem;
+  /// loss function shared by all the residual blocks, not owned by the problem
+  std::unique_ptr<ceres::LossFunction> _lossFunction;
+  /// linear solver ordering kept in sync with the problem: landmarks, poses, intrinsics
+  std::shared_ptr<ceres::ParameterBlockOrdering> _ordering;
+
+  HashMap<IndexT, ParameterBlock> _poses;
+  HashMap<IndexT, HashMap<IndexT, ParameterBlock>> _subPoses;
+  HashMap<IndexT, ParameterBlock> _intrinsics;
+  HashMap<IndexT, LandmarkBlock> _landmarks;
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -9,6 +9,8 @@
 #include <aliceVision/types.hpp>
 #include <aliceVision/track/Track.hpp>
 
+#include <lemon/list_graph.h>
+
 namespace aliceVision {
 
 namespace sfmData {
@@ -0,0 +1,456 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <ceres/sized_cost_function.h>
+
+#include <cmath>
+#include <limits>
+
+// Define ceres cost functions with analytic jacobians for each AliceVision camera model.
+// They compute the same residuals as the functors of ResidualErrorFunctor.hpp,
+// without the cost of the automatic differentiation.
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Distortion models of the analytic cost functions.
+ *
+ * Each model provides:
+ * - NB_PARAMS: the number of distortion parameters, stored after [focal, principal point x, principal point y]
+ *   in the intrinsic data block,
+ * - distort(disto, x_u, y_u, x_d, J_u, J_disto): the distorted point x_d of the undistorted point (x_u, y_u),
+ *   its jacobian J_u with respect to (x_u, y_u) and its jacobian J_disto with respect to the distortion parameters.
+ */
+
+struct AnalyticDistortion_None
+{
+  enum { NB_PARAMS = 0 };
+
+  static void distort(const double* const /*disto*/, double x_u, double y_u,
+                      Vec2& x_d, Eigen::Matrix2d& J_u, Eigen::Matrix<double, 2, 1>& /*J_disto*/)
+  {
+    x_d << x_u, y_u;
+    J_u.setIdentity();
+  }
+};
+
+struct AnalyticDistortion_RadialK1
+{
+  enum { NB_PARAMS = 1 };
+
+  static void distort(const double* const disto, double x_u, double y_u,
+                      Vec2& x_d, Eigen::Matrix2d& J_u, Eigen::Matrix<double, 2, NB_PARAMS>& J_disto)
+  {
+    const double k1 = disto[0];
+
+    const double r2 = x_u*x_u + y_u*y_u;
+    const double r_coeff = 1.0 + k1*r2;
+    const double dr_coeff_dr2 = k1;
+
+    x_d << x_u * r_coeff, y_u * r_coeff;
+
+    J_u << r_coeff + 2.0 * dr_coeff_dr2 * x_u*x_u,           2.0 * dr_coeff_dr2 * x_u*y_u,
+                     2.0 * dr_coeff_dr2 * x_u*y_u, r_coeff + 2.0 * dr_coeff_dr2 * y_u*y_u;
+
+    J_disto << x_u * r2,
+               y_u * r2;
+  }
+};
+
+struct AnalyticDistortion_RadialK3
+{
+  enum { NB_PARAMS = 3 };
+
+  static void distort(const double* const disto, double x_u, double y_u,
+                      Vec2& x_d, Eigen::Matrix2d& J_u, Eigen::Matrix<double, 2, NB_PARAMS>& J_disto)
+  {
+    const double k1 = disto[0];
+    const double k2 = disto[1];
+    const double k3 = disto[2];
+
+    const double r2 = x_u*x_u + y_u*y_u;
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double r_coeff = 1.0 + k1*r2 + k2*r4 + k3*r6;
+    const double dr_coeff_dr2 = k1 + 2.0*k2*r2 + 3.0*k3*r4;
+
+    x_d << x_u * r_coeff, y_u * r_coeff;
+
+    J_u << r_coeff + 2.0 * dr_coeff_dr2 * x_u*x_u,           2.0 * dr_coeff_dr2 * x_u*y_u,
+                     2.0 * dr_coeff_dr2 * x_u*y_u, r_coeff + 2.0 * dr_coeff_dr2 * y_u*y_u;
+
+    J_disto << x_u * r2, x_u * r4, x_u * r6,
+               y_u * r2, y_u * r4, y_u * r6;
+  }
+};
+
+struct AnalyticDistortion_BrownT2
+{
+  enum { NB_PARAMS = 5 };
+
+  static void distort(const double* const disto, double x_u, double y_u,
+                      Vec2& x_d, Eigen::Matrix2d& J_u, Eigen::Matrix<double, 2, NB_PARAMS>& J_disto)
+  {
+    const double k1 = disto[0];
+    const double k2 = disto[1];
+    const double k3 = disto[2];
+    const double t1 = disto[3];
+    const double t2 = disto[4];
+
+    const double r2 = x_u*x_u + y_u*y_u;
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double r_coeff = 1.0 + k1*r2 + k2*r4 + k3*r6;
+    const double dr_coeff_dr2 = k1 + 2.0*k2*r2 + 3.0*k3*r4;
+    const double t_x = t2 * (r2 + 2.0 * x_u*x_u) + 2.0 * t1 * x_u * y_u;
+    const double t_y = t1 * (r2 + 2.0 * y_u*y_u) + 2.0 * t2 * x_u * y_u;
+
+    x_d << x_u * r_coeff + t_x, y_u * r_coeff + t_y;
+
+    J_u << r_coeff + 2.0 * dr_coeff_dr2 * x_u*x_u + 6.0 * t2 * x_u + 2.0 * t1 * y_u,
+                     2.0 * dr_coeff_dr2 * x_u*y_u + 2.0 * t2 * y_u + 2.0 * t1 * x_u,
+                     2.0 * dr_coeff_dr2 * x_u*y_u + 2.0 * t1 * x_u + 2.0 * t2 * y_u,
+           r_coeff + 2.0 * dr_coeff_dr2 * y_u*y_u + 6.0 * t1 * y_u + 2.0 * t2 * x_u;
+
+    J_disto << x_u * r2, x_u * r4, x_u * r6, 2.0 * x_u * y_u, r2 + 2.0 * x_u*x_u,
+               y_u * r2, y_u * r4, y_u * r6, r2 + 2.0 * y_u*y_u, 2.0 * x_u * y_u;
+  }
+};
+
+struct AnalyticDistortion_Fisheye
+{
+  enum { NB_PARAMS = 4 };
+
+  static void distort(const double* const disto, double x_u, double y_u,
+                      Vec2& x_d, Eigen::Matrix2d& J_u, Eigen::Matrix<double, 2, NB_PARAMS>& J_disto)
+  {
+    const double k1 = disto[0];
+    const double k2 = disto[1];
+    const double k3 = disto[2];
+    const double k4 = disto[3];
+
+    const double r2 = x_u*x_u + y_u*y_u;
+    const double r = std::sqrt(r2);
+
+    if(!(r > 1e-8))
+    {
+      // same as ResidualErrorFunctor_PinholeFisheye: no distortion close to the center
+      x_d << x_u, y_u;
+      J_u.setIdentity();
+      J_disto.setZero();
+      return;
+    }
+
+    const double theta = std::atan(r);
+    const double theta2 = theta*theta, theta3 = theta2*theta, theta4 = theta2*theta2, theta5 = theta4*theta,
+    theta6 = theta3*theta3, theta7 = theta6*theta, theta8 = theta4*theta4, theta9 = theta8*theta;
+    const double theta_dist = theta + k1*theta3 + k2*theta5 + k3*theta7 + k4*theta9;
+    const double dtheta_dist_dtheta = 1.0 + 3.0*k1*theta2 + 5.0*k2*theta4 + 7.0*k3*theta6 + 9.0*k4*theta8;
+    const double dtheta_dr = 1.0 / (1.0 + r2);
+
+    const double inv_r = 1.0 / r;
+    const double cdist = theta_dist * inv_r;
+    // d(cdist)/dr divided by r, as dr/dx_u = x_u / r
+    const double dcdist_dr_r = (dtheta_dist_dtheta * dtheta_dr - cdist) * inv_r * inv_r;
+
+    x_d << x_u * cdist, y_u * cdist;
+
+    J_u << cdist + dcdist_dr_r * x_u*x_u,         dcdist_dr_r * x_u*y_u,
+                   dcdist_dr_r * x_u*y_u, cdist + dcdist_dr_r * y_u*y_u;
+
+    J_disto << x_u * theta3 * inv_r, x_u * theta5 * inv_r, x_u * theta7 * inv_r, x_u * theta9 * inv_r,
+               y_u * theta3 * inv_r, y_u * theta5 * inv_r, y_u * theta7 * inv_r, y_u * theta9 * inv_r;
+  }
+};
+
+struct AnalyticDistortion_Fisheye1
+{
+  enum { NB_PARAMS = 1 };
+
+  static void distort(const double* const disto, double x_u, double y_u,
+                      Vec2& x_d, Eigen::Matrix2d& J_u, Eigen::Matrix<double, 2, NB_PARAMS>& J_disto)
+  {
+    const double k1 = disto[0];
+
+    const double r2 = x_u*x_u + y_u*y_u;
+    const double r = std::sqrt(r2);
+    const double tan_half_k1 = std::tan(0.5 * k1);
+    const double s = 2.0 * r * tan_half_k1;
+    const double atan_s = std::atan(s);
+    const double datan_s_ds = 1.0 / (1.0 + s*s);
+    const double r_coeff = (atan_s / k1) / r;
+
+    // d(r_coeff)/dr divided by r, as dr/dx_u = x_u / r
+    const double dr_coeff_dr_r = (2.0 * tan_half_k1 * datan_s_ds / k1 - r_coeff) / r2;
+    const double dr_coeff_dk1 = ((1.0 + tan_half_k1*tan_half_k1) * datan_s_ds - r_coeff) / k1;
+
+    x_d << x_u * r_coeff, y_u * r_coeff;
+
+    J_u << r_coeff + dr_coeff_dr_r * x_u*x_u,           dr_coeff_dr_r * x_u*y_u,
+                     dr_coeff_dr_r * x_u*y_u, r_coeff + dr_coeff_dr_r * y_u*y_u;
+
+    J_disto << x_u * dr_coeff_dk1,
+               y_u * dr_coeff_dk1;
+  }
+};
+
+namespace detail {
+
+/**
+ * @brief Rotation matrix of an angle axis rotation (Rodrigues' formula).
+ * @param[in] angleAxis The angle axis [rX,rY,rZ]
+ * @return the rotation matrix
+ */
+inline Mat3 angleAxisToRotationMatrix(const double* const angleAxis)
+{
+  const Vec3 w(angleAxis[0], angleAxis[1], angleAxis[2]);
+  const Mat3 W = CrossProductMatrix(w);
+  const double theta2 = w.squaredNorm();
+
+  if(theta2 > std::numeric_limits<double>::epsilon())
+  {
+    const double theta = std::sqrt(theta2);
+    return Mat3::Identity() + (std::sin(theta) / theta) * W + ((1.0 - std::cos(theta)) / theta2) * W * W;
+  }
+  // first order approximation, as ceres::AngleAxisRotatePoint
+  return Mat3::Identity() + W;
+}
+
+/**
+ * @brief Jacobian of a rotated point with respect to the angle axis of the rotation.
+ *        d(R(w) * X) / dw = -R(w) * [X]x * Jr(w), with Jr the right jacobian of SO(3).
+ * @param[in] angleAxis The angle axis w
+ * @param[in] R The rotation matrix R(w)
+ * @param[in] point The point X before rotation
+ * @return the 3x3 jacobian
+ */
+inline Mat3 rotatedPointAngleAxisJacobian(const double* const angleAxis, const Mat3& R, const Vec3& point)
+{
+  const Vec3 w(angleAxis[0], angleAxis[1], angleAxis[2]);
+  const Mat3 W = CrossProductMatrix(w);
+  const double theta2 = w.squaredNorm();
+
+  Mat3 Jr;
+  if(theta2 > std::numeric_limits<double>::epsilon())
+  {
+    const double theta = std::sqrt(theta2);
+    Jr = Mat3::Identity() - ((1.0 - std::cos(theta)) / theta2) * W + ((theta - std::sin(theta)) / (theta2 * theta)) * W * W;
+  }
+  else
+  {
+    Jr = Mat3::Identity() - 0.5 * W;
+  }
+  return -R * CrossProductMatrix(point) * Jr;
+}
+
+/**
+ * @brief Project a point in the camera frame and compute the residual and its jacobians.
+ * @param[in] cam_K The intrinsic data block [focal, principal point x, principal point y, distortion...]
+ * @param[in] pos_proj The point in the camera frame
+ * @param[in] observation The 2D observation
+ * @param[out] residuals The residuals
+ * @param[out] J_intrinsics The jacobian with respect to the intrinsics (row-major), nullptr to skip
+ * @param[out] J_pos_proj The jacobian with respect to the point in the camera frame
+ */
+template <typename DistortionT>
+inline void project(const double* const cam_K, const Vec3& pos_proj, const double* const observation,
+                    double* residuals, double* J_intrinsics, Mat23& J_pos_proj)
+{
+  enum { NB_INTRINSICS = 3 + DistortionT::NB_PARAMS };
+  // at least one column, as Eigen doesn't support empty fixed size matrices
+  using DistortionJacobian = Eigen::Matrix<double, 2, (DistortionT::NB_PARAMS > 0 ? DistortionT::NB_PARAMS : 1)>;
+
+  const double focal = cam_K[0];
+
+  // Transform the point from homogeneous to euclidean (undistorted point)
+  const double inv_z = 1.0 / pos_proj(2);
+  const double x_u = pos_proj(0) * inv_z;
+  const double y_u = pos_proj(1) * inv_z;
+
+  Vec2 x_d;
+  Eigen::Matrix2d J_u;
+  DistortionJacobian J_disto;
+  DistortionT::distort(cam_K + 3, x_u, y_u, x_d, J_u, J_disto);
+
+  // Apply focal length and principal point to get the final image coordinates
+  residuals[0] = cam_K[1] + focal * x_d(0) - observation[0];
+  residuals[1] = cam_K[2] + focal * x_d(1) - observation[1];
+
+  if(J_intrinsics != nullptr)
+  {
+    Eigen::Map<Eigen::Matrix<double, 2, NB_INTRINSICS, Eigen::RowMajor>> J(J_intrinsics);
+    J.col(0) = x_d;
+    J.col(1) << 1.0, 0.0;
+    J.col(2) << 0.0, 1.0;
+    if(DistortionT::NB_PARAMS > 0)
+      J.template rightCols<DistortionT::NB_PARAMS>() = focal * J_disto.template leftCols<DistortionT::NB_PARAMS>();
+  }
+
+  Mat23 J_homogeneous;
+  J_homogeneous << inv_z, 0.0, -x_u * inv_z,
+                   0.0, inv_z, -y_u * inv_z;
+
+  J_pos_proj = focal * J_u * J_homogeneous;
+}
+
+} // namespace detail
+
+/**
+ * @brief Ceres cost function with analytic jacobians for a camera model and a 3D point.
+ *
+ *  Data parameter blocks are the following <2,3+N,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - 3+N => the intrinsic data block [focal, principal point x, principal point y, N distortion parameters],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ *
+ */
+template <typename DistortionT>
+class ResidualErrorCostFunction : public ceres::SizedCostFunction<2, 3 + DistortionT::NB_PARAMS, 6, 3>
+{
+public:
+  explicit ResidualErrorCostFunction(const double* const pos_2dpoint)
+  {
+    m_pos_2dpoint[0] = pos_2dpoint[0];
+    m_pos_2dpoint[1] = pos_2dpoint[1];
+  }
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double* cam_R = parameters[1];
+    const double* cam_t = &parameters[1][3];
+    const Vec3 pos_3dpoint(parameters[2][0], parameters[2][1], parameters[2][2]);
+
+    // Apply external parameters (Pose)
+    const Mat3 R = detail::angleAxisToRotationMatrix(cam_R);
+    const Vec3 pos_proj = R * pos_3dpoint + Vec3(cam_t[0], cam_t[1], cam_t[2]);
+
+    // Apply intrinsic parameters
+    Mat23 J_pos_proj;
+    detail::project<DistortionT>(cam_K, pos_proj, m_pos_2dpoint, residuals,
+                                 (jacobians != nullptr) ? jacobians[0] : nullptr, J_pos_proj);
+
+    if(jacobians == nullptr)
+      return true;
+
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[1]);
+      J.leftCols<3>() = J_pos_proj * detail::rotatedPointAngleAxisJacobian(cam_R, R, pos_3dpoint);
+      J.rightCols<3>() = J_pos_proj;
+    }
+
+    if(jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[2]);
+      J = J_pos_proj * R;
+    }
+    return true;
+  }
+
+private:
+  double m_pos_2dpoint[2]; // The 2D observation
+};
+
+/**
+ * @brief Ceres cost function with analytic jacobians for a camera model of a rig and a 3D point.
+ *
+ *  Data parameter blocks are the following <2,3+N,6,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - 3+N => the intrinsic data block [focal, principal point x, principal point y, N distortion parameters],
+ *  - 6 => the rig extrinsic data block (rig orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 6 => the camera sub-pose data block (camera orientation and position in the rig) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ *
+ */
+template <typename DistortionT>
+class RigResidualErrorCostFunction : public ceres::SizedCostFunction<2, 3 + DistortionT::NB_PARAMS, 6, 6, 3>
+{
+public:
+  explicit RigResidualErrorCostFunction(const double* const pos_2dpoint)
+  {
+    m_pos_2dpoint[0] = pos_2dpoint[0];
+    m_pos_2dpoint[1] = pos_2dpoint[1];
+  }
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double* rig_R = parameters[1];
+    const double* rig_t = &parameters[1][3];
+    const double* subpose_R = parameters[2];
+    const double* subpose_t = &parameters[2][3];
+    const Vec3 pos_3dpoint(parameters[3][0], parameters[3][1], parameters[3][2]);
+
+    // Apply RIG pose
+    const Mat3 R_rig = detail::angleAxisToRotationMatrix(rig_R);
+    const Vec3 pos_rig = R_rig * pos_3dpoint + Vec3(rig_t[0], rig_t[1], rig_t[2]);
+
+    // Apply RIG sub-pose
+    const Mat3 R_subpose = detail::angleAxisToRotationMatrix(subpose_R);
+    const Vec3 pos_proj = R_subpose * pos_rig + Vec3(subpose_t[0], subpose_t[1], subpose_t[2]);
+
+    // Apply intrinsic parameters
+    Mat23 J_pos_proj;
+    detail::project<DistortionT>(cam_K, pos_proj, m_pos_2dpoint, residuals,
+                                 (jacobians != nullptr) ? jacobians[0] : nullptr, J_pos_proj);
+
+    if(jacobians == nullptr)
+      return true;
+
+    const Mat23 J_pos_rig = J_pos_proj * R_subpose;
+
+    if(jacobians[1] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[1]);
+      J.leftCols<3>() = J_pos_rig * detail::rotatedPointAngleAxisJacobian(rig_R, R_rig, pos_3dpoint);
+      J.rightCols<3>() = J_pos_rig;
+    }
+
+    if(jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[2]);
+      J.leftCols<3>() = J_pos_proj * detail::rotatedPointAngleAxisJacobian(subpose_R, R_subpose, pos_rig);
+      J.rightCols<3>() = J_pos_proj;
+    }
+
+    if(jacobians[3] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[3]);
+      J = J_pos_rig * R_rig;
+    }
+    return true;
+  }
+
+private:
+  double m_pos_2dpoint[2]; // The 2D observation
+};
+
+using ResidualErrorCostFunction_Pinhole = ResidualErrorCostFunction<AnalyticDistortion_None>;
+using ResidualErrorCostFunction_PinholeRadialK1 = ResidualErrorCostFunction<AnalyticDistortion_RadialK1>;
+using ResidualErrorCostFunction_PinholeRadialK3 = ResidualErrorCostFunction<AnalyticDistortion_RadialK3>;
+using ResidualErrorCostFunction_PinholeBrownT2 = ResidualErrorCostFunction<AnalyticDistortion_BrownT2>;
+using ResidualErrorCostFunction_PinholeFisheye = ResidualErrorCostFunction<AnalyticDistortion_Fisheye>;
+using ResidualErrorCostFunction_PinholeFisheye1 = ResidualErrorCostFunction<AnalyticDistortion_Fisheye1>;
+
+using RigResidualErrorCostFunction_Pinhole = RigResidualErrorCostFunction<AnalyticDistortion_None>;
+using RigResidualErrorCostFunction_PinholeRadialK1 = RigResidualErrorCostFunction<AnalyticDistortion_RadialK1>;
+using RigResidualErrorCostFunction_PinholeRadialK3 = RigResidualErrorCostFunction<AnalyticDistortion_RadialK3>;
+using RigResidualErrorCostFunction_PinholeBrownT2 = RigResidualErrorCostFunction<AnalyticDistortion_BrownT2>;
+using RigResidualErrorCostFunction_PinholeFisheye = RigResidualErrorCostFunction<AnalyticDistortion_Fisheye>;
+using RigResidualErrorCostFunction_PinholeFisheye1 = RigResidualErrorCostFunction<AnalyticDistortion_Fisheye1>;
+
+} // namespace sfm
+} // namespace aliceVision
@@ -236,6 +236,73 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   BOOST_CHECK(dResidual_before > dResidual_after);
 }
 
+// Test summary:
+// - Create a SfMData scene from a synthetic dataset, without the pose of the last view
+// - Modify the scene between the calls to the incremental Bundle Adjustment:
+//   add the last view, remove landmarks and observations, change the refine options
+// - Check that the incremental Bundle Adjustment gives the same residual as a new Bundle Adjustment
+
+BOOST_AUTO_TEST_CASE(INCREMENTAL_BUNDLE_ADJUSTMENT_UpdatedScene_PinholeRadialK3)
+{
+  const int nviews = 6;
+  const int npoints = 32;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA_RADIAL3);
+
+  // Remove the last view from the reconstruction
+  const IndexT lastViewId = nviews - 1;
+  const CameraPose lastPose = sfmData.getPose(*sfmData.getViews().at(lastViewId));
+  HashMap<IndexT, Observation> lastViewObservations;
+  sfmData.erasePose(lastViewId);
+  for(auto& landmarkIt : sfmData.structure)
+  {
+    lastViewObservations[landmarkIt.first] = landmarkIt.second.observations.at(lastViewId);
+    landmarkIt.second.observations.erase(lastViewId);
+  }
+
+  IncrementalBundleAdjustmentCeres incrementalBA;
+
+  for(int step = 0; step < 4; ++step)
+  {
+    BA_Refine refineOptions = BA_REFINE_ALL;
+
+    if(step == 1)
+    {
+      // Add the last view to the reconstruction
+      sfmData.setPose(*sfmData.getViews().at(lastViewId), lastPose);
+      for(auto& landmarkIt : sfmData.structure)
+        landmarkIt.second.observations[lastViewId] = lastViewObservations.at(landmarkIt.first);
+    }
+    else if(step == 2)
+    {
+      // Remove some landmarks and some observations
+      for(IndexT landmarkId = 0; landmarkId < npoints; landmarkId += 4)
+        sfmData.structure.erase(landmarkId);
+      for(IndexT landmarkId = 1; landmarkId < npoints; landmarkId += 4)
+        sfmData.structure.at(landmarkId).observations.erase(landmarkId % nviews);
+    }
+    else if(step == 3)
+    {
+      // Fixed intrinsics
+      refineOptions = BA_REFINE_ROTATION | BA_REFINE_TRANSLATION | BA_REFINE_STRUCTURE;
+    }
+
+    // the reference scene does not share the intrinsics of the adjusted scene
+    SfMData referenceSfmData = sfmData;
+    for(auto& intrinsicIt : referenceSfmData.intrinsics)
+      intrinsicIt.second.reset(intrinsicIt.second->clone());
+
+    BundleAdjustmentCeres referenceBA;
+    BOOST_CHECK(referenceBA.Adjust(referenceSfmData, refineOptions));
+
+    BOOST_CHECK(incrementalBA.Adjust(sfmData, refineOptions));
+    BOOST_CHECK_SMALL(RMSE(sfmData) - RMSE(referenceSfmData), 1e-3);
+  }
+}
+
 /// Compute the Root Mean Square Error of the residuals
 double RMSE(const SfMData & sfm_data)
 {
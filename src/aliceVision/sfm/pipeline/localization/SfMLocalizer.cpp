@@ -19,16 +19,7 @@
 namespace aliceVision {
 namespace sfm {
 
-struct ResectionSquaredResidualError 
-{
-  // Compute the residual of the projection distance(pt2D, Project(P,pt3D))
-  // Return the squared error
-  static double Error(const Mat34& P, const Vec2& pt2D, const Vec3& pt3D)
-  {
-    const Vec2 x = Project(P, pt3D);
-    return (x - pt2D).squaredNorm();
-  }
-};
+using resection::kernel::ResectionSquaredResidualError;
 
 bool SfMLocalizer::Localize(const Pair& imageSize,
                             const camera::IntrinsicBase* optionalIntrinsics,
@@ -49,6 +40,7 @@ bool SfMLocalizer::Localize(const Pair& imageSize,
     Square(resectionData.error_max);
 
   std::size_t minimumSamples = 0;
+  const robustEstimation::ParallelEvaluation* parallel = resectionData.useParallelEstimation ? &resectionData.parallelEstimation : nullptr;
   const camera::Pinhole* pinholeCam = dynamic_cast<const camera::Pinhole*>(optionalIntrinsics);
 
   if (pinholeCam == nullptr || !pinholeCam->isValid())
@@ -65,7 +57,7 @@ bool SfMLocalizer::Localize(const Pair& imageSize,
     KernelType kernel(resectionData.pt2D, imageSize.first, imageSize.second, resectionData.pt3D);
     // Robust estimation of the Projection matrix and its precision
     const std::pair<double,double> ACRansacOut =
-      aliceVision::robustEstimation::ACRANSAC(kernel, resectionData.vec_inliers, resectionData.max_iteration, &P, precision, true);
+      aliceVision::robustEstimation::ACRANSAC(kernel, resectionData.vec_inliers, resectionData.max_iteration, &P, precision, true, parallel);
     // Update the upper bound precision of the model found by AC-RANSAC
     resectionData.error_max = ACRansacOut.first;
   }
@@ -102,7 +94,7 @@ bool SfMLocalizer::Localize(const Pair& imageSize,
 
         // Robust estimation of the Projection matrix and its precision
         const std::pair<double, double> ACRansacOut =
-                aliceVision::robustEstimation::ACRANSAC(kernel, resectionData.vec_inliers, resectionData.max_iteration, &P, precision, true);
+                aliceVision::robustEstimation::ACRANSAC(kernel, resectionData.vec_inliers, resectionData.max_iteration, &P, precision, true, parallel);
         // Update the upper bound precision of the model found by AC-RANSAC
         resectionData.error_max = ACRansacOut.first;
         break;
@@ -141,7 +133,7 @@ bool SfMLocalizer::Localize(const Pair& imageSize,
         // @todo refactor, maybe move scorer directly inside the kernel
         const double threshold = resectionData.error_max * resectionData.error_max * (kernel.normalizer2()(0, 0) * kernel.normalizer2()(0, 0));
         robustEstimation::ScoreEvaluator<KernelType> scorer(threshold);
-        P = robustEstimation::LO_RANSAC(kernel, scorer, &resectionData.vec_inliers);
+        P = robustEstimation::LO_RANSAC(kernel, scorer, &resectionData.vec_inliers, nullptr, false, 100, 1e-2, parallel);
         break;
       }
 
@@ -11,6 +11,7 @@
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/feature/RegionsPerView.hpp>
 #include <aliceVision/robustEstimation/estimators.hpp>
+#include <aliceVision/robustEstimation/ransacTools.hpp>
 
 #include <cstddef>
 #include <limits>
@@ -42,6 +43,11 @@ struct ImageLocalizerMatchData
   /// Upper bound pixel(s) tolerance for residual errors
   double error_max = std::numeric_limits<double>::infinity();
   size_t max_iteration = 4096;
+
+  /// Evaluate the robust estimation hypotheses by batches across the threads
+  /// (reproducible for the parallelEstimation seed, whatever the number of threads)
+  bool useParallelEstimation = false;
+  robustEstimation::ParallelEvaluation parallelEstimation;
 };
 
 class SfMLocalizer
@@ -6,6 +6,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "regionsIO.hpp"
+#include <aliceVision/feature/RegionsFile.hpp>
 
 #include <boost/progress.hpp>
 #include <boost/filesystem.hpp>
@@ -20,6 +21,61 @@ namespace sfm {
 
 using namespace sfmData;
 
+namespace {
+
+/**
+ * @brief Load the regions of a view from a binary regions file.
+ */
+std::unique_ptr<feature::Regions> loadRegionsFromFile(const feature::RegionsFile& regionsFile,
+                                                      IndexT viewId,
+                                                      const feature::ImageDescriber& imageDescriber)
+{
+  const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriber.getDescriberType());
+
+  ALICEVISION_LOG_TRACE("Regions filename: " << regionsFile.path());
+
+  std::unique_ptr<feature::Regions> regionsPtr;
+  imageDescriber.allocate(regionsPtr);
+
+  try
+  {
+    regionsPtr->Load(regionsFile, viewId);
+  }
+  catch(const std::exception& e)
+  {
+    std::stringstream ss;
+    ss << "Invalid " << imageDescriberTypeName << " regions file for the view " << viewId << " : \n";
+    ss << "\t- Regions file : " << regionsFile.path() << "\n";
+    ss << "\t  " << e.what() << "\n";
+    ALICEVISION_LOG_ERROR(ss.str());
+
+    throw std::runtime_error(e.what());
+  }
+
+  ALICEVISION_LOG_TRACE("Region count: " << regionsPtr->RegionCount());
+  return regionsPtr;
+}
+
+/**
+ * @brief Find the binary regions file of a single view ("<viewId>.<describerType>.regions").
+ * @return the file path or an empty string if there is no such file
+ */
+std::string findViewRegionsFile(const std::vector<std::string>& folders,
+                                const std::string& basename,
+                                const std::string& imageDescriberTypeName)
+{
+  std::string regionsFilename;
+  for(const std::string& folder : folders)
+  {
+    const fs::path regionsPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".regions");
+    if(fs::exists(regionsPath))
+      regionsFilename = regionsPath.string();
+  }
+  return regionsFilename;
+}
+
+} // namespace
+
 std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders,
                                               IndexT viewId,
                                               const feature::ImageDescriber& imageDescriber)
@@ -29,6 +85,11 @@ std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& fo
   const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriber.getDescriberType());
   const std::string basename = std::to_string(viewId);
 
+  // binary regions file (preferred)
+  const std::string regionsFilename = findViewRegionsFile(folders, basename, imageDescriberTypeName);
+  if(!regionsFilename.empty())
+    return loadRegionsFromFile(feature::RegionsFile(regionsFilename), viewId, imageDescriber);
+
   std::string featFilename;
   std::string descFilename;
 
@@ -82,6 +143,15 @@ std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& f
   const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriber.getDescriberType());
   const std::string basename = std::to_string(viewId);
 
+  // binary regions file (preferred), descriptors are dropped
+  const std::string regionsFilename = findViewRegionsFile(folders, basename, imageDescriberTypeName);
+  if(!regionsFilename.empty())
+  {
+    std::unique_ptr<feature::Regions> regionsPtr = loadRegionsFromFile(feature::RegionsFile(regionsFilename), viewId, imageDescriber);
+    regionsPtr->clearDescriptors();
+    return regionsPtr;
+  }
+
   std::string featFilename;
 
   for(const std::string& folder : folders)
@@ -137,6 +207,30 @@ bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
   for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
     imageDescribers.at(i) = createImageDescriber(imageDescriberTypes.at(i));
 
+  // binary regions files packing several views ("<describerType>.regions"), mapped once for all views
+  std::vector<std::vector<std::unique_ptr<feature::RegionsFile>>> packedRegionsFiles(imageDescriberTypes.size());
+  for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
+  {
+    const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriberTypes.at(i));
+    for(const std::string& folder : featuresFolders)
+    {
+      const fs::path regionsPath = fs::path(folder) / std::string(imageDescriberTypeName + ".regions");
+      if(fs::exists(regionsPath))
+        packedRegionsFiles.at(i).emplace_back(new feature::RegionsFile(regionsPath.string()));
+    }
+  }
+
+  const auto findPackedRegionsFile = [&](std::size_t i, IndexT viewId) -> const feature::RegionsFile*
+  {
+    // the last folder has priority, as for the per view files
+    for(auto it = packedRegionsFiles.at(i).rbegin(); it != packedRegionsFiles.at(i).rend(); ++it)
+    {
+      if((*it)->hasView(viewId))
+        return it->get();
+    }
+    return nullptr;
+  };
+
 #pragma omp parallel num_threads(3)
  for(auto iter = sfmData.getViews().begin(); iter != sfmData.getViews().end() && !invalid; ++iter)
  {
@@ -146,7 +240,11 @@ bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
      {
        if(viewIdFilter.empty() || viewIdFilter.find(iter->second.get()->getViewId()) != viewIdFilter.end())
        {
-         std::unique_ptr<feature::Regions> regionsPtr = loadRegions(featuresFolders, iter->second.get()->getViewId(), *(imageDescribers.at(i)));
+         const IndexT viewId = iter->second.get()->getViewId();
+         const feature::RegionsFile* packedRegionsFile = findPackedRegionsFile(i, viewId);
+         std::unique_ptr<feature::Regions> regionsPtr = (packedRegionsFile != nullptr) ?
+                   loadRegionsFromFile(*packedRegionsFile, viewId, *(imageDescribers.at(i))) :
+                   loadRegions(featuresFolders, viewId, *(imageDescribers.at(i)));
          if(regionsPtr)
          {
 #pragma omp critical
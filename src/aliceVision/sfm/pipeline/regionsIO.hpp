@@ -21,6 +21,8 @@ namespace sfm {
 
 /**
  * @brief Load Regions (Features & Descriptors) for one view.
+ * @note A binary regions file (<viewId>.<describerType>.regions) is used if available,
+ *       otherwise the regions are read from the .feat / .desc files.
  * @param[in] folders The list of featureFolders
  * @param[in] viewId The view id
  * @param[in] imageDescriber The imageDescriber type
@@ -39,6 +41,8 @@ std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& f
 
 /**
  * @brief Load Regions (Features & Descriptors) for each view of the provided SfMData container.
+ * @note Binary regions files packing several views (<describerType>.regions) found in the folders
+ *       are mapped once and used first.
  * @param[in,out] regionsPerView
  * @param[in] sfmData The provided SfMData container
  * @param[in] folders The feature Folders
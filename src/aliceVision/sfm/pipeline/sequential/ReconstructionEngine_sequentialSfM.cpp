@@ -407,7 +407,8 @@ void ReconstructionEngine_sequentialSfM::updateReconstruction(IndexT resectionId
   const std::set<IndexT> prevReconstructedViews = _sfmData.getValidViews();
 
   // add images to the 3D reconstruction
-#pragma omp parallel for
+  // with the parallel estimation, the views are resected one after another and each resection uses all the threads
+#pragma omp parallel for if(!_localizerParallelEstimation)
   for(int i = 0; i < bestViewIds.size(); ++i)
   {
     const IndexT viewId = bestViewIds.at(i);
@@ -1370,6 +1371,8 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewIndex
   // C. Do the resectioning: compute the camera pose.
   ALICEVISION_LOG_INFO("Robust Resection of view: " << viewIndex);
 
+  resectionData.useParallelEstimation = _localizerParallelEstimation;
+
   const bool bResection = sfm::SfMLocalizer::Localize(
       Pair(view_I->getWidth(), view_I->getHeight()),
       resectionData.optionalIntrinsic.get(),
@@ -1872,11 +1875,11 @@ bool ReconstructionEngine_sequentialSfM::BundleAdjustment(bool fixedIntrinsics)
     ALICEVISION_LOG_DEBUG("Global BundleAdjustment dense");
     options.setDenseBA();
   }
-  BundleAdjustmentCeres bundle_adjustment_obj(options);
+  _bundleAdjustment.setOptions(options);
   BA_Refine refineOptions = BA_REFINE_ROTATION | BA_REFINE_TRANSLATION | BA_REFINE_STRUCTURE;
   if(!fixedIntrinsics)
     refineOptions |= BA_REFINE_INTRINSICS_ALL;
-  return bundle_adjustment_obj.Adjust(_sfmData, refineOptions);
+  return _bundleAdjustment.Adjust(_sfmData, refineOptions);
 }
 
 bool ReconstructionEngine_sequentialSfM::localBundleAdjustment(const std::set<IndexT>& newReconstructedViews)
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <aliceVision/sfm/pipeline/ReconstructionEngine.hpp>
+#include <aliceVision/sfm/IncrementalBundleAdjustmentCeres.hpp>
 #include <aliceVision/sfm/LocalBundleAdjustmentData.hpp>
 #include <aliceVision/sfm/pipeline/localization/SfMLocalizer.hpp>
 #include <aliceVision/sfm/pipeline/pairwiseMatchesIO.hpp>
@@ -106,6 +107,11 @@ public:
     _localizerEstimator = estimator;
   }
 
+  void setLocalizerParallelEstimation(bool parallelEstimation)
+  {
+    _localizerParallelEstimation = parallelEstimation;
+  }
+
   void setIntermediateFileExtension(const std::string& interFileExtension)
   {
     _sfmdataInterFileExtension = interFileExtension;
@@ -381,6 +387,9 @@ private:
   float _maxAngleInitialPair = 40.0f;
   bool _useTrackFiltering = true;
   robustEstimation::ERobustEstimator _localizerEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
+  /// evaluate the resection hypotheses across the threads (reproducible, fixed seed)
+  /// instead of resecting the views of an iteration in parallel
+  bool _localizerParallelEstimation = false;
 
   // Data providers
 
@@ -406,6 +415,11 @@ private:
   /// Per camera confidence (A contrario estimated threshold error)
   HashMap<IndexT, double> _map_ACThreshold;
 
+  // Bundle Adjustment data
+
+  /// Global bundle adjustment problem, updated between the iterations instead of being rebuilt
+  IncrementalBundleAdjustmentCeres _bundleAdjustment;
+
   // Local Bundle Adjustment data
 
   /// Contains all the data used by the Local BA approach
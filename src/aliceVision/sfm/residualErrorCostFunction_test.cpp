@@ -0,0 +1,159 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
+
+#include <ceres/ceres.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE residualErrorCostFunction
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+// Test summary:
+// - Evaluate the analytic cost functions and the automatic differentiation of the reference functors
+//   on random cameras, rig sub-poses and 3D points
+// - Check that the residuals and the jacobians of all the parameter blocks are the same
+// - Perform the test for all the camera models, with and without rig
+
+/**
+ * @brief Evaluate two cost functions with the same parameter blocks
+ *        and check that their residuals and jacobians are the same.
+ */
+void checkCostFunctions(const ceres::CostFunction& analytic,
+                        const ceres::CostFunction& autodiff,
+                        const std::vector<std::vector<double>>& blocks)
+{
+  const auto& blockSizes = analytic.parameter_block_sizes();
+  BOOST_REQUIRE(blockSizes == autodiff.parameter_block_sizes());
+  BOOST_REQUIRE_EQUAL(blockSizes.size(), blocks.size());
+
+  std::vector<const double*> parameters;
+  std::vector<std::vector<double>> analyticJacobians;
+  std::vector<std::vector<double>> autodiffJacobians;
+  std::vector<double*> analyticJacobiansPtr;
+  std::vector<double*> autodiffJacobiansPtr;
+
+  for(std::size_t i = 0; i < blocks.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(blockSizes[i], blocks[i].size());
+    parameters.push_back(blocks[i].data());
+    analyticJacobians.emplace_back(2 * blocks[i].size());
+    autodiffJacobians.emplace_back(2 * blocks[i].size());
+  }
+  for(std::size_t i = 0; i < blocks.size(); ++i)
+  {
+    analyticJacobiansPtr.push_back(analyticJacobians[i].data());
+    autodiffJacobiansPtr.push_back(autodiffJacobians[i].data());
+  }
+
+  double analyticResiduals[2];
+  double autodiffResiduals[2];
+  BOOST_CHECK(analytic.Evaluate(parameters.data(), analyticResiduals, analyticJacobiansPtr.data()));
+  BOOST_CHECK(autodiff.Evaluate(parameters.data(), autodiffResiduals, autodiffJacobiansPtr.data()));
+
+  for(int r = 0; r < 2; ++r)
+    BOOST_CHECK_SMALL(analyticResiduals[r] - autodiffResiduals[r], 1e-9);
+
+  for(std::size_t i = 0; i < blocks.size(); ++i)
+  {
+    for(std::size_t j = 0; j < analyticJacobians[i].size(); ++j)
+    {
+      const double tolerance = 1e-8 * std::max(1.0, std::abs(autodiffJacobians[i][j]));
+      BOOST_CHECK_SMALL(analyticJacobians[i][j] - autodiffJacobians[i][j], tolerance);
+    }
+  }
+
+  // residuals only
+  BOOST_CHECK(analytic.Evaluate(parameters.data(), analyticResiduals, nullptr));
+  for(int r = 0; r < 2; ++r)
+    BOOST_CHECK_SMALL(analyticResiduals[r] - autodiffResiduals[r], 1e-9);
+}
+
+/**
+ * @brief Compare the analytic cost functions of a camera model (with and without rig)
+ *        to the automatic differentiation of its reference functor.
+ */
+template <typename FunctorT, typename DistortionT>
+void checkCameraModel(const std::vector<double>& intrinsics)
+{
+  enum { NB_INTRINSICS = 3 + DistortionT::NB_PARAMS };
+  BOOST_REQUIRE_EQUAL(intrinsics.size(), NB_INTRINSICS);
+
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+  for(int i = 0; i < 20; ++i)
+  {
+    const double observation[2] = {1000.0 * distribution(generator), 1000.0 * distribution(generator)};
+
+    std::vector<double> pose(6);
+    std::vector<double> subPose(6);
+    for(int j = 0; j < 6; ++j)
+    {
+      pose[j] = distribution(generator);
+      subPose[j] = 0.3 * distribution(generator);
+    }
+    if(i == 0)
+    {
+      // identity rotations, as the rig main camera
+      std::fill(pose.begin(), pose.begin() + 3, 0.0);
+      std::fill(subPose.begin(), subPose.begin() + 3, 0.0);
+    }
+
+    // 3D point in front of the cameras
+    const std::vector<double> point = {distribution(generator), distribution(generator), 7.5 + distribution(generator)};
+
+    {
+      const ResidualErrorCostFunction<DistortionT> analytic(observation);
+      const ceres::AutoDiffCostFunction<FunctorT, 2, NB_INTRINSICS, 6, 3> autodiff(new FunctorT(observation));
+      checkCostFunctions(analytic, autodiff, {intrinsics, pose, point});
+    }
+    {
+      const RigResidualErrorCostFunction<DistortionT> analytic(observation);
+      const ceres::AutoDiffCostFunction<FunctorT, 2, NB_INTRINSICS, 6, 6, 3> autodiff(new FunctorT(observation));
+      checkCostFunctions(analytic, autodiff, {intrinsics, pose, subPose, point});
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RESIDUAL_ERROR_COST_FUNCTION_Pinhole)
+{
+  checkCameraModel<ResidualErrorFunctor_Pinhole, AnalyticDistortion_None>({1000.0, 500.0, 400.0});
+}
+
+BOOST_AUTO_TEST_CASE(RESIDUAL_ERROR_COST_FUNCTION_PinholeRadialK1)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeRadialK1, AnalyticDistortion_RadialK1>({1000.0, 500.0, 400.0, -0.1});
+}
+
+BOOST_AUTO_TEST_CASE(RESIDUAL_ERROR_COST_FUNCTION_PinholeRadialK3)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeRadialK3, AnalyticDistortion_RadialK3>({1000.0, 500.0, 400.0, -0.1, 0.05, -0.01});
+}
+
+BOOST_AUTO_TEST_CASE(RESIDUAL_ERROR_COST_FUNCTION_PinholeBrownT2)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeBrownT2, AnalyticDistortion_BrownT2>({1000.0, 500.0, 400.0, -0.1, 0.05, -0.01, 0.001, -0.002});
+}
+
+BOOST_AUTO_TEST_CASE(RESIDUAL_ERROR_COST_FUNCTION_PinholeFisheye)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeFisheye, AnalyticDistortion_Fisheye>({1000.0, 500.0, 400.0, 0.01, -0.02, 0.003, -0.001});
+}
+
+BOOST_AUTO_TEST_CASE(RESIDUAL_ERROR_COST_FUNCTION_PinholeFisheye1)
+{
+  checkCameraModel<ResidualErrorFunctor_PinholeFisheye1, AnalyticDistortion_Fisheye1>({1000.0, 500.0, 400.0, 0.9});
+}
@@ -0,0 +1,446 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "JsonReader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <locale>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+namespace {
+
+/// maximum length of a number
+const std::size_t maxNumberLength = 64;
+
+inline bool isWhitespace(char c)
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/// @return true if the string is a non-finite value, as written by the standard streams
+bool readNonFinite(const char* str, std::size_t size, double& d)
+{
+  const bool negative = (size > 0 && *str == '-');
+  if(negative)
+  {
+    ++str;
+    --size;
+  }
+  if(size == 3 && std::strncmp(str, "nan", 3) == 0)
+    d = std::numeric_limits<double>::quiet_NaN();
+  else if(size == 3 && std::strncmp(str, "inf", 3) == 0)
+    d = std::numeric_limits<double>::infinity();
+  else
+    return false;
+  if(negative)
+    d = -d;
+  return true;
+}
+
+inline int hexValue(char c)
+{
+  if(c >= '0' && c <= '9')
+    return c - '0';
+  if(c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if(c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+void appendUtf8(unsigned int codePoint, std::string& str)
+{
+  if(codePoint < 0x80)
+  {
+    str.push_back(static_cast<char>(codePoint));
+  }
+  else if(codePoint < 0x800)
+  {
+    str.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+    str.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+  }
+  else if(codePoint < 0x10000)
+  {
+    str.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+    str.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+    str.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+  }
+  else
+  {
+    str.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+    str.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+    str.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+    str.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+  }
+}
+
+} // namespace
+
+JsonReader::JsonReader(const char* begin, const char* end, const std::string& name)
+  : _begin(begin)
+  , _end(end)
+  , _current(begin)
+  , _name(name)
+{
+  _numberStream.imbue(std::locale::classic());
+}
+
+void JsonReader::error(const std::string& message) const
+{
+  const std::size_t line = 1 + std::count(_begin, _current, '\n');
+  throw std::runtime_error("Invalid JSON file '" + _name + "' (line " + std::to_string(line) + "): " + message + ".");
+}
+
+void JsonReader::skipWhitespaces()
+{
+  while(_current != _end && isWhitespace(*_current))
+    ++_current;
+}
+
+char JsonReader::peek()
+{
+  skipWhitespaces();
+  if(_current == _end)
+    error("unexpected end of file");
+  return *_current;
+}
+
+void JsonReader::expect(char c)
+{
+  if(peek() != c)
+    error(std::string("'") + c + "' expected");
+  ++_current;
+}
+
+bool JsonReader::readEmptyString()
+{
+  if(peek() == '"' && _current + 1 != _end && _current[1] == '"')
+  {
+    _current += 2;
+    return true;
+  }
+  return false;
+}
+
+bool JsonReader::isObject()
+{
+  return peek() == '{';
+}
+
+bool JsonReader::isArray()
+{
+  return peek() == '[';
+}
+
+void JsonReader::beginObject()
+{
+  if(readEmptyString())
+  {
+    _emptyContainer = true;
+    return;
+  }
+  expect('{');
+}
+
+bool JsonReader::nextMember(std::string& key)
+{
+  if(_emptyContainer)
+  {
+    _emptyContainer = false;
+    return false;
+  }
+
+  char c = peek();
+  if(c == ',')
+  {
+    ++_current;
+    c = peek();
+  }
+  if(c == '}')
+  {
+    ++_current;
+    return false;
+  }
+  if(c != '"')
+    error("member key expected");
+
+  readString(key);
+  expect(':');
+  return true;
+}
+
+void JsonReader::beginArray()
+{
+  if(readEmptyString())
+  {
+    _emptyContainer = true;
+    return;
+  }
+  expect('[');
+}
+
+bool JsonReader::nextElement()
+{
+  if(_emptyContainer)
+  {
+    _emptyContainer = false;
+    return false;
+  }
+
+  char c = peek();
+  if(c == ',')
+  {
+    ++_current;
+    c = peek();
+  }
+  if(c == ']')
+  {
+    ++_current;
+    return false;
+  }
+  return true;
+}
+
+void JsonReader::readToken(const char*& tokenBegin, const char*& tokenEnd, bool& hasEscapes)
+{
+  hasEscapes = false;
+
+  if(peek() == '"')
+  {
+    ++_current;
+    tokenBegin = _current;
+    while(_current != _end && *_current != '"')
+    {
+      if(*_current == '\\')
+      {
+        hasEscapes = true;
+        ++_current;
+        if(_current == _end)
+          break;
+      }
+      ++_current;
+    }
+    if(_current == _end)
+      error("unterminated string");
+    tokenEnd = _current;
+    ++_current;
+    return;
+  }
+
+  // number or literal
+  tokenBegin = _current;
+  while(_current != _end && !isWhitespace(*_current) && *_current != ',' && *_current != '}' && *_current != ']')
+    ++_current;
+  tokenEnd = _current;
+
+  if(tokenBegin == tokenEnd || *tokenBegin == '{' || *tokenBegin == '[')
+    error("value expected");
+}
+
+void JsonReader::readString(std::string& str)
+{
+  const char* tokenBegin;
+  const char* tokenEnd;
+  bool hasEscapes;
+  readToken(tokenBegin, tokenEnd, hasEscapes);
+
+  if(!hasEscapes)
+  {
+    str.assign(tokenBegin, tokenEnd);
+    return;
+  }
+
+  str.clear();
+  for(const char* c = tokenBegin; c != tokenEnd; ++c)
+  {
+    if(*c != '\\')
+    {
+      str.push_back(*c);
+      continue;
+    }
+    ++c;
+    switch(*c)
+    {
+      case '"':  str.push_back('"'); break;
+      case '\\': str.push_back('\\'); break;
+      case '/':  str.push_back('/'); break;
+      case 'b':  str.push_back('\b'); break;
+      case 'f':  str.push_back('\f'); break;
+      case 'n':  str.push_back('\n'); break;
+      case 'r':  str.push_back('\r'); break;
+      case 't':  str.push_back('\t'); break;
+      case 'u':
+      {
+        unsigned int codePoint = 0;
+        for(int i = 0; i < 4; ++i)
+        {
+          const int h = (c + 1 != tokenEnd) ? hexValue(*(++c)) : -1;
+          if(h < 0)
+            error("invalid unicode escape sequence");
+          codePoint = codePoint * 16 + h;
+        }
+        // surrogate pair
+        if(codePoint >= 0xD800 && codePoint < 0xDC00 && tokenEnd - c > 6 && c[1] == '\\' && c[2] == 'u')
+        {
+          unsigned int low = 0;
+          for(int i = 3; i < 7; ++i)
+          {
+            const int h = hexValue(c[i]);
+            if(h < 0)
+              error("invalid unicode escape sequence");
+            low = low * 16 + h;
+          }
+          if(low >= 0xDC00 && low < 0xE000)
+          {
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            c += 6;
+          }
+        }
+        appendUtf8(codePoint, str);
+        break;
+      }
+      default:
+        error("invalid escape sequence");
+    }
+  }
+}
+
+void JsonReader::skipValue()
+{
+  const char c = peek();
+
+  if(c != '{' && c != '[')
+  {
+    const char* tokenBegin;
+    const char* tokenEnd;
+    bool hasEscapes;
+    readToken(tokenBegin, tokenEnd, hasEscapes);
+    return;
+  }
+
+  // skip the whole object / array, only the strings need to be parsed
+  std::size_t depth = 0;
+  while(_current != _end)
+  {
+    switch(*_current)
+    {
+      case '{':
+      case '[':
+        ++depth;
+        ++_current;
+        break;
+      case '}':
+      case ']':
+        ++_current;
+        if(--depth == 0)
+          return;
+        break;
+      case '"':
+      {
+        const char* tokenBegin;
+        const char* tokenEnd;
+        bool hasEscapes;
+        readToken(tokenBegin, tokenEnd, hasEscapes);
+        break;
+      }
+      default:
+        ++_current;
+    }
+  }
+  error("unexpected end of file");
+}
+
+bool JsonReader::readBool()
+{
+  const char* tokenBegin;
+  const char* tokenEnd;
+  bool hasEscapes;
+  readToken(tokenBegin, tokenEnd, hasEscapes);
+
+  const std::size_t size = tokenEnd - tokenBegin;
+  if((size == 4 && std::strncmp(tokenBegin, "true", 4) == 0) || (size == 1 && *tokenBegin == '1'))
+    return true;
+  if((size == 5 && std::strncmp(tokenBegin, "false", 5) == 0) || (size == 1 && *tokenBegin == '0'))
+    return false;
+  error("boolean expected");
+}
+
+double JsonReader::readDouble()
+{
+  const char* tokenBegin;
+  const char* tokenEnd;
+  bool hasEscapes;
+  readToken(tokenBegin, tokenEnd, hasEscapes);
+
+  const std::size_t size = tokenEnd - tokenBegin;
+  if(size == 0 || size >= maxNumberLength)
+    error("number expected");
+
+  double d;
+  if(readNonFinite(tokenBegin, size, d))
+    return d;
+
+  // strtod uses the decimal separator of the global C locale
+  _numberStream.clear();
+  _numberStream.str(std::string(tokenBegin, size));
+  _numberStream >> d;
+  if(_numberStream.fail() || _numberStream.peek() != std::char_traits<char>::eof())
+    error("number expected");
+  return d;
+}
+
+long long JsonReader::readInteger()
+{
+  const char* tokenBegin;
+  const char* tokenEnd;
+  bool hasEscapes;
+  readToken(tokenBegin, tokenEnd, hasEscapes);
+
+  const std::size_t size = tokenEnd - tokenBegin;
+  if(size == 0 || size >= maxNumberLength)
+    error("integer expected");
+  char buffer[maxNumberLength];
+  std::memcpy(buffer, tokenBegin, size);
+  buffer[size] = '\0';
+
+  char* numberEnd;
+  errno = 0;
+  const long long i = std::strtoll(buffer, &numberEnd, 10);
+  if(numberEnd != buffer + size || errno == ERANGE)
+    error("integer expected");
+  return i;
+}
+
+unsigned long long JsonReader::readUnsignedInteger()
+{
+  const char* tokenBegin;
+  const char* tokenEnd;
+  bool hasEscapes;
+  readToken(tokenBegin, tokenEnd, hasEscapes);
+
+  const std::size_t size = tokenEnd - tokenBegin;
+  if(size == 0 || size >= maxNumberLength || *tokenBegin == '-')
+    error("unsigned integer expected");
+  char buffer[maxNumberLength];
+  std::memcpy(buffer, tokenBegin, size);
+  buffer[size] = '\0';
+
+  char* numberEnd;
+  errno = 0;
+  const unsigned long long i = std::strtoull(buffer, &numberEnd, 10);
+  if(numberEnd != buffer + size || errno == ERANGE)
+    error("unsigned integer expected");
+  return i;
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
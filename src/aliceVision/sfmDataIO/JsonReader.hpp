@@ -0,0 +1,156 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+/**
+ * @brief Streaming (pull) JSON reader on a memory buffer.
+ *
+ * The document is read value by value in the file order and decoded directly by the caller,
+ * no tree is built. The values that are not needed are skipped without being decoded.
+ *
+ * Numbers and booleans can be written as JSON numbers / literals or as strings,
+ * as written by boost::property_tree. An empty string is accepted as an empty
+ * object or array (property_tree writes empty nodes as "").
+ *
+ * @code
+ * reader.beginObject();
+ * std::string key;
+ * while(reader.nextMember(key))
+ * {
+ *   if(key == "viewId")
+ *     viewId = reader.read<IndexT>();
+ *   else
+ *     reader.skipValue();
+ * }
+ * @endcode
+ *
+ * The numbers are always read with a '.' decimal separator, whatever the global locale.
+ *
+ * @note The separators are not strictly validated.
+ */
+class JsonReader
+{
+public:
+  /**
+   * @param[in] begin First character of the document
+   * @param[in] end End of the document
+   * @param[in] name Document name, for the error messages
+   */
+  JsonReader(const char* begin, const char* end, const std::string& name);
+
+  /// @return true if the next value is an object
+  bool isObject();
+  /// @return true if the next value is an array
+  bool isArray();
+
+  /// enter the object
+  void beginObject();
+  /**
+   * @brief Read the key of the next member of the current object.
+   * @param[out] key The member key
+   * @return false at the end of the object
+   */
+  bool nextMember(std::string& key);
+
+  /// enter the array
+  void beginArray();
+  /// @return false at the end of the array
+  bool nextElement();
+
+  /// skip the next value (and all its content) without decoding it
+  void skipValue();
+
+  /// read a string value (a number or a literal is returned as written)
+  void readString(std::string& str);
+  std::string readString()
+  {
+    std::string str;
+    readString(str);
+    return str;
+  }
+
+  /// read a number or a boolean (from a JSON number / literal or from a string)
+  template<typename T>
+  T read();
+
+  /**
+   * @brief Throw an error at the current position.
+   * @throw std::runtime_error
+   */
+  [[noreturn]] void error(const std::string& message) const;
+
+private:
+  void skipWhitespaces();
+  /// @return the next non-whitespace character, without consuming it
+  char peek();
+  void expect(char c);
+  /// @return true if the next value is an empty string (consumed)
+  bool readEmptyString();
+  /// @return the characters of a string (without the quotes) or of a number / literal
+  /// @param[out] hasEscapes true if the string contains escape sequences
+  void readToken(const char*& tokenBegin, const char*& tokenEnd, bool& hasEscapes);
+
+  bool readBool();
+  double readDouble();
+  long long readInteger();
+  unsigned long long readUnsignedInteger();
+
+  template<typename T>
+  T readIntegral(std::true_type /*signed*/)
+  {
+    const long long i = readInteger();
+    if(i < static_cast<long long>(std::numeric_limits<T>::min()) || i > static_cast<long long>(std::numeric_limits<T>::max()))
+      error("integer out of range");
+    return static_cast<T>(i);
+  }
+
+  template<typename T>
+  T readIntegral(std::false_type /*unsigned*/)
+  {
+    const unsigned long long i = readUnsignedInteger();
+    if(i > static_cast<unsigned long long>(std::numeric_limits<T>::max()))
+      error("integer out of range");
+    return static_cast<T>(i);
+  }
+
+  const char* _begin;
+  const char* _end;
+  const char* _current;
+  std::string _name;
+  /// parses the floating point values in the classic locale
+  std::istringstream _numberStream;
+  /// an empty string has been read instead of an object / array
+  bool _emptyContainer = false;
+};
+
+template<>
+inline bool JsonReader::read<bool>() { return readBool(); }
+
+template<>
+inline double JsonReader::read<double>() { return readDouble(); }
+
+template<>
+inline float JsonReader::read<float>() { return static_cast<float>(readDouble()); }
+
+template<typename T>
+inline T JsonReader::read()
+{
+  static_assert(std::is_integral<T>::value, "JsonReader::read: unsupported type");
+  return readIntegral<T>(std::integral_constant<bool, std::is_signed<T>::value>());
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -0,0 +1,186 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "JsonWriter.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <locale>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+JsonWriter::JsonWriter(std::ostream& stream)
+  : _stream(stream)
+{
+  _numberStream.imbue(std::locale::classic());
+  // 17 significant digits: a double is read back exactly
+  _numberStream.precision(17);
+}
+
+void JsonWriter::newLine()
+{
+  _stream.put('\n');
+  for(std::size_t i = 0; i < _hasMember.size(); ++i)
+    _stream.write("    ", 4);
+}
+
+void JsonWriter::beginValue()
+{
+  if(_afterKey)
+  {
+    _afterKey = false;
+    return;
+  }
+  if(_hasMember.empty())
+    return;
+  if(_hasMember.back())
+    _stream.put(',');
+  _hasMember.back() = true;
+  newLine();
+}
+
+void JsonWriter::beginObject()
+{
+  beginValue();
+  _stream.put('{');
+  _hasMember.push_back(false);
+}
+
+void JsonWriter::endObject()
+{
+  assert(!_hasMember.empty() && !_afterKey);
+  const bool hasMember = _hasMember.back();
+  _hasMember.pop_back();
+  if(hasMember)
+    newLine();
+  _stream.put('}');
+  if(_hasMember.empty())
+    _stream.put('\n');
+}
+
+void JsonWriter::beginArray()
+{
+  beginValue();
+  _stream.put('[');
+  _hasMember.push_back(false);
+}
+
+void JsonWriter::endArray()
+{
+  assert(!_hasMember.empty() && !_afterKey);
+  const bool hasMember = _hasMember.back();
+  _hasMember.pop_back();
+  if(hasMember)
+    newLine();
+  _stream.put(']');
+}
+
+void JsonWriter::key(const char* name)
+{
+  key(name, std::strlen(name));
+}
+
+void JsonWriter::key(const char* name, std::size_t size)
+{
+  assert(!_hasMember.empty() && !_afterKey);
+  beginValue();
+  writeEscaped(name, size);
+  _stream.write(": ", 2);
+  _afterKey = true;
+}
+
+void JsonWriter::value(const std::string& str)
+{
+  beginValue();
+  writeEscaped(str.data(), str.size());
+}
+
+void JsonWriter::value(const char* str)
+{
+  beginValue();
+  writeEscaped(str, std::strlen(str));
+}
+
+void JsonWriter::value(bool b)
+{
+  if(b)
+    writeRaw("true", 4);
+  else
+    writeRaw("false", 5);
+}
+
+void JsonWriter::value(double d)
+{
+  // printf and strtod use the decimal separator of the global C locale
+  _numberStream.str(std::string());
+  _numberStream << d;
+  const std::string number = _numberStream.str();
+  writeRaw(number.data(), number.size());
+}
+
+void JsonWriter::writeInteger(long long i)
+{
+  char buffer[32];
+  const int size = std::snprintf(buffer, sizeof(buffer), "%lld", i);
+  writeRaw(buffer, size);
+}
+
+void JsonWriter::writeInteger(unsigned long long i)
+{
+  char buffer[32];
+  const int size = std::snprintf(buffer, sizeof(buffer), "%llu", i);
+  writeRaw(buffer, size);
+}
+
+void JsonWriter::writeRaw(const char* str, std::size_t size)
+{
+  beginValue();
+  _stream.put('"');
+  _stream.write(str, size);
+  _stream.put('"');
+}
+
+void JsonWriter::writeEscaped(const char* str, std::size_t size)
+{
+  _stream.put('"');
+  const char* begin = str;
+  const char* end = begin + size;
+  const char* chunk = begin;
+
+  for(const char* c = begin; c != end; ++c)
+  {
+    const unsigned char uc = static_cast<unsigned char>(*c);
+    if(uc >= 0x20 && uc != '"' && uc != '\\')
+      continue;
+
+    _stream.write(chunk, c - chunk);
+    chunk = c + 1;
+
+    switch(uc)
+    {
+      case '"':  _stream.write("\\\"", 2); break;
+      case '\\': _stream.write("\\\\", 2); break;
+      case '\b': _stream.write("\\b", 2); break;
+      case '\f': _stream.write("\\f", 2); break;
+      case '\n': _stream.write("\\n", 2); break;
+      case '\r': _stream.write("\\r", 2); break;
+      case '\t': _stream.write("\\t", 2); break;
+      default:
+      {
+        char buffer[8];
+        std::snprintf(buffer, sizeof(buffer), "\\u%04X", uc);
+        _stream.write(buffer, 6);
+      }
+    }
+  }
+  _stream.write(chunk, end - chunk);
+  _stream.put('"');
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -0,0 +1,99 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+/**
+ * @brief Streaming JSON writer.
+ *
+ * Values are written directly in the output stream, nothing is kept in memory
+ * except the current nesting. The output is indented as boost::property_tree::write_json
+ * and the values are written as strings (as property_tree does), so the files
+ * stay readable by the property_tree based readers.
+ * The numbers are always written with a '.' decimal separator, whatever the global locale.
+ *
+ * @code
+ * writer.beginObject();
+ * writer.member("viewId", viewId);
+ * writer.key("center");
+ * writer.beginArray();
+ * writer.value(x);
+ * ...
+ * writer.endArray();
+ * writer.endObject();
+ * @endcode
+ */
+class JsonWriter
+{
+public:
+  explicit JsonWriter(std::ostream& stream);
+
+  void beginObject();
+  void endObject();
+
+  void beginArray();
+  void endArray();
+
+  /// write the key of the next member of the current object
+  void key(const std::string& name) { key(name.data(), name.size()); }
+  void key(const char* name);
+
+  void value(const std::string& str);
+  void value(const char* str);
+  void value(bool b);
+  void value(double d);
+  void value(float f) { value(static_cast<double>(f)); }
+
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type value(T i)
+  {
+    writeInteger(static_cast<long long>(i));
+  }
+
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type value(T i)
+  {
+    writeInteger(static_cast<unsigned long long>(i));
+  }
+
+  template<typename T>
+  void member(const char* name, const T& v)
+  {
+    key(name);
+    value(v);
+  }
+
+private:
+  /// write the separator and the indentation before a value
+  void beginValue();
+  void newLine();
+  void writeInteger(long long i);
+  void writeInteger(unsigned long long i);
+  /// write an already formatted value as a string
+  void writeRaw(const char* str, std::size_t size);
+  void key(const char* name, std::size_t size);
+  void writeEscaped(const char* str, std::size_t size);
+
+  std::ostream& _stream;
+  /// formats the floating point values in the classic locale
+  std::ostringstream _numberStream;
+  /// for each opened object or array, true if it already has a member
+  std::vector<bool> _hasMember;
+  /// the key of the next value is written
+  bool _afterKey = false;
+};
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -0,0 +1,756 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "binaryIO.hpp"
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+namespace {
+
+const char binaryMagic[8] = {'A', 'V', 'S', 'F', 'M', 'B', 'I', 'N'};
+const std::uint32_t binaryVersion = 1;
+
+enum ESection : std::uint32_t
+{
+  SECTION_STRINGS = 1,
+  SECTION_FEATURES_FOLDERS,
+  SECTION_MATCHES_FOLDERS,
+  SECTION_VIEWS,
+  SECTION_VIEWS_METADATA,
+  SECTION_INTRINSICS,
+  SECTION_INTRINSICS_PARAMS,
+  SECTION_POSES,
+  SECTION_RIGS,
+  SECTION_RIGS_SUBPOSES,
+  SECTION_LANDMARKS,
+  SECTION_OBSERVATIONS,
+  SECTION_CONTROL_POINTS,
+  SECTION_CONTROL_POINTS_OBSERVATIONS
+};
+
+// on-disk records, explicitly padded to avoid any implicit padding
+
+struct FileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t nbSections;
+};
+
+struct StringRecord
+{
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+struct ViewRecord
+{
+  std::uint32_t viewId;
+  std::uint32_t intrinsicId;
+  std::uint32_t poseId;
+  std::uint32_t rigId;
+  std::uint32_t subPoseId;
+  std::uint32_t resectionId;
+  std::uint64_t width;
+  std::uint64_t height;
+  StringRecord path;
+  std::uint64_t metadataBegin;
+  std::uint64_t metadataCount;
+};
+
+struct MetadataRecord
+{
+  StringRecord key;
+  StringRecord value;
+};
+
+struct IntrinsicRecord
+{
+  std::uint32_t intrinsicId;
+  std::uint32_t type;
+  std::uint32_t width;
+  std::uint32_t height;
+  double pxInitialFocalLength;
+  StringRecord serialNumber;
+  std::uint64_t paramsBegin;
+  std::uint64_t paramsCount;
+  std::uint8_t locked;
+  std::uint8_t padding[7];
+};
+
+/// rotation is stored column-major
+struct PoseRecord
+{
+  std::uint32_t poseId;
+  std::uint32_t locked;
+  double rotation[9];
+  double center[3];
+};
+
+struct RigRecord
+{
+  std::uint32_t rigId;
+  std::uint32_t padding;
+  std::uint64_t subPosesBegin;
+  std::uint64_t subPosesCount;
+};
+
+struct RigSubPoseRecord
+{
+  std::uint32_t status;
+  std::uint32_t padding;
+  double rotation[9];
+  double center[3];
+};
+
+struct LandmarkRecord
+{
+  std::uint32_t landmarkId;
+  std::uint32_t descType;
+  double X[3];
+  std::uint8_t rgb[3];
+  std::uint8_t padding[5];
+  std::uint64_t observationsBegin;
+  std::uint64_t observationsCount;
+};
+
+struct ObservationRecord
+{
+  std::uint32_t viewId;
+  std::uint32_t featureId;
+  double x[2];
+};
+
+static_assert(sizeof(FileHeader) == 16, "Unexpected binary SfMData header size");
+static_assert(sizeof(BinarySfMDataFile::Section) == 24, "Unexpected binary SfMData section size");
+static_assert(sizeof(StringRecord) == 16, "Unexpected binary SfMData record size");
+static_assert(sizeof(ViewRecord) == 72, "Unexpected binary SfMData record size");
+static_assert(sizeof(MetadataRecord) == 32, "Unexpected binary SfMData record size");
+static_assert(sizeof(IntrinsicRecord) == 64, "Unexpected binary SfMData record size");
+static_assert(sizeof(PoseRecord) == 104, "Unexpected binary SfMData record size");
+static_assert(sizeof(RigRecord) == 24, "Unexpected binary SfMData record size");
+static_assert(sizeof(RigSubPoseRecord) == 104, "Unexpected binary SfMData record size");
+static_assert(sizeof(LandmarkRecord) == 56, "Unexpected binary SfMData record size");
+static_assert(sizeof(ObservationRecord) == 24, "Unexpected binary SfMData record size");
+
+/// the records are written and read in the host byte order, the format is little-endian
+bool isLittleEndian()
+{
+  const std::uint16_t i = 1;
+  unsigned char c;
+  std::memcpy(&c, &i, 1);
+  return c == 1;
+}
+
+inline std::uint64_t align8(std::uint64_t offset)
+{
+  return (offset + 7) & ~std::uint64_t(7);
+}
+
+/**
+ * @brief View on the records of a section of a mapped file.
+ *        Records are copied on access, the mapping has no alignment requirement.
+ */
+template<typename T>
+class RecordArray
+{
+public:
+  RecordArray(const system::MappedFile& file, const BinarySfMDataFile::Section* section)
+    : _path(file.path())
+  {
+    if(section == nullptr)
+      return;
+    if(section->recordSize != sizeof(T))
+      throw std::runtime_error("Invalid binary SfMData file '" + _path + "': unexpected record size in section " + std::to_string(section->type) + ".");
+    _data = file.data() + section->offset;
+    _size = section->count;
+  }
+
+  std::size_t size() const { return _size; }
+  const unsigned char* data() const { return _data; }
+
+  T operator[](std::size_t index) const
+  {
+    T record;
+    std::memcpy(&record, _data + index * sizeof(T), sizeof(T));
+    return record;
+  }
+
+  /// check that [begin, begin + count[ is a valid range of records
+  void checkRange(std::uint64_t begin, std::uint64_t count) const
+  {
+    if(begin > _size || count > _size - begin)
+      throw std::runtime_error("Invalid binary SfMData file '" + _path + "': record range out of bounds.");
+  }
+
+private:
+  std::string _path;
+  const unsigned char* _data = nullptr;
+  std::size_t _size = 0;
+};
+
+std::string readString(const RecordArray<char>& strings, const StringRecord& record)
+{
+  strings.checkRange(record.offset, record.size);
+  return std::string(reinterpret_cast<const char*>(strings.data()) + record.offset, record.size);
+}
+
+void readLandmark(const LandmarkRecord& record, const RecordArray<ObservationRecord>& observations, sfmData::Landmark& landmark, bool withObservations)
+{
+  landmark.X = Vec3(record.X[0], record.X[1], record.X[2]);
+  landmark.descType = static_cast<feature::EImageDescriberType>(record.descType);
+  landmark.rgb = image::RGBColor(record.rgb[0], record.rgb[1], record.rgb[2]);
+  landmark.observations.clear();
+
+  if(!withObservations || observations.size() == 0)
+    return;
+
+  observations.checkRange(record.observationsBegin, record.observationsCount);
+  landmark.observations.reserve(record.observationsCount);
+  for(std::uint64_t i = record.observationsBegin; i < record.observationsBegin + record.observationsCount; ++i)
+  {
+    const ObservationRecord observation = observations[i];
+    landmark.observations.emplace_hint(landmark.observations.end(), observation.viewId,
+                                       sfmData::Observation(Vec2(observation.x[0], observation.x[1]), observation.featureId));
+  }
+}
+
+void readLandmarks(const RecordArray<LandmarkRecord>& records, const RecordArray<ObservationRecord>& observations, sfmData::Landmarks& landmarks, bool withObservations)
+{
+  for(std::size_t i = 0; i < records.size(); ++i)
+  {
+    const LandmarkRecord record = records[i];
+    readLandmark(record, observations, landmarks[record.landmarkId], withObservations);
+  }
+}
+
+template<typename T>
+void writeRecords(std::ostream& stream, const std::vector<T>& records)
+{
+  stream.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+}
+
+template<typename T>
+void writeRecord(std::ostream& stream, const T& record)
+{
+  stream.write(reinterpret_cast<const char*>(&record), sizeof(T));
+}
+
+void writePose(const geometry::Pose3& pose, double* rotation, double* center)
+{
+  Eigen::Map<Mat3> rotationMap(rotation);
+  Eigen::Map<Vec3> centerMap(center);
+  rotationMap = pose.rotation();
+  centerMap = pose.center();
+}
+
+geometry::Pose3 readPose(const double* rotation, const double* center)
+{
+  return geometry::Pose3(Eigen::Map<const Mat3>(rotation), Eigen::Map<const Vec3>(center));
+}
+
+std::uint64_t countObservations(const sfmData::Landmarks& landmarks)
+{
+  std::uint64_t count = 0;
+  for(const auto& landmarkPair : landmarks)
+    count += landmarkPair.second.observations.size();
+  return count;
+}
+
+void writeLandmarks(std::ostream& stream, const sfmData::Landmarks& landmarks, bool withObservations)
+{
+  std::uint64_t observationsBegin = 0;
+  for(const auto& landmarkPair : landmarks)
+  {
+    const sfmData::Landmark& landmark = landmarkPair.second;
+
+    LandmarkRecord record = {};
+    record.landmarkId = landmarkPair.first;
+    record.descType = static_cast<std::uint32_t>(landmark.descType);
+    record.X[0] = landmark.X(0);
+    record.X[1] = landmark.X(1);
+    record.X[2] = landmark.X(2);
+    record.rgb[0] = landmark.rgb.r();
+    record.rgb[1] = landmark.rgb.g();
+    record.rgb[2] = landmark.rgb.b();
+    if(withObservations)
+    {
+      record.observationsBegin = observationsBegin;
+      record.observationsCount = landmark.observations.size();
+      observationsBegin += landmark.observations.size();
+    }
+    writeRecord(stream, record);
+  }
+}
+
+void writeObservations(std::ostream& stream, const sfmData::Landmarks& landmarks)
+{
+  for(const auto& landmarkPair : landmarks)
+  {
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      ObservationRecord record = {};
+      record.viewId = observationPair.first;
+      record.featureId = observationPair.second.id_feat;
+      record.x[0] = observationPair.second.x(0);
+      record.x[1] = observationPair.second.x(1);
+      writeRecord(stream, record);
+    }
+  }
+}
+
+/// a section of the file and the function writing its records
+struct SectionWriter
+{
+  BinarySfMDataFile::Section section;
+  std::function<void(std::ostream&)> write;
+};
+
+template<typename T>
+SectionWriter recordsSection(std::uint32_t type, const std::vector<T>& records)
+{
+  return {{type, sizeof(T), 0, records.size()}, [&records](std::ostream& stream){ writeRecords(stream, records); }};
+}
+
+} // namespace
+
+BinarySfMDataFile::BinarySfMDataFile(const std::string& filename)
+  : _file(filename)
+{
+  const std::string error = "Invalid binary SfMData file '" + filename + "': ";
+
+  if(!isLittleEndian())
+    throw std::runtime_error("Binary SfMData files are not supported on big-endian platforms.");
+
+  FileHeader header;
+  if(_file.size() < sizeof(FileHeader))
+    throw std::runtime_error(error + "truncated header.");
+  std::memcpy(&header, _file.data(), sizeof(FileHeader));
+
+  if(std::memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0)
+    throw std::runtime_error(error + "bad magic number.");
+  if(header.version != binaryVersion)
+    throw std::runtime_error(error + "unsupported version " + std::to_string(header.version) + ".");
+  if(header.nbSections > (_file.size() - sizeof(FileHeader)) / sizeof(Section))
+    throw std::runtime_error(error + "truncated section table.");
+
+  _sections.resize(header.nbSections);
+  std::memcpy(_sections.data(), _file.data() + sizeof(FileHeader), header.nbSections * sizeof(Section));
+
+  for(const Section& section : _sections)
+  {
+    if(section.offset > _file.size() ||
+       (section.recordSize != 0 && section.count > (_file.size() - section.offset) / section.recordSize))
+      throw std::runtime_error(error + "section " + std::to_string(section.type) + " out of bounds.");
+  }
+}
+
+const BinarySfMDataFile::Section* BinarySfMDataFile::findSection(std::uint32_t type) const
+{
+  for(const Section& section : _sections)
+  {
+    if(section.type == type)
+      return &section;
+  }
+  return nullptr;
+}
+
+void BinarySfMDataFile::load(sfmData::SfMData& sfmData, ESfMData partFlag) const
+{
+  // load flags
+  const bool loadViews = (partFlag & VIEWS) == VIEWS;
+  const bool loadIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool loadExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool loadStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool loadObservations = (partFlag & OBSERVATIONS) == OBSERVATIONS;
+  const bool loadControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+
+  const RecordArray<char> strings(_file, findSection(SECTION_STRINGS));
+
+  // folders
+  {
+    const RecordArray<StringRecord> featuresFolders(_file, findSection(SECTION_FEATURES_FOLDERS));
+    for(std::size_t i = 0; i < featuresFolders.size(); ++i)
+      sfmData.addFeaturesFolder(readString(strings, featuresFolders[i]));
+
+    const RecordArray<StringRecord> matchesFolders(_file, findSection(SECTION_MATCHES_FOLDERS));
+    for(std::size_t i = 0; i < matchesFolders.size(); ++i)
+      sfmData.addMatchesFolder(readString(strings, matchesFolders[i]));
+  }
+
+  // views
+  if(loadViews)
+  {
+    const RecordArray<ViewRecord> viewRecords(_file, findSection(SECTION_VIEWS));
+    const RecordArray<MetadataRecord> metadataRecords(_file, findSection(SECTION_VIEWS_METADATA));
+    sfmData::Views& views = sfmData.getViews();
+
+    for(std::size_t i = 0; i < viewRecords.size(); ++i)
+    {
+      const ViewRecord record = viewRecords[i];
+      std::shared_ptr<sfmData::View> view = std::make_shared<sfmData::View>(readString(strings, record.path),
+                                                                           record.viewId,
+                                                                           record.intrinsicId,
+                                                                           record.poseId,
+                                                                           record.width,
+                                                                           record.height,
+                                                                           record.rigId,
+                                                                           record.subPoseId);
+      view->setResectionId(record.resectionId);
+
+      metadataRecords.checkRange(record.metadataBegin, record.metadataCount);
+      for(std::uint64_t m = record.metadataBegin; m < record.metadataBegin + record.metadataCount; ++m)
+      {
+        const MetadataRecord metadata = metadataRecords[m];
+        view->addMetadata(readString(strings, metadata.key), readString(strings, metadata.value));
+      }
+
+      views.emplace(record.viewId, view);
+    }
+  }
+
+  // intrinsics
+  if(loadIntrinsics)
+  {
+    const RecordArray<IntrinsicRecord> intrinsicRecords(_file, findSection(SECTION_INTRINSICS));
+    const RecordArray<double> paramsRecords(_file, findSection(SECTION_INTRINSICS_PARAMS));
+    sfmData::Intrinsics& intrinsics = sfmData.getIntrinsics();
+
+    for(std::size_t i = 0; i < intrinsicRecords.size(); ++i)
+    {
+      const IntrinsicRecord record = intrinsicRecords[i];
+      const camera::EINTRINSIC intrinsicType = static_cast<camera::EINTRINSIC>(record.type);
+
+      // check if the camera is a Pinhole model
+      if(!camera::isPinhole(intrinsicType))
+        throw std::out_of_range("Only Pinhole camera model supported");
+
+      std::shared_ptr<camera::Pinhole> pinholeIntrinsic = camera::createPinholeIntrinsic(intrinsicType, record.width, record.height);
+      pinholeIntrinsic->setInitialFocalLengthPix(record.pxInitialFocalLength);
+      pinholeIntrinsic->setSerialNumber(readString(strings, record.serialNumber));
+
+      paramsRecords.checkRange(record.paramsBegin, record.paramsCount);
+      std::vector<double> params(record.paramsCount);
+      for(std::uint64_t p = 0; p < record.paramsCount; ++p)
+        params[p] = paramsRecords[record.paramsBegin + p];
+
+      if(!pinholeIntrinsic->updateFromParams(params))
+        throw std::runtime_error("Invalid binary SfMData file '" + _file.path() + "': wrong number of parameters for intrinsic " + std::to_string(record.intrinsicId) + ".");
+
+      if(record.locked)
+        pinholeIntrinsic->lock();
+      else
+        pinholeIntrinsic->unlock();
+
+      intrinsics.emplace(record.intrinsicId, std::static_pointer_cast<camera::IntrinsicBase>(pinholeIntrinsic));
+    }
+  }
+
+  // extrinsics
+  if(loadExtrinsics)
+  {
+    const RecordArray<PoseRecord> poseRecords(_file, findSection(SECTION_POSES));
+    sfmData::Poses& poses = sfmData.getPoses();
+
+    for(std::size_t i = 0; i < poseRecords.size(); ++i)
+    {
+      const PoseRecord record = poseRecords[i];
+      poses.emplace(record.poseId, sfmData::CameraPose(readPose(record.rotation, record.center), record.locked != 0));
+    }
+
+    const RecordArray<RigRecord> rigRecords(_file, findSection(SECTION_RIGS));
+    const RecordArray<RigSubPoseRecord> subPoseRecords(_file, findSection(SECTION_RIGS_SUBPOSES));
+    sfmData::Rigs& rigs = sfmData.getRigs();
+
+    for(std::size_t i = 0; i < rigRecords.size(); ++i)
+    {
+      const RigRecord record = rigRecords[i];
+      subPoseRecords.checkRange(record.subPosesBegin, record.subPosesCount);
+
+      sfmData::Rig rig(record.subPosesCount);
+      for(std::uint64_t s = 0; s < record.subPosesCount; ++s)
+      {
+        const RigSubPoseRecord subPose = subPoseRecords[record.subPosesBegin + s];
+        rig.setSubPose(s, sfmData::RigSubPose(readPose(subPose.rotation, subPose.center), static_cast<sfmData::ERigSubPoseStatus>(subPose.status)));
+      }
+      rigs.emplace(record.rigId, rig);
+    }
+  }
+
+  // structure
+  if(loadStructure)
+  {
+    readLandmarks(RecordArray<LandmarkRecord>(_file, findSection(SECTION_LANDMARKS)),
+                  RecordArray<ObservationRecord>(_file, loadObservations ? findSection(SECTION_OBSERVATIONS) : nullptr),
+                  sfmData.getLandmarks(), loadObservations);
+  }
+
+  // control points
+  if(loadControlPoints)
+  {
+    readLandmarks(RecordArray<LandmarkRecord>(_file, findSection(SECTION_CONTROL_POINTS)),
+                  RecordArray<ObservationRecord>(_file, findSection(SECTION_CONTROL_POINTS_OBSERVATIONS)),
+                  sfmData.getControlPoints(), true);
+  }
+}
+
+std::size_t BinarySfMDataFile::getNbLandmarks() const
+{
+  const Section* section = findSection(SECTION_LANDMARKS);
+  return (section == nullptr) ? 0 : section->count;
+}
+
+void BinarySfMDataFile::getLandmark(std::size_t index, IndexT& landmarkId, sfmData::Landmark& landmark, bool withObservations) const
+{
+  const RecordArray<LandmarkRecord> landmarkRecords(_file, findSection(SECTION_LANDMARKS));
+  landmarkRecords.checkRange(index, 1);
+
+  const LandmarkRecord record = landmarkRecords[index];
+  landmarkId = record.landmarkId;
+  readLandmark(record, RecordArray<ObservationRecord>(_file, withObservations ? findSection(SECTION_OBSERVATIONS) : nullptr), landmark, withObservations);
+}
+
+bool saveBinary(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  if(!isLittleEndian())
+  {
+    ALICEVISION_LOG_ERROR("Binary SfMData files are not supported on big-endian platforms.");
+    return false;
+  }
+
+  // save flags
+  const bool saveViews = (partFlag & VIEWS) == VIEWS;
+  const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool saveObservations = (partFlag & OBSERVATIONS) == OBSERVATIONS;
+  const bool saveControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+
+  // the small sections are built in memory, the landmarks are written directly
+  std::string strings;
+  const auto addString = [&strings](const std::string& str)
+  {
+    const StringRecord record = {static_cast<std::uint64_t>(strings.size()), static_cast<std::uint64_t>(str.size())};
+    strings += str;
+    return record;
+  };
+
+  // folders
+  std::vector<StringRecord> featuresFolders;
+  for(const std::string& featuresFolder : sfmData.getRelativeFeaturesFolders())
+    featuresFolders.push_back(addString(featuresFolder));
+
+  std::vector<StringRecord> matchesFolders;
+  for(const std::string& matchesFolder : sfmData.getRelativeMatchesFolders())
+    matchesFolders.push_back(addString(matchesFolder));
+
+  // views
+  std::vector<ViewRecord> views;
+  std::vector<MetadataRecord> metadata;
+  if(saveViews)
+  {
+    views.reserve(sfmData.getViews().size());
+    for(const auto& viewPair : sfmData.getViews())
+    {
+      const sfmData::View& view = *(viewPair.second);
+
+      ViewRecord record = {};
+      record.viewId = view.getViewId();
+      record.intrinsicId = view.getIntrinsicId();
+      record.poseId = view.getPoseId();
+      record.rigId = view.getRigId();
+      record.subPoseId = view.getSubPoseId();
+      record.resectionId = view.getResectionId();
+      record.width = view.getWidth();
+      record.height = view.getHeight();
+      record.path = addString(view.getImagePath());
+      record.metadataBegin = metadata.size();
+      record.metadataCount = view.getMetadata().size();
+      views.push_back(record);
+
+      for(const auto& metadataPair : view.getMetadata())
+        metadata.push_back({addString(metadataPair.first), addString(metadataPair.second)});
+    }
+  }
+
+  // intrinsics
+  std::vector<IntrinsicRecord> intrinsics;
+  std::vector<double> intrinsicsParams;
+  if(saveIntrinsics)
+  {
+    intrinsics.reserve(sfmData.getIntrinsics().size());
+    for(const auto& intrinsicPair : sfmData.getIntrinsics())
+    {
+      const camera::IntrinsicBase& intrinsic = *(intrinsicPair.second);
+      const std::vector<double> params = intrinsic.getParams();
+
+      IntrinsicRecord record = {};
+      record.intrinsicId = intrinsicPair.first;
+      record.type = static_cast<std::uint32_t>(intrinsic.getType());
+      record.width = intrinsic.w();
+      record.height = intrinsic.h();
+      record.pxInitialFocalLength = intrinsic.initialFocalLengthPix();
+      record.serialNumber = addString(intrinsic.serialNumber());
+      record.paramsBegin = intrinsicsParams.size();
+      record.paramsCount = params.size();
+      record.locked = intrinsic.isLocked() ? 1 : 0;
+      intrinsics.push_back(record);
+
+      intrinsicsParams.insert(intrinsicsParams.end(), params.begin(), params.end());
+    }
+  }
+
+  // extrinsics
+  std::vector<PoseRecord> poses;
+  std::vector<RigRecord> rigs;
+  std::vector<RigSubPoseRecord> rigsSubPoses;
+  if(saveExtrinsics)
+  {
+    poses.reserve(sfmData.getPoses().size());
+    for(const auto& posePair : sfmData.getPoses())
+    {
+      PoseRecord record = {};
+      record.poseId = posePair.first;
+      record.locked = posePair.second.isLocked() ? 1 : 0;
+      writePose(posePair.second.getTransform(), record.rotation, record.center);
+      poses.push_back(record);
+    }
+
+    for(const auto& rigPair : sfmData.getRigs())
+    {
+      const std::vector<sfmData::RigSubPose>& subPoses = rigPair.second.getSubPoses();
+
+      RigRecord record = {};
+      record.rigId = rigPair.first;
+      record.subPosesBegin = rigsSubPoses.size();
+      record.subPosesCount = subPoses.size();
+      rigs.push_back(record);
+
+      for(const sfmData::RigSubPose& subPose : subPoses)
+      {
+        RigSubPoseRecord subPoseRecord = {};
+        subPoseRecord.status = static_cast<std::uint32_t>(subPose.status);
+        writePose(subPose.pose, subPoseRecord.rotation, subPoseRecord.center);
+        rigsSubPoses.push_back(subPoseRecord);
+      }
+    }
+  }
+
+  // file layout
+  std::vector<SectionWriter> sections;
+  const auto addSection = [&sections](std::uint32_t type, std::uint32_t recordSize, std::uint64_t count, std::function<void(std::ostream&)> write)
+  {
+    sections.push_back({{type, recordSize, 0, count}, write});
+  };
+
+  addSection(SECTION_STRINGS, 1, strings.size(), [&strings](std::ostream& stream){ stream.write(strings.data(), strings.size()); });
+  sections.push_back(recordsSection(SECTION_FEATURES_FOLDERS, featuresFolders));
+  sections.push_back(recordsSection(SECTION_MATCHES_FOLDERS, matchesFolders));
+
+  if(saveViews)
+  {
+    sections.push_back(recordsSection(SECTION_VIEWS, views));
+    sections.push_back(recordsSection(SECTION_VIEWS_METADATA, metadata));
+  }
+
+  if(saveIntrinsics)
+  {
+    sections.push_back(recordsSection(SECTION_INTRINSICS, intrinsics));
+    sections.push_back(recordsSection(SECTION_INTRINSICS_PARAMS, intrinsicsParams));
+  }
+
+  if(saveExtrinsics)
+  {
+    sections.push_back(recordsSection(SECTION_POSES, poses));
+    sections.push_back(recordsSection(SECTION_RIGS, rigs));
+    sections.push_back(recordsSection(SECTION_RIGS_SUBPOSES, rigsSubPoses));
+  }
+
+  if(saveStructure)
+  {
+    const sfmData::Landmarks& landmarks = sfmData.getLandmarks();
+    addSection(SECTION_LANDMARKS, sizeof(LandmarkRecord), landmarks.size(),
+               [&landmarks, saveObservations](std::ostream& stream){ writeLandmarks(stream, landmarks, saveObservations); });
+    if(saveObservations)
+      addSection(SECTION_OBSERVATIONS, sizeof(ObservationRecord), countObservations(landmarks),
+                 [&landmarks](std::ostream& stream){ writeObservations(stream, landmarks); });
+  }
+
+  if(saveControlPoints)
+  {
+    const sfmData::Landmarks& controlPoints = sfmData.getControlPoints();
+    addSection(SECTION_CONTROL_POINTS, sizeof(LandmarkRecord), controlPoints.size(),
+               [&controlPoints](std::ostream& stream){ writeLandmarks(stream, controlPoints, true); });
+    addSection(SECTION_CONTROL_POINTS_OBSERVATIONS, sizeof(ObservationRecord), countObservations(controlPoints),
+               [&controlPoints](std::ostream& stream){ writeObservations(stream, controlPoints); });
+  }
+
+  std::uint64_t offset = align8(sizeof(FileHeader) + sections.size() * sizeof(BinarySfMDataFile::Section));
+  for(SectionWriter& sectionWriter : sections)
+  {
+    sectionWriter.section.offset = offset;
+    offset = align8(offset + sectionWriter.section.count * sectionWriter.section.recordSize);
+  }
+
+  // write
+  std::vector<char> buffer(1024 * 1024);
+  std::ofstream stream;
+  stream.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+  stream.open(filename, std::ios::out | std::ios::binary);
+
+  if(!stream.is_open())
+  {
+    ALICEVISION_LOG_ERROR("Cannot open the SfMData file '" << filename << "' for writing.");
+    return false;
+  }
+
+  FileHeader header = {};
+  std::memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+  header.version = binaryVersion;
+  header.nbSections = sections.size();
+  writeRecord(stream, header);
+
+  std::uint64_t position = sizeof(FileHeader);
+  for(const SectionWriter& sectionWriter : sections)
+  {
+    writeRecord(stream, sectionWriter.section);
+    position += sizeof(BinarySfMDataFile::Section);
+  }
+
+  const char padding[8] = {};
+  for(const SectionWriter& sectionWriter : sections)
+  {
+    stream.write(padding, sectionWriter.section.offset - position);
+    sectionWriter.write(stream);
+    position = sectionWriter.section.offset + sectionWriter.section.count * sectionWriter.section.recordSize;
+  }
+
+  stream.close();
+
+  if(!stream)
+  {
+    ALICEVISION_LOG_ERROR("Cannot write the SfMData file '" << filename << "'.");
+    return false;
+  }
+  return true;
+}
+
+bool loadBinary(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  BinarySfMDataFile(filename).load(sfmData, partFlag);
+  return true;
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
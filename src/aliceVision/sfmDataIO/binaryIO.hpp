@@ -0,0 +1,104 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/system/MappedFile.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+// AliceVision binary SfMData file (.sfmb), little-endian:
+// -- Header
+// magic "AVSFMBIN", version (uint32), number of sections (uint32)
+// -- Section table
+// [type (uint32), record size (uint32), offset (uint64), number of records (uint64)]
+// -- Sections (8 bytes aligned)
+// each section is a contiguous array of fixed size records:
+// strings, features / matches folders, views, views metadata, intrinsics,
+// intrinsics parameters, poses, rigs, rigs sub-poses, landmarks, observations,
+// control points, control points observations.
+// Strings are stored in the strings section and referenced by [offset, size],
+// variable length lists (metadata, parameters, sub-poses, observations) are
+// stored in their own section and referenced by [first record, number of records].
+// --
+// Only the sections needed by the load flags are read: as the file is memory-mapped,
+// the other sections (typically the landmarks and their observations) are never touched.
+
+/**
+ * @brief Random access to a binary SfMData file.
+ *        The file is memory-mapped, the records are decoded on demand.
+ */
+class BinarySfMDataFile
+{
+public:
+  /**
+   * @brief Open a binary SfMData file and read its section table.
+   * @param[in] filename The filename
+   * @throw std::runtime_error if the file is not a valid binary SfMData file
+   */
+  explicit BinarySfMDataFile(const std::string& filename);
+
+  /**
+   * @brief Load the SfMData parts selected by the flags.
+   * @param[out] sfmData The output SfMData
+   * @param[in] partFlag The ESfMData load flag
+   */
+  void load(sfmData::SfMData& sfmData, ESfMData partFlag) const;
+
+  /// @return the number of landmarks stored in the file
+  std::size_t getNbLandmarks() const;
+
+  /**
+   * @brief Read a single landmark.
+   * @param[in] index The landmark index in the file, in [0, getNbLandmarks()[
+   * @param[out] landmarkId The landmark id
+   * @param[out] landmark The landmark
+   * @param[in] withObservations Read the landmark observations
+   */
+  void getLandmark(std::size_t index, IndexT& landmarkId, sfmData::Landmark& landmark, bool withObservations) const;
+
+  struct Section
+  {
+    std::uint32_t type;
+    std::uint32_t recordSize;
+    std::uint64_t offset;
+    std::uint64_t count;
+  };
+
+private:
+  /// @return the section of the given type or nullptr if it is not in the file
+  const Section* findSection(std::uint32_t type) const;
+
+  system::MappedFile _file;
+  std::vector<Section> _sections;
+};
+
+/**
+ * @brief Save SfMData in a binary file.
+ * @param[in] sfmData The input SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData save flag
+ * @return true if completed
+ */
+bool saveBinary(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+/**
+ * @brief Load a binary SfMData file.
+ * @param[out] sfmData The output SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData load flag
+ * @return true if completed
+ */
+bool loadBinary(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -6,81 +6,19 @@
 
 #include "jsonIO.hpp"
 #include <aliceVision/camera/camera.hpp>
+#include <aliceVision/sfmDataIO/JsonReader.hpp>
+#include <aliceVision/sfmDataIO/JsonWriter.hpp>
 #include <aliceVision/sfmDataIO/viewIO.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MappedFile.hpp>
 
-#include <boost/property_tree/json_parser.hpp>
-
+#include <fstream>
 #include <memory>
 #include <cassert>
 
 namespace aliceVision {
 namespace sfmDataIO {
 
-void saveView(const std::string& name, const sfmData::View& view, bpt::ptree& parentTree)
-{
-  bpt::ptree viewTree;
-
-  if(view.getViewId() != UndefinedIndexT)
-    viewTree.put("viewId", view.getViewId());
-
-  if(view.getPoseId() != UndefinedIndexT)
-    viewTree.put("poseId", view.getPoseId());
-
-  if(view.isPartOfRig())
-  {
-    viewTree.put("rigId", view.getRigId());
-    viewTree.put("subPoseId", view.getSubPoseId());
-  }
-
-  if(view.getIntrinsicId() != UndefinedIndexT)
-    viewTree.put("intrinsicId", view.getIntrinsicId());
-
-  if(view.getResectionId() != UndefinedIndexT)
-    viewTree.put("resectionId", view.getResectionId());
-
-  viewTree.put("path", view.getImagePath());
-  viewTree.put("width", view.getWidth());
-  viewTree.put("height", view.getHeight());
-
-  // metadata
-  {
-    bpt::ptree metadataTree;
-
-    for(const auto& metadataPair : view.getMetadata())
-      metadataTree.put(metadataPair.first, metadataPair.second);
-
-    viewTree.add_child("metadata", metadataTree);
-  }
-
-  parentTree.push_back(std::make_pair(name, viewTree));
-}
-
-void loadView(sfmData::View& view, bpt::ptree& viewTree)
-{
-  view.setViewId(viewTree.get<IndexT>("viewId", UndefinedIndexT));
-  view.setPoseId(viewTree.get<IndexT>("poseId", UndefinedIndexT));
-
-  if(viewTree.count("rigId"))
-  {
-    view.setRigAndSubPoseId(
-      viewTree.get<IndexT>("rigId"),
-      viewTree.get<IndexT>("subPoseId"));
-  }
-
-  view.setIntrinsicId(viewTree.get<IndexT>("intrinsicId", UndefinedIndexT));
-  view.setResectionId(viewTree.get<IndexT>("resectionId", UndefinedIndexT));
-
-  view.setImagePath(viewTree.get<std::string>("path"));
-  view.setWidth(viewTree.get<std::size_t>("width", 0));
-  view.setHeight(viewTree.get<std::size_t>("height", 0));
-
-  // metadata
-  if(viewTree.count("metadata"))
-    for(bpt::ptree::value_type &metaDataNode : viewTree.get_child("metadata"))
-      view.addMetadata(metaDataNode.first, metaDataNode.second.data());
-
-}
-
 void saveIntrinsic(const std::string& name, IndexT intrinsicId, const std::shared_ptr<camera::IntrinsicBase>& intrinsic, bpt::ptree& parentTree)
 {
   bpt::ptree intrinsicTree;
@@ -156,102 +94,521 @@ void loadIntrinsic(IndexT& intrinsicId, std::shared_ptr<camera::IntrinsicBase>&
     intrinsic->unlock();
 }
 
-void saveRig(const std::string& name, IndexT rigId, const sfmData::Rig& rig, bpt::ptree& parentTree)
+namespace {
+
+template<typename Derived>
+void writeMatrix(JsonWriter& writer, const char* name, const Eigen::MatrixBase<Derived>& matrix)
 {
-  bpt::ptree rigTree;
+  writer.key(name);
+  writer.beginArray();
+  for(int i = 0; i < matrix.size(); ++i)
+    writer.value(matrix(i));
+  writer.endArray();
+}
 
-  rigTree.put("rigId", rigId);
+template<typename Derived>
+void readMatrix(JsonReader& reader, Eigen::MatrixBase<Derived>& matrix)
+{
+  int i = 0;
+  reader.beginArray();
+  while(reader.nextElement())
+  {
+    if(i >= matrix.size())
+      reader.error("invalid matrix / vector size");
+    matrix(i++) = reader.read<typename Derived::Scalar>();
+  }
+}
 
-  bpt::ptree rigSubPosesTree;
+void writePose3(JsonWriter& writer, const char* name, const geometry::Pose3& pose)
+{
+  writer.key(name);
+  writer.beginObject();
+  writeMatrix(writer, "rotation", pose.rotation());
+  writeMatrix(writer, "center", pose.center());
+  writer.endObject();
+}
 
-  for(const auto& rigSubPose : rig.getSubPoses())
+void readPose3(JsonReader& reader, geometry::Pose3& pose)
+{
+  Mat3 rotation = Mat3::Identity();
+  Vec3 center = Vec3::Zero();
+  std::string key;
+
+  reader.beginObject();
+  while(reader.nextMember(key))
   {
-    bpt::ptree rigSubPoseTree;
+    if(key == "rotation")
+      readMatrix(reader, rotation);
+    else if(key == "center")
+      readMatrix(reader, center);
+    else
+      reader.skipValue();
+  }
+
+  pose = geometry::Pose3(rotation, center);
+}
+
+void writeView(JsonWriter& writer, const sfmData::View& view)
+{
+  writer.beginObject();
 
-    rigSubPoseTree.put("status", sfmData::ERigSubPoseStatus_enumToString(rigSubPose.status));
-    savePose3("pose", rigSubPose.pose, rigSubPoseTree);
+  if(view.getViewId() != UndefinedIndexT)
+    writer.member("viewId", view.getViewId());
+
+  if(view.getPoseId() != UndefinedIndexT)
+    writer.member("poseId", view.getPoseId());
 
-    rigSubPosesTree.push_back(std::make_pair("", rigSubPoseTree));
+  if(view.isPartOfRig())
+  {
+    writer.member("rigId", view.getRigId());
+    writer.member("subPoseId", view.getSubPoseId());
   }
 
-  rigTree.add_child("subPoses", rigSubPosesTree);
+  if(view.getIntrinsicId() != UndefinedIndexT)
+    writer.member("intrinsicId", view.getIntrinsicId());
+
+  if(view.getResectionId() != UndefinedIndexT)
+    writer.member("resectionId", view.getResectionId());
+
+  writer.member("path", view.getImagePath());
+  writer.member("width", view.getWidth());
+  writer.member("height", view.getHeight());
 
-  parentTree.push_back(std::make_pair(name, rigTree));
+  // metadata
+  writer.key("metadata");
+  writer.beginObject();
+  for(const auto& metadataPair : view.getMetadata())
+  {
+    writer.key(metadataPair.first);
+    writer.value(metadataPair.second);
+  }
+  writer.endObject();
+
+  writer.endObject();
 }
 
+/// nested objects are flattened with '.' separated keys, as property_tree paths
+void readMetadata(JsonReader& reader, const std::string& prefix, sfmData::View& view)
+{
+  std::string key;
+
+  reader.beginObject();
+  while(reader.nextMember(key))
+  {
+    if(reader.isObject())
+      readMetadata(reader, prefix + key + ".", view);
+    else if(reader.isArray())
+      reader.skipValue();
+    else
+      view.addMetadata(prefix + key, reader.readString());
+  }
+}
 
-void loadRig(IndexT& rigId, sfmData::Rig& rig, bpt::ptree& rigTree)
+void readView(JsonReader& reader, sfmData::View& view)
 {
-  rigId =  rigTree.get<IndexT>("rigId");
-  rig = sfmData::Rig(rigTree.get_child("subPoses").size());
-  int subPoseId = 0;
+  IndexT rigId = UndefinedIndexT;
+  IndexT subPoseId = UndefinedIndexT;
+  bool hasPath = false;
+  std::string key;
+
+  reader.beginObject();
+  while(reader.nextMember(key))
+  {
+    if(key == "viewId")
+      view.setViewId(reader.read<IndexT>());
+    else if(key == "poseId")
+      view.setPoseId(reader.read<IndexT>());
+    else if(key == "rigId")
+      rigId = reader.read<IndexT>();
+    else if(key == "subPoseId")
+      subPoseId = reader.read<IndexT>();
+    else if(key == "intrinsicId")
+      view.setIntrinsicId(reader.read<IndexT>());
+    else if(key == "resectionId")
+      view.setResectionId(reader.read<IndexT>());
+    else if(key == "path")
+    {
+      view.setImagePath(reader.readString());
+      hasPath = true;
+    }
+    else if(key == "width")
+      view.setWidth(reader.read<std::size_t>());
+    else if(key == "height")
+      view.setHeight(reader.read<std::size_t>());
+    else if(key == "metadata")
+      readMetadata(reader, "", view);
+    else
+      reader.skipValue();
+  }
+
+  if(!hasPath)
+    reader.error("view without path");
 
-  for(bpt::ptree::value_type& subPoseNode : rigTree.get_child("subPoses"))
+  if(rigId != UndefinedIndexT)
   {
-    bpt::ptree& subPoseTree = subPoseNode.second;
+    if(subPoseId == UndefinedIndexT)
+      reader.error("view " + std::to_string(view.getViewId()) + " has a rig but no sub-pose");
+    view.setRigAndSubPoseId(rigId, subPoseId);
+  }
+}
 
-    sfmData::RigSubPose subPose;
+void writeIntrinsic(JsonWriter& writer, IndexT intrinsicId, const camera::IntrinsicBase& intrinsic)
+{
+  const camera::EINTRINSIC intrinsicType = intrinsic.getType();
 
-    subPose.status = sfmData::ERigSubPoseStatus_stringToEnum(subPoseTree.get<std::string>("status"));
-    loadPose3("pose", subPose.pose, subPoseTree);
+  writer.beginObject();
+  writer.member("intrinsicId", intrinsicId);
+  writer.member("width", intrinsic.w());
+  writer.member("height", intrinsic.h());
+  writer.member("type", camera::EINTRINSIC_enumToString(intrinsicType));
+  writer.member("serialNumber", intrinsic.serialNumber());
+  writer.member("pxInitialFocalLength", intrinsic.initialFocalLengthPix());
 
-    rig.setSubPose(subPoseId++, subPose);
+  if(camera::isPinhole(intrinsicType))
+  {
+    const camera::Pinhole& pinholeIntrinsic = dynamic_cast<const camera::Pinhole&>(intrinsic);
+
+    writer.member("pxFocalLength", pinholeIntrinsic.getFocalLengthPix());
+    writeMatrix(writer, "principalPoint", pinholeIntrinsic.getPrincipalPoint());
+
+    writer.key("distortionParams");
+    writer.beginArray();
+    for(double param : pinholeIntrinsic.getDistortionParams())
+      writer.value(param);
+    writer.endArray();
   }
+
+  writer.member("locked", intrinsic.isLocked());
+  writer.endObject();
 }
 
-void saveLandmark(const std::string& name, IndexT landmarkId, const sfmData::Landmark& landmark, bpt::ptree& parentTree)
+void readIntrinsic(JsonReader& reader, IndexT& intrinsicId, std::shared_ptr<camera::IntrinsicBase>& intrinsic)
 {
-  bpt::ptree landmarkTree;
+  // members needed to create the intrinsic
+  enum : unsigned int
+  {
+    INTRINSIC_ID = 1 << 0,
+    WIDTH = 1 << 1,
+    HEIGHT = 1 << 2,
+    TYPE = 1 << 3,
+    SERIAL_NUMBER = 1 << 4,
+    INITIAL_FOCAL_LENGTH = 1 << 5,
+    FOCAL_LENGTH = 1 << 6,
+    PRINCIPAL_POINT = 1 << 7,
+    DISTORTION_PARAMS = 1 << 8,
+    ALL_MEMBERS = (1 << 9) - 1
+  };
+
+  unsigned int members = 0;
+  unsigned int width = 0;
+  unsigned int height = 0;
+  camera::EINTRINSIC intrinsicType = camera::PINHOLE_CAMERA;
+  std::string serialNumber;
+  double pxInitialFocalLength = 0.0;
+  double pxFocalLength = 0.0;
+  Vec2 principalPoint = Vec2::Zero();
+  std::vector<double> distortionParams;
+  bool locked = false;
+  std::string key;
 
-  landmarkTree.put("landmarkId", landmarkId);
-  landmarkTree.put("descType", feature::EImageDescriberType_enumToString(landmark.descType));
+  reader.beginObject();
+  while(reader.nextMember(key))
+  {
+    if(key == "intrinsicId")
+    {
+      intrinsicId = reader.read<IndexT>();
+      members |= INTRINSIC_ID;
+    }
+    else if(key == "width")
+    {
+      width = reader.read<unsigned int>();
+      members |= WIDTH;
+    }
+    else if(key == "height")
+    {
+      height = reader.read<unsigned int>();
+      members |= HEIGHT;
+    }
+    else if(key == "type")
+    {
+      intrinsicType = camera::EINTRINSIC_stringToEnum(reader.readString());
+      members |= TYPE;
+    }
+    else if(key == "serialNumber")
+    {
+      reader.readString(serialNumber);
+      members |= SERIAL_NUMBER;
+    }
+    else if(key == "pxInitialFocalLength")
+    {
+      pxInitialFocalLength = reader.read<double>();
+      members |= INITIAL_FOCAL_LENGTH;
+    }
+    else if(key == "pxFocalLength")
+    {
+      pxFocalLength = reader.read<double>();
+      members |= FOCAL_LENGTH;
+    }
+    else if(key == "principalPoint")
+    {
+      readMatrix(reader, principalPoint);
+      members |= PRINCIPAL_POINT;
+    }
+    else if(key == "distortionParams")
+    {
+      reader.beginArray();
+      while(reader.nextElement())
+        distortionParams.push_back(reader.read<double>());
+      members |= DISTORTION_PARAMS;
+    }
+    else if(key == "locked")
+      locked = reader.read<bool>();
+    else
+      reader.skipValue();
+  }
 
-  saveMatrix("color", landmark.rgb, landmarkTree);
-  saveMatrix("X", landmark.X, landmarkTree);
+  if(members != ALL_MEMBERS)
+    reader.error("incomplete intrinsic");
 
-  // observations
-  bpt::ptree observationsTree;
-  for(const auto& obsPair : landmark.observations)
+  // check if the camera is a Pinhole model
+  if(!camera::isPinhole(intrinsicType))
+    throw std::out_of_range("Only Pinhole camera model supported");
+
+  // pinhole parameters
+  std::shared_ptr<camera::Pinhole> pinholeIntrinsic = camera::createPinholeIntrinsic(intrinsicType, width, height, pxFocalLength, principalPoint(0), principalPoint(1));
+  pinholeIntrinsic->setInitialFocalLengthPix(pxInitialFocalLength);
+  pinholeIntrinsic->setSerialNumber(serialNumber);
+
+  // Ensure that we have the right number of params
+  distortionParams.resize(pinholeIntrinsic->getDistortionParams().size(), 0.0);
+
+  pinholeIntrinsic->setDistortionParams(distortionParams);
+  intrinsic = std::static_pointer_cast<camera::IntrinsicBase>(pinholeIntrinsic);
+
+  // intrinsic lock
+  if(locked)
+    intrinsic->lock();
+  else
+    intrinsic->unlock();
+}
+
+void writeCameraPose(JsonWriter& writer, IndexT poseId, const sfmData::CameraPose& cameraPose)
+{
+  writer.beginObject();
+  writer.member("poseId", poseId);
+  writer.key("pose");
+  writer.beginObject();
+  writePose3(writer, "transform", cameraPose.getTransform());
+  writer.member("locked", cameraPose.isLocked());
+  writer.endObject();
+  writer.endObject();
+}
+
+void readCameraPose(JsonReader& reader, IndexT& poseId, sfmData::CameraPose& cameraPose)
+{
+  bool hasPoseId = false;
+  std::string key;
+
+  reader.beginObject();
+  while(reader.nextMember(key))
   {
-    bpt::ptree obsTree;
+    if(key == "poseId")
+    {
+      poseId = reader.read<IndexT>();
+      hasPoseId = true;
+    }
+    else if(key == "pose")
+    {
+      reader.beginObject();
+      while(reader.nextMember(key))
+      {
+        if(key == "transform")
+        {
+          geometry::Pose3 pose;
+          readPose3(reader, pose);
+          cameraPose.setTransform(pose);
+        }
+        else if(key == "locked")
+        {
+          if(reader.read<bool>())
+            cameraPose.lock();
+          else
+            cameraPose.unlock();
+        }
+        else
+          reader.skipValue();
+      }
+    }
+    else
+      reader.skipValue();
+  }
 
-    const sfmData::Observation& observation = obsPair.second;
+  if(!hasPoseId)
+    reader.error("pose without id");
+}
 
-    obsTree.put("observationId", obsPair.first);
-    obsTree.put("featureId", observation.id_feat);
+void writeRig(JsonWriter& writer, IndexT rigId, const sfmData::Rig& rig)
+{
+  writer.beginObject();
+  writer.member("rigId", rigId);
 
-    saveMatrix("x", observation.x, obsTree);
+  writer.key("subPoses");
+  writer.beginArray();
+  for(const auto& rigSubPose : rig.getSubPoses())
+  {
+    writer.beginObject();
+    writer.member("status", sfmData::ERigSubPoseStatus_enumToString(rigSubPose.status));
+    writePose3(writer, "pose", rigSubPose.pose);
+    writer.endObject();
+  }
+  writer.endArray();
+
+  writer.endObject();
+}
+
+void readRig(JsonReader& reader, IndexT& rigId, sfmData::Rig& rig)
+{
+  bool hasRigId = false;
+  std::vector<sfmData::RigSubPose> subPoses;
+  std::string key;
 
-    observationsTree.push_back(std::make_pair("", obsTree));
+  reader.beginObject();
+  while(reader.nextMember(key))
+  {
+    if(key == "rigId")
+    {
+      rigId = reader.read<IndexT>();
+      hasRigId = true;
+    }
+    else if(key == "subPoses")
+    {
+      reader.beginArray();
+      while(reader.nextElement())
+      {
+        sfmData::RigSubPose subPose;
+
+        reader.beginObject();
+        while(reader.nextMember(key))
+        {
+          if(key == "status")
+            subPose.status = sfmData::ERigSubPoseStatus_stringToEnum(reader.readString());
+          else if(key == "pose")
+            readPose3(reader, subPose.pose);
+          else
+            reader.skipValue();
+        }
+        subPoses.push_back(subPose);
+      }
+    }
+    else
+      reader.skipValue();
   }
 
-  landmarkTree.add_child("observations", observationsTree);
+  if(!hasRigId)
+    reader.error("rig without id");
 
-  parentTree.push_back(std::make_pair(name, landmarkTree));
+  rig = sfmData::Rig(subPoses.size());
+  for(std::size_t subPoseId = 0; subPoseId < subPoses.size(); ++subPoseId)
+    rig.setSubPose(subPoseId, subPoses[subPoseId]);
 }
 
-void loadLandmark(IndexT& landmarkId, sfmData::Landmark& landmark, bpt::ptree& landmarkTree)
+void writeLandmark(JsonWriter& writer, IndexT landmarkId, const sfmData::Landmark& landmark, bool saveObservations)
 {
-  landmarkId = landmarkTree.get<IndexT>("landmarkId");
-  landmark.descType = feature::EImageDescriberType_stringToEnum(landmarkTree.get<std::string>("descType"));
+  writer.beginObject();
+  writer.member("landmarkId", landmarkId);
+  writer.member("descType", feature::EImageDescriberType_enumToString(landmark.descType));
 
-  loadMatrix("color", landmark.rgb, landmarkTree);
-  loadMatrix("X", landmark.X, landmarkTree);
+  writeMatrix(writer, "color", landmark.rgb);
+  writeMatrix(writer, "X", landmark.X);
 
   // observations
-  for(bpt::ptree::value_type &obsNode : landmarkTree.get_child("observations"))
+  if(saveObservations)
   {
-    bpt::ptree& obsTree = obsNode.second;
+    writer.key("observations");
+    writer.beginArray();
+    for(const auto& obsPair : landmark.observations)
+    {
+      const sfmData::Observation& observation = obsPair.second;
+
+      writer.beginObject();
+      writer.member("observationId", obsPair.first);
+      writer.member("featureId", observation.id_feat);
+      writeMatrix(writer, "x", observation.x);
+      writer.endObject();
+    }
+    writer.endArray();
+  }
 
-    sfmData::Observation observation;
+  writer.endObject();
+}
 
-    observation.id_feat = obsTree.get<IndexT>("featureId");
-    loadMatrix("x", observation.x, obsTree);
+void readLandmark(JsonReader& reader, IndexT& landmarkId, sfmData::Landmark& landmark, bool loadObservations)
+{
+  bool hasLandmarkId = false;
+  std::string key;
 
-    landmark.observations.emplace(obsTree.get<IndexT>("observationId"), observation);
+  reader.beginObject();
+  while(reader.nextMember(key))
+  {
+    if(key == "landmarkId")
+    {
+      landmarkId = reader.read<IndexT>();
+      hasLandmarkId = true;
+    }
+    else if(key == "descType")
+      landmark.descType = feature::EImageDescriberType_stringToEnum(reader.readString());
+    else if(key == "color")
+      readMatrix(reader, landmark.rgb);
+    else if(key == "X")
+      readMatrix(reader, landmark.X);
+    else if(key == "observations" && loadObservations)
+    {
+      reader.beginArray();
+      while(reader.nextElement())
+      {
+        IndexT observationId = UndefinedIndexT;
+        sfmData::Observation observation;
+
+        reader.beginObject();
+        while(reader.nextMember(key))
+        {
+          if(key == "observationId")
+            observationId = reader.read<IndexT>();
+          else if(key == "featureId")
+            observation.id_feat = reader.read<IndexT>();
+          else if(key == "x")
+            readMatrix(reader, observation.x);
+          else
+            reader.skipValue();
+        }
+
+        // observations are saved sorted by view id
+        landmark.observations.emplace_hint(landmark.observations.end(), observationId, observation);
+      }
+    }
+    else
+      reader.skipValue();
+  }
+
+  if(!hasLandmarkId)
+    reader.error("landmark without id");
+}
+
+void readLandmarks(JsonReader& reader, sfmData::Landmarks& landmarks, bool loadObservations)
+{
+  reader.beginArray();
+  while(reader.nextElement())
+  {
+    IndexT landmarkId;
+    sfmData::Landmark landmark;
+
+    readLandmark(reader, landmarkId, landmark, loadObservations);
+
+    landmarks.emplace(landmarkId, std::move(landmark));
   }
 }
 
+} // namespace
 
 bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
 {
@@ -262,63 +619,63 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
   const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
   const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
   const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool saveObservations = (partFlag & OBSERVATIONS) == OBSERVATIONS;
   const bool saveControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
 
-  // main tree
-  bpt::ptree fileTree;
+  std::vector<char> buffer(1024 * 1024);
+  std::ofstream stream;
+  stream.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+  stream.open(filename, std::ios::out | std::ios::binary);
+
+  if(!stream.is_open())
+  {
+    ALICEVISION_LOG_ERROR("Cannot open the SfMData file '" << filename << "' for writing.");
+    return false;
+  }
+
+  JsonWriter writer(stream);
+  writer.beginObject();
 
   // file version
-  saveMatrix("version", version, fileTree);
+  writeMatrix(writer, "version", version);
 
   // folders
   if(!sfmData.getRelativeFeaturesFolders().empty())
   {
-    bpt::ptree featureFoldersTree;
-
+    writer.key("featuresFolders");
+    writer.beginArray();
     for(const std::string& featuresFolder : sfmData.getRelativeFeaturesFolders())
-    {
-      bpt::ptree featureFolderTree;
-      featureFolderTree.put("", featuresFolder);
-      featureFoldersTree.push_back(std::make_pair("", featureFolderTree));
-    }
-
-    fileTree.add_child("featuresFolders", featureFoldersTree);
+      writer.value(featuresFolder);
+    writer.endArray();
   }
 
   if(!sfmData.getRelativeMatchesFolders().empty())
   {
-    bpt::ptree matchingFoldersTree;
-
+    writer.key("matchesFolders");
+    writer.beginArray();
     for(const std::string& matchesFolder : sfmData.getRelativeMatchesFolders())
-    {
-      bpt::ptree matchingFolderTree;
-      matchingFolderTree.put("", matchesFolder);
-      matchingFoldersTree.push_back(std::make_pair("", matchingFolderTree));
-    }
-
-    fileTree.add_child("matchesFolders", matchingFoldersTree);
+      writer.value(matchesFolder);
+    writer.endArray();
   }
 
   // views
   if(saveViews && !sfmData.getViews().empty())
   {
-    bpt::ptree viewsTree;
-
+    writer.key("views");
+    writer.beginArray();
     for(const auto& viewPair : sfmData.getViews())
-      saveView("", *(viewPair.second), viewsTree);
-
-    fileTree.add_child("views", viewsTree);
+      writeView(writer, *(viewPair.second));
+    writer.endArray();
   }
 
   // intrinsics
   if(saveIntrinsics && !sfmData.getIntrinsics().empty())
   {
-    bpt::ptree intrinsicsTree;
-
+    writer.key("intrinsics");
+    writer.beginArray();
     for(const auto& intrinsicPair : sfmData.getIntrinsics())
-      saveIntrinsic("", intrinsicPair.first, intrinsicPair.second, intrinsicsTree);
-
-    fileTree.add_child("intrinsics", intrinsicsTree);
+      writeIntrinsic(writer, intrinsicPair.first, *(intrinsicPair.second));
+    writer.endArray();
   }
 
   //extrinsics
@@ -327,58 +684,52 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
     // poses
     if(!sfmData.getPoses().empty())
     {
-      bpt::ptree posesTree;
-
+      writer.key("poses");
+      writer.beginArray();
       for(const auto& posePair : sfmData.getPoses())
-      {
-        bpt::ptree poseTree;
-
-        poseTree.put("poseId", posePair.first);
-        saveCameraPose("pose", posePair.second, poseTree);
-        posesTree.push_back(std::make_pair("", poseTree));
-      }
-
-      fileTree.add_child("poses", posesTree);
+        writeCameraPose(writer, posePair.first, posePair.second);
+      writer.endArray();
     }
 
     // rigs
     if(!sfmData.getRigs().empty())
     {
-      bpt::ptree rigsTree;
-
+      writer.key("rigs");
+      writer.beginArray();
       for(const auto& rigPair : sfmData.getRigs())
-        saveRig("", rigPair.first, rigPair.second, rigsTree);
-
-      fileTree.add_child("rigs", rigsTree);
+        writeRig(writer, rigPair.first, rigPair.second);
+      writer.endArray();
     }
   }
 
   // structure
   if(saveStructure && !sfmData.getLandmarks().empty())
   {
-    bpt::ptree structureTree;
-
+    writer.key("structure");
+    writer.beginArray();
     for(const auto& structurePair : sfmData.getLandmarks())
-      saveLandmark("", structurePair.first, structurePair.second, structureTree);
-
-    fileTree.add_child("structure", structureTree);
+      writeLandmark(writer, structurePair.first, structurePair.second, saveObservations);
+    writer.endArray();
   }
 
   // control points
   if(saveControlPoints && !sfmData.getControlPoints().empty())
   {
-    bpt::ptree controlPointTree;
-
+    writer.key("controlPoints");
+    writer.beginArray();
     for(const auto& controlPointPair : sfmData.getControlPoints())
-      saveLandmark("", controlPointPair.first, controlPointPair.second, controlPointTree);
-
-    fileTree.add_child("controlPoints", controlPointTree);
+      writeLandmark(writer, controlPointPair.first, controlPointPair.second, true);
+    writer.endArray();
   }
 
-  // write the json file with the tree
-
-  bpt::write_json(filename, fileTree);
+  writer.endObject();
+  stream.close();
 
+  if(!stream)
+  {
+    ALICEVISION_LOG_ERROR("Cannot write the SfMData file '" << filename << "'.");
+    return false;
+  }
   return true;
 }
 
@@ -391,166 +742,152 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
   const bool loadIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
   const bool loadExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
   const bool loadStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool loadObservations = (partFlag & OBSERVATIONS) == OBSERVATIONS;
   const bool loadControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
 
-  // main tree
-  bpt::ptree fileTree;
-
-  // read the json file and initialize the tree
-  bpt::read_json(filename, fileTree);
+  // the file is decoded while it is read, the sections that are not loaded are only skipped
+  const system::MappedFile file(filename);
+  const char* fileData = reinterpret_cast<const char*>(file.data());
+  JsonReader reader(fileData, fileData + file.size(), filename);
 
-  // version
-  loadMatrix("version", version, fileTree);
+  // views, when the intrinsics are needed to complete them
+  std::vector<sfmData::View> incompleteViewsVec;
 
-  // folders
-  if(fileTree.count("featuresFolders"))
-    for(bpt::ptree::value_type& featureFolderNode : fileTree.get_child("featuresFolders"))
-      sfmData.addFeaturesFolder(featureFolderNode.second.get_value<std::string>());
-
-  if(fileTree.count("matchesFolders"))
-    for(bpt::ptree::value_type& matchingFolderNode : fileTree.get_child("matchesFolders"))
-      sfmData.addMatchesFolder(matchingFolderNode.second.get_value<std::string>());
-
-  // intrinsics
-  if(loadIntrinsics && fileTree.count("intrinsics"))
+  std::string key;
+  reader.beginObject();
+  while(reader.nextMember(key))
   {
-    sfmData::Intrinsics& intrinsics = sfmData.getIntrinsics();
-
-    for(bpt::ptree::value_type &intrinsicNode : fileTree.get_child("intrinsics"))
+    // version
+    if(key == "version")
     {
-      IndexT intrinsicId;
-      std::shared_ptr<camera::IntrinsicBase> intrinsic;
-
-      loadIntrinsic(intrinsicId, intrinsic, intrinsicNode.second);
-
-      intrinsics.emplace(intrinsicId, intrinsic);
+      readMatrix(reader, version);
     }
-  }
-
-  // views
-  if(loadViews && fileTree.count("views"))
-  {
-    sfmData::Views& views = sfmData.getViews();
-
-    if(incompleteViews)
+    // folders
+    else if(key == "featuresFolders")
+    {
+      reader.beginArray();
+      while(reader.nextElement())
+        sfmData.addFeaturesFolder(reader.readString());
+    }
+    else if(key == "matchesFolders")
+    {
+      reader.beginArray();
+      while(reader.nextElement())
+        sfmData.addMatchesFolder(reader.readString());
+    }
+    // intrinsics
+    else if(key == "intrinsics" && loadIntrinsics)
     {
-      // store incomplete views in a vector
-      std::vector<sfmData::View> incompleteViews(fileTree.get_child("views").size());
+      sfmData::Intrinsics& intrinsics = sfmData.getIntrinsics();
 
-      int viewIndex = 0;
-      for(bpt::ptree::value_type &viewNode : fileTree.get_child("views"))
+      reader.beginArray();
+      while(reader.nextElement())
       {
-        loadView(incompleteViews.at(viewIndex), viewNode.second);
-        ++viewIndex;
-      }
+        IndexT intrinsicId;
+        std::shared_ptr<camera::IntrinsicBase> intrinsic;
 
-      // update incomplete views
-      #pragma omp parallel for
-      for(int i = 0; i < incompleteViews.size(); ++i)
-      {
-        sfmData::View& v = incompleteViews.at(i);
-        // if we have the intrinsics and the view has an valid associated intrinsics
-        // update the width and height field of View (they are mirrored)
-        if (loadIntrinsics && v.getIntrinsicId() != UndefinedIndexT)
-        {
-          const auto intrinsics = sfmData.getIntrinsicPtr(v.getIntrinsicId());
-
-          if(intrinsics == nullptr)
-          {
-            throw std::logic_error("View " + std::to_string(v.getViewId())
-                                   + " has a intrinsics id " +std::to_string(v.getIntrinsicId())
-                                   + " that cannot be found or the intrinsics are not correctly "
-                                     "loaded from the json file.");
-          }
-
-          v.setWidth(intrinsics->w());
-          v.setHeight(intrinsics->h());
-        }
-        updateIncompleteView(incompleteViews.at(i));
-      }
+        readIntrinsic(reader, intrinsicId, intrinsic);
 
-      // copy complete views in the SfMData views map
-      for(const sfmData::View& view : incompleteViews)
-        views.emplace(view.getViewId(), std::make_shared<sfmData::View>(view));
+        intrinsics.emplace(intrinsicId, intrinsic);
+      }
     }
-    else
+    // views
+    else if(key == "views" && loadViews)
     {
-      // store directly in the SfMData views map
-      for(bpt::ptree::value_type &viewNode : fileTree.get_child("views"))
+      sfmData::Views& views = sfmData.getViews();
+
+      reader.beginArray();
+      while(reader.nextElement())
       {
         sfmData::View view;
-        loadView(view, viewNode.second);
-        views.emplace(view.getViewId(), std::make_shared<sfmData::View>(view));
+        readView(reader, view);
+
+        // store incomplete views in a vector, they are updated once the whole file is read
+        if(incompleteViews)
+          incompleteViewsVec.push_back(view);
+        else
+          views.emplace(view.getViewId(), std::make_shared<sfmData::View>(view));
       }
     }
-  }
-
-  // extrinsics
-  if(loadExtrinsics)
-  {
-    // poses
-    if(fileTree.count("poses"))
+    // extrinsics
+    else if(key == "poses" && loadExtrinsics)
     {
       sfmData::Poses& poses = sfmData.getPoses();
 
-      for(bpt::ptree::value_type &poseNode : fileTree.get_child("poses"))
+      reader.beginArray();
+      while(reader.nextElement())
       {
-        bpt::ptree& poseTree = poseNode.second;
+        IndexT poseId;
         sfmData::CameraPose pose;
 
-        loadCameraPose("pose", pose, poseTree);
+        readCameraPose(reader, poseId, pose);
 
-        poses.emplace(poseTree.get<IndexT>("poseId"), pose);
+        poses.emplace(poseId, pose);
       }
     }
-
-    // rigs
-    if(fileTree.count("rigs"))
+    else if(key == "rigs" && loadExtrinsics)
     {
       sfmData::Rigs& rigs = sfmData.getRigs();
 
-      for(bpt::ptree::value_type &rigNode : fileTree.get_child("rigs"))
+      reader.beginArray();
+      while(reader.nextElement())
       {
         IndexT rigId;
         sfmData::Rig rig;
 
-        loadRig(rigId, rig, rigNode.second);
+        readRig(reader, rigId, rig);
 
         rigs.emplace(rigId, rig);
       }
     }
-  }
-
-  // structure
-  if(loadStructure && fileTree.count("structure"))
-  {
-    sfmData::Landmarks& structure = sfmData.getLandmarks();
-
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("structure"))
+    // structure
+    else if(key == "structure" && loadStructure)
     {
-      IndexT landmarkId;
-      sfmData::Landmark landmark;
-
-      loadLandmark(landmarkId, landmark, landmarkNode.second);
-
-      structure.emplace(landmarkId, landmark);
+      readLandmarks(reader, sfmData.getLandmarks(), loadObservations);
+    }
+    // control points
+    else if(key == "controlPoints" && loadControlPoints)
+    {
+      readLandmarks(reader, sfmData.getControlPoints(), true);
+    }
+    else
+    {
+      reader.skipValue();
     }
   }
 
-  // control points
-  if(loadControlPoints && fileTree.count("controlPoints"))
+  if(!incompleteViewsVec.empty())
   {
-    sfmData::Landmarks& controlPoints = sfmData.getControlPoints();
+    sfmData::Views& views = sfmData.getViews();
 
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("controlPoints"))
+    // update incomplete views
+    #pragma omp parallel for
+    for(int i = 0; i < incompleteViewsVec.size(); ++i)
     {
-      IndexT landmarkId;
-      sfmData::Landmark landmark;
+      sfmData::View& v = incompleteViewsVec.at(i);
+      // if we have the intrinsics and the view has an valid associated intrinsics
+      // update the width and height field of View (they are mirrored)
+      if (loadIntrinsics && v.getIntrinsicId() != UndefinedIndexT)
+      {
+        const auto intrinsics = sfmData.getIntrinsicPtr(v.getIntrinsicId());
 
-      loadLandmark(landmarkId, landmark, landmarkNode.second);
+        if(intrinsics == nullptr)
+        {
+          throw std::logic_error("View " + std::to_string(v.getViewId())
+                                 + " has a intrinsics id " +std::to_string(v.getIntrinsicId())
+                                 + " that cannot be found or the intrinsics are not correctly "
+                                   "loaded from the json file.");
+        }
 
-      controlPoints.emplace(landmarkId, landmark);
+        v.setWidth(intrinsics->w());
+        v.setHeight(intrinsics->h());
+      }
+      updateIncompleteView(incompleteViewsVec.at(i));
     }
+
+    // copy complete views in the SfMData views map
+    for(const sfmData::View& view : incompleteViewsVec)
+      views.emplace(view.getViewId(), std::make_shared<sfmData::View>(view));
   }
 
   return true;
@@ -94,56 +94,6 @@ inline void loadPose3(const std::string& name, geometry::Pose3& pose, bpt::ptree
   pose = geometry::Pose3(rotation, center);
 }
 
-/**
- * @brief Save a Pose3 in a boost property tree.
- * @param[in] name The node name ( "" = no name )
- * @param[in] pose The input pose3
- * @param[out] parentTree The parent tree
- */
-inline void saveCameraPose(const std::string& name, const sfmData::CameraPose& cameraPose, bpt::ptree& parentTree)
-{
-  bpt::ptree cameraPoseTree;
-
-  savePose3("transform", cameraPose.getTransform(), cameraPoseTree);
-  cameraPoseTree.put("locked", cameraPose.isLocked());
-
-  parentTree.add_child(name, cameraPoseTree);
-}
-
-/**
- * @brief Load a Pose3 from a boost property tree.
- * @param[in] name The Pose3 name ( "" = no name )
- * @param[out] pose The output Pose3
- * @param[in,out] pose3Tree The input tree
- */
-inline void loadCameraPose(const std::string& name, sfmData::CameraPose& cameraPose, bpt::ptree& cameraPoseTree)
-{
-  geometry::Pose3 pose;
-
-  loadPose3(name + ".transform", pose, cameraPoseTree);
-  cameraPose.setTransform(pose);
-
-  if(cameraPoseTree.get<bool>("locked", false))
-    cameraPose.lock();
-  else
-    cameraPose.unlock();
-}
-
-/**
- * @brief Save a View in a boost property tree.
- * @param[in] name The node name ( "" = no name )
- * @param[in] view The input View
- * @param[out] parentTree The parent tree
- */
-void saveView(const std::string& name, const sfmData::View& view, bpt::ptree& parentTree);
-
-/**
- * @brief Load a View from a boost property tree.
- * @param[out] view The output View
- * @param[in,out] viewTree The input tree
- */
-void loadView(sfmData::View& view, bpt::ptree& viewTree);
-
 /**
  * @brief Save an Intrinsic in a boost property tree.
  * @param[in] name The node name ( "" = no name )
@@ -162,41 +112,8 @@ void saveIntrinsic(const std::string& name, IndexT intrinsicId, const std::share
 void loadIntrinsic(IndexT& intrinsicId, std::shared_ptr<camera::IntrinsicBase>& intrinsic, bpt::ptree& intrinsicTree);
 
 /**
- * @brief Save a Rig in a boost property tree.
- * @param[in] name The node name ( "" = no name )
- * @param[in] rigId The rig Id
- * @param[in] rig The rig
- * @param[out] parentTree The parent tree
- */
-void saveRig(const std::string& name, IndexT rigId, const sfmData::Rig& rig, bpt::ptree& parentTree);
-
-/**
- * @brief Load a Rig from a boost property tree.
- * @param[out] rigId The output Rig Id
- * @param[out] rig The output Rig
- * @param[in,out] rigTree The input tree
- */
-void loadRig(IndexT& rigId, sfmData::Rig& rig, bpt::ptree& rigTree);
-
-/**
- * @brief Save a Landmark in a boost property tree.
- * @param[in] name The node name ( "" = no name )
- * @param[in] landmarkId The landmark Id
- * @param[in] landmark The landmark
- * @param[out] parentTree The parent tree
- */
-void saveLandmark(const std::string& name, IndexT landmarkId, const sfmData::Landmark& landmark, bpt::ptree& parentTree);
-
-/**
- * @brief Load a Landmark from a boost property tree.
- * @param[out] landmarkId The output Landmark Id
- * @param[out] landmark The output Landmmark
- * @param[in,out] landmarkTree The input tree
- */
-void loadLandmark(IndexT& landmarkId, sfmData::Landmark& landmark, bpt::ptree& landmarkTree);
-
-/**
- * @brief Save an SfMData in a JSON file with a boost property tree.
+ * @brief Save an SfMData in a JSON file.
+ *        The file is written while the SfMData is traversed, without any intermediate tree.
  * @param[in] sfmData The input SfMData
  * @param[in] filename The filename
  * @param[in] partFlag The ESfMData save flag
@@ -206,6 +123,7 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
 
 /**
  * @brief Load a JSON SfMData file.
+ *        The file is decoded directly in the SfMData; the sections excluded by the flags are skipped.
  * @param[out] sfmData The output SfMData
  * @param[in] filename The filename
  * @param[in] partFlag The ESfMData load flag
@@ -7,10 +7,21 @@
 
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfmDataIO/binaryIO.hpp>
+#include <aliceVision/sfmDataIO/JsonReader.hpp>
+#include <aliceVision/sfmDataIO/JsonWriter.hpp>
 
 #include <boost/filesystem.hpp>
 
+#include <clocale>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <locale>
+#include <random>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
 
 #define BOOST_TEST_MODULE sfmDataIO
 #include <boost/test/included/unit_test.hpp>
@@ -173,6 +184,223 @@ BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_JSON) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(SfMData_IO_content) {
+
+  sfmData::SfMData sfmData = createTestScene(3, 3, false);
+
+  // rig
+  sfmData::Rig rig(2);
+  rig.setSubPose(1, sfmData::RigSubPose(Pose3(RotationAroundX(0.1), Vec3(1.0, 2.0, 3.0)), sfmData::ERigSubPoseStatus::CONSTANT));
+  sfmData.getRigs().emplace(0, rig);
+  sfmData.views.at(1)->setRigAndSubPoseId(0, 1);
+
+  // metadata to escape
+  sfmData.views.at(0)->addMetadata("Make", "A \"quoted\" \\ name/with\tcontrol\ncharacters \xC3\xA9");
+  sfmData.views.at(0)->addMetadata("Exif:FocalLength", "35");
+
+  // intrinsic
+  sfmData.intrinsics[1] = std::make_shared<PinholeRadialK3>(1000, 800, 1234.5678901234567, 500.25, 400.125, 0.1, -0.02, 0.003);
+  sfmData.intrinsics[1]->lock();
+
+  // pose
+  sfmData.setAbsolutePose(2, sfmData::CameraPose(Pose3(RotationAroundY(0.3), Vec3(-1.0, 0.5, 2.0)), true));
+
+  // control points
+  sfmData.control_points[5] = sfmData.structure[0];
+
+  const std::vector<std::string> ext_Type = {"sfm", "sfmb"};
+
+  for(const std::string& ext : ext_Type)
+  {
+    const std::string filename = "SAVE_LOAD_CONTENT." + ext;
+    ALICEVISION_LOG_DEBUG("Testing:" << filename);
+
+    BOOST_CHECK(Save(sfmData, filename, ALL));
+
+    {
+      sfmData::SfMData sfmDataLoad;
+      BOOST_CHECK(Load(sfmDataLoad, filename, ALL));
+      BOOST_CHECK(sfmData == sfmDataLoad);
+      BOOST_CHECK(sfmDataLoad.views.at(0)->getMetadata() == sfmData.views.at(0)->getMetadata());
+      BOOST_CHECK(sfmDataLoad.control_points == sfmData.control_points);
+      BOOST_CHECK(sfmDataLoad.intrinsics.at(1)->isLocked());
+      BOOST_CHECK(sfmDataLoad.getPoses().at(2).isLocked());
+    }
+
+    // structure without the observations
+    {
+      sfmData::SfMData sfmDataLoad;
+      BOOST_CHECK(Load(sfmDataLoad, filename, STRUCTURE));
+      BOOST_CHECK_EQUAL(sfmDataLoad.structure.size(), 1);
+      BOOST_CHECK(sfmDataLoad.structure.at(0).X == sfmData.structure.at(0).X);
+      BOOST_CHECK(sfmDataLoad.structure.at(0).observations.empty());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_binary) {
+
+  const std::string filename = "SAVE_LOAD_BINARY.sfmb";
+  const sfmData::SfMData sfmData = createTestScene(4, 3, true);
+
+  BOOST_CHECK(Save(sfmData, filename, ALL));
+
+  // views and poses only
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK(Load(sfmDataLoad, filename, ESfMData(VIEWS|EXTRINSICS)));
+    BOOST_CHECK_EQUAL(sfmDataLoad.views.size(), sfmData.views.size());
+    BOOST_CHECK_EQUAL(sfmDataLoad.getPoses().size(), sfmData.getPoses().size());
+    BOOST_CHECK(sfmDataLoad.intrinsics.empty());
+    BOOST_CHECK(sfmDataLoad.structure.empty());
+  }
+
+  // random access to the landmarks
+  {
+    const BinarySfMDataFile file(filename);
+    BOOST_CHECK_EQUAL(file.getNbLandmarks(), sfmData.structure.size());
+
+    IndexT landmarkId;
+    sfmData::Landmark landmark;
+    file.getLandmark(0, landmarkId, landmark, true);
+    BOOST_CHECK(landmark == sfmData.structure.at(landmarkId));
+  }
+
+  // file saved without the structure
+  {
+    BOOST_CHECK(Save(sfmData, filename, ESfMData(VIEWS|INTRINSICS|EXTRINSICS)));
+    const BinarySfMDataFile file(filename);
+    BOOST_CHECK_EQUAL(file.getNbLandmarks(), 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_propertyTree) {
+
+  // file written by boost::property_tree: values as strings, empty nodes as "" and escaped '/'
+  const std::string filename = "LOAD_PROPERTY_TREE.sfm";
+  {
+    std::ofstream stream(filename);
+    stream << "{\n"
+              "    \"version\": [\n        \"1\",\n        \"0\",\n        \"0\"\n    ],\n"
+              "    \"views\": [\n        {\n"
+              "            \"viewId\": \"10\",\n            \"poseId\": \"10\",\n            \"intrinsicId\": \"0\",\n"
+              "            \"path\": \"\\/data\\/img.jpg\",\n            \"width\": \"1000\",\n            \"height\": \"800\",\n"
+              "            \"metadata\": \"\"\n        }\n    ],\n"
+              "    \"intrinsics\": [\n        {\n"
+              "            \"intrinsicId\": \"0\",\n            \"width\": \"1000\",\n            \"height\": \"800\",\n"
+              "            \"type\": \"pinhole\",\n            \"serialNumber\": \"\",\n            \"pxInitialFocalLength\": \"-1\",\n"
+              "            \"pxFocalLength\": \"1200.5\",\n            \"principalPoint\": [\n                \"500\",\n                \"400\"\n            ],\n"
+              "            \"distortionParams\": \"\",\n            \"locked\": \"true\"\n        }\n    ],\n"
+              "    \"poses\": [\n        {\n            \"poseId\": \"10\",\n            \"pose\": {\n                \"transform\": {\n"
+              "                    \"rotation\": [\"1\", \"0\", \"0\", \"0\", \"1\", \"0\", \"0\", \"0\", \"1\"],\n"
+              "                    \"center\": [\"1.5\", \"2\", \"-3\"]\n                },\n                \"locked\": \"false\"\n"
+              "            }\n        }\n    ],\n"
+              "    \"structure\": [\n        {\n            \"landmarkId\": \"3\",\n            \"descType\": \"sift\",\n"
+              "            \"color\": [\"255\", \"128\", \"0\"],\n            \"X\": [\"1\", \"2\", \"3\"],\n"
+              "            \"observations\": [\n                {\n                    \"observationId\": \"10\",\n"
+              "                    \"featureId\": \"42\",\n                    \"x\": [\"12.5\", \"13.25\"]\n                }\n            ]\n"
+              "        }\n    ]\n}\n";
+  }
+
+  sfmData::SfMData sfmData;
+  BOOST_CHECK(Load(sfmData, filename, ALL));
+
+  BOOST_CHECK_EQUAL(sfmData.views.size(), 1);
+  BOOST_CHECK_EQUAL(sfmData.views.at(10)->getImagePath(), "/data/img.jpg");
+  BOOST_CHECK_EQUAL(sfmData.views.at(10)->getWidth(), 1000);
+  BOOST_CHECK(sfmData.views.at(10)->getMetadata().empty());
+
+  BOOST_CHECK_EQUAL(sfmData.intrinsics.size(), 1);
+  BOOST_CHECK(sfmData.intrinsics.at(0)->isLocked());
+  BOOST_CHECK_EQUAL(sfmData.intrinsics.at(0)->getParams().at(0), 1200.5);
+
+  BOOST_CHECK_EQUAL(sfmData.getPoses().size(), 1);
+  BOOST_CHECK(sfmData.getPoses().at(10).getTransform().center() == Vec3(1.5, 2.0, -3.0));
+
+  BOOST_CHECK_EQUAL(sfmData.structure.size(), 1);
+  const sfmData::Landmark& landmark = sfmData.structure.at(3);
+  BOOST_CHECK(landmark.descType == feature::EImageDescriberType::SIFT);
+  BOOST_CHECK(landmark.rgb == image::RGBColor(255, 128, 0));
+  BOOST_CHECK_EQUAL(landmark.observations.size(), 1);
+  BOOST_CHECK_EQUAL(landmark.observations.at(10).id_feat, 42);
+  BOOST_CHECK(landmark.observations.at(10).x == Vec2(12.5, 13.25));
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_numbers) {
+
+  // global locale with a ',' decimal separator, when one is installed
+  const std::string previousCLocale = std::setlocale(LC_ALL, nullptr);
+  const std::locale previousLocale;
+  for(const char* name : {"de_DE.UTF-8", "fr_FR.UTF-8", "de_DE", "fr_FR"})
+  {
+    try
+    {
+      std::locale::global(std::locale(name));
+      break;
+    }
+    catch(const std::runtime_error&)
+    {}
+  }
+
+  std::vector<double> values = {0.0, -0.0, 1.0, 0.1, -2.5, 1.0 / 3.0, M_PI, 1234567.891, 1e-300, -1e300,
+                                std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest(),
+                                std::numeric_limits<double>::min(), std::numeric_limits<double>::denorm_min(),
+                                std::numeric_limits<double>::epsilon(), std::numeric_limits<double>::infinity(),
+                                -std::numeric_limits<double>::infinity()};
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> mantissa(-1.0, 1.0);
+  std::uniform_int_distribution<int> exponent(-300, 300);
+  for(int i = 0; i < 1000; ++i)
+    values.push_back(std::ldexp(mantissa(generator), exponent(generator)));
+
+  std::ostringstream stream;
+  {
+    JsonWriter writer(stream);
+    writer.beginObject();
+    writer.key("values");
+    writer.beginArray();
+    for(const double value : values)
+      writer.value(value);
+    writer.value(std::numeric_limits<double>::quiet_NaN());
+    writer.endArray();
+    writer.member("float", 0.1f);
+    writer.endObject();
+  }
+  const std::string json = stream.str();
+  BOOST_CHECK(json.find("\"0.10000000000000001\"") != std::string::npos);
+
+  // the values are read back exactly
+  JsonReader reader(json.data(), json.data() + json.size(), "numbers");
+  reader.beginObject();
+  std::string key;
+  BOOST_CHECK(reader.nextMember(key));
+  BOOST_CHECK_EQUAL(key, "values");
+  reader.beginArray();
+  for(const double value : values)
+  {
+    BOOST_CHECK(reader.nextElement());
+    const double readValue = reader.read<double>();
+    BOOST_CHECK_EQUAL(readValue, value);
+    BOOST_CHECK_EQUAL(std::signbit(readValue), std::signbit(value));
+  }
+  BOOST_CHECK(reader.nextElement());
+  BOOST_CHECK(std::isnan(reader.read<double>()));
+  BOOST_CHECK(!reader.nextElement());
+  BOOST_CHECK(reader.nextMember(key));
+  BOOST_CHECK_EQUAL(reader.read<float>(), 0.1f);
+  BOOST_CHECK(!reader.nextMember(key));
+
+  // the decimal separator of the locale is not a number
+  const std::string invalidJson = "[\"1,5\"]";
+  JsonReader invalidReader(invalidJson.data(), invalidJson.data() + invalidJson.size(), "invalid");
+  invalidReader.beginArray();
+  BOOST_CHECK(invalidReader.nextElement());
+  BOOST_CHECK_THROW(invalidReader.read<double>(), std::runtime_error);
+
+  std::locale::global(previousLocale);
+  std::setlocale(LC_ALL, previousCLocale.c_str());
+}
+
 /*
 BOOST_AUTO_TEST_CASE(SfMData_IO_BigFile) {
   const int nbViews = 1000;
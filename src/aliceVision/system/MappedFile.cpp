@@ -0,0 +1,112 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace aliceVision {
+namespace system {
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& path)
+  : _path(path)
+{
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if(file == INVALID_HANDLE_VALUE)
+    throw std::runtime_error("Can't open file '" + path + "' !");
+  _fileHandle = file;
+
+  LARGE_INTEGER fileSize;
+  if(!GetFileSizeEx(file, &fileSize))
+  {
+    CloseHandle(file);
+    throw std::runtime_error("Can't get the size of file '" + path + "' !");
+  }
+  _size = static_cast<std::size_t>(fileSize.QuadPart);
+
+  if(_size == 0)
+    return;
+
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(mapping == NULL)
+  {
+    CloseHandle(file);
+    throw std::runtime_error("Can't map file '" + path + "' !");
+  }
+  _mappingHandle = mapping;
+
+  _data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if(_data == nullptr)
+  {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    throw std::runtime_error("Can't map file '" + path + "' !");
+  }
+}
+
+MappedFile::~MappedFile()
+{
+  if(_data != nullptr)
+    UnmapViewOfFile(_data);
+  if(_mappingHandle != nullptr)
+    CloseHandle(_mappingHandle);
+  if(_fileHandle != nullptr)
+    CloseHandle(_fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+  : _path(path)
+{
+  _fd = open(path.c_str(), O_RDONLY);
+  if(_fd < 0)
+    throw std::runtime_error("Can't open file '" + path + "' !");
+
+  struct stat fileStat;
+  if(fstat(_fd, &fileStat) != 0)
+  {
+    close(_fd);
+    throw std::runtime_error("Can't get the size of file '" + path + "' !");
+  }
+  _size = static_cast<std::size_t>(fileStat.st_size);
+
+  if(_size == 0)
+    return;
+
+  void* data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+  if(data == MAP_FAILED)
+  {
+    close(_fd);
+    throw std::runtime_error("Can't map file '" + path + "' !");
+  }
+  _data = static_cast<const unsigned char*>(data);
+}
+
+MappedFile::~MappedFile()
+{
+  if(_data != nullptr)
+    munmap(const_cast<unsigned char*>(_data), _size);
+  if(_fd >= 0)
+    close(_fd);
+}
+
+#endif
+
+} // namespace system
+} // namespace aliceVision
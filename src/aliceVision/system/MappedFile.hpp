@@ -0,0 +1,55 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *        The mapping is released when the object is destroyed.
+ */
+class MappedFile
+{
+public:
+  /**
+   * @brief Map the given file in memory.
+   * @param[in] path The file path
+   * @throw std::runtime_error if the file can't be opened or mapped
+   */
+  explicit MappedFile(const std::string& path);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /// @return pointer to the first byte of the file (nullptr for an empty file)
+  const unsigned char* data() const { return _data; }
+
+  /// @return file size in bytes
+  std::size_t size() const { return _size; }
+
+  const std::string& path() const { return _path; }
+
+private:
+  std::string _path;
+  const unsigned char* _data = nullptr;
+  std::size_t _size = 0;
+#if defined(_WIN32)
+  void* _fileHandle = nullptr;
+  void* _mappingHandle = nullptr;
+#else
+  int _fd = -1;
+#endif
+};
+
+} // namespace system
+} // namespace aliceVision
@@ -7,82 +7,207 @@
 
 #include "Track.hpp"
 
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <limits>
+#include <stdexcept>
+
 namespace aliceVision {
 namespace track {
 
 using namespace aliceVision::matching;
-using namespace lemon;
 
-void TracksBuilder::build(const PairwiseMatches& pairwiseMatches)
+namespace {
+
+/// unused feature index
+const std::uint32_t noFeature = std::numeric_limits<std::uint32_t>::max();
+
+} // namespace
+
+void TracksBuilder::build(const PairwiseMatches& pairwiseMatches, bool multithreaded)
 {
-  typedef std::set<IndexedFeaturePair> SetIndexedPair;
+  std::vector<PairwiseMatches::const_iterator> pairs;
+  pairs.reserve(pairwiseMatches.size());
+  for(PairwiseMatches::const_iterator it = pairwiseMatches.begin(); it != pairwiseMatches.end(); ++it)
+    pairs.push_back(it);
 
-  // set of all features of all images: (imageIndex, featureIndex)
-  SetIndexedPair allFeatures;
+  typedef std::pair<IndexT, feature::EImageDescriberType> ViewDescType;
 
-  // for each couple of images make the union according the pair matches
-  for(const auto& matchesPerDescIt: pairwiseMatches)
+  // number of feature indexes needed for each (view, describer type): largest matched feature id + 1
+  std::map<ViewDescType, std::size_t> nbFeaturesPerViewDesc;
+
+#pragma omp parallel if(multithreaded)
   {
-    const std::size_t& I = matchesPerDescIt.first.first;
-    const std::size_t& J = matchesPerDescIt.first.second;
-    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt.second;
+    std::map<ViewDescType, std::size_t> threadNbFeatures;
 
-    for(const auto& matchesIt: matchesPerDesc)
+#pragma omp for schedule(dynamic)
+    for(int p = 0; p < static_cast<int>(pairs.size()); ++p)
     {
-      const feature::EImageDescriberType descType = matchesIt.first;
-      const IndMatches& matches = matchesIt.second;
-      // we have correspondences between I and J image index.
-      for(const IndMatch& m: matches)
+      const Pair& pair = pairs[p]->first;
+      const MatchesPerDescType& matchesPerDesc = pairs[p]->second;
+
+      for(const auto& matchesIt: matchesPerDesc)
       {
-        IndexedFeaturePair pairI(I, KeypointId(descType, m._i));
-        IndexedFeaturePair pairJ(J, KeypointId(descType, m._j));
-        allFeatures.insert(pairI);
-        allFeatures.insert(pairJ);
+        std::size_t& nbFeaturesI = threadNbFeatures[ViewDescType(pair.first, matchesIt.first)];
+        std::size_t& nbFeaturesJ = threadNbFeatures[ViewDescType(pair.second, matchesIt.first)];
+        for(const IndMatch& m: matchesIt.second)
+        {
+          nbFeaturesI = std::max(nbFeaturesI, static_cast<std::size_t>(m._i) + 1);
+          nbFeaturesJ = std::max(nbFeaturesJ, static_cast<std::size_t>(m._j) + 1);
+        }
       }
     }
-  }
 
-  // build the node indirection for each referenced feature
-  MapIndexToNode map_indexToNode;
-  map_indexToNode.reserve(allFeatures.size());
-  _map_nodeToIndex.reserve(allFeatures.size());
+#pragma omp critical
+    {
+      for(const auto& it: threadNbFeatures)
+      {
+        std::size_t& nbFeatures = nbFeaturesPerViewDesc[it.first];
+        nbFeatures = std::max(nbFeatures, it.second);
+      }
+    }
+  }
 
-  for(const IndexedFeaturePair& featPair: allFeatures)
+  // feature index ranges, ordered by (viewId, descType)
+  _ranges.clear();
+  _ranges.reserve(nbFeaturesPerViewDesc.size());
+  std::size_t nbFeatures = 0;
+  for(const auto& it: nbFeaturesPerViewDesc)
   {
-    lemon::ListDigraph::Node node = _graph.addNode();
-    map_indexToNode.insert(std::make_pair(featPair, node));
-    _map_nodeToIndex.insert(std::make_pair(node, featPair));
+    _ranges.push_back({it.first.first, it.first.second, static_cast<std::uint32_t>(nbFeatures)});
+    nbFeatures += it.second;
   }
+  if(nbFeatures >= noFeature)
+    throw std::runtime_error("Can't build tracks: too many features (" + std::to_string(nbFeatures) + ").");
+  _nbFeatures = static_cast<std::uint32_t>(nbFeatures);
 
-  // add the element of myset to the UnionFind insert method.
-  _index = std::unique_ptr<IndexMap>( new IndexMap(_graph) );
-  _tracksUF = std::unique_ptr<UnionFindObject>(new UnionFindObject(*_index));
-
-  for(ListDigraph::NodeIt it(_graph); it != INVALID; ++it)
+  const auto getOffset = [&](IndexT viewId, feature::EImageDescriberType descType)
   {
-    _tracksUF->insert(it);
-  }
+    const auto it = std::lower_bound(_ranges.begin(), _ranges.end(), ViewDescType(viewId, descType),
+                                     [](const FeaturesRange& range, const ViewDescType& key)
+                                     {
+                                       return ViewDescType(range.viewId, range.descType) < key;
+                                     });
+    return it->offset;
+  };
+
+  _parent.reset(new std::atomic<std::uint32_t>[_nbFeatures]);
+  for(std::uint32_t f = 0; f < _nbFeatures; ++f)
+    _parent[f] = noFeature;
 
   // make the union according the pair matches
-  for(const auto& matchesPerDescIt: pairwiseMatches)
+#pragma omp parallel if(multithreaded)
   {
-    const std::size_t& I = matchesPerDescIt.first.first;
-    const std::size_t& J = matchesPerDescIt.first.second;
-    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt.second;
-
-    for(const auto& matchesIt: matchesPerDesc)
+#pragma omp for schedule(dynamic)
+    for(int p = 0; p < static_cast<int>(pairs.size()); ++p)
     {
-      const feature::EImageDescriberType descType = matchesIt.first;
-      const IndMatches& matches = matchesIt.second;
-      // we have correspondences between I and J image index.
-      for(const IndMatch& m: matches)
+      const Pair& pair = pairs[p]->first;
+      const MatchesPerDescType& matchesPerDesc = pairs[p]->second;
+
+      for(const auto& matchesIt: matchesPerDesc)
       {
-        IndexedFeaturePair pairI(I, KeypointId(descType, m._i));
-        IndexedFeaturePair pairJ(J, KeypointId(descType, m._j));
-        _tracksUF->join(map_indexToNode[pairI], map_indexToNode[pairJ]);
+        const std::uint32_t offsetI = getOffset(pair.first, matchesIt.first);
+        const std::uint32_t offsetJ = getOffset(pair.second, matchesIt.first);
+
+        // we have correspondences between I and J image index.
+        for(const IndMatch& m: matchesIt.second)
+        {
+          const std::uint32_t featureI = offsetI + static_cast<std::uint32_t>(m._i);
+          const std::uint32_t featureJ = offsetJ + static_cast<std::uint32_t>(m._j);
+
+          // mark the features as used
+          std::uint32_t expected = noFeature;
+          _parent[featureI].compare_exchange_strong(expected, featureI);
+          expected = noFeature;
+          _parent[featureJ].compare_exchange_strong(expected, featureJ);
+
+          unite(featureI, featureJ);
+        }
       }
     }
   }
+
+  // a parent index is always lower than the feature index, so the tracks can be numbered
+  // in a single ordered pass: the parent array is reused to store the track index of each feature
+  std::uint32_t nbTracks = 0;
+  std::size_t nbUsedFeatures = 0;
+  for(std::uint32_t f = 0; f < _nbFeatures; ++f)
+  {
+    const std::uint32_t parent = _parent[f];
+    if(parent == noFeature)
+      continue;
+    ++nbUsedFeatures;
+    _parent[f] = (parent == f) ? nbTracks++ : _parent[parent].load();
+  }
+
+  // store the features of each track contiguously
+  _trackOffsets.assign(nbTracks + 1, 0);
+  for(std::uint32_t f = 0; f < _nbFeatures; ++f)
+  {
+    if(_parent[f] != noFeature)
+      ++_trackOffsets[_parent[f] + 1];
+  }
+  for(std::size_t t = 0; t < nbTracks; ++t)
+    _trackOffsets[t + 1] += _trackOffsets[t];
+
+  _trackFeatures.resize(nbUsedFeatures);
+  {
+    std::vector<std::uint32_t> position(_trackOffsets.begin(), _trackOffsets.end() - 1);
+    for(std::uint32_t f = 0; f < _nbFeatures; ++f)
+    {
+      if(_parent[f] != noFeature)
+        _trackFeatures[position[_parent[f]]++] = f;
+    }
+  }
+
+  _parent.reset();
+}
+
+std::uint32_t TracksBuilder::findRoot(std::uint32_t feature)
+{
+  for(;;)
+  {
+    std::uint32_t parent = _parent[feature];
+    if(parent == feature)
+      return feature;
+    const std::uint32_t grandParent = _parent[parent];
+    if(grandParent == parent)
+      return parent;
+    // path halving, a concurrent update of the parent is not an issue: it's still an ancestor
+    _parent[feature].compare_exchange_weak(parent, grandParent);
+    feature = grandParent;
+  }
+}
+
+void TracksBuilder::unite(std::uint32_t featureA, std::uint32_t featureB)
+{
+  for(;;)
+  {
+    featureA = findRoot(featureA);
+    featureB = findRoot(featureB);
+    if(featureA == featureB)
+      return;
+    // the root with the higher index is attached to the other one
+    if(featureA < featureB)
+      std::swap(featureA, featureB);
+    std::uint32_t expected = featureA;
+    if(_parent[featureA].compare_exchange_strong(expected, featureB))
+      return;
+    // featureA is no longer a root, retry
+  }
+}
+
+std::size_t TracksBuilder::getRangeIndex(std::uint32_t feature) const
+{
+  const auto it = std::upper_bound(_ranges.begin(), _ranges.end(), feature,
+                                   [](std::uint32_t f, const FeaturesRange& range){ return f < range.offset; });
+  return std::distance(_ranges.begin(), it) - 1;
+}
+
+TracksBuilder::IndexedFeaturePair TracksBuilder::getIndexedFeaturePair(std::uint32_t feature) const
+{
+  const FeaturesRange& range = _ranges[getRangeIndex(feature)];
+  return IndexedFeaturePair(range.viewId, KeypointId(range.descType, feature - range.offset));
 }
 
 void TracksBuilder::filter(std::size_t minTrackLength, bool multithreaded)
@@ -91,49 +216,109 @@ void TracksBuilder::filter(std::size_t minTrackLength, bool multithreaded)
   // - track that are too short,
   // - track with id conflicts (many times the same image index)
 
-  std::set<int> set_classToErase;
+  const std::size_t nbTracksIn = nbTracks();
 
-#pragma omp parallel if(multithreaded)
-  for(lemon::UnionFindEnum<IndexMap>::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
+  // contiguous chunks of tracks, a few per thread for load balancing,
+  // so the filtered tracks keep their order
+  const std::size_t nbThreads = multithreaded ? static_cast<std::size_t>(omp_get_max_threads()) : 1;
+  const std::size_t nbChunks = std::max<std::size_t>(1, std::min(nbTracksIn, 4 * nbThreads));
+  const std::size_t chunkSize = (nbTracksIn + nbChunks - 1) / std::max<std::size_t>(1, nbChunks);
+
+  std::vector<char> isValid(nbTracksIn, 0);
+  // number of valid tracks and features per chunk, then output offsets of each chunk
+  std::vector<std::size_t> chunkNbTracks(nbChunks + 1, 0);
+  std::vector<std::uint32_t> chunkNbFeatures(nbChunks + 1, 0);
+
+#pragma omp parallel for schedule(dynamic) if(multithreaded)
+  for(int c = 0; c < static_cast<int>(nbChunks); ++c)
   {
+    const std::size_t chunkBegin = std::min(nbTracksIn, c * chunkSize);
+    const std::size_t chunkEnd = std::min(nbTracksIn, chunkBegin + chunkSize);
+    std::size_t nbValidTracks = 0;
+    std::uint32_t nbValidFeatures = 0;
 
-#pragma omp single nowait
+    for(std::size_t t = chunkBegin; t < chunkEnd; ++t)
     {
-      std::size_t cpt = 0;
-      std::set<std::size_t> myset;
-      for(lemon::UnionFindEnum<IndexMap>::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
-      {
-        myset.insert(_map_nodeToIndex[iit].first);
-        ++cpt;
-      }
-      if(myset.size() != cpt || myset.size() < minTrackLength)
+      const std::uint32_t begin = _trackOffsets[t];
+      const std::uint32_t end = _trackOffsets[t + 1];
+
+      if(end - begin < minTrackLength)
+        continue;
+
+      // the features of a track are sorted by view, so the view conflicts are consecutive
+      bool conflict = false;
+      IndexT previousViewId = UndefinedIndexT;
+      for(std::uint32_t i = begin; i < end && !conflict; ++i)
       {
-#pragma omp critical
-        set_classToErase.insert(cit.operator int());
+        const IndexT viewId = _ranges[getRangeIndex(_trackFeatures[i])].viewId;
+        conflict = (viewId == previousViewId);
+        previousViewId = viewId;
       }
+
+      if(conflict)
+        continue;
+
+      isValid[t] = 1;
+      ++nbValidTracks;
+      nbValidFeatures += end - begin;
     }
+    chunkNbTracks[c + 1] = nbValidTracks;
+    chunkNbFeatures[c + 1] = nbValidFeatures;
+  }
+
+  // exclusive prefix sums: where each chunk starts in the output
+  for(std::size_t c = 0; c < nbChunks; ++c)
+  {
+    chunkNbTracks[c + 1] += chunkNbTracks[c];
+    chunkNbFeatures[c + 1] += chunkNbFeatures[c];
   }
 
-  std::for_each(set_classToErase.begin(), set_classToErase.end(),
-    std::bind1st(std::mem_fun(&UnionFindObject::eraseClass), _tracksUF.get()));
+  const std::size_t nbTracksOut = chunkNbTracks[nbChunks];
+  const std::uint32_t nbFeaturesOut = chunkNbFeatures[nbChunks];
+
+  if(nbTracksOut == nbTracksIn)
+    return;
+
+  // compaction: each chunk is copied at its own offsets
+  std::vector<std::uint32_t> trackOffsets(nbTracksOut + 1);
+  std::vector<std::uint32_t> trackFeatures(nbFeaturesOut);
+
+#pragma omp parallel for schedule(dynamic) if(multithreaded)
+  for(int c = 0; c < static_cast<int>(nbChunks); ++c)
+  {
+    const std::size_t chunkBegin = std::min(nbTracksIn, c * chunkSize);
+    const std::size_t chunkEnd = std::min(nbTracksIn, chunkBegin + chunkSize);
+    std::size_t trackOut = chunkNbTracks[c];
+    std::uint32_t featureOut = chunkNbFeatures[c];
+
+    for(std::size_t t = chunkBegin; t < chunkEnd; ++t)
+    {
+      if(!isValid[t])
+        continue;
+      const std::uint32_t begin = _trackOffsets[t];
+      const std::uint32_t end = _trackOffsets[t + 1];
+      trackOffsets[trackOut++] = featureOut;
+      std::copy(_trackFeatures.begin() + begin, _trackFeatures.begin() + end, trackFeatures.begin() + featureOut);
+      featureOut += end - begin;
+    }
+  }
+  trackOffsets[nbTracksOut] = nbFeaturesOut;
+
+  _trackOffsets.swap(trackOffsets);
+  _trackFeatures.swap(trackFeatures);
 }
 
 bool TracksBuilder::exportToStream(std::ostream& os)
 {
-  std::size_t cpt = 0;
-  for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
+  for(std::size_t t = 0; t < nbTracks(); ++t)
   {
-    os << "Class: " << cpt++ << std::endl;
-    std::size_t cptTrackLength = 0;
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
-    {
-      ++cptTrackLength;
-    }
-    os << "\t" << "track length: " << cptTrackLength << std::endl;
+    os << "Class: " << t << std::endl;
+    os << "\t" << "track length: " << (_trackOffsets[t + 1] - _trackOffsets[t]) << std::endl;
 
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
+    for(std::uint32_t i = _trackOffsets[t]; i < _trackOffsets[t + 1]; ++i)
     {
-      os << _map_nodeToIndex[ iit ].first << "  " << _map_nodeToIndex[ iit ].second << std::endl;
+      const IndexedFeaturePair featPair = getIndexedFeaturePair(_trackFeatures[i]);
+      os << featPair.first << "  " << featPair.second << std::endl;
     }
   }
   return os.good();
@@ -142,21 +327,21 @@ bool TracksBuilder::exportToStream(std::ostream& os)
 void TracksBuilder::exportToSTL(TracksMap& allTracks) const
 {
   allTracks.clear();
+  allTracks.reserve(nbTracks());
 
-  std::size_t trackIndex = 0;
-  for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit, ++trackIndex)
+  for(std::size_t t = 0; t < nbTracks(); ++t)
   {
-    // create the output track
-    std::pair<TracksMap::iterator, bool> ret = allTracks.insert(std::make_pair(trackIndex, Track()));
-
-    Track& outTrack = ret.first->second;
+    // create the output track (tracks are exported by increasing index)
+    Track& outTrack = allTracks.emplace_hint(allTracks.end(), t, Track())->second;
+    outTrack.featPerView.reserve(_trackOffsets[t + 1] - _trackOffsets[t]);
 
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
+    for(std::uint32_t i = _trackOffsets[t]; i < _trackOffsets[t + 1]; ++i)
     {
-      const IndexedFeaturePair & currentPair = _map_nodeToIndex.at(iit);
+      const IndexedFeaturePair currentPair = getIndexedFeaturePair(_trackFeatures[i]);
       // all descType inside the track will be the same
       outTrack.descType = currentPair.second.descType;
-      outTrack.featPerView[currentPair.first] = currentPair.second.featIndex;
+      // features are sorted by view
+      outTrack.featPerView.emplace_hint(outTrack.featPerView.end(), currentPair.first, currentPair.second.featIndex);
     }
   }
 }
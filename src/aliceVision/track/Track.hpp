@@ -13,10 +13,9 @@
 #include <aliceVision/stl/FlatMap.hpp>
 #include <aliceVision/stl/FlatSet.hpp>
 
-#include <lemon/list_graph.h>
-#include <lemon/unionfind.h>
-
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <functional>
 #include <vector>
@@ -28,7 +27,6 @@ namespace aliceVision {
 namespace track {
 
 using namespace aliceVision::matching;
-using namespace lemon;
 
 /**
  * @brief A Track is a feature visible accross multiple views.
@@ -115,6 +113,12 @@ inline std::ostream& operator<<(std::ostream& os, const KeypointId& k)
  *
  * From map< [imageI,ImageJ], [indexed matches array] > it builds tracks.
  *
+ * The features are identified by an index in a flat array ordered by (viewId, descType, featureId):
+ * each (view, describer type) owns a range of consecutive indexes, sized by its largest matched feature id.
+ * The union-find works directly on this array, without any per-feature node or map.
+ * The unions are lock-free, so the matches can be processed by several threads, and the root
+ * of a track is always its smallest index: tracks are deterministic and ordered by their first feature.
+ *
  * Usage:
  * @code{.cpp}
  *  PairWiseMatches matches;
@@ -131,34 +135,13 @@ struct TracksBuilder
 {
   /// IndexedFeaturePair is: map<viewId, keypointId>
   typedef std::pair<std::size_t, KeypointId> IndexedFeaturePair;
-  typedef ListDigraph::NodeMap<std::size_t> IndexMap;
-  typedef lemon::UnionFindEnum< IndexMap > UnionFindObject;
-
-  typedef stl::flat_map< lemon::ListDigraph::Node, IndexedFeaturePair> MapNodeToIndex;
-  typedef stl::flat_map< IndexedFeaturePair, lemon::ListDigraph::Node > MapIndexToNode;
-
-  /// graph container to create the node
-  lemon::ListDigraph _graph;
-  /// node to index map
-  MapNodeToIndex _map_nodeToIndex;
-  std::unique_ptr<IndexMap> _index;
-  std::unique_ptr<UnionFindObject> _tracksUF;
-
-  const UnionFindObject& getUnionFindEnum() const
-  {
-    return *_tracksUF;
-  }
-
-  const MapNodeToIndex& getReverseMap() const
-  {
-    return _map_nodeToIndex;
-  }
 
   /**
    * @brief Build tracks for a given series of pairWise matches
    * @param[in] pairwiseMatches PairWise matches
+   * @param[in] multithreaded Is multithreaded
    */
-  void build(const PairwiseMatches& pairwiseMatches);
+  void build(const PairwiseMatches& pairwiseMatches, bool multithreaded = true);
 
   /**
    * @brief Remove bad tracks (too short or track with ids collision)
@@ -186,11 +169,38 @@ struct TracksBuilder
    */
   std::size_t nbTracks() const
   {
-    std::size_t cpt = 0;
-    for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
-      ++cpt;
-    return cpt;
+    return _trackOffsets.empty() ? 0 : _trackOffsets.size() - 1;
   }
+
+private:
+  /// Range of feature indexes of a (view, describer type)
+  struct FeaturesRange
+  {
+    IndexT viewId;
+    feature::EImageDescriberType descType;
+    std::uint32_t offset;
+  };
+
+  /// @return the index of the range containing the given feature index
+  std::size_t getRangeIndex(std::uint32_t feature) const;
+
+  /// @return the (view, keypoint) of the given feature index
+  IndexedFeaturePair getIndexedFeaturePair(std::uint32_t feature) const;
+
+  /// union-find: root of the given feature index (path halving)
+  std::uint32_t findRoot(std::uint32_t feature);
+  /// union-find: merge the tracks of the two given feature indexes
+  void unite(std::uint32_t featureA, std::uint32_t featureB);
+
+  /// feature ranges, sorted by (viewId, descType)
+  std::vector<FeaturesRange> _ranges;
+  /// total number of feature indexes
+  std::uint32_t _nbFeatures = 0;
+  /// union-find parent of each feature index (only used during build)
+  std::unique_ptr<std::atomic<std::uint32_t>[]> _parent;
+  /// tracks: the features of the track i are _trackFeatures[_trackOffsets[i] .. _trackOffsets[i+1]]
+  std::vector<std::uint32_t> _trackOffsets;
+  std::vector<std::uint32_t> _trackFeatures;
 };
 
 namespace tracksUtilsMap {
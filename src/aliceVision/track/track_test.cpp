@@ -8,6 +8,9 @@
 #include "aliceVision/track/Track.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
 
+#include <random>
+#include <set>
+#include <tuple>
 #include <vector>
 #include <utility>
 
@@ -178,6 +181,117 @@ BOOST_AUTO_TEST_CASE(Track_Conflict) {
   }
 }
 
+void checkSameTracks(const TracksMap& tracksA, const TracksMap& tracksB)
+{
+  BOOST_CHECK_EQUAL(tracksA.size(), tracksB.size());
+  for(auto itA = tracksA.begin(), itB = tracksB.begin(); itA != tracksA.end() && itB != tracksB.end(); ++itA, ++itB)
+  {
+    BOOST_CHECK_EQUAL(itA->first, itB->first);
+    BOOST_CHECK(itA->second.descType == itB->second.descType);
+    BOOST_CHECK(itA->second.featPerView == itB->second.featPerView);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Track_Multithreaded) {
+
+  // random matches between 10 views, with 2 describer types
+  PairwiseMatches map_pairwisematches;
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_int_distribution<int> distribution(0, 300);
+
+  for(int i = 0; i < 10; ++i)
+  {
+    for(int j = i + 1; j < 10; ++j)
+    {
+      for(EImageDescriberType descType : {EImageDescriberType::SIFT, EImageDescriberType::AKAZE})
+      {
+        std::vector<IndMatch>& matches = map_pairwisematches[std::make_pair(i, j)][descType];
+        for(int m = 0; m < 100; ++m)
+          matches.emplace_back(distribution(randomNumberGenerator), distribution(randomNumberGenerator));
+      }
+    }
+  }
+
+  TracksBuilder trackBuilder;
+  trackBuilder.build(map_pairwisematches, false);
+  TracksMap map_tracks;
+  trackBuilder.exportToSTL(map_tracks);
+
+  TracksBuilder trackBuilderMT;
+  trackBuilderMT.build(map_pairwisematches, true);
+  TracksMap map_tracksMT;
+  trackBuilderMT.exportToSTL(map_tracksMT);
+
+  checkSameTracks(map_tracks, map_tracksMT);
+
+  // a feature belongs to one track
+  std::size_t nbFeatures = 0;
+  std::set<std::tuple<EImageDescriberType, std::size_t, std::size_t>> features;
+  for(const auto& track : map_tracks)
+  {
+    for(const auto& feat : track.second.featPerView)
+      features.insert(std::make_tuple(track.second.descType, feat.first, feat.second));
+    nbFeatures += track.second.featPerView.size();
+  }
+  BOOST_CHECK_EQUAL(nbFeatures, features.size());
+
+  trackBuilder.filter(3, false);
+  trackBuilderMT.filter(3, true);
+  trackBuilder.exportToSTL(map_tracks);
+  trackBuilderMT.exportToSTL(map_tracksMT);
+  checkSameTracks(map_tracks, map_tracksMT);
+
+  for(const auto& track : map_tracks)
+    BOOST_CHECK(track.second.featPerView.size() >= 3);
+}
+
+BOOST_AUTO_TEST_CASE(Track_FilterMultithreaded) {
+
+  // many small tracks: feature k is matched along a chain of views 0..length-1,
+  // some of them with a second feature in the view 1 (conflict)
+  PairwiseMatches map_pairwisematches;
+  std::size_t nbExpectedTracks = 0;
+  for(std::size_t k = 0; k < 10000; ++k)
+  {
+    const std::size_t length = 2 + k % 4;
+    const bool conflict = (k % 7 == 0);
+    for(std::size_t v = 0; v + 1 < length; ++v)
+      map_pairwisematches[std::make_pair(v, v + 1)][EImageDescriberType::SIFT].emplace_back(k, k);
+    if(conflict)
+      map_pairwisematches[std::make_pair(0, 1)][EImageDescriberType::SIFT].emplace_back(k, k + 10000);
+    if(length >= 3 && !conflict)
+      ++nbExpectedTracks;
+  }
+
+  TracksBuilder trackBuilder;
+  trackBuilder.build(map_pairwisematches, false);
+  TracksBuilder trackBuilderMT;
+  trackBuilderMT.build(map_pairwisematches, true);
+  BOOST_CHECK_EQUAL(10000, trackBuilder.nbTracks());
+
+  trackBuilder.filter(3, false);
+  trackBuilderMT.filter(3, true);
+  BOOST_CHECK_EQUAL(nbExpectedTracks, trackBuilder.nbTracks());
+  BOOST_CHECK_EQUAL(nbExpectedTracks, trackBuilderMT.nbTracks());
+
+  TracksMap map_tracks;
+  trackBuilder.exportToSTL(map_tracks);
+  TracksMap map_tracksMT;
+  trackBuilderMT.exportToSTL(map_tracksMT);
+  checkSameTracks(map_tracks, map_tracksMT);
+
+  // the filtered tracks keep their order
+  std::size_t previousFeature = 0;
+  for(const auto& track : map_tracks)
+  {
+    BOOST_CHECK(track.second.featPerView.size() >= 3);
+    const std::size_t feature = track.second.featPerView.at(0);
+    BOOST_CHECK(track.first == 0 || feature > previousFeature);
+    BOOST_CHECK(feature % 7 != 0);
+    previousFeature = feature;
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Track_GetCommonTracksInImages)
 {
   {
@@ -5,9 +5,10 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Database.hpp"
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/tail.hpp>
-#include <boost/progress.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <fstream>
 #include <stdexcept>
@@ -16,6 +17,16 @@
 namespace aliceVision{
 namespace voctree{
 
+Database::EDistanceMethod Database::EDistanceMethod_stringToEnum(const std::string& distanceMethod)
+{
+  if(distanceMethod == "classic")                      return EDistanceMethod::CLASSIC;
+  if(distanceMethod == "commonPoints")                 return EDistanceMethod::COMMON_POINTS;
+  if(distanceMethod == "strongCommonPoints")           return EDistanceMethod::STRONG_COMMON_POINTS;
+  if(distanceMethod == "weightedStrongCommonPoints")   return EDistanceMethod::WEIGHTED_STRONG_COMMON_POINTS;
+  if(distanceMethod == "inversedWeightedCommonPoints") return EDistanceMethod::INVERSED_WEIGHTED_COMMON_POINTS;
+  throw std::invalid_argument("distance method "+ distanceMethod +" unknown!");
+}
+
 std::ostream& operator<<(std::ostream& os, const SparseHistogram &dv)	
 {
 	for( const auto &e : dv )
@@ -35,17 +46,23 @@ DocId Database::insert(DocId doc_id, const SparseHistogram& document)
   // Ensure that the new document to insert is not already there.
   assert(database_.find(doc_id) == database_.end());
 
+  const uint32_t index = document_ids_.size();
+  uint32_t norm = 0;
+
   // For each word, retrieve its inverted file and increment the count for doc_id.
   for(SparseHistogram::const_iterator it = document.begin(), end = document.end(); it != end; ++it)
   {
     Word word = it->first;
     InvertedFile& file = word_files_[word];
-    if(file.empty() || file.back().id != doc_id)
-      file.push_back(WordFrequency(doc_id, it->second.size()));
+    if(file.empty() || file.back().index != index)
+      file.push_back(WordFrequency(index, it->second.size()));
     else
       file.back().count += it->second.size();
+    norm += it->second.size();
   }
 
+  document_ids_.push_back(doc_id);
+  document_norms_.push_back(norm);
   database_[doc_id] = document;
 
   return doc_id;
@@ -66,20 +83,18 @@ void Database::sanityCheck(std::size_t N, std::map<std::size_t, DocMatches>& mat
     N = std::min(N, this->size());
   }
 
+  std::vector<const SparseHistogram*> queries;
+  queries.reserve(database_.size());
+  for(const auto& doc : database_)
+    queries.push_back(&doc.second);
+
+  std::vector<DocMatches> queriesMatches;
+  findAll(queries, N, queriesMatches);
+
   matches.clear();
-  // since we already know the size of the vectors, in order to parallelize the 
-  // query allocate the whole memory
-  boost::progress_display display(database_.size());
-  
-  //#pragma omp parallel for default(none) shared(database_)
-  for(const auto &doc : database_)
-  {
-    std::vector<DocMatch> m;
-    find(doc.second, N, m);
-    //		matches.emplace_back( m );
-    matches[doc.first] = m;
-    ++display;
-  }
+  std::size_t i = 0;
+  for(const auto& doc : database_)
+    matches[doc.first].swap(queriesMatches[i++]);
 }
 
 /**
@@ -110,23 +125,199 @@ void Database::find(const std::vector<Word>& document, std::size_t N, std::vecto
  */
 void Database::find( const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod) const
 {
-  // Accumulate the best N matches
-  using bestN_tag = boost::accumulators::tag::tail<boost::accumulators::left>;
-  boost::accumulators::accumulator_set<DocMatch, boost::accumulators::features<bestN_tag> > acc(bestN_tag::cache_size = N);
+  const EDistanceMethod method = EDistanceMethod_stringToEnum(distanceMethod);
+
+  QueryScores queryScores(document_ids_.size());
+  for(const auto& queryWord : query)
+  {
+    const WordQuery wordQuery = {static_cast<uint32_t>(queryWord.second.size()), &queryScores};
+    accumulateWord(queryWord.first, &wordQuery, 1, method);
+  }
+
+  selectBestN(queryScores, N, method, matches);
+}
+
+void Database::findAll(const std::vector<const SparseHistogram*>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string &distanceMethod) const
+{
+  const EDistanceMethod method = EDistanceMethod_stringToEnum(distanceMethod);
+  const std::size_t nbDocuments = document_ids_.size();
+
+  // bound the memory used by the scores of a block of queries (per thread)
+  const std::size_t maxScoresPerThread = 1 << 22;
+  const std::size_t blockSize = std::max<std::size_t>(1, std::min<std::size_t>(64, maxScoresPerThread / std::max<std::size_t>(1, nbDocuments)));
+  const std::size_t nbBlocks = (queries.size() + blockSize - 1) / blockSize;
+
+  matches.clear();
+  matches.resize(queries.size());
+
+  /// a word of a query of the current block
+  struct BlockWord
+  {
+    Word word;
+    uint32_t query;
+    uint32_t count;
+  };
+
+  #pragma omp parallel
+  {
+    std::vector<QueryScores> blockScores(blockSize, QueryScores(nbDocuments));
+    std::vector<BlockWord> blockWords;
+    std::vector<WordQuery> wordQueries;
+
+    #pragma omp for schedule(dynamic)
+    for(ptrdiff_t b = 0; b < static_cast<ptrdiff_t>(nbBlocks); ++b)
+    {
+      const std::size_t firstQuery = b * blockSize;
+      const std::size_t nbQueries = std::min(blockSize, queries.size() - firstQuery);
+
+      // gather the words of all the queries of the block, sorted by word
+      // so that each inverted file is traversed once for the whole block
+      blockWords.clear();
+      for(std::size_t q = 0; q < nbQueries; ++q)
+      {
+        for(const auto& queryWord : *queries[firstQuery + q])
+          blockWords.push_back({queryWord.first, static_cast<uint32_t>(q), static_cast<uint32_t>(queryWord.second.size())});
+      }
+      std::sort(blockWords.begin(), blockWords.end(), [](const BlockWord& a, const BlockWord& b)
+      {
+        return a.word < b.word || (a.word == b.word && a.query < b.query);
+      });
+
+      // each run of the same word reads its inverted file once for all the queries of the run
+      for(std::size_t begin = 0; begin < blockWords.size();)
+      {
+        const Word word = blockWords[begin].word;
+        wordQueries.clear();
+        std::size_t end = begin;
+        for(; end < blockWords.size() && blockWords[end].word == word; ++end)
+          wordQueries.push_back({blockWords[end].count, &blockScores[blockWords[end].query]});
+
+        accumulateWord(word, wordQueries.data(), wordQueries.size(), method);
+        begin = end;
+      }
+
+      for(std::size_t q = 0; q < nbQueries; ++q)
+        selectBestN(blockScores[q], N, method, matches[firstQuery + q]);
+    }
+  }
+}
+
+void Database::accumulateWord(Word word, const WordQuery* wordQueries, std::size_t nbWordQueries, EDistanceMethod method) const
+{
+  for(std::size_t i = 0; i < nbWordQueries; ++i)
+    wordQueries[i].scores->norm += wordQueries[i].count;
+
+  if(static_cast<std::size_t>(word) >= word_files_.size())
+    return;
+
+  const bool strongMethod = (method == EDistanceMethod::STRONG_COMMON_POINTS || method == EDistanceMethod::WEIGHTED_STRONG_COMMON_POINTS);
+  const float weight = (static_cast<std::size_t>(word) < word_weights_.size()) ? word_weights_[word] : 1.0f;
+
+  for(const WordFrequency& frequency : word_files_[word])
+  {
+    for(std::size_t i = 0; i < nbWordQueries; ++i)
+    {
+      const uint32_t queryCount = wordQueries[i].count;
+      // only the words seen once in both documents are counted
+      if(queryCount != 1 && strongMethod)
+        continue;
+
+      QueryScores& queryScores = *wordQueries[i].scores;
+      double& score = queryScores.scores[frequency.index];
+      if(!queryScores.isTouched[frequency.index])
+      {
+        queryScores.isTouched[frequency.index] = true;
+        queryScores.touched.push_back(frequency.index);
+      }
+
+      switch(method)
+      {
+        case EDistanceMethod::CLASSIC:
+        case EDistanceMethod::COMMON_POINTS:
+          score += std::min(queryCount, frequency.count);
+          break;
+        case EDistanceMethod::STRONG_COMMON_POINTS:
+          if(frequency.count == 1)
+            score += 1.0;
+          break;
+        case EDistanceMethod::WEIGHTED_STRONG_COMMON_POINTS:
+          if(frequency.count == 1)
+            score += weight;
+          break;
+        case EDistanceMethod::INVERSED_WEIGHTED_COMMON_POINTS:
+          score += (1.0 / std::min(queryCount, frequency.count)) * weight;
+          break;
+      }
+    }
+  }
+}
+
+void Database::selectBestN(QueryScores& queryScores, std::size_t N, EDistanceMethod method, DocMatches& matches) const
+{
+  const std::size_t nbDocuments = document_ids_.size();
+
+  N = std::min(N, nbDocuments);
+  matches.clear();
+
+  // Keep the best N in a bounded max-heap, the worst of the best N on top
+  const auto isBetter = [](const DocMatch& a, const DocMatch& b)
+  {
+    return a.score < b.score || (a.score == b.score && a.id < b.id);
+  };
+  matches.reserve(N);
+  const auto accumulate = [&](uint32_t index, float distance)
+  {
+    const DocMatch match(document_ids_[index], distance);
+    if(matches.size() < N)
+    {
+      matches.push_back(match);
+      std::push_heap(matches.begin(), matches.end(), isBetter);
+    }
+    else if(isBetter(match, matches.front()))
+    {
+      std::pop_heap(matches.begin(), matches.end(), isBetter);
+      matches.back() = match;
+      std::push_heap(matches.begin(), matches.end(), isBetter);
+    }
+  };
 
-  /// @todo Try only computing distances against documents sharing at least one word
-  for(const auto& document: database_)
+  if(N == 0)
+  {
+    // nothing to select, the scores are only reset
+  }
+  else if(method == EDistanceMethod::CLASSIC)
   {
-    // for each document/image in the database compute the distance between the 
-    // histograms of the query image and the others
-    float distance = sparseDistance(query, document.second, distanceMethod, word_weights_);
-    acc(DocMatch(document.first, distance));
+    // L1 distance: |q - d| = |q| + |d| - 2 * sum(min(q_i, d_i)) over the shared words,
+    // it depends on the norm of every document
+    for(uint32_t index = 0; index < nbDocuments; ++index)
+      accumulate(index, static_cast<double>(queryScores.norm) + document_norms_[index] - 2.0 * queryScores.scores[index]);
+  }
+  else
+  {
+    for(uint32_t index : queryScores.touched)
+      accumulate(index, -queryScores.scores[index]);
+
+    // the documents without any shared word all have a null distance
+    if(matches.size() < N || matches.front().score >= 0.0f)
+    {
+      for(uint32_t index = 0; index < nbDocuments; ++index)
+      {
+        if(!queryScores.isTouched[index])
+          accumulate(index, 0.0f);
+      }
+    }
   }
 
-  // extract the best N
-  boost::accumulators::extractor<bestN_tag> bestN;
-  matches.resize(std::min(N, database_.size()));
-  std::copy(bestN(acc).begin(), bestN(acc).end(), matches.begin());
+  std::sort_heap(matches.begin(), matches.end(), isBetter);
+
+  // reset the scores of the touched documents only
+  for(uint32_t index : queryScores.touched)
+  {
+    queryScores.scores[index] = 0.0;
+    queryScores.isTouched[index] = false;
+  }
+  queryScores.touched.clear();
+  queryScores.norm = 0;
 }
 
 /**
@@ -94,9 +94,12 @@ public:
    */
   void find(const std::vector<Word>& document, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
   
-    /**
+  /**
    * @brief Find the top N matches in the database for the query document.
    *
+   * Only the documents sharing at least one word with the query are scored,
+   * through the inverted files of the query words.
+   *
    * @param[in] query The query document, a normalized set of quantized words.
    * @param[int] N        The number of matches to return.
    * @param[in] distanceMethod distance method (norm L1, etc.)
@@ -104,6 +107,20 @@ public:
    */
   void find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
 
+  /**
+   * @brief Find the top N matches in the database for each of the query documents.
+   *
+   * The queries are processed by blocks: the inverted file of each word is traversed once
+   * for all the queries of a block using it. Blocks are dynamically distributed over the threads
+   * and the memory used for the scores is bounded, whatever the number of queries.
+   *
+   * @param[in] queries The query documents, normalized sets of quantized words.
+   * @param[in] N        The number of matches to return for each query.
+   * @param[out] matches IDs and scores for the top N matching database documents, for each query.
+   * @param[in] distanceMethod distance method (norm L1, etc.)
+   */
+  void findAll(const std::vector<const SparseHistogram*>& queries, std::size_t N, std::vector<DocMatches>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
+
   /**
    * @brief Compute the TF-IDF weights of all the words. To be called after inserting a corpus of
    * training examples into the database.
@@ -136,17 +153,18 @@ private:
 
   struct WordFrequency
   {
-    DocId id;
+    /// index of the document in document_ids_
+    uint32_t index;
     uint32_t count;
 
     WordFrequency() = default;
-    WordFrequency(DocId _id, uint32_t _count)
-      : id(_id)
+    WordFrequency(uint32_t _index, uint32_t _count)
+      : index(_index)
       , count(_count)
     {}
   };
 
-  // Stored in increasing order by DocId
+  // Stored in increasing order by document index
   typedef std::vector<WordFrequency> InvertedFile;
 
   /// @todo Use sorted vector?
@@ -154,9 +172,53 @@ private:
   
   friend std::ostream& operator<<(std::ostream& os, const SparseHistogram& dv);
 
+  enum class EDistanceMethod
+  {
+    CLASSIC,
+    COMMON_POINTS,
+    STRONG_COMMON_POINTS,
+    WEIGHTED_STRONG_COMMON_POINTS,
+    INVERSED_WEIGHTED_COMMON_POINTS
+  };
+
+  static EDistanceMethod EDistanceMethod_stringToEnum(const std::string& distanceMethod);
+
+  /// Scores of a query against the documents of the database, only the touched documents are reset
+  struct QueryScores
+  {
+    explicit QueryScores(std::size_t nbDocuments)
+      : scores(nbDocuments, 0.0)
+      , isTouched(nbDocuments, false)
+    {}
+
+    /// contribution of the shared words, for each document
+    std::vector<double> scores;
+    std::vector<bool> isTouched;
+    /// documents sharing at least one word with the query
+    std::vector<uint32_t> touched;
+    /// number of features of the query
+    uint32_t norm = 0;
+  };
+
+  /// A query using a word: number of occurrences of the word in the query and scores of the query
+  struct WordQuery
+  {
+    uint32_t count;
+    QueryScores* scores;
+  };
+
+  /// Accumulate the contribution of a word on the documents of its inverted file, for all the queries using it.
+  /// The inverted file is traversed once, whatever the number of queries.
+  void accumulateWord(Word word, const WordQuery* wordQueries, std::size_t nbWordQueries, EDistanceMethod method) const;
+
+  /// Extract the best N matches from the accumulated scores and reset them for the next query
+  void selectBestN(QueryScores& queryScores, std::size_t N, EDistanceMethod method, DocMatches& matches) const;
+
   std::vector<InvertedFile> word_files_;
   std::vector<float> word_weights_;
   SparseHistogramPerImage database_; // Precomputed for inserted documents
+  std::vector<DocId> document_ids_; // DocId of each inserted document, by insertion index
+  std::vector<uint32_t> document_norms_; // Number of features of each inserted document (L1 norm of its histogram)
 
   /**
    * Normalize a document vector representing the histogram of visual words for a given image
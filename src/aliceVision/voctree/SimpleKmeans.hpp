@@ -10,6 +10,7 @@
 #include "DefaultAllocator.hpp"
 
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/function.hpp>
 #include <boost/foreach.hpp>
@@ -18,6 +19,7 @@
 #include <numeric>
 #include <vector>
 #include <limits>
+#include <random>
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
@@ -32,14 +34,15 @@ struct InitRandom
 {
 
   template<class Feature, class Distance, class FeatureAllocator>
-  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, const int verbose = 0)
+  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, std::mt19937& generator, const int verbose = 0)
   {
     ALICEVISION_LOG_DEBUG("#\t\tRandom initialization");
     // Construct a random permutation of the features using a Fisher-Yates shuffle
     std::vector<Feature*> features_perm = features;
     for(size_t i = features.size(); i > 1; --i)
     {
-      size_t k = rand() % i;
+      std::uniform_int_distribution<size_t> indexDistribution(0, i - 1);
+      size_t k = indexDistribution(generator);
       std::swap(features_perm[i - 1], features_perm[k]);
     }
     // Take the first k permuted features as the initial centers
@@ -60,7 +63,7 @@ struct InitKmeanspp
 {
 
   template<class Feature, class Distance, class FeatureAllocator>
-  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, const int verbose = 0)
+  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, std::mt19937& generator, const int verbose = 0)
   {
     typedef typename Distance::result_type squared_distance_type;
 
@@ -86,7 +89,8 @@ struct InitKmeanspp
     typename std::vector<Feature*>::const_iterator featiter;
 
     // 1. Choose a random center
-    size_t randCenter = rand() % features.size();
+    std::uniform_int_distribution<size_t> featureDistribution(0, features.size() - 1);
+    size_t randCenter = featureDistribution(generator);
 
     // add it to the centers
     centers[0] = *features[ randCenter ];
@@ -101,7 +105,8 @@ struct InitKmeanspp
     }
 
     // iterate k-1 times
-    for(int i = 1; i < k; ++i)
+    std::uniform_real_distribution<float> percDistribution(0.f, 1.f);
+    for(size_t i = 1; i < k; ++i)
     {
       if(verbose > 1) ALICEVISION_LOG_DEBUG("Finding initial center " << i + 1);
 
@@ -118,7 +123,7 @@ struct InitKmeanspp
         // 0 and this sum, then start compute the sum from the first element again
         // until the partial sum is greater than the number drawn: the
         // the previous element is what we are looking for
-        const float perc = (float)rand() / RAND_MAX;
+        const float perc = percDistribution(generator);
         squared_distance_type partial = (squared_distance_type)(currSum * perc);
         // look for the element that cap the partial sum that has been
         // drawn
@@ -146,15 +151,14 @@ struct InitKmeanspp
           featidx = dstiter - dists.begin();
 
         // 2. compute the distance of each feature from the current center
-        squared_distance_type distSum = 0;
-
         Feature newCenter = *features[ featidx ];
-        #pragma omp parallel for reduction(+:distSum)
+        #pragma omp parallel for
         for(ptrdiff_t it = 0; it < static_cast<ptrdiff_t>(features.size()); ++it)
         {
           distsTemp[it] = std::min(distance(*(features[it]), newCenter), dists[it]);
-          distSum += distsTemp[it];
         }
+        // sum in order, so the choice does not depend on the number of threads
+        const squared_distance_type distSum = std::accumulate(distsTemp.begin(), distsTemp.end(), squared_distance_type(0));
         if(verbose > 2) ALICEVISION_LOG_DEBUG("trial " << j << " found feat " << featidx << ": " << *features[ featidx ] << " with sum: " << distSum);
 
         if(distSum < bestSum)
@@ -186,7 +190,7 @@ struct InitGiven
 {
 
   template<class Feature, class Distance, class FeatureAllocator>
-  void operator()(const std::vector<Feature*>& features, std::size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, const int verbose = 0)
+  void operator()(const std::vector<Feature*>& features, std::size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, std::mt19937& generator, const int verbose = 0)
   {
     // Do nothing!
   }
@@ -257,6 +261,10 @@ bool checkVectorElements(const std::vector<Feature, FeatureAllocator> &f, const
  * @brief Class for performing K-means clustering, optimized for a particular feature type and metric.
  *
  * The standard Lloyd's algorithm is used. By default, cluster centers are initialized randomly.
+ * If a mini-batch size is set, the mini-batch k-means algorithm is used instead:
+ *
+ *  Sculley, D. (2010). "Web-scale k-means clustering" Proceedings of the 19th
+ *  international conference on World Wide Web. pp. 1177-1178.
  */
 template<class Feature,
          class Distance = L2<Feature, Feature>,
@@ -265,7 +273,7 @@ class SimpleKmeans
 {
 public:
   typedef typename Distance::result_type squared_distance_type;
-  typedef boost::function<void(const std::vector<Feature*>&, std::size_t, std::vector<Feature, FeatureAllocator>&, Distance, const int verbose) > Initializer;
+  typedef boost::function<void(const std::vector<Feature*>&, std::size_t, std::vector<Feature, FeatureAllocator>&, Distance, std::mt19937&, const int verbose) > Initializer;
 
   /**
    * @brief Constructor
@@ -304,6 +312,20 @@ public:
     restarts_ = restarts;
   }
 
+  std::size_t getMiniBatchSize() const
+  {
+    return mini_batch_size_;
+  }
+
+  /**
+   * @brief Set the number of features used at each iteration by the mini-batch k-means.
+   * @param[in] miniBatchSize The batch size, 0 to use the standard Lloyd's algorithm
+   */
+  void setMiniBatchSize(std::size_t miniBatchSize)
+  {
+    mini_batch_size_ = miniBatchSize;
+  }
+
   int getVerbose() const
   {
     return verbose_;
@@ -321,10 +343,24 @@ public:
    * @param      k          The number of clusters.
    * @param[out] centers    A set of k cluster centers.
    * @param[out] membership Cluster assignment for each feature
+   * @param[in,out] generator Random generator used to choose the initial centers, reseed the empty clusters and draw the mini-batches
    */
   squared_distance_type cluster(const std::vector<Feature, FeatureAllocator>& features, std::size_t k,
                                 std::vector<Feature, FeatureAllocator>& centers,
-                                std::vector<unsigned int>& membership) const;
+                                std::vector<unsigned int>& membership,
+                                std::mt19937& generator) const;
+
+  /**
+   * @brief Partition a set of features into k clusters, using a random generator with the default seed.
+   * @see cluster(features, k, centers, membership, generator)
+   */
+  squared_distance_type cluster(const std::vector<Feature, FeatureAllocator>& features, std::size_t k,
+                                std::vector<Feature, FeatureAllocator>& centers,
+                                std::vector<unsigned int>& membership) const
+  {
+    std::mt19937 generator;
+    return cluster(features, k, centers, membership, generator);
+  }
 
   /**
    * @brief Partition a set of features into k clusters.
@@ -336,22 +372,47 @@ public:
    * @param      k          The number of clusters.
    * @param[out] centers    A set of k cluster centers.
    * @param[out] membership Cluster assignment for each feature
+   * @param[in,out] generator Random generator used to choose the initial centers, reseed the empty clusters and draw the mini-batches
+   */
+  squared_distance_type clusterPointers(const std::vector<Feature*>& features, std::size_t k,
+                                        std::vector<Feature, FeatureAllocator>& centers,
+                                        std::vector<unsigned int>& membership,
+                                        std::mt19937& generator) const;
+
+  /**
+   * @brief Partition a set of features into k clusters, using a random generator with the default seed.
+   * @see clusterPointers(features, k, centers, membership, generator)
    */
   squared_distance_type clusterPointers(const std::vector<Feature*>& features, std::size_t k,
                                         std::vector<Feature, FeatureAllocator>& centers,
-                                        std::vector<unsigned int>& membership) const;
+                                        std::vector<unsigned int>& membership) const
+  {
+    std::mt19937 generator;
+    return clusterPointers(features, k, centers, membership, generator);
+  }
 
 private:
 
   squared_distance_type clusterOnce(const std::vector<Feature*>& features, std::size_t k,
                                     std::vector<Feature, FeatureAllocator>& centers,
-                                    std::vector<unsigned int>& membership) const;
+                                    std::vector<unsigned int>& membership,
+                                    std::mt19937& generator) const;
+
+  squared_distance_type clusterOnceMiniBatch(const std::vector<Feature*>& features, std::size_t k,
+                                             std::vector<Feature, FeatureAllocator>& centers,
+                                             std::vector<unsigned int>& membership,
+                                             std::mt19937& generator) const;
+
+  /// @return the index of the center nearest to the feature and its distance
+  unsigned int nearestCenter(const Feature& feature, const std::vector<Feature, FeatureAllocator>& centers,
+                             std::size_t k, squared_distance_type& d_min) const;
 
   Feature zero_;
   Distance distance_;
   Initializer choose_centers_;
   std::size_t max_iterations_;
   std::size_t restarts_;
+  std::size_t mini_batch_size_;
   int verbose_;
 };
 
@@ -362,29 +423,54 @@ distance_(d),
 //    choose_centers_( InitRandom( ) ),
 choose_centers_(InitKmeanspp()),
 max_iterations_(100),
-verbose_(verbose),
-restarts_(1)
+restarts_(1),
+mini_batch_size_(0),
+verbose_(verbose)
+{
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+unsigned int SimpleKmeans<Feature, Distance, FeatureAllocator>::nearestCenter(const Feature& feature,
+                                                                              const std::vector<Feature, FeatureAllocator>& centers,
+                                                                              std::size_t k, squared_distance_type& d_min) const
 {
+  d_min = std::numeric_limits<squared_distance_type>::max();
+  unsigned int nearest = 0;
+
+  // @todo if k is large, let's say k>100 use FLAAN to retrieve the
+  // cluster center
+  for(unsigned int j = 0; j < k; ++j)
+  {
+    const squared_distance_type distance = distance_(feature, centers[j]);
+    if(distance < d_min)
+    {
+      d_min = distance;
+      nearest = j;
+    }
+  }
+  return nearest;
 }
 
 template < class Feature, class Distance, class FeatureAllocator >
 typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
 SimpleKmeans<Feature, Distance, FeatureAllocator>::cluster(const std::vector<Feature, FeatureAllocator>& features, size_t k,
                                                            std::vector<Feature, FeatureAllocator>& centers,
-                                                           std::vector<unsigned int>& membership) const
+                                                           std::vector<unsigned int>& membership,
+                                                           std::mt19937& generator) const
 {
   std::vector<Feature*> feature_ptrs;
   feature_ptrs.reserve(features.size());
   BOOST_FOREACH(const Feature& f, features)
   feature_ptrs.push_back(const_cast<Feature*> (&f));
-  return clusterPointers(feature_ptrs, k, centers, membership);
+  return clusterPointers(feature_ptrs, k, centers, membership, generator);
 }
 
 template < class Feature, class Distance, class FeatureAllocator >
 typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
 SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterPointers(const std::vector<Feature*>& features, size_t k,
                                                                    std::vector<Feature, FeatureAllocator>& centers,
-                                                                   std::vector<unsigned int>& membership) const
+                                                                   std::vector<unsigned int>& membership,
+                                                                   std::mt19937& generator) const
 {
   std::vector<Feature, FeatureAllocator> new_centers(centers);
   new_centers.resize(k);
@@ -395,8 +481,10 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterPointers(const std::ve
   for(std::size_t starts = 0; starts < restarts_; ++starts)
   {
     if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Trial " << starts + 1 << "/" << restarts_);
-    choose_centers_(features, k, new_centers, distance_, verbose_);
-    squared_distance_type sse = clusterOnce(features, k, new_centers, new_membership);
+    choose_centers_(features, k, new_centers, distance_, generator, verbose_);
+    squared_distance_type sse = (mini_batch_size_ > 0 && features.size() > mini_batch_size_) ?
+                                  clusterOnceMiniBatch(features, k, new_centers, new_membership, generator) :
+                                  clusterOnce(features, k, new_centers, new_membership, generator);
     if(verbose_ > 0) ALICEVISION_LOG_DEBUG("End of Trial " << starts + 1 << "/" << restarts_);
     if(sse < least_sse)
     {
@@ -415,7 +503,8 @@ template < class Feature, class Distance, class FeatureAllocator >
 typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
 SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector<Feature*>& features, std::size_t k,
                                                                std::vector<Feature, FeatureAllocator>& centers,
-                                                               std::vector<unsigned int>& membership) const
+                                                               std::vector<unsigned int>& membership,
+                                                               std::mt19937& generator) const
 {
   typedef typename std::vector<Feature, FeatureAllocator>::value_type centerType;
   typedef typename Distance::value_type feature_value_type;
@@ -424,6 +513,12 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
   std::vector<Feature, FeatureAllocator> new_centers(k);
   squared_distance_type max_center_shift = std::numeric_limits<squared_distance_type>::max();
 
+  // The cluster centers are accumulated per block of features and the blocks are summed in order:
+  // the number of blocks does not depend on the number of threads, so neither does the result.
+  const std::size_t nb_blocks = std::min(features.size(), static_cast<std::size_t>(64));
+  std::vector<std::vector<Feature, FeatureAllocator> > block_centers(nb_blocks);
+  std::vector<std::vector<std::size_t> > block_center_counts(nb_blocks);
+
   if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Iterations");
   for(std::size_t iter = 0; iter < max_iterations_; ++iter)
   {
@@ -438,49 +533,41 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
 
 
     // Assign data objects to current centers
-    #pragma omp parallel for shared( new_centers, new_center_counts, features, centers, membership)
-    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
+    #pragma omp parallel for schedule(dynamic) reduction(&&:is_stable)
+    for(ptrdiff_t b = 0; b < static_cast<ptrdiff_t>(nb_blocks); ++b)
     {
-      squared_distance_type d_min = std::numeric_limits<squared_distance_type>::max();
-      unsigned int nearest = 0;
-      bool found = false;
-
-      // @todo if k is large, let's say k>100 use FLAAN to retrieve the 
-      // cluster center
-
-      // Find the nearest cluster center to feature i
-      for(unsigned int j = 0; j < k; ++j)
+      // Accumulate the cluster centers and their membership counts of the block
+      std::vector<Feature, FeatureAllocator>& block_centers_b = block_centers[b];
+      std::vector<std::size_t>& block_center_counts_b = block_center_counts[b];
+      block_centers_b.assign(k, zero_);
+      block_center_counts_b.assign(k, 0);
+
+      const std::size_t block_begin = features.size() * b / nb_blocks;
+      const std::size_t block_end = features.size() * (b + 1) / nb_blocks;
+      for(std::size_t i = block_begin; i < block_end; ++i)
       {
-        squared_distance_type distance = distance_(*features[i], centers[j]);
-        //		printf("\t\tdistance %f\n", (float)distance);
-        //		PrintFeat(*features[i] );
-        if(distance < d_min)
+        // Find the nearest cluster center to feature i
+        squared_distance_type d_min;
+        const unsigned int nearest = nearestCenter(*features[i], centers, k, d_min);
+
+        // Assign feature i to the cluster it is nearest to
+        if(membership[i] != nearest)
         {
-          d_min = distance;
-          nearest = j;
-          found = true;
+          is_stable = false;
+          membership[i] = nearest;
         }
-        //		 printf("\t distance %f %f\n", (double)distance, (double)d_min);
-      }
-      assert(found);
-      // Assign feature i to the cluster it is nearest to
-      if(membership[i] != nearest)
-      {
-        is_stable = false;
-        membership[i] = nearest;
+        block_centers_b[nearest] += *features[i];
+        ++block_center_counts_b[nearest];
       }
-      // Accumulate the cluster center and its membership count
-      //	  printf("\t nearest %d\n", nearest);
-      //			checkElements(*features[i], "feat");
-      #pragma omp critical
+    }
+    for(std::size_t b = 0; b < nb_blocks; ++b)
+    {
+      for(std::size_t j = 0; j < k; ++j)
       {
-        new_centers[nearest] += *features[i];
-        //			checkElements(new_centers[nearest], "sum");
-        //	  printf("\t new_centers[nearest] += *features[i];\n");
-        ++new_center_counts[nearest];
-        //	  printf("\taccumulate\n");
+        new_centers[j] += block_centers[b][j];
+        new_center_counts[j] += block_center_counts[b][j];
       }
-    }//for
+    }
 
     if(is_stable) break;
 
@@ -509,7 +596,8 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
       {
         // Choose a new center randomly from the input features
         // @todo use a better strategy like taking splitting the largest cluster
-        unsigned int index = rand() % features.size();
+        std::uniform_int_distribution<std::size_t> featureDistribution(0, features.size() - 1);
+        const std::size_t index = featureDistribution(generator);
         centers[i] = *features[index];
         ALICEVISION_LOG_DEBUG("Choosing a new center: " << index);
       }
@@ -519,15 +607,78 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
   }
   if(verbose_ > 0) ALICEVISION_LOG_DEBUG("");
 
-  // Return the sum squared error
+  // Return the sum squared error, summed in order
   /// @todo Kahan summation?
-  squared_distance_type sse = squared_distance_type(0);
   assert(features.size() > 0);
-  for(std::size_t i = 0; i < features.size(); ++i)
+  std::vector<squared_distance_type> distances(features.size());
+  #pragma omp parallel for
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
+  {
+    distances[i] = distance_(*features[i], centers[membership[i]]);
+  }
+  return std::accumulate(distances.begin(), distances.end(), squared_distance_type(0));
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
+SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnceMiniBatch(const std::vector<Feature*>& features, std::size_t k,
+                                                                        std::vector<Feature, FeatureAllocator>& centers,
+                                                                        std::vector<unsigned int>& membership,
+                                                                        std::mt19937& generator) const
+{
+  typedef typename Distance::value_type feature_value_type;
+
+  std::vector<std::size_t> center_counts(k, 0);
+  std::vector<Feature, FeatureAllocator> previous_centers(k);
+  std::vector<std::size_t> batch(mini_batch_size_);
+  std::vector<unsigned int> batch_membership(mini_batch_size_);
+
+  std::uniform_int_distribution<std::size_t> featureDistribution(0, features.size() - 1);
+
+  if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Mini-batch iterations");
+  for(std::size_t iter = 0; iter < max_iterations_; ++iter)
+  {
+    if(verbose_ > 0) ALICEVISION_LOG_DEBUG("*");
+
+    // Draw the batch
+    for(std::size_t& index : batch)
+      index = featureDistribution(generator);
+
+    // Assign the batch features to the current centers
+    #pragma omp parallel for
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(batch.size()); ++i)
+    {
+      squared_distance_type d_min;
+      batch_membership[i] = nearestCenter(*features[batch[i]], centers, k, d_min);
+    }
+
+    // Move the centers toward their batch features, with a per-center learning rate
+    std::copy(centers.begin(), centers.begin() + k, previous_centers.begin());
+    for(std::size_t i = 0; i < batch.size(); ++i)
+    {
+      const Feature& feature = *features[batch[i]];
+      Feature& center = centers[batch_membership[i]];
+      const double eta = 1.0 / ++center_counts[batch_membership[i]];
+      for(std::size_t d = 0; d < static_cast<std::size_t>(center.size()); ++d)
+        center[d] = static_cast<feature_value_type>(center[d] + eta * (feature[d] - center[d]));
+    }
+
+    squared_distance_type max_center_shift = 0;
+    for(std::size_t i = 0; i < k; ++i)
+      max_center_shift = std::max(max_center_shift, distance_(centers[i], previous_centers[i]));
+    if(max_center_shift <= 10e-10) break;
+  }
+  if(verbose_ > 0) ALICEVISION_LOG_DEBUG("");
+
+  // Assign all the features to the final centers and return the sum squared error, summed in order
+  assert(features.size() > 0);
+  std::vector<squared_distance_type> distances(features.size());
+  #pragma omp parallel for
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
   {
-    sse += distance_(*features[i], centers[membership[i]]);
+    membership[i] = nearestCenter(*features[i], centers, k, distances[i]);
   }
-  return sse;
+  return std::accumulate(distances.begin(), distances.end(), squared_distance_type(0));
 }
 
 }
@@ -8,7 +8,11 @@
 
 #include "MutableVocabularyTree.hpp"
 #include "SimpleKmeans.hpp"
-#include <deque>
+
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <random>
 //#include <cstdio> //DEBUG
 
 namespace aliceVision {
@@ -105,29 +109,42 @@ void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(const FeatureVecto
   tree_.centers().reserve(tree_.nodes());
   tree_.validCenters().reserve(tree_.nodes());
 
-  // We keep a queue of disjoint feature subsets to cluster.
+  // We keep the disjoint feature subsets to cluster at the current level,
+  // in the order of their parent node.
   // Feature* is used to avoid copying features.
-  std::deque< std::vector<Feature*> > subset_queue(1);
+  std::vector< std::vector<Feature*> > subsets(1);
 
   {
-    // At first the queue contains one "subset" containing all the features.
-    std::vector<Feature*> &feature_ptrs = subset_queue.front();
+    // At first there is one "subset" containing all the features.
+    std::vector<Feature*> &feature_ptrs = subsets.front();
     feature_ptrs.reserve(training_features.size());
     for(const Feature& f: training_features)
     {
       feature_ptrs.push_back(const_cast<Feature*> (&f));
     }
   }
-  FeatureVector centers; // always size k
   for(uint32_t level = 0; level < levels; ++level)
   {
     if(verbose_) printf("# Level %u\n", level);
-    std::vector<unsigned int> membership;
 
-    for(std::size_t i = 0, ie = subset_queue.size(); i < ie; ++i)
+    // The children of subset i are the centers [i*k, (i+1)*k[ of the level
+    // and the subsets [i*k, (i+1)*k[ of the next level.
+    const std::size_t nb_subsets = subsets.size();
+    const std::size_t level_offset = tree_.centers().size();
+    tree_.centers().resize(level_offset + nb_subsets * k, zero_);
+    tree_.validCenters().resize(level_offset + nb_subsets * k, 0);
+    std::vector< std::vector<Feature*> > new_subsets(nb_subsets * k);
+
+    // Sibling subsets are independent: cluster them in parallel when there are enough of them,
+    // otherwise the k-means is parallelized internally.
+    // Each subset has its own random generator seeded from its position in the tree,
+    // so the tree does not depend on the number of threads or on the scheduling.
+    #pragma omp parallel for schedule(dynamic) if(nb_subsets >= static_cast<std::size_t>(omp_get_max_threads()))
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nb_subsets); ++i)
     {
-      std::vector<Feature*> &subset = subset_queue.front();
-      if(verbose_ > 1) printf("#\tClustering subset %lu/%lu of size %lu\n", i + 1, ie, subset.size());
+      std::vector<Feature*> &subset = subsets[i];
+      const std::size_t first_child = level_offset + i * k;
+      if(verbose_ > 1) printf("#\tClustering subset %lu/%lu of size %lu\n", static_cast<std::size_t>(i) + 1, nb_subsets, subset.size());
 
       // If the subset already has k or fewer elements, just use those as the centers.
       if(subset.size() <= k)
@@ -135,39 +152,35 @@ void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(const FeatureVecto
         if(verbose_ > 2) printf("#\tno need to cluster %lu elements\n", subset.size());
         for(std::size_t j = 0; j < subset.size(); ++j)
         {
-          tree_.centers().push_back(*subset[j]);
-          tree_.validCenters().push_back(1);
+          tree_.centers()[first_child + j] = *subset[j];
+          tree_.validCenters()[first_child + j] = 1;
         }
-        // Mark non-existent centers as invalid.
-        tree_.centers().insert(tree_.centers().end(), k - subset.size(), zero_);
-        tree_.validCenters().insert(tree_.validCenters().end(), k - subset.size(), 0);
-
-        // Push k empty subsets into the queue so all children get marked invalid.
-        subset_queue.pop_front();
-        subset_queue.insert(subset_queue.end(), k, std::vector<Feature*>());
+        // Non-existent centers stay invalid and all their children get marked invalid (empty subsets).
       }
       else
       {
         // Cluster the current subset into k centers.
         if(verbose_ > 2) printf("#\tclustering the current subset of %lu elements into %d centers\n", subset.size(), k);
-        kmeans_.clusterPointers(subset, k, centers, membership);
+        FeatureVector centers;
+        std::vector<unsigned int> membership;
+        std::seed_seq seed{level, static_cast<uint32_t>(i)};
+        std::mt19937 generator(seed);
+        kmeans_.clusterPointers(subset, k, centers, membership, generator);
         // Add the centers and mark them as valid.
-        tree_.centers().insert(tree_.centers().end(), centers.begin(), centers.end());
-        tree_.validCenters().insert(tree_.validCenters().end(), k, 1);
+        std::copy(centers.begin(), centers.begin() + k, tree_.centers().begin() + first_child);
+        std::fill(tree_.validCenters().begin() + first_child, tree_.validCenters().begin() + first_child + k, 1);
         // Partition the current subset into k new subsets based on the cluster assignments.
-        std::vector< std::vector<Feature*> > new_subsets(k);
         assert(membership.size() >= subset.size());
         for(std::size_t j = 0; j < subset.size(); ++j)
         {
           assert(membership[j] < k);
-          assert(membership[j] < new_subsets.size());
-          new_subsets[ membership[j] ].push_back(subset[j]);
+          new_subsets[i * k + membership[j]].push_back(subset[j]);
         }
-        // Update the queue
-        subset_queue.pop_front();
-        subset_queue.insert(subset_queue.end(), new_subsets.begin(), new_subsets.end());
       }
+      // Release the subset
+      std::vector<Feature*>().swap(subset);
     }
+    subsets.swap(new_subsets);
     if(verbose_) printf("# centers so far = %lu\n", tree_.centers().size());
   }
 }
@@ -17,6 +17,7 @@
 #include <aliceVision/system/Logger.hpp>
 
 #include <stdint.h>
+#include <algorithm>
 #include <vector>
 #include <map>
 #include <cassert>
@@ -117,6 +118,16 @@ public:
   template<class DescriptorT>
   Word quantize(const DescriptorT& feature) const;
 
+  /**
+   * @brief Quantizes a batch of features into visual words.
+   * The features are quantized level by level, grouped by node.
+   * @param[in] features The features
+   * @param[in] nbFeatures The number of features
+   * @param[out] words The visual words, of size nbFeatures
+   */
+  template<class DescriptorT>
+  void quantize(const DescriptorT* features, std::size_t nbFeatures, Word* words) const;
+
   /// Quantizes a set of features into visual words.
   template<class DescriptorT>
   std::vector<Word> quantize(const std::vector<DescriptorT>& features) const;
@@ -171,6 +182,22 @@ protected:
   }
 
   void setNodeCounts();
+
+  /**
+   * @brief Find the child of a node closest to a feature.
+   * The children of a node are stored contiguously in centers_,
+   * their distances to the feature are computed at once.
+   * @param[in] feature The feature
+   * @param[in] query The feature prepared for the block distance
+   * @param[in] index The node index (-1 for the root)
+   * @param[out] distances Buffer for the children distances, of size splits()
+   * @return the index of the closest child
+   */
+  template<class DescriptorT>
+  int32_t closestChild(const DescriptorT& feature,
+                       const typename BlockDistance<DescriptorT, Feature, Distance>::Query& query,
+                       int32_t index,
+                       typename BlockDistance<DescriptorT, Feature, Distance>::result_type* distances) const;
 };
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
@@ -188,38 +215,109 @@ VocabularyTree<Feature, Distance, FeatureAllocator>::VocabularyTree(const std::s
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 template<class DescriptorT>
-Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const DescriptorT& feature) const
+int32_t VocabularyTree<Feature, Distance, FeatureAllocator>::closestChild(const DescriptorT& feature,
+                                                                          const typename BlockDistance<DescriptorT, Feature, Distance>::Query& query,
+                                                                          int32_t index,
+                                                                          typename BlockDistance<DescriptorT, Feature, Distance>::result_type* distances) const
 {
-  typedef typename Distance<Feature, DescriptorT>::result_type distance_type;
+  typedef BlockDistance<DescriptorT, Feature, Distance> BlockDistanceT;
+  typedef typename BlockDistanceT::result_type block_distance_type;
+  typedef typename Distance<DescriptorT, Feature>::result_type distance_type;
+
+  // Calculate the offset to the first child of the current index.
+  const int32_t first_child = (index + 1) * splits();
+  // Fewer than splits() children if some centers are invalid.
+  int32_t nb_children = 0;
+  while(nb_children < (int32_t) splits() && valid_centers_[first_child + nb_children])
+    ++nb_children;
+  if(nb_children == 0)
+    return first_child;
+
+  // Compute the distances to all the children, stored contiguously.
+  BlockDistanceT::compute(query, &centers_[first_child], nb_children, distances);
+
+  // Find the child center closest to the query.
+  int32_t best_child = 0;
+  for(int32_t child = 1; child < nb_children; ++child)
+  {
+    if(distances[child] < distances[best_child])
+      best_child = child;
+  }
 
-  //	printf("asserting\n");
-  assert(initialized());
-  //	printf("initialized\n");
-  int32_t index = -1; // virtual "root" index, which has no associated center.
-  for(unsigned level = 0; level < levels_; ++level)
+  const double relativeError = BlockDistanceT::relativeError();
+  if(relativeError > 0.0)
   {
-    // Calculate the offset to the first child of the current index.
-    int32_t first_child = (index + 1) * splits();
-    // Find the child center closest to the query.
-    int32_t best_child = first_child;
+    // The block distances are approximated:
+    // check the candidates that could be the closest one with the exact distance.
+    const block_distance_type threshold = static_cast<block_distance_type>(distances[best_child] * (1.0 + relativeError));
     distance_type best_distance = std::numeric_limits<distance_type>::max();
-    for(int32_t child = first_child; child < first_child + (int32_t) splits(); ++child)
+    for(int32_t child = 0; child < nb_children; ++child)
     {
-      if(!valid_centers_[child])
-        break; // Fewer than splits() children.
-      distance_type child_distance = Distance<DescriptorT, Feature>()(feature, centers_[child]);
+      if(distances[child] > threshold)
+        continue;
+      const distance_type child_distance = Distance<DescriptorT, Feature>()(feature, centers_[first_child + child]);
       if(child_distance < best_distance)
       {
         best_child = child;
         best_distance = child_distance;
       }
     }
-    index = best_child;
   }
+  return first_child + best_child;
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const DescriptorT& feature) const
+{
+  typedef BlockDistance<DescriptorT, Feature, Distance> BlockDistanceT;
+
+  assert(initialized());
+
+  typename BlockDistanceT::Query query;
+  BlockDistanceT::prepare(feature, query);
+  std::vector<typename BlockDistanceT::result_type> distances(splits());
+
+  int32_t index = -1; // virtual "root" index, which has no associated center.
+  for(unsigned level = 0; level < levels_; ++level)
+    index = closestChild(feature, query, index, distances.data());
 
   return index - word_start_;
 }
 
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const DescriptorT* features, std::size_t nbFeatures, Word* words) const
+{
+  typedef BlockDistance<DescriptorT, Feature, Distance> BlockDistanceT;
+
+  assert(initialized());
+
+  std::vector<typename BlockDistanceT::Query> queries(nbFeatures);
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+    BlockDistanceT::prepare(features[i], queries[i]);
+  std::vector<typename BlockDistanceT::result_type> distances(splits());
+
+  std::vector<int32_t> indexes(nbFeatures, -1); // start from the virtual "root" index
+  std::vector<uint32_t> order(nbFeatures);
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+    order[i] = i;
+
+  for(unsigned level = 0; level < levels_; ++level)
+  {
+    // Visit the features sharing the same node one after the other,
+    // so the children of the node are read from the cache.
+    if(level > 0)
+      std::sort(order.begin(), order.end(), [&indexes](uint32_t a, uint32_t b) { return indexes[a] < indexes[b]; });
+
+    for(uint32_t i : order)
+      indexes[i] = closestChild(features[i], queries[i], indexes[i], distances.data());
+  }
+
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+    words[i] = indexes[i] - word_start_;
+}
+
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 template<class DescriptorT>
 std::vector<Word> VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const std::vector<DescriptorT>& features) const
@@ -227,12 +325,17 @@ std::vector<Word> VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(
   // ALICEVISION_LOG_DEBUG("VocabularyTree quantize: " << features.size());
   std::vector<Word> imgVisualWords(features.size(), 0);
 
-  // quantize the features
-  #pragma omp parallel for
-  for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(features.size()); ++j)
+  // quantize the features by batches
+  const std::size_t batchSize = 256;
+  const ptrdiff_t nbBatches = static_cast<ptrdiff_t>((features.size() + batchSize - 1) / batchSize);
+
+  #pragma omp parallel for schedule(dynamic)
+  for(ptrdiff_t b = 0; b < nbBatches; ++b)
   {
-    // store the visual word associated to the feature in the temporary list
-    imgVisualWords[j] = quantize<DescriptorT>(features[j]);
+    const std::size_t first = b * batchSize;
+    const std::size_t size = std::min(batchSize, features.size() - first);
+    // store the visual words associated to the features in the temporary list
+    quantize(&features[first], size, &imgVisualWords[first]);
   }
 
   // add the vector to the documents
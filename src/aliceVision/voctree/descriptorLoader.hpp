@@ -52,6 +52,29 @@ std::size_t readDescFromFiles(const sfmData::SfMData& sfmData,
                          std::vector<DescriptorT>& descriptors,
                          std::vector<std::size_t>& numFeatures);
 
+/**
+ * @brief Read a random subset of the descriptors of a sfmData.
+ *
+ * The descriptor files are read one after the other and a uniform random sample
+ * of the descriptors is kept (reservoir sampling), so at most \p maxDescriptors
+ * descriptors are in memory whatever the total number of descriptors.
+ *
+ * @param[in] sfmData The input sfmData
+ * @param[in] featuresFolders The folder(s) containing the descriptor files (optional)
+ * @param[in] maxDescriptors The maximum number of descriptors to keep
+ * @param[out] descriptors The sampled descriptors
+ * @param[out] numFeatures A vector collecting for each file read the number of features in the file
+ * @param[in] seed The random generator seed
+ * @return the total number of features read
+ */
+template<class DescriptorT, class FileDescriptorT>
+std::size_t sampleDescFromFiles(const sfmData::SfMData& sfmData,
+                                const std::vector<std::string>& featuresFolders,
+                                std::size_t maxDescriptors,
+                                std::vector<DescriptorT>& descriptors,
+                                std::vector<std::size_t>& numFeatures,
+                                unsigned int seed = 0);
+
 } // namespace voctree
 } // namespace aliceVision
 
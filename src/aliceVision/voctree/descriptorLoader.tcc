@@ -13,6 +13,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <random>
 
 namespace aliceVision {
 namespace voctree {
@@ -89,5 +90,55 @@ std::size_t readDescFromFiles(const sfmData::SfMData& sfmData,
   return numDescriptors;
 }
 
+template<class DescriptorT, class FileDescriptorT>
+std::size_t sampleDescFromFiles(const sfmData::SfMData& sfmData,
+                                const std::vector<std::string>& featuresFolders,
+                                std::size_t maxDescriptors,
+                                std::vector<DescriptorT>& descriptors,
+                                std::vector<std::size_t>& numFeatures,
+                                unsigned int seed)
+{
+  std::map<IndexT, std::string> descriptorsFiles;
+  getListOfDescriptorFiles(sfmData, featuresFolders, descriptorsFiles);
+
+  descriptors.clear();
+  descriptors.reserve(maxDescriptors);
+  numFeatures.clear();
+  numFeatures.reserve(descriptorsFiles.size());
+
+  std::mt19937_64 generator(seed);
+  std::size_t numDescriptors = 0;
+  std::vector<DescriptorT> fileDescriptors;
+
+  ALICEVISION_LOG_DEBUG("Sampling at most " << maxDescriptors << " descriptors...");
+  boost::progress_display display(descriptorsFiles.size());
+
+  for(const auto &currentFile : descriptorsFiles)
+  {
+    feature::loadDescsFromBinFile<DescriptorT, FileDescriptorT>(currentFile.second, fileDescriptors, false);
+    numFeatures.push_back(fileDescriptors.size());
+
+    for(const DescriptorT& descriptor : fileDescriptors)
+    {
+      // Reservoir sampling: the i-th descriptor is kept with probability maxDescriptors / (i + 1)
+      if(descriptors.size() < maxDescriptors)
+      {
+        descriptors.push_back(descriptor);
+      }
+      else
+      {
+        const std::size_t j = std::uniform_int_distribution<std::size_t>(0, numDescriptors)(generator);
+        if(j < maxDescriptors)
+          descriptors[j] = descriptor;
+      }
+      ++numDescriptors;
+    }
+    ++display;
+  }
+
+  ALICEVISION_LOG_DEBUG("Kept " << descriptors.size() << " descriptors out of " << numDescriptors);
+  return numDescriptors;
+}
+
 } // namespace voctree
 } // namespace aliceVision
@@ -6,10 +6,21 @@
 
 #pragma once
 
+#include <aliceVision/config.hpp>
+#include <aliceVision/feature/Descriptor.hpp>
+
 #include <stdint.h>
 //#include <iostream>
 #include <Eigen/Core>
 
+#include <cstddef>
+#include <limits>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#endif
+
 namespace aliceVision {
 namespace voctree {
 
@@ -57,5 +68,166 @@ struct L2< Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>, Eigen::
   }
 };
 
+/**
+ * @brief Distances between a query and a block of contiguous descriptors
+ * (the children of a vocabulary tree node).
+ *
+ * The query is converted once by prepare() and reused for all the blocks.
+ * The distances computed by compute() may differ from \c Distance by at most
+ * relativeError() (relative), the caller is expected to check the ambiguous
+ * candidates with \c Distance.
+ *
+ * This default implementation simply calls \c Distance on each descriptor.
+ */
+template<class DescriptorA, class DescriptorB, template<typename, typename> class Distance>
+struct BlockDistance
+{
+  typedef typename Distance<DescriptorA, DescriptorB>::result_type result_type;
+  typedef const DescriptorA* Query;
+
+  static double relativeError() { return 0.0; }
+
+  static void prepare(const DescriptorA& a, Query& query)
+  {
+    query = &a;
+  }
+
+  static void compute(const Query& query, const DescriptorB* block, std::size_t size, result_type* distances)
+  {
+    const Distance<DescriptorA, DescriptorB> distance;
+    for(std::size_t i = 0; i < size; ++i)
+      distances[i] = distance(*query, block[i]);
+  }
+};
+
+/**
+ * @brief Vectorized L2 distances between unsigned char descriptors.
+ * The differences are computed on 16 bits and squared/accumulated on 32 bits integers,
+ * so the result is exact.
+ */
+template<std::size_t N>
+struct BlockDistance<feature::Descriptor<unsigned char, N>, feature::Descriptor<unsigned char, N>, L2>
+{
+  typedef feature::Descriptor<unsigned char, N> DescriptorT;
+  typedef float result_type;
+
+  /// query widened to 16 bits, read with unaligned loads (a std::vector does not guarantee the 16 bytes alignment)
+  struct Query
+  {
+    alignas(16) int16_t data[N];
+  };
+
+  static double relativeError() { return 0.0; }
+
+  static void prepare(const DescriptorT& a, Query& query)
+  {
+    const unsigned char* aPt = a.getData();
+    for(std::size_t i = 0; i < N; ++i)
+      query.data[i] = aPt[i];
+  }
+
+  static void compute(const Query& query, const DescriptorT* block, std::size_t size, result_type* distances)
+  {
+    for(std::size_t c = 0; c < size; ++c)
+    {
+      const unsigned char* bPt = block[c].getData();
+      std::size_t i = 0;
+      int32_t result = 0;
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+      const __m128i zero = _mm_setzero_si128();
+      __m128i cumSum = _mm_setzero_si128();
+      for(; i + 16 <= N; i += 16)
+      {
+        const __m128i srcB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bPt + i));
+        //-- Subtract
+        const __m128i diffLow = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(query.data + i)), _mm_unpacklo_epi8(srcB, zero));
+        const __m128i diffHigh = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(query.data + i + 8)), _mm_unpackhi_epi8(srcB, zero));
+        //-- Multiply and sum adjacent pairs
+        cumSum = _mm_add_epi32(cumSum, _mm_madd_epi16(diffLow, diffLow));
+        cumSum = _mm_add_epi32(cumSum, _mm_madd_epi16(diffHigh, diffHigh));
+      }
+      //-- horizontal sum
+      cumSum = _mm_add_epi32(cumSum, _mm_shuffle_epi32(cumSum, _MM_SHUFFLE(1, 0, 3, 2)));
+      cumSum = _mm_add_epi32(cumSum, _mm_shuffle_epi32(cumSum, _MM_SHUFFLE(2, 3, 0, 1)));
+      result = _mm_cvtsi128_si32(cumSum);
+#endif
+      for(; i < N; ++i)
+      {
+        const int32_t diff = query.data[i] - static_cast<int32_t>(bPt[i]);
+        result += diff * diff;
+      }
+      distances[c] = static_cast<result_type>(result);
+    }
+  }
+};
+
+/**
+ * @brief Vectorized L2 distances between a descriptor and float descriptors.
+ * The distances are accumulated in single precision (L2 uses double precision).
+ */
+template<class DescriptorA, std::size_t N>
+struct BlockDistanceFloat
+{
+  typedef feature::Descriptor<float, N> DescriptorB;
+  typedef float result_type;
+
+  /// query converted to float, read with unaligned loads (a std::vector does not guarantee the 16 bytes alignment)
+  struct Query
+  {
+    alignas(16) float data[N];
+  };
+
+  /// bound of the rounding errors of the differences and of the sum of N squares
+  static double relativeError() { return 4.0 * (N + 2) * std::numeric_limits<float>::epsilon(); }
+
+  static void prepare(const DescriptorA& a, Query& query)
+  {
+    for(std::size_t i = 0; i < N; ++i)
+      query.data[i] = static_cast<float>(a[i]);
+  }
+
+  static void compute(const Query& query, const DescriptorB* block, std::size_t size, result_type* distances)
+  {
+    for(std::size_t c = 0; c < size; ++c)
+    {
+      const float* bPt = block[c].getData();
+      std::size_t i = 0;
+      float result = 0.f;
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
+      __m128 cumSum0 = _mm_setzero_ps();
+      __m128 cumSum1 = _mm_setzero_ps();
+      for(; i + 8 <= N; i += 8)
+      {
+        const __m128 diff0 = _mm_sub_ps(_mm_loadu_ps(query.data + i), _mm_loadu_ps(bPt + i));
+        const __m128 diff1 = _mm_sub_ps(_mm_loadu_ps(query.data + i + 4), _mm_loadu_ps(bPt + i + 4));
+        cumSum0 = _mm_add_ps(cumSum0, _mm_mul_ps(diff0, diff0));
+        cumSum1 = _mm_add_ps(cumSum1, _mm_mul_ps(diff1, diff1));
+      }
+      //-- horizontal sum
+      __m128 cumSum = _mm_add_ps(cumSum0, cumSum1);
+      cumSum = _mm_add_ps(cumSum, _mm_movehl_ps(cumSum, cumSum));
+      cumSum = _mm_add_ss(cumSum, _mm_shuffle_ps(cumSum, cumSum, 1));
+      result = _mm_cvtss_f32(cumSum);
+#endif
+      for(; i < N; ++i)
+      {
+        const float diff = query.data[i] - bPt[i];
+        result += diff * diff;
+      }
+      distances[c] = result;
+    }
+  }
+};
+
+template<std::size_t N>
+struct BlockDistance<feature::Descriptor<float, N>, feature::Descriptor<float, N>, L2>
+  : public BlockDistanceFloat<feature::Descriptor<float, N>, N>
+{};
+
+template<std::size_t N>
+struct BlockDistance<feature::Descriptor<unsigned char, N>, feature::Descriptor<float, N>, L2>
+  : public BlockDistanceFloat<feature::Descriptor<unsigned char, N>, N>
+{};
+
 }
 }
@@ -44,8 +44,9 @@ BOOST_AUTO_TEST_CASE(kmeanInitializer)
   }
 
   voctree::InitKmeanspp initializer;
+  std::mt19937 generator;
 
-  initializer(featPtr, K, centers, voctree::L2<FeatureFloat, FeatureFloat>());
+  initializer(featPtr, K, centers, voctree::L2<FeatureFloat, FeatureFloat>(), generator);
 
   // it's difficult to check the result as it is random, just check there are no weird things
   BOOST_CHECK(voctree::checkVectorElements(centers, "initializer1"));
@@ -65,7 +66,7 @@ BOOST_AUTO_TEST_CASE(kmeanInitializer)
     }
   }
 
-  initializer(featPtr, K, centers, voctree::L2<FeatureFloat,FeatureFloat>());
+  initializer(featPtr, K, centers, voctree::L2<FeatureFloat, FeatureFloat>(), generator);
 
   // it's difficult to check the result as it is random, just check there are no weird things
   BOOST_CHECK(voctree::checkVectorElements(centers, "initializer2"));
@@ -104,6 +105,7 @@ BOOST_AUTO_TEST_CASE(kmeanInitializerVarying)
     FeatureFloatVector centers;
 
     voctree::InitKmeanspp initializer;
+    std::mt19937 generator;
 
     features.reserve(FEATURENUMBER * K);
     featPtr.reserve(features.size());
@@ -119,7 +121,7 @@ BOOST_AUTO_TEST_CASE(kmeanInitializerVarying)
       }
     }
 
-    initializer(featPtr, K, centers, voctree::L2<FeatureFloat,FeatureFloat>());
+    initializer(featPtr, K, centers, voctree::L2<FeatureFloat, FeatureFloat>(), generator);
 
     // it's difficult to check the result as it is random, just check there are no weird things
     BOOST_CHECK(voctree::checkVectorElements(centers, "initializer"));
@@ -290,3 +292,53 @@ BOOST_AUTO_TEST_CASE(kmeanVarying)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(kmeanMiniBatch)
+{
+  using namespace aliceVision;
+  ALICEVISION_LOG_DEBUG("Testing mini-batch kmeans...");
+
+  const std::size_t DIMENSION = 16;
+  const std::size_t FEATURENUMBER = 1000;
+  const std::size_t K = 10;
+  const std::size_t STEP = 5 * K;
+
+  typedef Eigen::Matrix<float, 1, DIMENSION> FeatureFloat;
+  typedef std::vector<FeatureFloat, Eigen::aligned_allocator<FeatureFloat> > FeatureFloatVector;
+
+  // generate k clusters well far away
+  FeatureFloatVector features;
+  features.reserve(FEATURENUMBER * K);
+  for(std::size_t i = 0; i < K; ++i)
+  {
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+    {
+      features.push_back((FeatureFloat::Random(1, DIMENSION) + Eigen::MatrixXf::Constant(1, DIMENSION, STEP * i) - Eigen::MatrixXf::Constant(1, DIMENSION, STEP * (K - 1) / 2)) / ((STEP * (K - 1) / 2) * sqrt(DIMENSION)));
+    }
+  }
+
+  voctree::SimpleKmeans<FeatureFloat> kmeans(FeatureFloat::Zero());
+  kmeans.setVerbose(0);
+  kmeans.setRestarts(5);
+  kmeans.setMiniBatchSize(200);
+
+  FeatureFloatVector centers;
+  std::vector<unsigned int> membership;
+  kmeans.cluster(features, K, centers, membership);
+
+  BOOST_CHECK_EQUAL(centers.size(), K);
+  BOOST_CHECK(voctree::checkVectorElements(centers, "minibatch"));
+  BOOST_REQUIRE_EQUAL(membership.size(), features.size());
+
+  // each cluster is found and all its features are assigned to the same center
+  std::vector<std::size_t> h(K, 0);
+  for(std::size_t i = 0; i < K; ++i)
+  {
+    const unsigned int center = membership[i * FEATURENUMBER];
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+      BOOST_CHECK_EQUAL(membership[i * FEATURENUMBER + j], center);
+    ++h[center];
+  }
+  for(std::size_t i = 0; i < K; ++i)
+    BOOST_CHECK_EQUAL(h[i], 1);
+}
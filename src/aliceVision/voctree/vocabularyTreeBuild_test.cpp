@@ -6,11 +6,13 @@
 
 #include <aliceVision/voctree/TreeBuilder.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <Eigen/Core>
 
 #include <iostream>
 #include <fstream>
+#include <random>
 #include <vector>
 
 #define BOOST_TEST_MODULE voctreeBuilder
@@ -83,3 +85,51 @@ BOOST_AUTO_TEST_CASE(voctreeBuilder)
   }
 //  voctree::printFeatVector( features ); 
 }
+
+BOOST_AUTO_TEST_CASE(voctreeBuilder_threads)
+{
+  using namespace aliceVision;
+
+  const std::size_t DIMENSION = 8;
+  const std::size_t FEATURENUMBER = 5000;
+  const std::size_t K = 5;
+  const std::size_t LEVELS = 3;
+
+  typedef Eigen::Matrix<float, 1, DIMENSION> FeatureFloat;
+  typedef std::vector<FeatureFloat, Eigen::aligned_allocator<FeatureFloat> > FeatureFloatVector;
+
+  // random features around a few cluster centers
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+  std::uniform_int_distribution<int> cluster(0, 9);
+  FeatureFloatVector features(FEATURENUMBER);
+  for(FeatureFloat& feature : features)
+  {
+    const float offset = static_cast<float>(cluster(generator));
+    for(std::size_t d = 0; d < DIMENSION; ++d)
+      feature(d) = offset + 0.3f * uniform(generator);
+  }
+
+  // the tree built with several threads is the same as with a single thread
+  const int nbThreads[] = {1, 2, 4};
+  std::vector<FeatureFloatVector> centers;
+  std::vector<std::vector<uint8_t> > validCenters;
+  for(const int n : nbThreads)
+  {
+    omp_set_num_threads(n);
+    voctree::TreeBuilder<FeatureFloat> builder(FeatureFloat::Zero());
+    builder.setVerbose(0);
+    builder.kmeans().setRestarts(3);
+    builder.build(features, K, LEVELS);
+    centers.push_back(builder.tree().centers());
+    validCenters.push_back(builder.tree().validCenters());
+  }
+
+  for(std::size_t t = 1; t < centers.size(); ++t)
+  {
+    BOOST_REQUIRE_EQUAL(centers[t].size(), centers[0].size());
+    BOOST_CHECK(validCenters[t] == validCenters[0]);
+    for(std::size_t i = 0; i < centers[0].size(); ++i)
+      BOOST_CHECK(centers[t][i] == centers[0][i]);
+  }
+}
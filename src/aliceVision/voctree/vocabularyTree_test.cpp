@@ -5,9 +5,13 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/voctree/Database.hpp>
+#include <aliceVision/voctree/MutableVocabularyTree.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <fstream>
+#include <random>
 #include <vector>
 
 #define BOOST_TEST_MODULE vocabularyTree
@@ -17,6 +21,76 @@
 using namespace std;
 using namespace aliceVision::voctree;
 
+namespace {
+
+/// quantize by walking the tree, one center at a time
+template<class CenterT, class DescriptorT>
+Word referenceQuantize(const MutableVocabularyTree<CenterT>& tree, const DescriptorT& descriptor)
+{
+  int32_t index = -1;
+  for(uint32_t level = 0; level < tree.levels(); ++level)
+  {
+    const int32_t firstChild = (index + 1) * tree.splits();
+    int32_t bestChild = firstChild;
+    double bestDistance = std::numeric_limits<double>::max();
+    for(int32_t child = firstChild; child < firstChild + (int32_t) tree.splits() && tree.validCenters()[child]; ++child)
+    {
+      const double distance = L2<DescriptorT, CenterT>()(descriptor, tree.centers()[child]);
+      if(distance < bestDistance)
+      {
+        bestChild = child;
+        bestDistance = distance;
+      }
+    }
+    index = bestChild;
+  }
+  return index - (tree.nodes() - tree.words());
+}
+
+template<class CenterT, class DescriptorT>
+void checkQuantize()
+{
+  std::mt19937 generator(11);
+  std::uniform_int_distribution<int> valueDistribution(0, 255);
+
+  MutableVocabularyTree<CenterT> tree;
+  tree.setSize(3, 10);
+  tree.centers().resize(tree.nodes());
+  tree.validCenters().assign(tree.nodes(), 1);
+  for(std::size_t i = 0; i < tree.nodes(); ++i)
+  {
+    for(std::size_t d = 0; d < CenterT::static_size; ++d)
+      tree.centers()[i][d] = valueDistribution(generator);
+    // nodes with fewer than splits() children
+    if(i % 10 >= 7 && (i / 10) % 3 == 0)
+      tree.validCenters()[i] = 0;
+    // almost equidistant children
+    if(i % 10 == 5)
+    {
+      tree.centers()[i] = tree.centers()[i - 1];
+      tree.centers()[i][i % CenterT::static_size] += 1;
+    }
+  }
+
+  vector<DescriptorT> descriptors(1000);
+  for(std::size_t i = 0; i < descriptors.size(); ++i)
+  {
+    for(std::size_t d = 0; d < DescriptorT::static_size; ++d)
+      descriptors[i][d] = (i % 4 == 0) ? tree.centers()[i % tree.nodes()][d] : valueDistribution(generator);
+  }
+
+  const vector<Word> words = tree.quantize(descriptors);
+  BOOST_REQUIRE_EQUAL(words.size(), descriptors.size());
+  for(std::size_t i = 0; i < descriptors.size(); ++i)
+  {
+    const Word expected = referenceQuantize(tree, descriptors[i]);
+    BOOST_CHECK_EQUAL(words[i], expected);
+    BOOST_CHECK_EQUAL(tree.quantize(descriptors[i]), expected);
+  }
+}
+
+} // namespace
+
 BOOST_AUTO_TEST_CASE(database)
 {
   const int cardDocuments = 10;
@@ -57,3 +131,154 @@ BOOST_AUTO_TEST_CASE(database)
     BOOST_CHECK_SMALL(static_cast<double>(match[0].score), 0.001);
   }
 }
+
+BOOST_AUTO_TEST_CASE(database_invertedFile)
+{
+  const int cardDocuments = 50;
+  const int cardWords = 100;
+  const std::size_t N = 10;
+
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> wordDistribution(0, cardWords - 1);
+
+  // Create random documents, some words appearing several times
+  Database db(cardWords);
+  vector<SparseHistogram> documents(cardDocuments);
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    vector<Word> document(20);
+    for(Word& word : document)
+      word = wordDistribution(generator);
+    computeSparseHistogram(document, documents[i]);
+    // insert in a non-increasing order of DocId
+    db.insert(cardDocuments - i, documents[i]);
+  }
+  db.computeTfIdfWeights();
+
+  const std::vector<float> weights = [&]()
+  {
+    // recompute the weights used by the database
+    std::vector<int> nbDocumentsPerWord(cardWords, 0);
+    for(const SparseHistogram& document : documents)
+      for(const auto& word : document)
+        ++nbDocumentsPerWord[word.first];
+    std::vector<float> w(cardWords);
+    for(int i = 0; i < cardWords; ++i)
+      w[i] = nbDocumentsPerWord[i] ? std::log(float(cardDocuments) / nbDocumentsPerWord[i]) : 1.0f;
+    return w;
+  }();
+
+  for(const std::string distanceMethod : {"classic", "commonPoints", "strongCommonPoints", "weightedStrongCommonPoints", "inversedWeightedCommonPoints"})
+  {
+    for(int q = 0; q < cardDocuments; q += 7)
+    {
+      // brute force distances
+      vector<DocMatch> expected;
+      for(int i = 0; i < cardDocuments; ++i)
+        expected.emplace_back(cardDocuments - i, sparseDistance(documents[q], documents[i], distanceMethod, weights));
+      std::sort(expected.begin(), expected.end(), [](const DocMatch& a, const DocMatch& b)
+      {
+        return a.score < b.score || (a.score == b.score && a.id < b.id);
+      });
+
+      vector<DocMatch> matches;
+      db.find(documents[q], N, matches, distanceMethod);
+
+      BOOST_REQUIRE_EQUAL(matches.size(), N);
+      for(std::size_t i = 0; i < N; ++i)
+      {
+        BOOST_CHECK_CLOSE(matches[i].score, expected[i].score, 0.001);
+        // same scores with possibly different ids (rounding errors)
+        if(i + 1 < N && std::abs(expected[i].score - expected[i + 1].score) > 1e-4 &&
+           (i == 0 || std::abs(expected[i].score - expected[i - 1].score) > 1e-4))
+          BOOST_CHECK_EQUAL(matches[i].id, expected[i].id);
+      }
+    }
+  }
+
+  // L1 distance
+  for(int q = 0; q < cardDocuments; q += 7)
+  {
+    vector<DocMatch> matches;
+    db.find(documents[q], cardDocuments, matches, "classic");
+
+    BOOST_REQUIRE_EQUAL(matches.size(), cardDocuments);
+    BOOST_CHECK_EQUAL(matches.front().id, cardDocuments - q);
+    BOOST_CHECK_SMALL(static_cast<double>(matches.front().score), 0.001);
+
+    for(const DocMatch& match : matches)
+    {
+      const SparseHistogram& document = documents[cardDocuments - match.id];
+      std::map<Word, int> difference;
+      for(const auto& word : documents[q])
+        difference[word.first] += word.second.size();
+      for(const auto& word : document)
+        difference[word.first] -= word.second.size();
+      float distance = 0.0f;
+      for(const auto& word : difference)
+        distance += std::abs(word.second);
+      BOOST_CHECK_EQUAL(match.score, distance);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(database_findAll)
+{
+  const int cardDocuments = 200;
+  const int cardWords = 500;
+
+  std::mt19937 generator(7);
+  std::uniform_int_distribution<int> wordDistribution(0, cardWords - 1);
+
+  Database db(cardWords);
+  vector<SparseHistogram> documents(cardDocuments);
+  for(int i = 0; i < cardDocuments; ++i)
+  {
+    vector<Word> document(50);
+    for(Word& word : document)
+      word = wordDistribution(generator);
+    computeSparseHistogram(document, documents[i]);
+    db.insert(i, documents[i]);
+  }
+  db.computeTfIdfWeights();
+
+  vector<const SparseHistogram*> queries;
+  for(const SparseHistogram& document : documents)
+    queries.push_back(&document);
+
+  for(const std::string distanceMethod : {"classic", "strongCommonPoints", "inversedWeightedCommonPoints"})
+  {
+    for(std::size_t N : {std::size_t(0), std::size_t(5), std::size_t(cardDocuments + 10)})
+    {
+      vector<DocMatches> allMatches;
+      db.findAll(queries, N, allMatches, distanceMethod);
+
+      BOOST_REQUIRE_EQUAL(allMatches.size(), queries.size());
+      for(std::size_t q = 0; q < queries.size(); ++q)
+      {
+        DocMatches matches;
+        db.find(*queries[q], N, matches, distanceMethod);
+        BOOST_CHECK(allMatches[q] == matches);
+      }
+    }
+  }
+
+  // sanity check: each document is its own best match
+  std::map<std::size_t, DocMatches> sanityMatches;
+  db.sanityCheck(1, sanityMatches);
+  BOOST_CHECK_EQUAL(sanityMatches.size(), cardDocuments);
+  for(const auto& docMatches : sanityMatches)
+    BOOST_CHECK_EQUAL(docMatches.second.front().id, docMatches.first);
+}
+
+BOOST_AUTO_TEST_CASE(vocabularyTree_quantize)
+{
+  typedef aliceVision::feature::Descriptor<unsigned char, 128> DescriptorUChar;
+  typedef aliceVision::feature::Descriptor<float, 128> DescriptorFloat;
+  typedef aliceVision::feature::Descriptor<float, 61> DescriptorFloatOdd;
+
+  checkQuantize<DescriptorUChar, DescriptorUChar>();
+  checkQuantize<DescriptorFloat, DescriptorFloat>();
+  checkQuantize<DescriptorFloat, DescriptorUChar>();
+  checkQuantize<DescriptorFloatOdd, DescriptorFloatOdd>();
+}
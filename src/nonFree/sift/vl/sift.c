@@ -771,6 +771,40 @@ copy_and_upsample_rows
   }
 }
 
+/** ------------------------------------------------------------------
+ ** @internal
+ ** @brief Convolve the columns of an image and transpose the result
+ **
+ ** Same as ::vl_imconvcol_vf with ::VL_TRANSPOSE, the columns are
+ ** split in blocks filtered concurrently (with OpenMP).
+ **/
+
+static void
+_vl_sift_imconvcol_transp (vl_sift_pix * dst,
+                           vl_sift_pix const * src,
+                           vl_size width,
+                           vl_size height,
+                           vl_sift_pix const * filt,
+                           vl_index filt_width)
+{
+  /* multiple of 4 columns to keep the SSE2 code path */
+  vl_index const blockWidth = 64 ;
+  vl_index const numBlocks = ((vl_index)width + blockWidth - 1) / blockWidth ;
+  vl_index b ;
+
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) if(numBlocks > 1)
+#endif
+  for (b = 0 ; b < numBlocks ; ++b) {
+    vl_index const x0 = b * blockWidth ;
+    vl_index const x1 = VL_MIN(x0 + blockWidth, (vl_index)width) ;
+    vl_imconvcol_vf (dst + x0 * height, height,
+                     src + x0, x1 - x0, height, width,
+                     filt, - filt_width, filt_width,
+                     1, VL_PAD_BY_CONTINUITY | VL_TRANSPOSE) ;
+  }
+}
+
 /** ------------------------------------------------------------------
  ** @internal
  ** @brief Smooth an image
@@ -816,17 +850,11 @@ _vl_sift_smooth (VlSiftFilt * self,
     return ;
   }
 
-  vl_imconvcol_vf (tempImage, height,
-                   inputImage, width, height, width,
-                   self->gaussFilter,
-                   - self->gaussFilterWidth, self->gaussFilterWidth,
-                   1, VL_PAD_BY_CONTINUITY | VL_TRANSPOSE) ;
-
-  vl_imconvcol_vf (outputImage, width,
-                   tempImage, height, width, height,
-                   self->gaussFilter,
-                   - self->gaussFilterWidth, self->gaussFilterWidth,
-                   1, VL_PAD_BY_CONTINUITY | VL_TRANSPOSE) ;
+  _vl_sift_imconvcol_transp (tempImage, inputImage, width, height,
+                             self->gaussFilter, self->gaussFilterWidth) ;
+
+  _vl_sift_imconvcol_transp (outputImage, tempImage, height, width,
+                             self->gaussFilter, self->gaussFilterWidth) ;
 }
 
 /** ------------------------------------------------------------------
@@ -1009,6 +1037,8 @@ vl_sift_process_first_octave (VlSiftFilt *f, vl_sift_pix const *im)
   /* restart from the first */
   f->o_cur = o_min ;
   f->nkeys = 0 ;
+  /* the gradient of a previous image is not valid anymore */
+  f->grad_o = o_min - 1 ;
   w = f-> octave_width  = VL_SHIFT_LEFT(f->width,  - f->o_cur) ;
   h = f-> octave_height = VL_SHIFT_LEFT(f->height, - f->o_cur) ;
 
@@ -1187,14 +1217,17 @@ vl_sift_detect (VlSiftFilt * f)
   /* clear current list */
   f-> nkeys = 0 ;
 
-  /* compute difference of gaussian (DoG) */
-  pt = f-> dog ;
+  /* compute difference of gaussian (DoG), one level per thread */
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static)
+#endif
   for (s = s_min ; s <= s_max - 1 ; ++s) {
+    vl_sift_pix* dst_s = f-> dog + (s - s_min) * so ;
     vl_sift_pix* src_a = vl_sift_get_octave (f, s    ) ;
     vl_sift_pix* src_b = vl_sift_get_octave (f, s + 1) ;
     vl_sift_pix* end_a = src_a + w * h ;
     while (src_a != end_a) {
-      *pt++ = *src_b++ - *src_a++ ;
+      *dst_s++ = *src_b++ - *src_a++ ;
     }
   }
 
@@ -1470,6 +1503,10 @@ vl_sift_update_gradient (VlSiftFilt *f)
 
   if (f->grad_o == f->o_cur) return ;
 
+  /* the levels are independent, one level per thread */
+#if defined(_OPENMP)
+#pragma omp parallel for private(y) schedule(static)
+#endif
   for (s  = s_min + 1 ;
        s <= s_max - 2 ; ++ s) {
 
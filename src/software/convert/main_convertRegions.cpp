@@ -0,0 +1,175 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2018 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/feature/Regions.hpp>
+#include <aliceVision/feature/RegionsFile.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+#include <map>
+#include <memory>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+int main(int argc, char** argv)
+{
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string inputFolder;
+  std::string outputFolder;
+  std::string describerTypesName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  bool pack = false;
+
+  po::options_description allParams("This program is used to convert regions from .feat/.desc files to binary regions files (.regions)\n"
+                                    "AliceVision convertRegions");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&inputFolder)->required(),
+      "Input folder containing the .feat and .desc files.")
+    ("output,o", po::value<std::string>(&outputFolder)->required(),
+      "Output folder for the .regions files.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
+      feature::EImageDescriberType_informations().c_str())
+    ("pack", po::value<bool>(&pack)->default_value(pack),
+      "Pack all the views in a single file per describer type (<describerType>.regions) "
+      "instead of one file per view (<viewId>.<describerType>.regions).");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal,  error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(!(fs::exists(inputFolder) && fs::is_directory(inputFolder)))
+  {
+    ALICEVISION_LOG_ERROR(inputFolder << " does not exists or it is not a folder");
+    return EXIT_FAILURE;
+  }
+
+  // if the folder does not exist create it (recursively)
+  if(!fs::exists(outputFolder))
+  {
+    fs::create_directories(outputFolder);
+  }
+
+  const std::vector<feature::EImageDescriberType> describerTypes = feature::EImageDescriberType_stringToEnums(describerTypesName);
+
+  for(const feature::EImageDescriberType describerType : describerTypes)
+  {
+    const std::string describerTypeName = feature::EImageDescriberType_enumToString(describerType);
+    const std::string featExtension = "." + describerTypeName + ".feat";
+    const std::unique_ptr<feature::ImageDescriber> imageDescriber = feature::createImageDescriber(describerType);
+
+    // find the views from the "<viewId>.<describerType>.feat" files
+    std::map<IndexT, std::unique_ptr<feature::Regions>> regionsPerView;
+
+    for(fs::directory_iterator it(inputFolder); it != fs::directory_iterator(); ++it)
+    {
+      const std::string filename = it->path().filename().string();
+      if(filename.size() <= featExtension.size() ||
+         filename.compare(filename.size() - featExtension.size(), featExtension.size(), featExtension) != 0)
+        continue;
+
+      const std::string basename = filename.substr(0, filename.size() - featExtension.size());
+      IndexT viewId;
+      try
+      {
+        viewId = static_cast<IndexT>(std::stoul(basename));
+      }
+      catch(const std::exception&)
+      {
+        ALICEVISION_LOG_WARNING("Skip '" << filename << "': the file name should start with a view id.");
+        continue;
+      }
+
+      const fs::path descPath = fs::path(inputFolder) / std::string(basename + "." + describerTypeName + ".desc");
+      if(!fs::exists(descPath))
+      {
+        ALICEVISION_LOG_WARNING("Skip view " << viewId << ": no descriptors file '" << descPath.string() << "'.");
+        continue;
+      }
+
+      std::unique_ptr<feature::Regions> regions;
+      imageDescriber->allocate(regions);
+      regions->Load(it->path().string(), descPath.string());
+
+      if(pack)
+      {
+        regionsPerView[viewId] = std::move(regions);
+      }
+      else
+      {
+        const std::string outputPath = (fs::path(outputFolder) / std::string(basename + "." + describerTypeName + ".regions")).string();
+        feature::saveRegionsFile(outputPath, {{viewId, regions.get()}});
+        regionsPerView[viewId].reset();
+      }
+    }
+
+    if(pack && !regionsPerView.empty())
+    {
+      std::map<IndexT, const feature::Regions*> regionsToSave;
+      for(const auto& regionsIt : regionsPerView)
+        regionsToSave[regionsIt.first] = regionsIt.second.get();
+
+      feature::saveRegionsFile((fs::path(outputFolder) / std::string(describerTypeName + ".regions")).string(), regionsToSave);
+    }
+
+    ALICEVISION_LOG_INFO("Converted " << regionsPerView.size() << " views with " << describerTypeName << " regions.");
+  }
+
+  return EXIT_SUCCESS;
+}
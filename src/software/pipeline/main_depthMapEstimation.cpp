@@ -4,6 +4,7 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file,
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
+#include <aliceVision/config.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/Timer.hpp>
@@ -144,6 +145,7 @@ int main(int argc, char* argv[])
     // set verbose level
     system::Logger::get()->setLogLevel(verboseLevel);
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     // print GPU Information
     ALICEVISION_LOG_INFO(system::gpuInformationCUDA());
 
@@ -153,6 +155,9 @@ int main(int argc, char* argv[])
       ALICEVISION_LOG_ERROR("This program needs a CUDA-Enabled GPU (with at least compute capablility 2.0).");
       return EXIT_FAILURE;
     }
+#else
+    ALICEVISION_LOG_INFO("Built without CUDA: depth maps are computed on the CPU.");
+#endif
 
     // check if the scale is correct
     if(downscale < 1)
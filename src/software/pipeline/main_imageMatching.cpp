@@ -312,36 +312,45 @@ void generateFromVoctree(PairList& allMatches,
       allMatches[descriptorPair.first] = {};
   }
 
-  // query each document
-  #pragma omp parallel for
-  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(descriptorsFiles.size()); ++i)
-  {
-    auto itA = descriptorsFiles.cbegin();
-    std::advance(itA, i);
-    const IndexT viewIdA = itA->first;
-    const std::string featuresPathA = itA->second;
+  std::vector<const aliceVision::voctree::SparseHistogram*> queries;
+  std::vector<aliceVision::voctree::SparseHistogram> queriesSH;
 
-    aliceVision::voctree::SparseHistogram imageSH;
+  if(modeMultiSfM != EImageMatchingMode::A_B)
+  {
+    // sparse histograms of A are already computed in the DB
+    for(const auto& descriptorPair : descriptorsFiles)
+      queries.push_back(&db.getSparseHistogramPerImage().at(descriptorPair.first));
+  }
+  else // mode AB
+  {
+    // compute the sparse histogram of each image A
+    queriesSH.resize(descriptorsFiles.size());
 
-    if(modeMultiSfM != EImageMatchingMode::A_B)
-    {
-      // sparse histogram of A is already computed in the DB
-      imageSH = db.getSparseHistogramPerImage().at(viewIdA);
-    }
-    else // mode AB
+    #pragma omp parallel for
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(descriptorsFiles.size()); ++i)
     {
-      // compute the sparse histogram of each image A
+      auto itA = descriptorsFiles.cbegin();
+      std::advance(itA, i);
+
       std::vector<DescriptorUChar> descriptors;
       // read the descriptors
-      loadDescsFromBinFile(featuresPathA, descriptors, false, nbMaxDescriptors);
-      imageSH = tree.quantizeToSparse(descriptors);
+      loadDescsFromBinFile(itA->second, descriptors, false, nbMaxDescriptors);
+      queriesSH.at(i) = tree.quantizeToSparse(descriptors);
     }
 
-    std::vector<aliceVision::voctree::DocMatch> matches;
+    for(const aliceVision::voctree::SparseHistogram& imageSH : queriesSH)
+      queries.push_back(&imageSH);
+  }
 
-    db.find(imageSH, numImageQuery, matches);
+  // query all the documents at once
+  std::vector<aliceVision::voctree::DocMatches> allDocMatches;
+  db.findAll(queries, numImageQuery, allDocMatches);
 
-    ListOfImageID& imgMatches = allMatches.at(viewIdA);
+  std::size_t i = 0;
+  for(const auto& descriptorPair : descriptorsFiles)
+  {
+    const aliceVision::voctree::DocMatches& matches = allDocMatches.at(i++);
+    ListOfImageID& imgMatches = allMatches.at(descriptorPair.first);
     imgMatches.reserve(imgMatches.size() + matches.size());
 
     for(const aliceVision::voctree::DocMatch& m : matches)
@@ -26,7 +26,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 static const int DIMENSION = 128;
 
@@ -53,6 +53,8 @@ int main(int argc, char** argv)
   std::uint32_t K = 10;
   std::uint32_t restart = 5;
   std::uint32_t LEVELS = 6;
+  std::size_t maxDescriptors = 0;
+  std::size_t miniBatchSize = 0;
   bool sanityCheck = true;
 
   po::options_description allParams("This program is used to load the sift descriptors from a SfMData file and create a vocabulary tree\n"
@@ -73,6 +75,12 @@ int main(int argc, char** argv)
     (",k", po::value<uint32_t>(&K)->default_value(10), "The branching factor of the tree")
     ("restart,r", po::value<uint32_t>(&restart)->default_value(5), "Number of times that the kmean is launched for each cluster, the best solution is kept")
     (",L", po::value<uint32_t>(&LEVELS)->default_value(6), "Number of levels of the tree")
+    ("maxDescriptors", po::value<std::size_t>(&maxDescriptors)->default_value(maxDescriptors),
+      "Maximum number of descriptors used to build the tree (0 for all). "
+      "If there are more descriptors, a random subset is used and the descriptors are then read image by image to compute the weights, "
+      "so the memory usage does not depend on the total number of descriptors.")
+    ("miniBatchSize", po::value<std::size_t>(&miniBatchSize)->default_value(miniBatchSize),
+      "Use the mini-batch k-means with batches of this size instead of the standard k-means (0 to disable).")
     ("sanitycheck,s", po::value<bool>(&sanityCheck)->default_value(sanityCheck), "Perform a sanity check at the end of the creation of the vocabulary tree. The sanity check is a query to the database with the same documents/images useed to train the vocabulary tree");
 
   po::options_description logParams("Log parameters");
@@ -127,7 +135,13 @@ int main(int argc, char** argv)
   std::vector<size_t> descRead;
   ALICEVISION_COUT("Reading descriptors from " << sfmDataFilename);
   auto detect_start = std::chrono::steady_clock::now();
-  size_t numTotDescriptors = aliceVision::voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, descriptors, descRead);
+  size_t numTotDescriptors = 0;
+  if(maxDescriptors == 0)
+    numTotDescriptors = aliceVision::voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, descriptors, descRead);
+  else
+    numTotDescriptors = aliceVision::voctree::sampleDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, maxDescriptors, descriptors, descRead);
+  // all the descriptors are in memory
+  const bool allDescriptorsLoaded = (descriptors.size() == numTotDescriptors);
   auto detect_end = std::chrono::steady_clock::now();
   auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
   if(descriptors.size() == 0)
@@ -137,12 +151,15 @@ int main(int argc, char** argv)
   }
 
   ALICEVISION_COUT("Done! " << descRead.size() << " sets of descriptors read for a total of " << numTotDescriptors << " features");
+  if(!allDescriptorsLoaded)
+    ALICEVISION_COUT(descriptors.size() << " descriptors randomly selected to build the tree");
   ALICEVISION_COUT("Reading took " << detect_elapsed.count() << " sec");
 
   // Create tree
   aliceVision::voctree::TreeBuilder<DescriptorFloat> builder(DescriptorFloat(0));
   builder.setVerbose(tbVerbosity);
   builder.kmeans().setRestarts(restart);
+  builder.kmeans().setMiniBatchSize(miniBatchSize);
   ALICEVISION_COUT("Building a tree of L=" << LEVELS << " levels with a branching factor of k=" << K);
   detect_start = std::chrono::steady_clock::now();
   builder.build(descriptors, K, LEVELS);
@@ -154,34 +171,53 @@ int main(int argc, char** argv)
   builder.tree().save(treeName);
 
   aliceVision::voctree::SparseHistogramPerImage allSparseHistograms;
-  // temporary vector used to save all the visual word for each image before adding them to documents
-  std::vector<aliceVision::voctree::Word> imgVisualWords;
   ALICEVISION_COUT("Quantizing the features");
-  size_t offset = 0; ///< this is used to align to the features of a given image in 'feature'
   detect_start = std::chrono::steady_clock::now();
-  // pass each feature through the vocabulary tree to get the associated visual word
-  // for each read images, recover the number of features in it from descRead and loop over the features
-  for(size_t i = 0; i < descRead.size(); ++i)
+  if(allDescriptorsLoaded)
   {
-    // for each image:
-    // clear the temporary vector used to save all the visual word and allocate the proper size
-    imgVisualWords.clear();
-    // allocate as many visual words as the number of the features in the image
-    imgVisualWords.resize(descRead[i], 0);
-
-    #pragma omp parallel for
-    for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(descRead[i]); ++j)
+    // temporary vector used to save all the visual word for each image before adding them to documents
+    std::vector<aliceVision::voctree::Word> imgVisualWords;
+    size_t offset = 0; ///< this is used to align to the features of a given image in 'feature'
+    // pass each feature through the vocabulary tree to get the associated visual word
+    // for each read images, recover the number of features in it from descRead and loop over the features
+    for(size_t i = 0; i < descRead.size(); ++i)
     {
-      //	store the visual word associated to the feature in the temporary list
-      imgVisualWords[j] = builder.tree().quantize(descriptors[ j + offset ]);
-    }
-    aliceVision::voctree::SparseHistogram histo;
-    aliceVision::voctree::computeSparseHistogram(imgVisualWords, histo);
-    // add the vector to the documents
-    allSparseHistograms[i] = histo;
+      // for each image:
+      // clear the temporary vector used to save all the visual word and allocate the proper size
+      imgVisualWords.clear();
+      // allocate as many visual words as the number of the features in the image
+      imgVisualWords.resize(descRead[i], 0);
+
+      #pragma omp parallel for
+      for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(descRead[i]); ++j)
+      {
+        //	store the visual word associated to the feature in the temporary list
+        imgVisualWords[j] = builder.tree().quantize(descriptors[ j + offset ]);
+      }
+      aliceVision::voctree::SparseHistogram histo;
+      aliceVision::voctree::computeSparseHistogram(imgVisualWords, histo);
+      // add the vector to the documents
+      allSparseHistograms[i] = histo;
 
-    // update the offset
-    offset += descRead[i];
+      // update the offset
+      offset += descRead[i];
+    }
+  }
+  else
+  {
+    // the training subset is not needed anymore
+    std::vector<DescriptorFloat>().swap(descriptors);
+
+    // read the descriptors image by image
+    std::map<IndexT, std::string> descriptorsFiles;
+    aliceVision::voctree::getListOfDescriptorFiles(sfmData, featuresFolders, descriptorsFiles);
+    std::vector<DescriptorUChar> imageDescriptors;
+    size_t i = 0;
+    for(const auto& descriptorsFile : descriptorsFiles)
+    {
+      aliceVision::feature::loadDescsFromBinFile(descriptorsFile.second, imageDescriptors, false);
+      allSparseHistograms[i++] = builder.tree().quantizeToSparse(imageDescriptors);
+    }
   }
   detect_end = std::chrono::steady_clock::now();
   detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);